@@ -0,0 +1,77 @@
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "temporary_wav.hpp"
+
+import music;
+
+namespace
+{
+    constexpr std::size_t s_period_frames = 512;
+} // namespace
+
+TEST_CASE("Decoding and resampling", "[benchmark][music][track]")
+{
+    // Tracks are decoded at 44.1 kHz: the first file passes through the resampler unchanged, the second is converted.
+    // No peak overviews, their background decode would compete with the timed one
+    support::c_temporary_wav native("spectra_bench_44100.wav", 44100);
+    support::c_temporary_wav converted("spectra_bench_48000.wav", 48000);
+    music::c_track native_track(0, native.path(), music::e_peak_overview::none);
+    music::c_track converted_track(1, converted.path(), music::e_peak_overview::none);
+    native_track.set_looping(true);
+    converted_track.set_looping(true);
+
+    std::vector<float> period(s_period_frames * 2);
+    BENCHMARK("decode period 44.1 kHz")
+    {
+        return native_track.render(period, s_period_frames);
+    };
+    BENCHMARK("decode period 48 kHz resampled")
+    {
+        return converted_track.render(period, s_period_frames);
+    };
+}
+
+TEST_CASE("Mixing", "[benchmark][music][mix]")
+{
+    support::c_temporary_wav file("spectra_bench_mix.wav", 44100);
+
+    // The audio callback's mix: every track rendered into a scratch period and summed into the output
+    for (std::size_t track_count : { 1U, 4U, 16U })
+    {
+        std::vector<std::unique_ptr<music::c_track>> tracks;
+        for (std::size_t i = 0; i < track_count; ++i)
+        {
+            tracks.push_back(std::make_unique<music::c_track>(static_cast<int>(i), file.path(), music::e_peak_overview::none));
+            tracks.back()->set_looping(true);
+        }
+        std::vector<float> scratch(s_period_frames * 2);
+        std::vector<float> output(s_period_frames * 2);
+        BENCHMARK("mix " + std::to_string(track_count) + " tracks")
+        {
+            std::ranges::fill(output, 0.F);
+            for (auto &track : tracks)
+            {
+                track->render(scratch, s_period_frames);
+                std::ranges::transform(output, scratch, output.begin(), std::plus<float>{});
+            }
+            return output.front();
+        };
+    }
+
+    std::vector<float> outgoing(s_period_frames * music::c_playlist::s_channels, 0.5F);
+    std::vector<float> incoming(s_period_frames * music::c_playlist::s_channels, -0.5F);
+    std::vector<float> output(outgoing.size());
+    BENCHMARK("crossfade period")
+    {
+        music::c_playlist::crossfade(outgoing, incoming, output, s_period_frames / 2, s_period_frames * 4);
+        return output.front();
+    };
+}
@@ -0,0 +1,269 @@
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <numeric>
+#include <print>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "temporary_wav.hpp"
+
+import gui;
+import music;
+import opengl;
+import glm;
+import utility;
+
+// Allocations of the render thread, counted by replacing the global allocator
+namespace
+{
+    thread_local std::uint64_t t_allocations = 0;
+}
+
+auto operator new(std::size_t size) -> void *
+{
+    ++t_allocations;
+    if (auto *pointer = std::malloc(size == 0 ? 1 : size))
+    {
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+
+auto operator delete(void *pointer) noexcept -> void
+{
+    std::free(pointer);
+}
+
+auto operator delete(void *pointer, std::size_t /*size*/) noexcept -> void
+{
+    std::free(pointer);
+}
+
+namespace
+{
+    struct s_options
+    {
+        std::size_t frames = 600;
+        std::size_t warmup_frames = 60;
+        std::size_t tracks = 8;
+        int width = 1280;
+        int height = 720;
+        std::filesystem::path output = "frame_bench.json";
+    };
+
+    struct s_frame_sample
+    {
+        float cpu_time{}; // Milliseconds from the start of the frame to the swap
+        std::uint64_t draw_calls{};
+        std::uint64_t uploads{};
+        std::uint64_t allocations{};
+    };
+
+    auto parse_options(int argc, char **argv) -> s_options
+    {
+        s_options options;
+        for (int index = 1; index + 1 < argc; index += 2)
+        {
+            std::string_view name = argv[index];
+            std::string value = argv[index + 1];
+            if (name == "--frames")
+            {
+                options.frames = std::stoul(value);
+            }
+            else if (name == "--warmup")
+            {
+                options.warmup_frames = std::stoul(value);
+            }
+            else if (name == "--tracks")
+            {
+                options.tracks = std::stoul(value);
+            }
+            else if (name == "--out")
+            {
+                options.output = value;
+            }
+            else
+            {
+                throw std::invalid_argument(std::format("Unknown option {}", name));
+            }
+        }
+        if (argc % 2 == 0)
+        {
+            throw std::invalid_argument("Options take a value: --frames M --warmup W --tracks N --out file.json");
+        }
+        return options;
+    }
+
+    auto create_hidden_window(int width, int height) -> GLFWwindow *
+    {
+        glfwSetErrorCallback([](int error, const char *description)
+                             { std::println(std::cerr, "Warning: GLFW error {}: {}", error, description); });
+        if (not glfwInit())
+        {
+            return nullptr;
+        }
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
+        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+        return glfwCreateWindow(width, height, "Spectra frame benchmark", nullptr, nullptr);
+    }
+
+    auto percentile(std::vector<float> sorted, float fraction) -> float
+    {
+        std::ranges::sort(sorted);
+        return sorted[static_cast<std::size_t>(fraction * static_cast<float>(sorted.size() - 1))];
+    }
+
+    auto run(const s_options &options, GLFWwindow *window) -> std::vector<s_frame_sample>
+    {
+        glewExperimental = GL_TRUE;
+        if (glewInit() != GLEW_OK)
+        {
+            throw std::runtime_error("Error initializing GLEW");
+        }
+        glfwSwapInterval(0); // Frames as fast as they render, the time of a frame is its cost
+        opengl::c_text_renderer::instance().load_font(SOURCE_DIR "/assets/fonts/NotoSans.ttf", 24);
+        opengl::c_command_queue::instance().make_current();
+        utility::c_profiler::instance().name_thread("Main");
+
+        int width = 0;
+        int height = 0;
+        glfwGetFramebufferSize(window, &width, &height);
+        auto size = glm::vec2{ static_cast<float>(width), static_cast<float>(height) };
+        opengl::c_frame_uniforms::instance().set_view({ 0.F, 0.F }, size);
+
+        // Synthetic tracks played on the null device, so the spectrum sees real output without sound hardware
+        std::vector<std::unique_ptr<support::c_temporary_wav>> files;
+        std::vector<music::s_track_entry> entries;
+        music::c_audio_manager audio_manager(music::e_audio_backend::null);
+        for (std::size_t index = 0; index < options.tracks; ++index)
+        {
+            files.push_back(std::make_unique<support::c_temporary_wav>(std::format("spectra_frame_bench_{}.wav", index), 44100));
+            auto track = std::make_shared<music::c_track>(static_cast<int>(index), files.back()->path());
+            track->set_looping(true);
+            audio_manager.add_track(track);
+            entries.push_back({ .path = files.back()->path(), .state = music::e_load_state::ready, .track = std::move(track), .error = {} });
+        }
+        // The track list draws the overviews; wait for them, so their background decode does not overlap the timed frames
+        for (const auto &entry : entries)
+        {
+            while (entry.track->peaks() == nullptr)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds{ 1 });
+            }
+        }
+        audio_manager.play();
+
+        gui::c_waveform_panel waveform({ size.x / 2.F, 0.F }, { size.x / 2.F, size.y }, audio_manager);
+        gui::c_track_panel track_panel({ 0.F, 0.F }, { size.x / 2.F, size.y }, entries, audio_manager);
+
+        std::vector<s_frame_sample> samples;
+        samples.reserve(options.frames);
+        auto start_time = std::chrono::steady_clock::now();
+        auto last_time = start_time;
+        for (std::size_t frame = 0; frame < options.warmup_frames + options.frames; ++frame)
+        {
+            t_allocations = 0;
+            auto frame_start = std::chrono::steady_clock::now();
+            glfwPollEvents();
+            opengl::c_command_queue::instance().drain(std::chrono::microseconds{ 2000 });
+            opengl::c_frame_uniforms::instance().set_time(std::chrono::duration<float>(frame_start - start_time).count(), std::chrono::duration<float>(frame_start - last_time).count());
+            last_time = frame_start;
+            audio_manager.auto_cleanup();
+            waveform.update_waveform();
+
+            opengl::c_renderer::begin_frame();
+            opengl::c_renderer::clear();
+            waveform.render();
+            track_panel.render();
+            opengl::c_text_renderer::instance().draw_texts();
+
+            auto counters = opengl::c_gl_state::instance().current_counters();
+            s_frame_sample sample{
+                .cpu_time = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - frame_start).count(),
+                .draw_calls = counters.draw_calls,
+                .uploads = counters.uploads,
+                .allocations = t_allocations,
+            };
+            glfwSwapBuffers(window);
+            if (frame >= options.warmup_frames)
+            {
+                samples.push_back(sample);
+            }
+        }
+        return samples;
+    }
+
+    auto report(const s_options &options, const std::vector<s_frame_sample> &samples) -> void
+    {
+        std::vector<float> times;
+        times.reserve(samples.size());
+        std::ranges::transform(samples, std::back_inserter(times), &s_frame_sample::cpu_time);
+        auto mean = [&samples](auto member) -> double
+        {
+            auto total = std::accumulate(samples.begin(), samples.end(), 0.0, [member](double sum, const s_frame_sample &sample)
+                                         { return sum + static_cast<double>(sample.*member); });
+            return total / static_cast<double>(samples.size());
+        };
+
+        auto json = std::format(R"({{"frames":{},"tracks":{},"renderer":"{}","cpu_frame_ms":{{"mean":{:.4f},"p50":{:.4f},"p95":{:.4f},"p99":{:.4f},"max":{:.4f}}},"draw_calls_per_frame":{:.2f},"uploads_per_frame":{:.2f},"allocations_per_frame":{:.2f}}})",
+                                samples.size(), options.tracks, reinterpret_cast<const char *>(glGetString(GL_RENDERER)),
+                                mean(&s_frame_sample::cpu_time), percentile(times, 0.5F), percentile(times, 0.95F), percentile(times, 0.99F), std::ranges::max(times),
+                                mean(&s_frame_sample::draw_calls), mean(&s_frame_sample::uploads), mean(&s_frame_sample::allocations));
+        std::println("{}", json);
+
+        std::ofstream file(options.output);
+        file << json << '\n';
+        if (not file)
+        {
+            std::println(std::cerr, "Warning: could not write {}", options.output.string());
+        }
+    }
+} // namespace
+
+auto main(int argc, char **argv) -> int
+{
+    try
+    {
+        auto options = parse_options(argc, argv);
+        auto *window = create_hidden_window(options.width, options.height);
+        if (window == nullptr)
+        {
+            std::println(std::cerr, "No OpenGL 4.5 context; without a display run under xvfb-run, Mesa's llvmpipe needs no GPU");
+            glfwTerminate();
+            return 1;
+        }
+        glfwMakeContextCurrent(window);
+
+        // GL objects of the run are destroyed before the context
+        auto samples = run(options, window);
+        report(options, samples);
+
+        glfwDestroyWindow(window);
+        glfwTerminate();
+        return 0;
+    }
+    catch (const std::exception &e)
+    {
+        std::println(std::cerr, "Exception caught: {}", e.what());
+        return 1;
+    }
+}
@@ -0,0 +1,132 @@
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <cstddef>
+#include <numbers>
+#include <random>
+#include <ranges>
+#include <string>
+#include <vector>
+
+import glm;
+import math;
+
+namespace
+{
+    auto noise(std::size_t size) -> std::vector<float>
+    {
+        std::mt19937 generator(42);
+        std::uniform_real_distribution<float> distribution(-1.F, 1.F);
+        std::vector<float> samples(size);
+        std::ranges::generate(samples, [&]()
+                              { return distribution(generator); });
+        return samples;
+    }
+} // namespace
+
+TEST_CASE("FFT", "[benchmark][math][fft]")
+{
+    for (std::size_t size = 256; size <= 65536; size *= 4)
+    {
+        auto samples = noise(size);
+        auto spectrum = math::fft(samples);
+
+        BENCHMARK("fft " + std::to_string(size))
+        {
+            return math::fft(samples);
+        };
+        BENCHMARK("ifft " + std::to_string(size))
+        {
+            return math::ifft(spectrum);
+        };
+    }
+}
+
+TEST_CASE("Window and colour", "[benchmark][math][helpers]")
+{
+    for (std::size_t size : { 2048U, 16384U })
+    {
+        auto samples = noise(size);
+        BENCHMARK_ADVANCED("hanning_window " + std::to_string(size))(Catch::Benchmark::Chronometer meter)
+        {
+            std::vector<std::vector<float>> copies(static_cast<std::size_t>(meter.runs()), samples);
+            meter.measure([&copies](int run)
+                          { math::helpers::hanning_window(copies[static_cast<std::size_t>(run)]); });
+        };
+    }
+
+    // One colour per bar of the spectrum: converted each time, and looked up as update_waveform() does
+    constexpr std::size_t bars = 1024;
+    std::vector<glm::vec4> colours(bars);
+    BENCHMARK("hsv_to_rgba x" + std::to_string(bars))
+    {
+        for (std::size_t bar = 0; bar < bars; ++bar)
+        {
+            colours[bar] = math::helpers::hsv_to_rgba({ static_cast<float>(bar) * 360.F / static_cast<float>(bars), 1.F, 1.F });
+        }
+        return colours.back();
+    };
+
+    auto sweep = math::c_colormap::hsv_sweep(1.F, 1.F);
+    BENCHMARK("colormap sample x" + std::to_string(bars))
+    {
+        for (std::size_t bar = 0; bar < bars; ++bar)
+        {
+            colours[bar] = sweep.sample(static_cast<float>(bar) / static_cast<float>(bars));
+        }
+        return colours.back();
+    };
+}
+
+TEST_CASE("Band binning", "[benchmark][math][bands]")
+{
+    auto samples = noise(8192);
+    auto magnitudes = math::fft(samples)
+                      | std::views::transform([](const std::complex<float> &datum) -> float
+                                              { return std::abs(datum); })
+                      | std::ranges::to<std::vector>();
+
+    std::vector<float> bands;
+    BENCHMARK("semitone_bands 8192")
+    {
+        math::semitone_bands(magnitudes, bands);
+        return bands.size();
+    };
+
+    math::c_constant_q constant_q;
+    auto frame = noise(constant_q.frame_size());
+    auto spectrum = math::fft(frame);
+    std::vector<float> bins(constant_q.bin_count());
+    BENCHMARK("constant-Q " + std::to_string(constant_q.bin_count()) + " bins")
+    {
+        constant_q.transform(spectrum, bins);
+        return bins.front();
+    };
+    BENCHMARK("constant-Q kernel build")
+    {
+        return math::c_constant_q{}.kernel_size();
+    };
+
+    math::c_filterbank filterbank({ .fft_size = 8192 });
+    std::vector<float> power(filterbank.spectrum_size());
+    std::ranges::transform(magnitudes | std::views::take(power.size()), power.begin(), [](float magnitude)
+                           { return magnitude * magnitude; });
+    std::vector<float> energies(filterbank.band_count());
+    BENCHMARK("mel filterbank " + std::to_string(filterbank.band_count()) + " bands")
+    {
+        filterbank.apply(power, energies);
+        return energies.front();
+    };
+
+    math::c_mfcc mfcc;
+    auto mfcc_spectrum = math::fft(noise(2048));
+    std::vector<float> coefficients(mfcc.coefficient_count());
+    BENCHMARK("MFCC " + std::to_string(mfcc.coefficient_count()) + " coefficients")
+    {
+        mfcc.compute(mfcc_spectrum, coefficients);
+        return coefficients.front();
+    };
+}
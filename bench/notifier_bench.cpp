@@ -0,0 +1,48 @@
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstddef>
+#include <string>
+#include <thread>
+#include <vector>
+
+import utility;
+
+TEST_CASE("Notifier throughput", "[benchmark][utility][notifier]")
+{
+    // GL objects subscribe before the context exists and run once it does; thousands are created per session
+    for (std::size_t callbacks : { 100U, 10000U })
+    {
+        BENCHMARK("subscribe and notify " + std::to_string(callbacks))
+        {
+            utility::c_notifier::reset();
+            std::size_t calls = 0;
+            for (std::size_t i = 0; i < callbacks; ++i)
+            {
+                utility::c_notifier::subscribe([&calls]()
+                                               { ++calls; });
+            }
+            utility::c_notifier::notify();
+            return calls;
+        };
+    }
+
+    BENCHMARK("subscribe from 4 threads, 2500 each")
+    {
+        utility::c_notifier::reset();
+        std::vector<std::jthread> threads;
+        for (int thread = 0; thread < 4; ++thread)
+        {
+            threads.emplace_back([]()
+                                 {
+                                     for (int i = 0; i < 2500; ++i)
+                                     {
+                                         utility::c_notifier::subscribe([]() {});
+                                     }
+                                 });
+        }
+        threads.clear();
+        utility::c_notifier::notify();
+    };
+    utility::c_notifier::reset();
+}
@@ -0,0 +1,374 @@
+module;
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+export module opengl:command_queue;
+
+export namespace opengl
+{
+    enum class e_command_kind : std::uint8_t
+    {
+        state,  // Cheap state changes (uniforms, attribute setup), never throttled
+        upload, // Resource creation and data transfers, throttled by the drain budget
+    };
+
+    /**
+     * @brief Linear allocator backing recorded commands.
+     *
+     * Memory is handed out from fixed-size blocks and is only reclaimed all at once by reset(), so recording a
+     * command is a pointer bump instead of a heap allocation. Blocks are kept between frames.
+     */
+    class c_command_arena
+    {
+    public:
+        c_command_arena() noexcept = default;
+
+        auto allocate(std::size_t size, std::size_t alignment) -> void *;
+        auto reset() noexcept -> void;
+
+        [[nodiscard]] auto bytes_used() const noexcept -> std::size_t;
+        [[nodiscard]] auto bytes_reserved() const noexcept -> std::size_t;
+
+    private:
+        struct s_block
+        {
+            std::unique_ptr<std::byte[]> data;
+            std::size_t capacity{};
+            std::size_t used{};
+        };
+
+        static constexpr std::size_t s_block_size = 64UL * 1024UL;
+
+        std::vector<s_block> m_blocks;
+        std::size_t m_current{};
+    };
+
+    struct s_command_record;
+
+    /**
+     * @brief Deferred GL command queue.
+     *
+     * Commands are any invocable objects (typed command structs or lambdas). They are stored by value in a linear
+     * arena, so no std::function is allocated per command. Commands are recorded and executed in submission order by
+     * drain() on the GL thread. State commands submitted on the GL thread run immediately when nothing is recorded
+     * ahead of them, so they can never overtake the queued creation of the object they use; commands submitted from
+     * within a command being executed run immediately as part of it.
+     *
+     * Upload commands are always recorded and throttled by the time budget given to drain(), so resource creation is
+     * spread over several frames instead of stalling the one that asked for it. Objects therefore exist only from a
+     * later drain() on; their users check for that before drawing. State commands are never throttled, but keep
+     * their order relative to uploads.
+     */
+    class c_command_queue
+    {
+    public:
+        c_command_queue() noexcept = default;
+        ~c_command_queue();
+
+        c_command_queue(const c_command_queue &) = delete;
+        c_command_queue(c_command_queue &&) = delete;
+        auto operator=(const c_command_queue &) -> c_command_queue & = delete;
+        auto operator=(c_command_queue &&) -> c_command_queue & = delete;
+
+        static auto instance() -> c_command_queue &;
+
+        /**
+         * @brief Execute the command now if runs_inline() allows it, otherwise record it.
+         */
+        template <std::invocable F>
+        auto submit(F &&command, e_command_kind kind = e_command_kind::state) -> void;
+
+        /**
+         * @brief Always record the command, even on the GL thread.
+         *
+         * Use this for expensive, self-contained uploads whose result is not needed in the current frame.
+         */
+        template <std::invocable F>
+        auto defer(F &&command, e_command_kind kind = e_command_kind::upload) -> void;
+
+        /**
+         * @brief Bind the queue to the calling thread, which must own the GL context. What was recorded so far is left
+         * to drain(), under its budget.
+         */
+        auto make_current() -> void;
+
+        /**
+         * @brief Execute recorded commands until the queue is empty or the upload budget is spent.
+         *
+         * At least one upload is executed per call so progress is always made.
+         *
+         * @param upload_budget Time allowed for upload commands in this call
+         * @return Number of commands executed
+         */
+        auto drain(std::chrono::microseconds upload_budget) -> std::size_t;
+
+        /**
+         * @brief Execute every recorded command regardless of budget.
+         */
+        auto flush() -> std::size_t;
+
+        /**
+         * @brief Drop all recorded commands without executing them and detach from the GL thread.
+         */
+        auto reset() -> void;
+
+        [[nodiscard]] auto is_gl_thread() const noexcept -> bool;
+        [[nodiscard]] auto pending() const -> std::size_t;
+
+        /**
+         * @brief Whether a command of this kind submitted now would run immediately instead of being recorded.
+         */
+        [[nodiscard]] auto runs_inline(e_command_kind kind) const -> bool;
+
+    private:
+        template <typename F>
+        auto record(F &&command, e_command_kind kind) -> void;
+        auto pop(bool uploads_allowed) -> s_command_record *;
+
+        mutable std::mutex m_mutex;
+        c_command_arena m_arena;
+        s_command_record *m_head{};
+        s_command_record *m_tail{};
+        std::size_t m_pending{};
+        std::size_t m_executing{}; // GL thread only, depth of commands being executed by drain()
+        std::atomic<std::thread::id> m_gl_thread;
+    };
+} // namespace opengl
+
+// Implementation
+namespace opengl
+{
+    struct s_command_record
+    {
+        auto (*invoke)(s_command_record *record, bool execute) -> void;
+        s_command_record *next;
+        e_command_kind kind;
+    };
+
+    template <typename F>
+    constexpr auto command_payload_offset() -> std::size_t
+    {
+        return (sizeof(s_command_record) + alignof(F) - 1) / alignof(F) * alignof(F);
+    }
+
+    template <typename F>
+    auto invoke_command_record(s_command_record *record, bool execute) -> void
+    {
+        auto *command = std::launder(reinterpret_cast<F *>(reinterpret_cast<std::byte *>(record) + command_payload_offset<F>()));
+        if (execute)
+        {
+            std::invoke(*command);
+        }
+        std::destroy_at(command);
+    }
+
+    auto c_command_arena::allocate(std::size_t size, std::size_t alignment) -> void *
+    {
+        for (; m_current < m_blocks.size(); ++m_current)
+        {
+            auto &block = m_blocks[m_current];
+            std::size_t aligned = (block.used + alignment - 1) / alignment * alignment;
+            if (aligned + size <= block.capacity)
+            {
+                block.used = aligned + size;
+                return block.data.get() + aligned;
+            }
+        }
+
+        // Oversized commands get a dedicated block
+        std::size_t capacity = std::max(s_block_size, size + alignment);
+        m_blocks.push_back({ .data = std::make_unique_for_overwrite<std::byte[]>(capacity), .capacity = capacity, .used = size });
+        m_current = m_blocks.size() - 1;
+        return m_blocks.back().data.get();
+    }
+
+    auto c_command_arena::reset() noexcept -> void
+    {
+        for (auto &block : m_blocks)
+        {
+            block.used = 0;
+        }
+        m_current = 0;
+    }
+
+    auto c_command_arena::bytes_used() const noexcept -> std::size_t
+    {
+        std::size_t total = 0;
+        for (const auto &block : m_blocks)
+        {
+            total += block.used;
+        }
+        return total;
+    }
+
+    auto c_command_arena::bytes_reserved() const noexcept -> std::size_t
+    {
+        std::size_t total = 0;
+        for (const auto &block : m_blocks)
+        {
+            total += block.capacity;
+        }
+        return total;
+    }
+
+    c_command_queue::~c_command_queue()
+    {
+        reset();
+    }
+
+    auto c_command_queue::instance() -> c_command_queue &
+    {
+        static c_command_queue instance;
+        return instance;
+    }
+
+    template <std::invocable F>
+    auto c_command_queue::submit(F &&command, e_command_kind kind) -> void
+    {
+        if (runs_inline(kind))
+        {
+            std::invoke(command);
+            return;
+        }
+        record(std::forward<F>(command), kind);
+    }
+
+    template <std::invocable F>
+    auto c_command_queue::defer(F &&command, e_command_kind kind) -> void
+    {
+        record(std::forward<F>(command), kind);
+    }
+
+    template <typename F>
+    auto c_command_queue::record(F &&command, e_command_kind kind) -> void
+    {
+        using command_type = std::remove_cvref_t<F>;
+        static_assert(alignof(command_type) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__, "Over-aligned commands are not supported");
+
+        constexpr std::size_t alignment = std::max(alignof(s_command_record), alignof(command_type));
+        constexpr std::size_t size = command_payload_offset<command_type>() + sizeof(command_type);
+
+        std::scoped_lock lock(m_mutex);
+        auto *storage = static_cast<std::byte *>(m_arena.allocate(size, alignment));
+        auto *record = ::new (storage) s_command_record{ .invoke = &invoke_command_record<command_type>, .next = nullptr, .kind = kind };
+        ::new (storage + command_payload_offset<command_type>()) command_type(std::forward<F>(command));
+
+        if (m_tail)
+        {
+            m_tail->next = record;
+        }
+        else
+        {
+            m_head = record;
+        }
+        m_tail = record;
+        ++m_pending;
+    }
+
+    auto c_command_queue::pop(bool uploads_allowed) -> s_command_record *
+    {
+        std::scoped_lock lock(m_mutex);
+        if (not m_head)
+        {
+            // Everything recorded so far has been executed and destroyed, the arena can be reused
+            m_arena.reset();
+            return nullptr;
+        }
+        if (m_head->kind == e_command_kind::upload and not uploads_allowed)
+        {
+            return nullptr;
+        }
+        auto *record = m_head;
+        m_head = record->next;
+        if (not m_head)
+        {
+            m_tail = nullptr;
+        }
+        --m_pending;
+        return record;
+    }
+
+    auto c_command_queue::make_current() -> void
+    {
+        m_gl_thread.store(std::this_thread::get_id(), std::memory_order_release);
+    }
+
+    auto c_command_queue::drain(std::chrono::microseconds upload_budget) -> std::size_t
+    {
+        using clock = std::chrono::steady_clock;
+
+        std::size_t executed = 0;
+        std::size_t uploads = 0;
+        clock::duration upload_time{};
+        while (auto *record = pop(uploads == 0 or std::chrono::duration_cast<std::chrono::microseconds>(upload_time) < upload_budget))
+        {
+            auto start = clock::now();
+            ++m_executing;
+            record->invoke(record, true);
+            --m_executing;
+            if (record->kind == e_command_kind::upload)
+            {
+                upload_time += clock::now() - start;
+                ++uploads;
+            }
+            ++executed;
+        }
+        return executed;
+    }
+
+    auto c_command_queue::flush() -> std::size_t
+    {
+        return drain(std::chrono::microseconds::max());
+    }
+
+    auto c_command_queue::reset() -> void
+    {
+        std::scoped_lock lock(m_mutex);
+        for (auto *record = m_head; record;)
+        {
+            auto *next = record->next;
+            record->invoke(record, false);
+            record = next;
+        }
+        m_head = nullptr;
+        m_tail = nullptr;
+        m_pending = 0;
+        m_arena.reset();
+        m_gl_thread.store(std::thread::id{}, std::memory_order_release);
+    }
+
+    auto c_command_queue::is_gl_thread() const noexcept -> bool
+    {
+        return m_gl_thread.load(std::memory_order_acquire) == std::this_thread::get_id();
+    }
+
+    auto c_command_queue::pending() const -> std::size_t
+    {
+        std::scoped_lock lock(m_mutex);
+        return m_pending;
+    }
+
+    auto c_command_queue::runs_inline(e_command_kind kind) const -> bool
+    {
+        if (not is_gl_thread())
+        {
+            return false;
+        }
+        if (m_executing > 0)
+        {
+            return true;
+        }
+        return kind == e_command_kind::state and pending() == 0;
+    }
+} // namespace opengl
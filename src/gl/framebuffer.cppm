@@ -0,0 +1,162 @@
+module;
+#include <GL/glew.h>
+
+#include <array>
+#include <iostream>
+#include <print>
+#include <utility>
+export module opengl:framebuffer;
+
+import :command_queue;
+import :state;
+import :texture;
+import :uniform_buffer;
+
+import glm;
+
+export namespace opengl
+{
+    /**
+     * @brief Off-screen render target with a single RGBA8 color attachment.
+     *
+     * Drawing between begin() and end() goes to the attached texture instead of the window. The texture holds
+     * premultiplied alpha, so it must be composited with glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA).
+     */
+    class c_framebuffer
+    {
+    public:
+        explicit c_framebuffer(glm::ivec2 size) noexcept;
+        ~c_framebuffer();
+
+        c_framebuffer(c_framebuffer &&other) noexcept;
+        auto operator=(c_framebuffer &&other) noexcept -> c_framebuffer &;
+
+        /**
+         * @brief Redirect drawing to this target, cleared to transparent.
+         *
+         * The pixel area starting at origin is mapped onto the target, so callers keep drawing in window coordinates.
+         * The previous view is restored by end(). Passes do not nest.
+         */
+        auto begin(glm::vec2 origin) -> void;
+        auto end() -> void;
+
+        /**
+         * @brief Whether the GL objects exist yet; creation is deferred through the command queue.
+         */
+        [[nodiscard]] auto is_ready() const -> bool;
+        [[nodiscard]] auto texture() const -> const c_texture &;
+        [[nodiscard]] auto size() const -> glm::ivec2;
+
+    private:
+        unsigned int m_fbo_id{};
+        c_texture m_color;
+        glm::ivec2 m_size;
+
+        // View of the previous target, restored by end()
+        glm::vec2 m_previous_origin{};
+        glm::vec2 m_previous_size{};
+
+        auto destroy() -> void;
+    };
+} // namespace opengl
+
+// Implementation
+namespace opengl
+{
+    c_framebuffer::c_framebuffer(glm::ivec2 size) noexcept
+        : m_color(e_texture_target::texture_2d, GL_RGBA8, size, GL_NEAREST),
+          m_size(size)
+    {
+        // Submitted after the texture, so the attachment already exists when this runs
+        auto init = [this]()
+        {
+            glGenFramebuffers(1, &m_fbo_id);
+            c_gl_state::instance().bind_framebuffer(m_fbo_id);
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_color.id(), 0);
+            if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            {
+                std::println(std::cerr, "Warning: incomplete framebuffer of size {}x{}", m_size.x, m_size.y);
+            }
+            c_gl_state::instance().bind_framebuffer(0);
+        };
+        c_command_queue::instance().submit(std::move(init), e_command_kind::upload);
+    }
+
+    c_framebuffer::~c_framebuffer()
+    {
+        destroy();
+    }
+
+    c_framebuffer::c_framebuffer(c_framebuffer &&other) noexcept
+        : m_fbo_id(std::exchange(other.m_fbo_id, 0)),
+          m_color(std::move(other.m_color)),
+          m_size(other.m_size)
+    {
+    }
+
+    auto c_framebuffer::operator=(c_framebuffer &&other) noexcept -> c_framebuffer &
+    {
+        if (this != &other)
+        {
+            destroy();
+            m_fbo_id = std::exchange(other.m_fbo_id, 0);
+            m_color = std::move(other.m_color);
+            m_size = other.m_size;
+        }
+        return *this;
+    }
+
+    auto c_framebuffer::destroy() -> void
+    {
+        if (m_fbo_id)
+        {
+            c_gl_state::instance().on_framebuffer_deleted(m_fbo_id);
+            glDeleteFramebuffers(1, &m_fbo_id);
+            m_fbo_id = 0;
+        }
+    }
+
+    auto c_framebuffer::begin(glm::vec2 origin) -> void
+    {
+        auto &frame = c_frame_uniforms::instance();
+        m_previous_origin = frame.view_origin();
+        m_previous_size = frame.view_size();
+
+        auto &state = c_gl_state::instance();
+        state.bind_framebuffer(m_fbo_id);
+        state.viewport(0, 0, m_size.x, m_size.y);
+        frame.set_view(origin, glm::vec2(m_size));
+
+        // Scissor state of the previous target is in its own coordinates
+        state.set_scissor(false);
+        const std::array<float, 4> transparent = { 0.F, 0.F, 0.F, 0.F };
+        glClearBufferfv(GL_COLOR, 0, transparent.data());
+
+        // Accumulate alpha as coverage so the result is premultiplied
+        state.blend_func_separate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    }
+
+    auto c_framebuffer::end() -> void
+    {
+        auto &state = c_gl_state::instance();
+        state.bind_framebuffer(0);
+        state.viewport(0, 0, static_cast<int>(m_previous_size.x), static_cast<int>(m_previous_size.y));
+        state.blend_func(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        c_frame_uniforms::instance().set_view(m_previous_origin, m_previous_size);
+    }
+
+    auto c_framebuffer::is_ready() const -> bool
+    {
+        return m_fbo_id != 0 and m_color.id() != 0;
+    }
+
+    auto c_framebuffer::texture() const -> const c_texture &
+    {
+        return m_color;
+    }
+
+    auto c_framebuffer::size() const -> glm::ivec2
+    {
+        return m_size;
+    }
+} // namespace opengl
@@ -5,7 +5,8 @@ module;
 #include <vector>
 export module opengl:index_buffer;
 
-import utility;
+import :command_queue;
+import :state;
 
 export namespace opengl
 {
@@ -44,7 +45,7 @@ namespace opengl
             glGenBuffers(1, &m_ibo_id);
             if (m_count > 0)
             {
-                glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ibo_id);
+                c_gl_state::instance().bind_buffer(GL_ELEMENT_ARRAY_BUFFER, m_ibo_id);
                 if (data.empty())
                 {
                     glBufferData(GL_ELEMENT_ARRAY_BUFFER, m_count * sizeof(unsigned int), nullptr, m_usage);
@@ -52,14 +53,16 @@ namespace opengl
                 else
                 {
                     glBufferData(GL_ELEMENT_ARRAY_BUFFER, m_count * sizeof(unsigned int), data.data(), m_usage);
+                    c_gl_state::instance().count_upload(m_count * sizeof(unsigned int));
                 }
             }
         };
-        utility::c_notifier::subscribe(init);
+        c_command_queue::instance().submit(std::move(init), e_command_kind::upload);
     }
 
     c_index_buffer::~c_index_buffer()
     {
+        c_gl_state::instance().on_buffer_deleted(m_ibo_id);
         glDeleteBuffers(1, &m_ibo_id);
     }
 
@@ -74,6 +77,7 @@ namespace opengl
     {
         if (this != &other)
         {
+            c_gl_state::instance().on_buffer_deleted(m_ibo_id);
             glDeleteBuffers(1, &m_ibo_id);
             m_ibo_id = std::exchange(other.m_ibo_id, 0);
             m_count = std::exchange(other.m_count, 0);
@@ -91,17 +95,18 @@ namespace opengl
     {
         bind();
         glBufferData(GL_ELEMENT_ARRAY_BUFFER, count * sizeof(unsigned int), data.data(), GL_STATIC_DRAW);
+        c_gl_state::instance().count_upload(count * sizeof(unsigned int));
         m_count = count;
         unbind();
     }
 
     auto c_index_buffer::bind() const -> void
     {
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ibo_id);
+        c_gl_state::instance().bind_buffer(GL_ELEMENT_ARRAY_BUFFER, m_ibo_id);
     }
 
     auto c_index_buffer::unbind() -> void
     {
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+        c_gl_state::instance().bind_buffer(GL_ELEMENT_ARRAY_BUFFER, 0);
     }
 } // namespace opengl
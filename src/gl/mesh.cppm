@@ -10,7 +10,7 @@ import :vertex_array;
 import :buffer_layout;
 import :shader;
 import :renderer;
-import utility;
+import :command_queue;
 import glm;
 
 export namespace opengl
@@ -70,7 +70,7 @@ namespace opengl
 
             m_vertex_array.add_buffer(m_vertex_buffer, m_layout);
         };
-        utility::c_notifier::subscribe(init);
+        c_command_queue::instance().submit(std::move(init));
     }
 
     c_mesh::c_mesh(c_mesh &&other) noexcept
@@ -2,10 +2,16 @@ module;
 
 export module opengl;
 
+export import :command_queue;
+export import :state;
+export import :uniform_buffer;
+export import :texture;
+export import :framebuffer;
 export import :renderer;
 export import :vertex_buffer;
 export import :index_buffer;
 export import :vertex_array;
+export import :streaming_buffer;
 export import :buffer_layout;
 export import :shader;
 export import :error;
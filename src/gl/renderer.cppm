@@ -1,6 +1,7 @@
 module;
 #include <GL/glew.h>
 
+#include <cstddef>
 #include <cstdint>
 export module opengl:renderer;
 
@@ -8,6 +9,8 @@ import :shader;
 import :vertex_array;
 import :index_buffer;
 import :vertex_buffer;
+import :state;
+import :uniform_buffer;
 
 import glm;
 
@@ -34,10 +37,41 @@ export namespace opengl
             const c_index_buffer &ibuff,
             const c_shader &shader,
             e_render_primitive primitive = e_render_primitive::triangles) const -> void;
+        auto draw_arrays(
+            const c_vertex_array &varr,
+            const c_shader &shader,
+            e_render_primitive primitive,
+            std::size_t first,
+            std::size_t count) const -> void;
+
+        /**
+         * @brief Draw count vertices once per instance. The vertex shader generates its geometry from gl_VertexID and
+         * gl_InstanceID, so the vertex array can be empty.
+         */
+        auto draw_instanced(
+            const c_vertex_array &varr,
+            const c_shader &shader,
+            e_render_primitive primitive,
+            std::size_t count,
+            std::size_t instances) const -> void;
+
+        /**
+         * @brief Mark the start of a new frame. Per-frame resources (streaming buffers) advance their ring on the next
+         * use, and the GL state counters of the previous frame are published.
+         */
+        static auto begin_frame() -> void;
+        [[nodiscard]] static auto frame_index() -> std::uint64_t;
+
+        /**
+         * @brief Clip drawing to an area given in the coordinates of the current view.
+         */
         static auto set_scissor_area(glm::vec2 position, glm::vec2 size) -> void;
         static auto reset_scissor_area() -> void;
         static auto clear() -> void;
         static auto clear_color(float red, float green, float blue, float alpha = 1.0F) -> void;
+
+    private:
+        inline static std::uint64_t s_frame_index{};
     };
 } // namespace opengl
 
@@ -52,23 +86,78 @@ namespace opengl
         const c_shader &shader,
         e_render_primitive primitive) const -> void
     {
+        if (not varr.is_ready() or not shader.is_ready())
+        {
+            return;
+        }
         shader.bind();
         varr.bind();
         vbuff.bind();
         ibuff.bind();
 
         glDrawElements(static_cast<GLenum>(primitive), static_cast<int>(ibuff.get_count()), GL_UNSIGNED_INT, nullptr);
+        c_gl_state::instance().count_draw_call();
+    }
+
+    auto c_renderer::draw_arrays(
+        const c_vertex_array &varr,
+        const c_shader &shader,
+        e_render_primitive primitive,
+        std::size_t first,
+        std::size_t count) const -> void
+    {
+        if (not varr.is_ready() or not shader.is_ready())
+        {
+            return;
+        }
+        shader.bind();
+        varr.bind();
+
+        glDrawArrays(static_cast<GLenum>(primitive), static_cast<GLint>(first), static_cast<GLsizei>(count));
+        c_gl_state::instance().count_draw_call();
+    }
+
+    auto c_renderer::draw_instanced(
+        const c_vertex_array &varr,
+        const c_shader &shader,
+        e_render_primitive primitive,
+        std::size_t count,
+        std::size_t instances) const -> void
+    {
+        if (not varr.is_ready() or not shader.is_ready())
+        {
+            return;
+        }
+        shader.bind();
+        varr.bind();
+
+        glDrawArraysInstanced(static_cast<GLenum>(primitive), 0, static_cast<GLsizei>(count), static_cast<GLsizei>(instances));
+        c_gl_state::instance().count_draw_call();
+    }
+
+    auto c_renderer::begin_frame() -> void
+    {
+        ++s_frame_index;
+        c_gl_state::instance().begin_frame();
+    }
+
+    auto c_renderer::frame_index() -> std::uint64_t
+    {
+        return s_frame_index;
     }
 
     auto c_renderer::set_scissor_area(glm::vec2 position, glm::vec2 size) -> void
     {
-        glEnable(GL_SCISSOR_TEST);
-        glScissor(static_cast<GLint>(position.x), static_cast<GLint>(position.y), static_cast<GLsizei>(size.x), static_cast<GLsizei>(size.y));
+        // glScissor works in pixels of the render target, which start at the view origin
+        auto target_position = position - c_frame_uniforms::instance().view_origin();
+        auto &state = c_gl_state::instance();
+        state.set_scissor(true);
+        state.scissor(static_cast<int>(target_position.x), static_cast<int>(target_position.y), static_cast<int>(size.x), static_cast<int>(size.y));
     }
 
     auto c_renderer::reset_scissor_area() -> void
     {
-        glDisable(GL_SCISSOR_TEST);
+        c_gl_state::instance().set_scissor(false);
     }
 
     auto c_renderer::clear() -> void
@@ -1,18 +1,22 @@
 module;
 #include <GL/glew.h>
 
+#include <algorithm>
 #include <array>
+#include <cstddef>
 #include <filesystem>
 #include <fstream>
 #include <iostream>
 #include <print>
 #include <sstream>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <utility>
 export module opengl:shader;
 
-import utility;
+import :command_queue;
+import :state;
 import glm;
 
 namespace
@@ -130,6 +134,11 @@ export namespace opengl
         auto bind() const -> void;
         auto unbind() const -> void;
 
+        /**
+         * @brief Whether the program has been linked yet; creation is deferred through the command queue.
+         */
+        [[nodiscard]] auto is_ready() const -> bool;
+
         auto set_uniform_1f(const std::string &name, float value) -> void;
         auto set_uniform_1i(const std::string &name, int value) -> void;
         auto set_uniform_1ui(const std::string &name, unsigned int value) -> void;
@@ -143,10 +152,47 @@ export namespace opengl
         auto set_uniform_mat4f(const std::string &name, const glm::mat4 &value) -> void;
 
     private:
+        template <typename T>
+        struct s_uniform_array
+        {
+            const T *data;
+            int count;
+        };
+
+        /**
+         * @brief Typed uniform update recorded by the command queue when it cannot run inline.
+         */
+        template <typename T>
+        struct s_uniform_command
+        {
+            static constexpr std::size_t max_name_length = 64;
+
+            s_uniform_command(c_shader &shader, std::string_view uniform_name, const T &uniform_value);
+            auto operator()() const -> void;
+
+            c_shader *target;
+            std::array<char, max_name_length> name{};
+            std::size_t name_length;
+            T value;
+        };
+
         unsigned int m_shader_id{};
         std::unordered_map<std::string, int> m_uniform_location_cache;
 
         [[nodiscard]] auto get_uniform_location(const std::string &name) -> int;
+
+        template <typename T>
+        auto set_uniform(const std::string &name, const T &value) -> void;
+
+        auto upload_uniform(int location, float value) const -> void;
+        auto upload_uniform(int location, int value) const -> void;
+        auto upload_uniform(int location, unsigned int value) const -> void;
+        auto upload_uniform(int location, s_uniform_array<float> value) const -> void;
+        auto upload_uniform(int location, s_uniform_array<int> value) const -> void;
+        auto upload_uniform(int location, const glm::vec2 &value) const -> void;
+        auto upload_uniform(int location, const glm::vec3 &value) const -> void;
+        auto upload_uniform(int location, const glm::vec4 &value) const -> void;
+        auto upload_uniform(int location, const glm::mat4 &value) const -> void;
     };
 } // namespace opengl
 
@@ -160,11 +206,12 @@ namespace opengl
             s_shader_program_source source = parse_file(path);
             m_shader_id = create_shader(source.vertex_source, source.fragment_source);
         };
-        utility::c_notifier::subscribe(init);
+        c_command_queue::instance().submit(std::move(init), e_command_kind::upload);
     }
 
     c_shader::~c_shader()
     {
+        c_gl_state::instance().on_program_deleted(m_shader_id);
         glDeleteProgram(m_shader_id);
     }
 
@@ -178,6 +225,7 @@ namespace opengl
     {
         if (this != &other)
         {
+            c_gl_state::instance().on_program_deleted(m_shader_id);
             glDeleteProgram(m_shader_id);
             m_shader_id = std::exchange(other.m_shader_id, 0);
             m_uniform_location_cache = std::move(other.m_uniform_location_cache);
@@ -187,12 +235,17 @@ namespace opengl
 
     auto c_shader::bind() const -> void
     {
-        glUseProgram(m_shader_id);
+        c_gl_state::instance().use_program(m_shader_id);
     }
 
     auto c_shader::unbind() const -> void
     {
-        glUseProgram(0);
+        c_gl_state::instance().use_program(0);
+    }
+
+    auto c_shader::is_ready() const -> bool
+    {
+        return m_shader_id != 0;
     }
 
     auto c_shader::get_uniform_location(const std::string &name) -> int
@@ -210,102 +263,126 @@ namespace opengl
         return location;
     }
 
-    auto c_shader::set_uniform_1f(const std::string &name, float value) -> void
+    template <typename T>
+    auto c_shader::set_uniform(const std::string &name, const T &value) -> void
     {
-        auto init = [this, &name, value]
+        auto &queue = c_command_queue::instance();
+        // Recorded while the program's creation, or anything else, is still queued ahead of this update
+        if (queue.runs_inline(e_command_kind::state))
         {
-            bind();
-            glUniform1f(get_uniform_location(name), value);
-            unbind();
-        };
-        utility::c_notifier::subscribe(init);
+            upload_uniform(get_uniform_location(name), value);
+            return;
+        }
+        if (name.size() >= s_uniform_command<T>::max_name_length)
+        {
+            std::println(std::cerr, "Warning: uniform name '{}' is too long to be recorded", name);
+            return;
+        }
+        queue.submit(s_uniform_command<T>(*this, name, value));
+    }
+
+    template <typename T>
+    c_shader::s_uniform_command<T>::s_uniform_command(c_shader &shader, std::string_view uniform_name, const T &uniform_value)
+        : target(&shader),
+          name_length(uniform_name.size()),
+          value(uniform_value)
+    {
+        std::ranges::copy(uniform_name, name.begin());
+    }
+
+    template <typename T>
+    auto c_shader::s_uniform_command<T>::operator()() const -> void
+    {
+        target->upload_uniform(target->get_uniform_location(std::string(name.data(), name_length)), value);
+    }
+
+    auto c_shader::upload_uniform(int location, float value) const -> void
+    {
+        glProgramUniform1f(m_shader_id, location, value);
+    }
+
+    auto c_shader::upload_uniform(int location, int value) const -> void
+    {
+        glProgramUniform1i(m_shader_id, location, value);
+    }
+
+    auto c_shader::upload_uniform(int location, unsigned int value) const -> void
+    {
+        glProgramUniform1ui(m_shader_id, location, value);
+    }
+
+    auto c_shader::upload_uniform(int location, s_uniform_array<float> value) const -> void
+    {
+        glProgramUniform1fv(m_shader_id, location, value.count, value.data);
+    }
+
+    auto c_shader::upload_uniform(int location, s_uniform_array<int> value) const -> void
+    {
+        glProgramUniform1iv(m_shader_id, location, value.count, value.data);
+    }
+
+    auto c_shader::upload_uniform(int location, const glm::vec2 &value) const -> void
+    {
+        glProgramUniform2f(m_shader_id, location, value.x, value.y);
+    }
+
+    auto c_shader::upload_uniform(int location, const glm::vec3 &value) const -> void
+    {
+        glProgramUniform3f(m_shader_id, location, value.x, value.y, value.z);
+    }
+
+    auto c_shader::upload_uniform(int location, const glm::vec4 &value) const -> void
+    {
+        glProgramUniform4f(m_shader_id, location, value.x, value.y, value.z, value.w);
+    }
+
+    auto c_shader::upload_uniform(int location, const glm::mat4 &value) const -> void
+    {
+        glProgramUniformMatrix4fv(m_shader_id, location, 1, GL_FALSE, glm::gtc::value_ptr(value));
+    }
+
+    auto c_shader::set_uniform_1f(const std::string &name, float value) -> void
+    {
+        set_uniform(name, value);
     }
 
     auto c_shader::set_uniform_1i(const std::string &name, int value) -> void
     {
-        auto init = [this, &name, value]
-        {
-            bind();
-            glUniform1i(get_uniform_location(name), value);
-            unbind();
-        };
-        utility::c_notifier::subscribe(init);
+        set_uniform(name, value);
     }
 
     auto c_shader::set_uniform_1ui(const std::string &name, unsigned int value) -> void
     {
-        auto init = [this, &name, value]
-        {
-            bind();
-            glUniform1ui(get_uniform_location(name), value);
-            unbind();
-        };
-        utility::c_notifier::subscribe(init);
+        set_uniform(name, value);
     }
 
     auto c_shader::set_uniform_1fv(const std::string &name, const float *value, int count) -> void
     {
-        auto init = [this, &name, value, count]
-        {
-            bind();
-            glUniform1fv(get_uniform_location(name), count, value);
-            unbind();
-        };
-        utility::c_notifier::subscribe(init);
+        set_uniform(name, s_uniform_array<float>{ .data = value, .count = count });
     }
 
     auto c_shader::set_uniform_1iv(const std::string &name, const int *value, int count) -> void
     {
-        auto init = [this, &name, value, count]
-        {
-            bind();
-            glUniform1iv(get_uniform_location(name), count, value);
-            unbind();
-        };
-        utility::c_notifier::subscribe(init);
+        set_uniform(name, s_uniform_array<int>{ .data = value, .count = count });
     }
 
     auto c_shader::set_uniform_2f(const std::string &name, const glm::vec2 &value) -> void
     {
-        auto init = [this, &name, value]
-        {
-            bind();
-            glUniform2f(get_uniform_location(name), value.x, value.y);
-            unbind();
-        };
-        utility::c_notifier::subscribe(init);
+        set_uniform(name, value);
     }
 
     auto c_shader::set_uniform_3f(const std::string &name, const glm::vec3 &value) -> void
     {
-        auto init = [this, &name, value]
-        {
-            bind();
-            glUniform3f(get_uniform_location(name), value.x, value.y, value.z);
-            unbind();
-        };
-        utility::c_notifier::subscribe(init);
+        set_uniform(name, value);
     }
 
     auto c_shader::set_uniform_4f(const std::string &name, const glm::vec4 &value) -> void
     {
-        auto init = [this, &name, value]
-        {
-            bind();
-            glUniform4f(get_uniform_location(name), value.x, value.y, value.z, value.w);
-            unbind();
-        };
-        utility::c_notifier::subscribe(init);
+        set_uniform(name, value);
     }
 
     auto c_shader::set_uniform_mat4f(const std::string &name, const glm::mat4 &value) -> void
     {
-        auto init = [this, &name, value]
-        {
-            bind();
-            glUniformMatrix4fv(get_uniform_location(name), 1, GL_FALSE, glm::gtc::value_ptr(value));
-            unbind();
-        };
-        utility::c_notifier::subscribe(init);
+        set_uniform(name, value);
     }
 } // namespace opengl
@@ -1,12 +1,15 @@
 module;
 #include <GL/glew.h>
 
+#include <algorithm>
 #include <array>
 #include <cmath>
 #include <cstddef>
+#include <cstdint>
 #include <numbers>
 #include <numeric>
 #include <ranges>
+#include <span>
 #include <variant>
 #include <vector>
 export module opengl:shapes;
@@ -14,6 +17,10 @@ export module opengl:shapes;
 import :mesh;
 import :shader;
 import :renderer;
+import :command_queue;
+import :streaming_buffer;
+import :vertex_array;
+import :buffer_layout;
 
 import glm;
 
@@ -27,7 +34,7 @@ export namespace opengl::shapes
         c_rectangle(glm::vec2 position, glm::vec2 size, glm::vec4 color);
         c_rectangle(c_rectangle &&other) noexcept = default;
         auto operator=(c_rectangle &&other) noexcept -> c_rectangle & = default;
-        auto draw(const c_renderer &renderer, const glm::mat4 &projection) const -> void;
+        auto draw(const c_renderer &renderer) const -> void;
     };
 
     class c_circle
@@ -38,7 +45,7 @@ export namespace opengl::shapes
         c_circle(glm::vec2 position, float radius, glm::vec4 color);
         c_circle(c_circle &&other) noexcept = default;
         auto operator=(c_circle &&other) noexcept -> c_circle & = default;
-        auto draw(const c_renderer &renderer, const glm::mat4 &projection) const -> void;
+        auto draw(const c_renderer &renderer) const -> void;
     };
 
     class c_triangle
@@ -49,7 +56,7 @@ export namespace opengl::shapes
         c_triangle(glm::vec2 point1, glm::vec2 point2, glm::vec2 point3, glm::vec4 color);
         c_triangle(c_triangle &&other) noexcept = default;
         auto operator=(c_triangle &&other) noexcept -> c_triangle & = default;
-        auto draw(const c_renderer &renderer, const glm::mat4 &projection) const -> void;
+        auto draw(const c_renderer &renderer) const -> void;
     };
 
     class c_line
@@ -60,7 +67,7 @@ export namespace opengl::shapes
         c_line(glm::vec2 start, glm::vec2 end, glm::vec4 color);
         c_line(c_line &&other) noexcept = default;
         auto operator=(c_line &&other) noexcept -> c_line & = default;
-        auto draw(const c_renderer &renderer, const glm::mat4 &projection) const -> void;
+        auto draw(const c_renderer &renderer) const -> void;
     };
 
     class c_ring
@@ -72,7 +79,7 @@ export namespace opengl::shapes
         c_ring(glm::vec2 position, float radius, float thickness, glm::vec4 color);
         c_ring(c_ring &&other) noexcept = default;
         auto operator=(c_ring &&other) noexcept -> c_ring & = default;
-        auto draw(const c_renderer &renderer, const glm::mat4 &projection) const -> void;
+        auto draw(const c_renderer &renderer) const -> void;
     };
 
     class c_rounded_rectangle
@@ -84,10 +91,49 @@ export namespace opengl::shapes
         c_rounded_rectangle(glm::vec2 position, glm::vec2 size, float radius, glm::vec4 color);
         c_rounded_rectangle(c_rounded_rectangle &&other) noexcept = default;
         auto operator=(c_rounded_rectangle &&other) noexcept -> c_rounded_rectangle & = default;
-        auto draw(const c_renderer &renderer, const glm::mat4 &projection) const -> void;
+        auto draw(const c_renderer &renderer) const -> void;
     };
 
     using variant = std::variant<c_rectangle, c_circle, c_triangle, c_line, c_rounded_rectangle>;
+
+    /**
+     * @brief Immediate-mode batch for shapes that are rebuilt every frame.
+     *
+     * Shapes are appended as plain triangles to a CPU-side list, which draw() copies into a streaming buffer and
+     * renders with a single draw call. Unlike the shape classes above, no GL objects are created per shape.
+     */
+    class c_batch
+    {
+    public:
+        explicit c_batch(std::size_t vertex_capacity = 4096);
+
+        auto add_rectangle(glm::vec2 position, glm::vec2 size, glm::vec4 color) -> void;
+        auto add_circle(glm::vec2 center, float radius, glm::vec4 color) -> void;
+        auto add_triangle(glm::vec2 point1, glm::vec2 point2, glm::vec2 point3, glm::vec4 color) -> void;
+        auto add_line(glm::vec2 start, glm::vec2 end, glm::vec4 color, float width = 1.0F) -> void;
+
+        /**
+         * @brief Append triangles recorded earlier (see vertices()), translated by offset.
+         */
+        auto append(std::span<const s_vertex> vertices, glm::vec2 offset = {}) -> void;
+
+        auto clear() -> void;
+        [[nodiscard]] auto empty() const -> bool;
+        [[nodiscard]] auto vertex_count() const -> std::size_t;
+        [[nodiscard]] auto vertices() const -> std::span<const s_vertex>;
+
+        /**
+         * @brief Upload the batched vertices and draw them. The batch keeps its contents until clear().
+         */
+        auto draw(const c_renderer &renderer) -> void;
+
+    private:
+        std::vector<s_vertex> m_vertices;
+        c_streaming_buffer<s_vertex> m_stream;
+        c_vertex_array m_vertex_array;
+        c_buffer_layout m_layout;
+        std::uint32_t m_attached_generation{};
+    };
 } // namespace opengl::shapes
 
 // Implementation
@@ -116,14 +162,13 @@ namespace opengl::shapes
             2, 3, 0  // Second triangle
         };
 
-        utility::c_notifier::subscribe([this, vertices = std::move(vertices), indices = std::move(indices)] mutable
-                                       { m_mesh.update_mesh(std::move(vertices), std::move(indices)); });
+        c_command_queue::instance().submit([this, vertices = std::move(vertices), indices = std::move(indices)] mutable
+                                           { m_mesh.update_mesh(std::move(vertices), std::move(indices)); },
+                                           e_command_kind::upload);
     }
 
-    auto c_rectangle::draw(const c_renderer &renderer, const glm::mat4 &projection) const -> void
+    auto c_rectangle::draw(const c_renderer &renderer) const -> void
     {
-        shape_shader().set_uniform_mat4f("projection", projection);
-
         m_mesh.draw(renderer, shape_shader());
     }
 
@@ -149,14 +194,13 @@ namespace opengl::shapes
         }
         vertices[segments + 1] = vertices[1]; // Close the circle
 
-        utility::c_notifier::subscribe([this, vertices = std::move(vertices), indices = std::move(indices)] mutable
-                                       { m_mesh.update_mesh(std::move(vertices), std::move(indices)); });
+        c_command_queue::instance().submit([this, vertices = std::move(vertices), indices = std::move(indices)] mutable
+                                           { m_mesh.update_mesh(std::move(vertices), std::move(indices)); },
+                                           e_command_kind::upload);
     }
 
-    auto c_circle::draw(const c_renderer &renderer, const glm::mat4 &projection) const -> void
+    auto c_circle::draw(const c_renderer &renderer) const -> void
     {
-        shape_shader().set_uniform_mat4f("projection", projection);
-
         m_mesh.draw(renderer, shape_shader());
     }
 
@@ -170,14 +214,13 @@ namespace opengl::shapes
 
         std::vector<unsigned int> indices = { 0, 1, 2 };
 
-        utility::c_notifier::subscribe([this, vertices = std::move(vertices), indices = std::move(indices)] mutable
-                                       { m_mesh.update_mesh(std::move(vertices), std::move(indices)); });
+        c_command_queue::instance().submit([this, vertices = std::move(vertices), indices = std::move(indices)] mutable
+                                           { m_mesh.update_mesh(std::move(vertices), std::move(indices)); },
+                                           e_command_kind::upload);
     }
 
-    auto c_triangle::draw(const c_renderer &renderer, const glm::mat4 &projection) const -> void
+    auto c_triangle::draw(const c_renderer &renderer) const -> void
     {
-        shape_shader().set_uniform_mat4f("projection", projection);
-
         m_mesh.draw(renderer, shape_shader());
     }
 
@@ -190,14 +233,13 @@ namespace opengl::shapes
 
         std::vector<unsigned int> indices = { 0, 1 };
 
-        utility::c_notifier::subscribe([this, vertices = std::move(vertices), indices = std::move(indices)] mutable
-                                       { m_mesh.update_mesh(std::move(vertices), std::move(indices)); });
+        c_command_queue::instance().submit([this, vertices = std::move(vertices), indices = std::move(indices)] mutable
+                                           { m_mesh.update_mesh(std::move(vertices), std::move(indices)); },
+                                           e_command_kind::upload);
     }
 
-    auto c_line::draw(const c_renderer &renderer, const glm::mat4 &projection) const -> void
+    auto c_line::draw(const c_renderer &renderer) const -> void
     {
-        shape_shader().set_uniform_mat4f("projection", projection);
-
         m_mesh.draw(renderer, shape_shader());
     }
 
@@ -259,8 +301,9 @@ namespace opengl::shapes
         indices.resize(vertices.size());
         std::ranges::iota(indices, 0U);
 
-        utility::c_notifier::subscribe([this, vertices = std::move(vertices), indices = std::move(indices)] mutable
-                                       { m_mesh.update_mesh(std::move(vertices), std::move(indices)); });
+        c_command_queue::instance().submit([this, vertices = std::move(vertices), indices = std::move(indices)] mutable
+                                           { m_mesh.update_mesh(std::move(vertices), std::move(indices)); },
+                                           e_command_kind::upload);
     }
 
     c_rounded_rectangle::c_rounded_rectangle(glm::vec2 position, glm::vec2 size, float radius, glm::vec4 color)
@@ -268,9 +311,8 @@ namespace opengl::shapes
     {
     }
 
-    auto c_rounded_rectangle::draw(const c_renderer &renderer, const glm::mat4 &projection) const -> void
+    auto c_rounded_rectangle::draw(const c_renderer &renderer) const -> void
     {
-        shape_shader().set_uniform_mat4f("projection", projection);
         m_mesh.draw(renderer, shape_shader());
     }
 
@@ -306,8 +348,9 @@ namespace opengl::shapes
         indices.resize(vertices.size());
         std::ranges::iota(indices, 0U);
 
-        utility::c_notifier::subscribe([this, vertices = std::move(vertices), indices = std::move(indices)] mutable
-                                       { m_mesh.update_mesh(std::move(vertices), std::move(indices)); });
+        c_command_queue::instance().submit([this, vertices = std::move(vertices), indices = std::move(indices)] mutable
+                                           { m_mesh.update_mesh(std::move(vertices), std::move(indices)); },
+                                           e_command_kind::upload);
     }
 
     c_ring::c_ring(glm::vec2 position, float radius, float thickness, glm::vec4 color)
@@ -315,10 +358,130 @@ namespace opengl::shapes
     {
     }
 
-    auto c_ring::draw(const c_renderer &renderer, const glm::mat4 &projection) const -> void
+    auto c_ring::draw(const c_renderer &renderer) const -> void
     {
-        shape_shader().set_uniform_mat4f("projection", projection);
-
         m_mesh.draw(renderer, shape_shader());
     }
+
+    c_batch::c_batch(std::size_t vertex_capacity)
+        : m_stream(vertex_capacity)
+    {
+        m_vertices.reserve(vertex_capacity);
+        m_layout.push<float>(3); // Position
+        m_layout.push<float>(4); // Color
+    }
+
+    auto c_batch::add_rectangle(glm::vec2 position, glm::vec2 size, glm::vec4 color) -> void
+    {
+        const glm::vec3 bottom_left = { position.x, position.y, 0.0F };
+        const glm::vec3 bottom_right = { position.x + size.x, position.y, 0.0F };
+        const glm::vec3 top_right = { position.x + size.x, position.y + size.y, 0.0F };
+        const glm::vec3 top_left = { position.x, position.y + size.y, 0.0F };
+
+        m_vertices.push_back({ .position = bottom_left, .color = color });
+        m_vertices.push_back({ .position = bottom_right, .color = color });
+        m_vertices.push_back({ .position = top_right, .color = color });
+        m_vertices.push_back({ .position = top_right, .color = color });
+        m_vertices.push_back({ .position = top_left, .color = color });
+        m_vertices.push_back({ .position = bottom_left, .color = color });
+    }
+
+    auto c_batch::add_circle(glm::vec2 center, float radius, glm::vec4 color) -> void
+    {
+        // Small circles don't need the full 32 segments used by c_circle
+        const int segments = std::clamp(static_cast<int>(radius), 12, 32);
+        const float step = 2.0F * std::numbers::pi_v<float> / static_cast<float>(segments);
+
+        glm::vec3 previous = { center.x + radius, center.y, 0.0F };
+        for (int i = 1; i <= segments; ++i)
+        {
+            float angle = step * static_cast<float>(i);
+            glm::vec3 current = { center.x + (radius * std::cos(angle)), center.y + (radius * std::sin(angle)), 0.0F };
+            m_vertices.push_back({ .position = { center.x, center.y, 0.0F }, .color = color });
+            m_vertices.push_back({ .position = previous, .color = color });
+            m_vertices.push_back({ .position = current, .color = color });
+            previous = current;
+        }
+    }
+
+    auto c_batch::add_triangle(glm::vec2 point1, glm::vec2 point2, glm::vec2 point3, glm::vec4 color) -> void
+    {
+        m_vertices.push_back({ .position = { point1.x, point1.y, 0.0F }, .color = color });
+        m_vertices.push_back({ .position = { point2.x, point2.y, 0.0F }, .color = color });
+        m_vertices.push_back({ .position = { point3.x, point3.y, 0.0F }, .color = color });
+    }
+
+    auto c_batch::add_line(glm::vec2 start, glm::vec2 end, glm::vec4 color, float width) -> void
+    {
+        glm::vec2 direction = end - start;
+        float length = std::hypot(direction.x, direction.y);
+        if (length <= 0.0F)
+        {
+            return;
+        }
+        // Lines are drawn as thin quads so they can share the triangle batch
+        glm::vec2 normal = glm::vec2{ -direction.y, direction.x } * (width * 0.5F / length);
+
+        const glm::vec3 start_low = { start.x - normal.x, start.y - normal.y, 0.0F };
+        const glm::vec3 start_high = { start.x + normal.x, start.y + normal.y, 0.0F };
+        const glm::vec3 end_low = { end.x - normal.x, end.y - normal.y, 0.0F };
+        const glm::vec3 end_high = { end.x + normal.x, end.y + normal.y, 0.0F };
+
+        m_vertices.push_back({ .position = start_low, .color = color });
+        m_vertices.push_back({ .position = end_low, .color = color });
+        m_vertices.push_back({ .position = end_high, .color = color });
+        m_vertices.push_back({ .position = end_high, .color = color });
+        m_vertices.push_back({ .position = start_high, .color = color });
+        m_vertices.push_back({ .position = start_low, .color = color });
+    }
+
+    auto c_batch::append(std::span<const s_vertex> vertices, glm::vec2 offset) -> void
+    {
+        m_vertices.reserve(m_vertices.size() + vertices.size());
+        for (const auto &vertex : vertices)
+        {
+            m_vertices.push_back({ .position = { vertex.position.x + offset.x, vertex.position.y + offset.y, vertex.position.z }, .color = vertex.color });
+        }
+    }
+
+    auto c_batch::clear() -> void
+    {
+        m_vertices.clear();
+    }
+
+    auto c_batch::empty() const -> bool
+    {
+        return m_vertices.empty();
+    }
+
+    auto c_batch::vertex_count() const -> std::size_t
+    {
+        return m_vertices.size();
+    }
+
+    auto c_batch::vertices() const -> std::span<const s_vertex>
+    {
+        return m_vertices;
+    }
+
+    auto c_batch::draw(const c_renderer &renderer) -> void
+    {
+        if (m_vertices.empty() or not m_vertex_array.is_ready())
+        {
+            return;
+        }
+
+        auto first = m_stream.upload(m_vertices);
+        if (first == c_streaming_buffer<s_vertex>::npos)
+        {
+            return;
+        }
+        if (m_stream.generation() != m_attached_generation)
+        {
+            m_vertex_array.add_buffer(m_stream, m_layout);
+            m_attached_generation = m_stream.generation();
+        }
+
+        renderer.draw_arrays(m_vertex_array, shape_shader(), e_render_primitive::triangles, first, m_vertices.size());
+    }
 } // namespace opengl::shapes
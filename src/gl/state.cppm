@@ -0,0 +1,390 @@
+module;
+#include <GL/glew.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+export module opengl:state;
+
+export namespace opengl
+{
+    /**
+     * @brief Number of GL calls issued to the driver and skipped by the state cache.
+     */
+    struct s_state_counters
+    {
+        std::uint64_t issued{};     // State changes passed on to the driver
+        std::uint64_t skipped{};    // State changes that matched the cached state
+        std::uint64_t draw_calls{}; // glDraw* calls
+        std::uint64_t uploads{};    // Buffer and texture data transfers
+        std::uint64_t upload_bytes{};
+    };
+
+    /**
+     * @brief Shadow copy of the GL context state used by the renderer.
+     *
+     * Every bind and state change in the opengl module goes through this class, which skips calls that would not
+     * change anything. Cached values start out unknown, so the first change of each kind always reaches the driver.
+     * Objects being deleted must be reported with the on_*_deleted() functions, since GL silently resets bindings to
+     * deleted objects. Anything that changes state behind the cache's back must call invalidate().
+     *
+     * Counters are accumulated over a frame; begin_frame() publishes them and starts a new frame. Like the context
+     * itself, this is only used from the GL thread.
+     */
+    class c_gl_state
+    {
+    public:
+        static constexpr std::size_t s_texture_units = 16;
+
+        static auto instance() -> c_gl_state &;
+
+        auto use_program(unsigned int program) -> void;
+        auto bind_vertex_array(unsigned int vertex_array) -> void;
+        auto bind_buffer(GLenum target, unsigned int buffer) -> void;
+        auto bind_buffer_base(GLenum target, unsigned int index, unsigned int buffer) -> void;
+        auto active_texture(unsigned int unit) -> void;
+        auto bind_texture(GLenum target, unsigned int texture) -> void;
+        auto bind_texture(unsigned int unit, GLenum target, unsigned int texture) -> void;
+        auto bind_framebuffer(unsigned int framebuffer) -> void;
+        auto viewport(int x, int y, int width, int height) -> void;
+
+        auto set_blend(bool enabled) -> void;
+        auto blend_func(GLenum source, GLenum destination) -> void;
+        auto blend_func_separate(GLenum source_rgb, GLenum destination_rgb, GLenum source_alpha, GLenum destination_alpha) -> void;
+
+        auto set_scissor(bool enabled) -> void;
+        auto scissor(int x, int y, int width, int height) -> void;
+
+        auto on_program_deleted(unsigned int program) -> void;
+        auto on_vertex_array_deleted(unsigned int vertex_array) -> void;
+        auto on_buffer_deleted(unsigned int buffer) -> void;
+        auto on_texture_deleted(unsigned int texture) -> void;
+        auto on_framebuffer_deleted(unsigned int framebuffer) -> void;
+
+        /**
+         * @brief Forget all cached state, so the next change of every kind is issued.
+         */
+        auto invalidate() -> void;
+
+        auto count_draw_call() -> void;
+        auto count_upload(std::size_t bytes) -> void;
+
+        /**
+         * @brief Publish the counters of the frame that just ended and reset them.
+         */
+        auto begin_frame() -> void;
+
+        [[nodiscard]] auto frame_counters() const -> const s_state_counters &;
+        [[nodiscard]] auto current_counters() const -> const s_state_counters &;
+
+    private:
+        struct s_texture_binding
+        {
+            GLenum target;
+            unsigned int texture;
+
+            auto operator==(const s_texture_binding &) const -> bool = default;
+        };
+
+        struct s_blend_func
+        {
+            GLenum source_rgb;
+            GLenum destination_rgb;
+            GLenum source_alpha;
+            GLenum destination_alpha;
+
+            auto operator==(const s_blend_func &) const -> bool = default;
+        };
+
+        struct s_rectangle
+        {
+            int x, y, width, height;
+
+            auto operator==(const s_rectangle &) const -> bool = default;
+        };
+
+        std::optional<unsigned int> m_program;
+        std::optional<unsigned int> m_vertex_array;
+        std::optional<unsigned int> m_array_buffer;
+        std::optional<unsigned int> m_element_buffer; // Part of the vertex array state
+        std::optional<unsigned int> m_uniform_buffer;
+        std::optional<unsigned int> m_active_texture;
+        std::array<std::optional<s_texture_binding>, s_texture_units> m_textures;
+        std::optional<bool> m_blend;
+        std::optional<s_blend_func> m_blend_func;
+        std::optional<bool> m_scissor;
+        std::optional<s_rectangle> m_scissor_box;
+        std::optional<unsigned int> m_framebuffer;
+        std::optional<s_rectangle> m_viewport;
+
+        s_state_counters m_counters;
+        s_state_counters m_frame_counters;
+
+        c_gl_state() = default;
+
+        template <typename T>
+        auto update(std::optional<T> &cached, const T &value) -> bool;
+        auto buffer_slot(GLenum target) -> std::optional<unsigned int> *;
+    };
+} // namespace opengl
+
+// Implementation
+namespace opengl
+{
+    auto c_gl_state::instance() -> c_gl_state &
+    {
+        static c_gl_state instance;
+        return instance;
+    }
+
+    template <typename T>
+    auto c_gl_state::update(std::optional<T> &cached, const T &value) -> bool
+    {
+        if (cached == value)
+        {
+            ++m_counters.skipped;
+            return false;
+        }
+        cached = value;
+        ++m_counters.issued;
+        return true;
+    }
+
+    auto c_gl_state::buffer_slot(GLenum target) -> std::optional<unsigned int> *
+    {
+        switch (target)
+        {
+        case GL_ARRAY_BUFFER:
+            return &m_array_buffer;
+        case GL_ELEMENT_ARRAY_BUFFER:
+            return &m_element_buffer;
+        case GL_UNIFORM_BUFFER:
+            return &m_uniform_buffer;
+        default:
+            return nullptr;
+        }
+    }
+
+    auto c_gl_state::use_program(unsigned int program) -> void
+    {
+        if (update(m_program, program))
+        {
+            glUseProgram(program);
+        }
+    }
+
+    auto c_gl_state::bind_vertex_array(unsigned int vertex_array) -> void
+    {
+        if (update(m_vertex_array, vertex_array))
+        {
+            glBindVertexArray(vertex_array);
+            // The element buffer binding belongs to the vertex array we just switched to
+            m_element_buffer.reset();
+        }
+    }
+
+    auto c_gl_state::bind_buffer(GLenum target, unsigned int buffer) -> void
+    {
+        auto *slot = buffer_slot(target);
+        if (not slot)
+        {
+            ++m_counters.issued;
+            glBindBuffer(target, buffer);
+            return;
+        }
+        if (update(*slot, buffer))
+        {
+            glBindBuffer(target, buffer);
+        }
+    }
+
+    auto c_gl_state::bind_buffer_base(GLenum target, unsigned int index, unsigned int buffer) -> void
+    {
+        // Indexed bindings are not cached, but they also change the generic binding point
+        ++m_counters.issued;
+        glBindBufferBase(target, index, buffer);
+        if (auto *slot = buffer_slot(target))
+        {
+            *slot = buffer;
+        }
+    }
+
+    auto c_gl_state::active_texture(unsigned int unit) -> void
+    {
+        if (update(m_active_texture, unit))
+        {
+            glActiveTexture(GL_TEXTURE0 + unit);
+        }
+    }
+
+    auto c_gl_state::bind_texture(GLenum target, unsigned int texture) -> void
+    {
+        bind_texture(m_active_texture.value_or(0), target, texture);
+    }
+
+    auto c_gl_state::bind_texture(unsigned int unit, GLenum target, unsigned int texture) -> void
+    {
+        if (unit >= s_texture_units)
+        {
+            ++m_counters.issued;
+            active_texture(unit);
+            glBindTexture(target, texture);
+            return;
+        }
+        if (update(m_textures[unit], s_texture_binding{ .target = target, .texture = texture }))
+        {
+            active_texture(unit);
+            glBindTexture(target, texture);
+        }
+    }
+
+    auto c_gl_state::set_blend(bool enabled) -> void
+    {
+        if (update(m_blend, enabled))
+        {
+            enabled ? glEnable(GL_BLEND) : glDisable(GL_BLEND);
+        }
+    }
+
+    auto c_gl_state::blend_func(GLenum source, GLenum destination) -> void
+    {
+        if (update(m_blend_func, s_blend_func{ .source_rgb = source, .destination_rgb = destination, .source_alpha = source, .destination_alpha = destination }))
+        {
+            glBlendFunc(source, destination);
+        }
+    }
+
+    auto c_gl_state::blend_func_separate(GLenum source_rgb, GLenum destination_rgb, GLenum source_alpha, GLenum destination_alpha) -> void
+    {
+        if (update(m_blend_func, s_blend_func{ .source_rgb = source_rgb, .destination_rgb = destination_rgb, .source_alpha = source_alpha, .destination_alpha = destination_alpha }))
+        {
+            glBlendFuncSeparate(source_rgb, destination_rgb, source_alpha, destination_alpha);
+        }
+    }
+
+    auto c_gl_state::set_scissor(bool enabled) -> void
+    {
+        if (update(m_scissor, enabled))
+        {
+            enabled ? glEnable(GL_SCISSOR_TEST) : glDisable(GL_SCISSOR_TEST);
+        }
+    }
+
+    auto c_gl_state::scissor(int x, int y, int width, int height) -> void
+    {
+        if (update(m_scissor_box, s_rectangle{ .x = x, .y = y, .width = width, .height = height }))
+        {
+            glScissor(x, y, width, height);
+        }
+    }
+
+    auto c_gl_state::bind_framebuffer(unsigned int framebuffer) -> void
+    {
+        if (update(m_framebuffer, framebuffer))
+        {
+            glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        }
+    }
+
+    auto c_gl_state::viewport(int x, int y, int width, int height) -> void
+    {
+        if (update(m_viewport, s_rectangle{ .x = x, .y = y, .width = width, .height = height }))
+        {
+            glViewport(x, y, width, height);
+        }
+    }
+
+    auto c_gl_state::on_program_deleted(unsigned int program) -> void
+    {
+        // Deleting the current program only flags it for deletion, but treat it as unknown to be safe
+        if (m_program == program)
+        {
+            m_program.reset();
+        }
+    }
+
+    auto c_gl_state::on_vertex_array_deleted(unsigned int vertex_array) -> void
+    {
+        if (m_vertex_array == vertex_array)
+        {
+            m_vertex_array = 0U;
+            m_element_buffer.reset();
+        }
+    }
+
+    auto c_gl_state::on_buffer_deleted(unsigned int buffer) -> void
+    {
+        for (auto *slot : { &m_array_buffer, &m_element_buffer, &m_uniform_buffer })
+        {
+            if (*slot == buffer)
+            {
+                *slot = 0U;
+            }
+        }
+    }
+
+    auto c_gl_state::on_texture_deleted(unsigned int texture) -> void
+    {
+        for (auto &binding : m_textures)
+        {
+            if (binding and binding->texture == texture)
+            {
+                binding.reset();
+            }
+        }
+    }
+
+    auto c_gl_state::on_framebuffer_deleted(unsigned int framebuffer) -> void
+    {
+        // Deleting the bound framebuffer reverts the binding to the default one
+        if (m_framebuffer == framebuffer)
+        {
+            m_framebuffer = 0U;
+        }
+    }
+
+    auto c_gl_state::invalidate() -> void
+    {
+        m_program.reset();
+        m_vertex_array.reset();
+        m_array_buffer.reset();
+        m_element_buffer.reset();
+        m_uniform_buffer.reset();
+        m_active_texture.reset();
+        m_textures.fill(std::nullopt);
+        m_blend.reset();
+        m_blend_func.reset();
+        m_scissor.reset();
+        m_scissor_box.reset();
+        m_framebuffer.reset();
+        m_viewport.reset();
+    }
+
+    auto c_gl_state::count_draw_call() -> void
+    {
+        ++m_counters.draw_calls;
+    }
+
+    auto c_gl_state::count_upload(std::size_t bytes) -> void
+    {
+        ++m_counters.uploads;
+        m_counters.upload_bytes += bytes;
+    }
+
+    auto c_gl_state::begin_frame() -> void
+    {
+        m_frame_counters = m_counters;
+        m_counters = {};
+    }
+
+    auto c_gl_state::frame_counters() const -> const s_state_counters &
+    {
+        return m_frame_counters;
+    }
+
+    auto c_gl_state::current_counters() const -> const s_state_counters &
+    {
+        return m_counters;
+    }
+} // namespace opengl
@@ -0,0 +1,357 @@
+module;
+#include <GL/glew.h>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <print>
+#include <span>
+#include <utility>
+#include <vector>
+export module opengl:streaming_buffer;
+
+import :command_queue;
+import :renderer;
+import :state;
+
+export namespace opengl
+{
+    /**
+     * @brief Ring-buffered vertex stream for data that is rewritten every frame.
+     *
+     * With ARB_buffer_storage the buffer is mapped once (persistent + coherent) and split into one partition per frame
+     * in flight; a fence guards each partition, so writing never waits for the driver unless the GPU is more than
+     * s_frames_in_flight frames behind. Without it, the buffer is orphaned at the start of every frame and writes are
+     * staged on the CPU and uploaded by commit().
+     *
+     * Allocations are expressed in elements of T so the returned index can be used directly as the first vertex of a
+     * draw call. If a frame asks for more than the capacity, the allocation fails and the buffer grows at the next
+     * frame; generation() changes when this happens, and vertex arrays must re-attach the buffer.
+     */
+    template <typename T>
+    class c_streaming_buffer
+    {
+    public:
+        static constexpr std::size_t s_frames_in_flight = 3;
+
+        struct s_allocation
+        {
+            std::span<T> data;
+            std::size_t first{};
+        };
+
+        explicit c_streaming_buffer(std::size_t capacity_per_frame, GLenum target = GL_ARRAY_BUFFER) noexcept;
+        ~c_streaming_buffer();
+
+        c_streaming_buffer(c_streaming_buffer &&other) noexcept;
+        auto operator=(c_streaming_buffer &&other) noexcept -> c_streaming_buffer &;
+
+        /**
+         * @brief Reserve space for count elements in the current frame's partition.
+         *
+         * @return Writable span and the element index of its first element; the span is empty if the buffer is not created yet or is full
+         */
+        [[nodiscard]] auto allocate(std::size_t count) -> s_allocation;
+
+        /**
+         * @brief Copy data into the stream and commit it.
+         *
+         * @return Element index of the first element, or npos if the data did not fit
+         */
+        [[nodiscard]] auto upload(std::span<const T> data) -> std::size_t;
+
+        /**
+         * @brief Make everything written since the last commit visible to the GPU.
+         */
+        auto commit() -> void;
+
+        auto bind() const -> void;
+        auto unbind() const -> void;
+
+        [[nodiscard]] auto is_persistent() const -> bool;
+        [[nodiscard]] auto generation() const -> std::uint32_t;
+
+        static constexpr std::size_t npos = std::numeric_limits<std::size_t>::max();
+
+    private:
+        GLenum m_target;
+        unsigned int m_buffer_id{};
+        std::size_t m_capacity;
+        std::size_t m_required{};
+        std::size_t m_partition{};
+        std::size_t m_cursor{};
+        std::size_t m_committed{};
+        std::uint64_t m_frame{ std::numeric_limits<std::uint64_t>::max() };
+        std::uint32_t m_generation{};
+        bool m_persistent{};
+        T *m_mapped{};
+        std::array<GLsync, s_frames_in_flight> m_fences{};
+        std::vector<T> m_staging;
+
+        auto create_storage() -> void;
+        auto destroy_storage() -> void;
+        auto advance_frame() -> void;
+    };
+} // namespace opengl
+
+// Implementation
+namespace opengl
+{
+    template <typename T>
+    c_streaming_buffer<T>::c_streaming_buffer(std::size_t capacity_per_frame, GLenum target) noexcept
+        : m_target(target),
+          m_capacity(std::max<std::size_t>(capacity_per_frame, 1))
+    {
+        auto init = [this]()
+        {
+            create_storage();
+        };
+        c_command_queue::instance().submit(std::move(init), e_command_kind::upload);
+    }
+
+    template <typename T>
+    c_streaming_buffer<T>::~c_streaming_buffer()
+    {
+        destroy_storage();
+    }
+
+    template <typename T>
+    c_streaming_buffer<T>::c_streaming_buffer(c_streaming_buffer &&other) noexcept
+        : m_target(other.m_target),
+          m_buffer_id(std::exchange(other.m_buffer_id, 0)),
+          m_capacity(other.m_capacity),
+          m_required(other.m_required),
+          m_partition(other.m_partition),
+          m_cursor(other.m_cursor),
+          m_committed(other.m_committed),
+          m_frame(other.m_frame),
+          m_generation(other.m_generation),
+          m_persistent(other.m_persistent),
+          m_mapped(std::exchange(other.m_mapped, nullptr)),
+          m_fences(std::exchange(other.m_fences, {})),
+          m_staging(std::move(other.m_staging))
+    {
+    }
+
+    template <typename T>
+    auto c_streaming_buffer<T>::operator=(c_streaming_buffer &&other) noexcept -> c_streaming_buffer &
+    {
+        if (this != &other)
+        {
+            destroy_storage();
+            m_target = other.m_target;
+            m_buffer_id = std::exchange(other.m_buffer_id, 0);
+            m_capacity = other.m_capacity;
+            m_required = other.m_required;
+            m_partition = other.m_partition;
+            m_cursor = other.m_cursor;
+            m_committed = other.m_committed;
+            m_frame = other.m_frame;
+            m_generation = other.m_generation;
+            m_persistent = other.m_persistent;
+            m_mapped = std::exchange(other.m_mapped, nullptr);
+            m_fences = std::exchange(other.m_fences, {});
+            m_staging = std::move(other.m_staging);
+        }
+        return *this;
+    }
+
+    template <typename T>
+    auto c_streaming_buffer<T>::create_storage() -> void
+    {
+        m_persistent = GLEW_ARB_buffer_storage != 0;
+        glGenBuffers(1, &m_buffer_id);
+        c_gl_state::instance().bind_buffer(m_target, m_buffer_id);
+        if (m_persistent)
+        {
+            constexpr GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+            auto size = static_cast<GLsizeiptr>(m_capacity * s_frames_in_flight * sizeof(T));
+            glBufferStorage(m_target, size, nullptr, flags);
+            m_mapped = static_cast<T *>(glMapBufferRange(m_target, 0, size, flags));
+            if (not m_mapped)
+            {
+                std::println(std::cerr, "Warning: persistent mapping failed, falling back to buffer orphaning");
+                c_gl_state::instance().on_buffer_deleted(m_buffer_id);
+                glDeleteBuffers(1, &m_buffer_id);
+                glGenBuffers(1, &m_buffer_id);
+                c_gl_state::instance().bind_buffer(m_target, m_buffer_id);
+                m_persistent = false;
+            }
+        }
+        if (not m_persistent)
+        {
+            glBufferData(m_target, static_cast<GLsizeiptr>(m_capacity * sizeof(T)), nullptr, GL_STREAM_DRAW);
+            m_staging.resize(m_capacity);
+        }
+        c_gl_state::instance().bind_buffer(m_target, 0);
+        m_partition = 0;
+        m_cursor = 0;
+        m_committed = 0;
+        ++m_generation;
+    }
+
+    template <typename T>
+    auto c_streaming_buffer<T>::destroy_storage() -> void
+    {
+        for (auto &fence : m_fences)
+        {
+            if (fence)
+            {
+                glDeleteSync(std::exchange(fence, nullptr));
+            }
+        }
+        if (m_mapped)
+        {
+            c_gl_state::instance().bind_buffer(m_target, m_buffer_id);
+            glUnmapBuffer(m_target);
+            c_gl_state::instance().bind_buffer(m_target, 0);
+            m_mapped = nullptr;
+        }
+        if (m_buffer_id)
+        {
+            c_gl_state::instance().on_buffer_deleted(m_buffer_id);
+            glDeleteBuffers(1, &m_buffer_id);
+            m_buffer_id = 0;
+        }
+    }
+
+    template <typename T>
+    auto c_streaming_buffer<T>::advance_frame() -> void
+    {
+        if (m_required > m_capacity)
+        {
+            // Last frame overflowed: recreate with enough room. Buffers still in use by the GPU are kept alive by the driver.
+            m_capacity = std::bit_ceil(std::max(m_required, m_capacity * 2));
+            m_required = 0;
+            destroy_storage();
+            create_storage();
+            return;
+        }
+
+        if (m_persistent)
+        {
+            // Fence the partition we just finished writing, then move on to the oldest one and wait until the GPU is done with it
+            m_fences[m_partition] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            m_partition = (m_partition + 1) % s_frames_in_flight;
+            if (auto *fence = std::exchange(m_fences[m_partition], nullptr))
+            {
+                constexpr GLuint64 timeout_ns = 1'000'000;
+                GLenum result = GL_TIMEOUT_EXPIRED;
+                while (result == GL_TIMEOUT_EXPIRED)
+                {
+                    result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, timeout_ns);
+                }
+                glDeleteSync(fence);
+            }
+        }
+        else
+        {
+            // Orphan the old storage so the driver can hand out fresh memory without synchronizing
+            c_gl_state::instance().bind_buffer(m_target, m_buffer_id);
+            glBufferData(m_target, static_cast<GLsizeiptr>(m_capacity * sizeof(T)), nullptr, GL_STREAM_DRAW);
+            c_gl_state::instance().bind_buffer(m_target, 0);
+        }
+        m_cursor = 0;
+        m_committed = 0;
+    }
+
+    template <typename T>
+    auto c_streaming_buffer<T>::allocate(std::size_t count) -> s_allocation
+    {
+        if (m_buffer_id == 0)
+        {
+            return {};
+        }
+        if (auto frame = c_renderer::frame_index(); frame != m_frame)
+        {
+            m_frame = frame;
+            advance_frame();
+        }
+        if (m_cursor + count > m_capacity)
+        {
+            if (m_required <= m_capacity)
+            {
+                std::println(std::cerr, "Warning: streaming buffer overflow ({} > {} elements), growing next frame", m_cursor + count, m_capacity);
+            }
+            m_required = std::max(m_required, m_cursor + count);
+            return {};
+        }
+
+        s_allocation allocation;
+        if (m_persistent)
+        {
+            allocation.first = (m_partition * m_capacity) + m_cursor;
+            allocation.data = std::span<T>(m_mapped + allocation.first, count);
+        }
+        else
+        {
+            allocation.first = m_cursor;
+            allocation.data = std::span<T>(m_staging.data() + m_cursor, count);
+        }
+        m_cursor += count;
+        return allocation;
+    }
+
+    template <typename T>
+    auto c_streaming_buffer<T>::upload(std::span<const T> data) -> std::size_t
+    {
+        auto allocation = allocate(data.size());
+        if (allocation.data.size() != data.size())
+        {
+            return npos;
+        }
+        std::ranges::copy(data, allocation.data.begin());
+        commit();
+        return allocation.first;
+    }
+
+    template <typename T>
+    auto c_streaming_buffer<T>::commit() -> void
+    {
+        if (m_committed == m_cursor)
+        {
+            return;
+        }
+
+        // Coherent persistent mappings are visible to the GPU without any call, the writes still count as a transfer
+        c_gl_state::instance().count_upload((m_cursor - m_committed) * sizeof(T));
+        if (m_persistent)
+        {
+            m_committed = m_cursor;
+            return;
+        }
+        c_gl_state::instance().bind_buffer(m_target, m_buffer_id);
+        glBufferSubData(m_target, static_cast<GLintptr>(m_committed * sizeof(T)), static_cast<GLsizeiptr>((m_cursor - m_committed) * sizeof(T)), m_staging.data() + m_committed);
+        c_gl_state::instance().bind_buffer(m_target, 0);
+        m_committed = m_cursor;
+    }
+
+    template <typename T>
+    auto c_streaming_buffer<T>::bind() const -> void
+    {
+        c_gl_state::instance().bind_buffer(m_target, m_buffer_id);
+    }
+
+    template <typename T>
+    auto c_streaming_buffer<T>::unbind() const -> void
+    {
+        c_gl_state::instance().bind_buffer(m_target, 0);
+    }
+
+    template <typename T>
+    auto c_streaming_buffer<T>::is_persistent() const -> bool
+    {
+        return m_persistent;
+    }
+
+    template <typename T>
+    auto c_streaming_buffer<T>::generation() const -> std::uint32_t
+    {
+        return m_generation;
+    }
+} // namespace opengl
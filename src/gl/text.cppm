@@ -7,23 +7,27 @@ module;
 
 #include <algorithm>
 #include <cmath>
+#include <cstddef>
+#include <cstdint>
 #include <filesystem>
 #include <iostream>
 #include <map>
 #include <mutex>
 #include <print>
+#include <utility>
 #include <string>
 #include <vector>
 export module opengl:text;
 
 import :shader;
 import :vertex_array;
-import :index_buffer;
-import :vertex_buffer;
+import :streaming_buffer;
 import :buffer_layout;
 
-import utility;
+import :command_queue;
+import :state;
 import glm;
+import utility;
 
 namespace
 {
@@ -44,6 +48,12 @@ namespace
         glm::vec3 color;  // Color of the text
     };
 
+    struct s_glyph_draw
+    {
+        unsigned int texture_id; // Glyph texture to bind
+        std::size_t text_index;  // Index into the text draw queue, used to pick the color
+    };
+
 } // namespace
 
 export namespace opengl
@@ -55,11 +65,13 @@ export namespace opengl
         std::mutex m_mutex;                                   // Mutex for thread safety
         std::vector<s_text_draw_data> m_text_draw_queue;      // Queue of text draw data
         std::map<std::uint32_t, s_character> m_character_map; // Map of character to character map
-        glm::mat4 m_projection_matrix{};                      // Projection matrix for text rendering
         unsigned int m_loaded_font_size{};                    // Loaded font size
 
         c_vertex_array m_vao;
-        c_vertex_buffer<float> m_vbo;
+        c_streaming_buffer<glm::vec4> m_vbo;         // Glyph quads of the whole frame, (x, y, u, v) per vertex
+        std::uint32_t m_attached_generation{};       // Streaming buffer generation attached to the VAO
+        std::vector<glm::vec4> m_vertices;           // Scratch vertices, reused across frames
+        std::vector<s_glyph_draw> m_glyph_draws;     // Scratch draw list, one entry per glyph quad
         c_shader m_shader;
 
         c_text_renderer();
@@ -68,7 +80,6 @@ export namespace opengl
     public:
         static auto instance() -> c_text_renderer &;
         auto load_font(const std::filesystem::path &font_path, unsigned int font_size) -> void;
-        auto resize(glm::vec2 new_size) -> void;
         auto submit(const std::string &text, glm::vec2 position, float font_size, const glm::vec3 &color) -> void;
         auto draw_texts() -> void;
         auto get_size(const std::string &text, float font_size) const -> glm::vec2;
@@ -86,33 +97,25 @@ export namespace opengl
 namespace opengl
 {
     c_text_renderer::c_text_renderer()
-        : m_vbo(std::vector<float>{}, 6UL * 4 * sizeof(float), GL_DYNAMIC_DRAW),
+        : m_vbo(6UL * 1024),
           m_shader(SOURCE_DIR "/src/shaders/text_shader.glsl")
     {
-        m_projection_matrix = glm::gtc::ortho(0.F, 640.F, 0.F, 480.F);
-
         auto init = [this]()
         {
-            m_shader.set_uniform_mat4f("projection", m_projection_matrix);
             m_shader.set_uniform_1i("text", 0); // Set the texture sampler to 0
 
-            c_buffer_layout layout;
-            layout.push<float>(2); // Position
-            layout.push<float>(2); // Texture coordinates
-
-            m_vao.add_buffer(m_vbo, layout);
-
-            glEnable(GL_BLEND);
-            glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+            c_gl_state::instance().set_blend(true);
+            c_gl_state::instance().blend_func(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
         };
 
-        utility::c_notifier::subscribe(init);
+        c_command_queue::instance().submit(std::move(init));
     }
 
     c_text_renderer::~c_text_renderer()
     {
         for (auto &[_, character] : m_character_map)
         {
+            c_gl_state::instance().on_texture_deleted(character.texture_id);
             glDeleteTextures(1, &character.texture_id);
         }
     }
@@ -128,6 +131,7 @@ namespace opengl
         // Clear existing character map and textures
         for (auto &[_, character] : m_character_map)
         {
+            c_gl_state::instance().on_texture_deleted(character.texture_id);
             glDeleteTextures(1, &character.texture_id);
         }
         m_character_map.clear();
@@ -168,7 +172,7 @@ namespace opengl
 
             unsigned int texture_id{};
             glGenTextures(1, &texture_id);
-            glBindTexture(GL_TEXTURE_2D, texture_id);
+            c_gl_state::instance().bind_texture(GL_TEXTURE_2D, texture_id);
             // Use GL_R8 for explicit 8-bit red channel storage
             glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, static_cast<int>(face->glyph->bitmap.width), static_cast<int>(face->glyph->bitmap.rows), 0, GL_RED, GL_UNSIGNED_BYTE, face->glyph->bitmap.buffer);
 
@@ -191,12 +195,6 @@ namespace opengl
         FT_Done_FreeType(ft_lib);
     }
 
-    auto c_text_renderer::resize(glm::vec2 new_size) -> void
-    {
-        m_projection_matrix = glm::gtc::ortho(0.F, new_size.x, 0.F, new_size.y, -1.F, 1.F);
-        m_shader.set_uniform_mat4f("projection", m_projection_matrix);
-    }
-
     auto c_text_renderer::submit(const std::string &text, glm::vec2 position, float font_size, const glm::vec3 &color) -> void
     {
         if (text.empty())
@@ -212,18 +210,19 @@ namespace opengl
 
     auto c_text_renderer::draw_texts() -> void
     {
+        utility::c_profile_zone zone(utility::zone_id<"Text draw">());
+        std::lock_guard<std::mutex> lock(m_mutex);
         if (m_text_draw_queue.empty())
         {
             return;
         }
 
-        std::lock_guard<std::mutex> lock(m_mutex);
-        glActiveTexture(GL_TEXTURE0);
-        m_vao.bind();
-        for (auto &[text, x, y, scale, color] : m_text_draw_queue)
+        // Build the quads of every queued text first, so the whole frame is uploaded at once
+        m_vertices.clear();
+        m_glyph_draws.clear();
+        for (std::size_t index = 0; index < m_text_draw_queue.size(); ++index)
         {
-            m_shader.set_uniform_3f("textColor", color);
-            m_shader.bind();
+            auto &[text, x, y, scale, color] = m_text_draw_queue[index];
 
             // We process text to ensure it is valid UTF-8
             std::string temp = utf8::replace_invalid(text);
@@ -252,34 +251,55 @@ namespace opengl
                 }
 
                 // clang-format off
-                // Update VBO for each character
                 // Remember that Gl's co-ordinate has y-axis increasing bottom to top, but texture coordinates have y-axis increasing top to bottom.
                 // So we flip texture's y-coordinate (0->1, 1->0)
-                std::vector<float> vertices{
-                    xpos,              ypos,               0.0F, 1.0F, //    (x,y+h)            (x+w,y+h)
-                    xpos,              ypos + char_height, 0.0F, 0.0F, //    (0,0)              (0,1)
-                    xpos + char_width, ypos + char_height, 1.0F, 0.0F, //      +------------------+
-                    //                                                         |                  |
-                    xpos + char_width, ypos,               1.0F, 1.0F, //      +------------------+
-                    xpos + char_width, ypos + char_height, 1.0F, 0.0F, //    (1,1)              (1,0)
-                    xpos,              ypos,               0.0F, 1.0F  //    (x,y)              (x+w,y)
-                };
+                m_vertices.insert(m_vertices.end(), {
+                    { xpos,              ypos,               0.0F, 1.0F }, //    (x,y+h)            (x+w,y+h)
+                    { xpos,              ypos + char_height, 0.0F, 0.0F }, //    (0,0)              (0,1)
+                    { xpos + char_width, ypos + char_height, 1.0F, 0.0F }, //      +------------------+
+                    //                                                           |                  |
+                    { xpos + char_width, ypos,               1.0F, 1.0F }, //      +------------------+
+                    { xpos + char_width, ypos + char_height, 1.0F, 0.0F }, //    (1,1)              (1,0)
+                    { xpos,              ypos,               0.0F, 1.0F }  //    (x,y)              (x+w,y)
+                });
                 // clang-format on
-
-                glBindTexture(GL_TEXTURE_2D, character_struct.texture_id);
-                m_vbo.update_buffer(vertices, vertices.size());
-
-                // Draw
-                m_vbo.bind();
-                glDrawArrays(GL_TRIANGLES, 0, 6);
+                m_glyph_draws.push_back({ .texture_id = character_struct.texture_id, .text_index = index });
 
                 // Advance cursor for next glyph
                 x += static_cast<float>(character_struct.advance >> 6U) * scale;
             }
         }
-        m_vao.unbind();
-        glBindTexture(GL_TEXTURE_2D, 0);
-        m_shader.unbind();
+
+        auto ready = not m_vertices.empty() and m_vao.is_ready() and m_shader.is_ready();
+        auto first = ready ? m_vbo.upload(m_vertices) : c_streaming_buffer<glm::vec4>::npos;
+        if (first != c_streaming_buffer<glm::vec4>::npos)
+        {
+            if (m_vbo.generation() != m_attached_generation)
+            {
+                c_buffer_layout layout;
+                layout.push<float>(2); // Position
+                layout.push<float>(2); // Texture coordinates
+                m_vao.add_buffer(m_vbo, layout);
+                m_attached_generation = m_vbo.generation();
+            }
+
+            auto &state = c_gl_state::instance();
+            m_vao.bind();
+            std::size_t current_text = m_text_draw_queue.size();
+            for (std::size_t i = 0; i < m_glyph_draws.size(); ++i)
+            {
+                const auto &[texture_id, text_index] = m_glyph_draws[i];
+                if (text_index != current_text)
+                {
+                    current_text = text_index;
+                    m_shader.set_uniform_3f("textColor", m_text_draw_queue[text_index].color);
+                    m_shader.bind();
+                }
+                state.bind_texture(0, GL_TEXTURE_2D, texture_id);
+                glDrawArrays(GL_TRIANGLES, static_cast<GLint>(first + (i * 6)), 6);
+                state.count_draw_call();
+            }
+        }
         m_text_draw_queue.clear();
     }
 
@@ -0,0 +1,187 @@
+module;
+#include <GL/glew.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <utility>
+#include <vector>
+export module opengl:texture;
+
+import :command_queue;
+import :state;
+
+import glm;
+
+export namespace opengl
+{
+    enum class e_texture_target : std::uint16_t
+    {
+        texture_1d = GL_TEXTURE_1D,
+        texture_2d = GL_TEXTURE_2D,
+    };
+
+    /**
+     * @brief 1D or 2D texture for data produced on the CPU (band intensities, spectrogram history, lookup tables).
+     *
+     * Storage is allocated once and only modified through update(), which uploads a sub-rectangle, so callers can
+     * stream small parts of a large texture each frame. For 1D textures the height is always 1. Updates made before
+     * the queued creation has run are copied and recorded behind it.
+     */
+    class c_texture
+    {
+    public:
+        c_texture(e_texture_target target, GLenum internal_format, glm::ivec2 size, GLenum filter = GL_LINEAR, GLenum wrap = GL_CLAMP_TO_EDGE) noexcept;
+        ~c_texture();
+
+        c_texture(c_texture &&other) noexcept;
+        auto operator=(c_texture &&other) noexcept -> c_texture &;
+
+        /**
+         * @brief Upload single-channel float data into the region starting at offset.
+         */
+        auto update(std::span<const float> data, glm::ivec2 offset, glm::ivec2 extent) const -> void;
+
+        /**
+         * @brief Upload RGBA float data into the region starting at offset.
+         */
+        auto update(std::span<const glm::vec4> data, glm::ivec2 offset, glm::ivec2 extent) const -> void;
+
+        auto bind(unsigned int unit) const -> void;
+
+        [[nodiscard]] auto size() const -> glm::ivec2;
+        [[nodiscard]] auto id() const -> unsigned int;
+
+    private:
+        unsigned int m_texture_id{};
+        e_texture_target m_target;
+        glm::ivec2 m_size;
+
+        template <typename T>
+        auto update_region(std::span<const T> data, GLenum format, glm::ivec2 offset, glm::ivec2 extent) const -> void;
+        auto upload(const void *data, GLenum format, glm::ivec2 offset, glm::ivec2 extent) const -> void;
+        auto destroy() -> void;
+    };
+} // namespace opengl
+
+// Implementation
+namespace opengl
+{
+    c_texture::c_texture(e_texture_target target, GLenum internal_format, glm::ivec2 size, GLenum filter, GLenum wrap) noexcept
+        : m_target(target),
+          m_size(size.x, target == e_texture_target::texture_1d ? 1 : size.y)
+    {
+        auto init = [this, internal_format, filter, wrap]()
+        {
+            auto gl_target = static_cast<GLenum>(m_target);
+            glGenTextures(1, &m_texture_id);
+            c_gl_state::instance().bind_texture(gl_target, m_texture_id);
+            if (m_target == e_texture_target::texture_1d)
+            {
+                glTexStorage1D(gl_target, 1, internal_format, m_size.x);
+            }
+            else
+            {
+                glTexStorage2D(gl_target, 1, internal_format, m_size.x, m_size.y);
+                glTexParameteri(gl_target, GL_TEXTURE_WRAP_T, static_cast<GLint>(wrap));
+            }
+            glTexParameteri(gl_target, GL_TEXTURE_WRAP_S, static_cast<GLint>(wrap));
+            glTexParameteri(gl_target, GL_TEXTURE_MIN_FILTER, static_cast<GLint>(filter));
+            glTexParameteri(gl_target, GL_TEXTURE_MAG_FILTER, static_cast<GLint>(filter));
+        };
+        c_command_queue::instance().submit(std::move(init), e_command_kind::upload);
+    }
+
+    c_texture::~c_texture()
+    {
+        destroy();
+    }
+
+    c_texture::c_texture(c_texture &&other) noexcept
+        : m_texture_id(std::exchange(other.m_texture_id, 0)),
+          m_target(other.m_target),
+          m_size(other.m_size)
+    {
+    }
+
+    auto c_texture::operator=(c_texture &&other) noexcept -> c_texture &
+    {
+        if (this != &other)
+        {
+            destroy();
+            m_texture_id = std::exchange(other.m_texture_id, 0);
+            m_target = other.m_target;
+            m_size = other.m_size;
+        }
+        return *this;
+    }
+
+    auto c_texture::destroy() -> void
+    {
+        if (m_texture_id)
+        {
+            c_gl_state::instance().on_texture_deleted(m_texture_id);
+            glDeleteTextures(1, &m_texture_id);
+            m_texture_id = 0;
+        }
+    }
+
+    auto c_texture::upload(const void *data, GLenum format, glm::ivec2 offset, glm::ivec2 extent) const -> void
+    {
+        if (m_texture_id == 0)
+        {
+            return;
+        }
+        auto gl_target = static_cast<GLenum>(m_target);
+        c_gl_state::instance().bind_texture(gl_target, m_texture_id);
+        if (m_target == e_texture_target::texture_1d)
+        {
+            glTexSubImage1D(gl_target, 0, offset.x, extent.x, format, GL_FLOAT, data);
+        }
+        else
+        {
+            glTexSubImage2D(gl_target, 0, offset.x, offset.y, extent.x, extent.y, format, GL_FLOAT, data);
+        }
+        auto channels = format == GL_RGBA ? 4U : 1U;
+        auto texels = static_cast<std::size_t>(extent.x) * static_cast<std::size_t>(std::max(extent.y, 1));
+        c_gl_state::instance().count_upload(texels * channels * sizeof(float));
+    }
+
+    template <typename T>
+    auto c_texture::update_region(std::span<const T> data, GLenum format, glm::ivec2 offset, glm::ivec2 extent) const -> void
+    {
+        if (m_texture_id != 0)
+        {
+            upload(data.data(), format, offset, extent);
+            return;
+        }
+        c_command_queue::instance().submit([this, copy = std::vector<T>(data.begin(), data.end()), format, offset, extent]
+                                           { upload(copy.data(), format, offset, extent); });
+    }
+
+    auto c_texture::update(std::span<const float> data, glm::ivec2 offset, glm::ivec2 extent) const -> void
+    {
+        update_region(data, GL_RED, offset, extent);
+    }
+
+    auto c_texture::update(std::span<const glm::vec4> data, glm::ivec2 offset, glm::ivec2 extent) const -> void
+    {
+        update_region(data, GL_RGBA, offset, extent);
+    }
+
+    auto c_texture::bind(unsigned int unit) const -> void
+    {
+        c_gl_state::instance().bind_texture(unit, static_cast<GLenum>(m_target), m_texture_id);
+    }
+
+    auto c_texture::size() const -> glm::ivec2
+    {
+        return m_size;
+    }
+
+    auto c_texture::id() const -> unsigned int
+    {
+        return m_texture_id;
+    }
+} // namespace opengl
@@ -0,0 +1,209 @@
+module;
+#include <GL/glew.h>
+
+#include <cstddef>
+#include <utility>
+export module opengl:uniform_buffer;
+
+import :command_queue;
+import :state;
+
+import glm;
+
+export namespace opengl
+{
+    /**
+     * @brief Uniform buffer holding one std140 block, bound to a fixed binding point.
+     *
+     * T must mirror the GLSL block declared with layout(std140, binding = ...) in the shaders, including padding.
+     * The last value passed to update() is kept on the CPU, so updates made before the GL context exists are uploaded
+     * when the buffer is created.
+     */
+    template <typename T>
+    class c_uniform_buffer
+    {
+    public:
+        explicit c_uniform_buffer(unsigned int binding, const T &data = {}) noexcept;
+        ~c_uniform_buffer();
+
+        c_uniform_buffer(c_uniform_buffer &&other) noexcept;
+        auto operator=(c_uniform_buffer &&other) noexcept -> c_uniform_buffer &;
+
+        auto update(const T &data) -> void;
+        [[nodiscard]] auto data() const -> const T &;
+        [[nodiscard]] auto binding() const -> unsigned int;
+
+    private:
+        unsigned int m_ubo_id{};
+        unsigned int m_binding;
+        T m_data;
+    };
+
+    /**
+     * @brief Per-frame and per-view data shared by every shader through the u_frame block (binding 0).
+     *
+     * Layout matches the block declared by every shader in src/shaders:
+     * @code
+     * layout(std140, binding = 0) uniform u_frame
+     * {
+     *     mat4 projection;
+     *     vec4 viewport; // xy: origin, zw: size in pixels
+     *     vec4 time;     // x: seconds since start, y: frame delta
+     * };
+     * @endcode
+     */
+    struct s_frame_uniforms
+    {
+        glm::mat4 projection{ 1.F };
+        glm::vec4 viewport{};
+        glm::vec4 time{};
+    };
+    static_assert(sizeof(s_frame_uniforms) == 96, "s_frame_uniforms must match the std140 layout of u_frame");
+
+    class c_frame_uniforms
+    {
+    public:
+        static constexpr unsigned int s_binding = 0;
+
+        static auto instance() -> c_frame_uniforms &;
+
+        /**
+         * @brief Set the pixel area drawn to, with an orthographic projection mapping it to clip space.
+         *
+         * The view is per render target: the window sets it on resize, and off-screen targets set their own before
+         * drawing and restore the previous one afterwards.
+         */
+        auto set_view(glm::vec2 origin, glm::vec2 size) -> void;
+        auto set_time(float seconds, float delta) -> void;
+
+        [[nodiscard]] auto view_origin() const -> glm::vec2;
+        [[nodiscard]] auto view_size() const -> glm::vec2;
+        [[nodiscard]] auto projection() const -> const glm::mat4 &;
+
+        c_frame_uniforms(const c_frame_uniforms &) = delete;
+        c_frame_uniforms(c_frame_uniforms &&) = delete;
+        auto operator=(const c_frame_uniforms &) -> c_frame_uniforms & = delete;
+        auto operator=(c_frame_uniforms &&) -> c_frame_uniforms & = delete;
+
+    private:
+        c_uniform_buffer<s_frame_uniforms> m_buffer{ s_binding };
+
+        c_frame_uniforms() = default;
+        ~c_frame_uniforms() = default;
+    };
+} // namespace opengl
+
+// Implementation
+namespace opengl
+{
+    template <typename T>
+    c_uniform_buffer<T>::c_uniform_buffer(unsigned int binding, const T &data) noexcept
+        : m_binding(binding),
+          m_data(data)
+    {
+        auto init = [this]()
+        {
+            glGenBuffers(1, &m_ubo_id);
+            c_gl_state::instance().bind_buffer(GL_UNIFORM_BUFFER, m_ubo_id);
+            glBufferData(GL_UNIFORM_BUFFER, sizeof(T), &m_data, GL_DYNAMIC_DRAW);
+            c_gl_state::instance().count_upload(sizeof(T));
+            c_gl_state::instance().bind_buffer_base(GL_UNIFORM_BUFFER, m_binding, m_ubo_id);
+        };
+        c_command_queue::instance().submit(std::move(init), e_command_kind::upload);
+    }
+
+    template <typename T>
+    c_uniform_buffer<T>::~c_uniform_buffer()
+    {
+        c_gl_state::instance().on_buffer_deleted(m_ubo_id);
+        glDeleteBuffers(1, &m_ubo_id);
+    }
+
+    template <typename T>
+    c_uniform_buffer<T>::c_uniform_buffer(c_uniform_buffer &&other) noexcept
+        : m_ubo_id(std::exchange(other.m_ubo_id, 0)),
+          m_binding(other.m_binding),
+          m_data(other.m_data)
+    {
+    }
+
+    template <typename T>
+    auto c_uniform_buffer<T>::operator=(c_uniform_buffer &&other) noexcept -> c_uniform_buffer &
+    {
+        if (this != &other)
+        {
+            c_gl_state::instance().on_buffer_deleted(m_ubo_id);
+            glDeleteBuffers(1, &m_ubo_id);
+            m_ubo_id = std::exchange(other.m_ubo_id, 0);
+            m_binding = other.m_binding;
+            m_data = other.m_data;
+        }
+        return *this;
+    }
+
+    template <typename T>
+    auto c_uniform_buffer<T>::update(const T &data) -> void
+    {
+        m_data = data;
+        if (m_ubo_id == 0)
+        {
+            return;
+        }
+        c_gl_state::instance().bind_buffer(GL_UNIFORM_BUFFER, m_ubo_id);
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(T), &m_data);
+        c_gl_state::instance().count_upload(sizeof(T));
+    }
+
+    template <typename T>
+    auto c_uniform_buffer<T>::data() const -> const T &
+    {
+        return m_data;
+    }
+
+    template <typename T>
+    auto c_uniform_buffer<T>::binding() const -> unsigned int
+    {
+        return m_binding;
+    }
+
+    auto c_frame_uniforms::instance() -> c_frame_uniforms &
+    {
+        static c_frame_uniforms instance;
+        return instance;
+    }
+
+    auto c_frame_uniforms::set_view(glm::vec2 origin, glm::vec2 size) -> void
+    {
+        auto data = m_buffer.data();
+        glm::vec4 viewport = { origin.x, origin.y, size.x, size.y };
+        if (data.viewport == viewport)
+        {
+            return;
+        }
+        data.viewport = viewport;
+        data.projection = glm::gtc::ortho(origin.x, origin.x + size.x, origin.y, origin.y + size.y, -1.F, 1.F);
+        m_buffer.update(data);
+    }
+
+    auto c_frame_uniforms::set_time(float seconds, float delta) -> void
+    {
+        auto data = m_buffer.data();
+        data.time = { seconds, delta, 0.F, 0.F };
+        m_buffer.update(data);
+    }
+
+    auto c_frame_uniforms::view_origin() const -> glm::vec2
+    {
+        return { m_buffer.data().viewport.x, m_buffer.data().viewport.y };
+    }
+
+    auto c_frame_uniforms::view_size() const -> glm::vec2
+    {
+        return { m_buffer.data().viewport.z, m_buffer.data().viewport.w };
+    }
+
+    auto c_frame_uniforms::projection() const -> const glm::mat4 &
+    {
+        return m_buffer.data().projection;
+    }
+} // namespace opengl
@@ -8,10 +8,10 @@ module;
 
 export module opengl:vertex_array;
 
-import :vertex_buffer;
 import :buffer_layout;
 
-import utility;
+import :command_queue;
+import :state;
 
 export namespace opengl
 {
@@ -24,12 +24,20 @@ export namespace opengl
         c_vertex_array(c_vertex_array &&other) noexcept;
         auto operator=(c_vertex_array &&other) noexcept -> c_vertex_array &;
 
-        template <typename T>
-        auto add_buffer(const c_vertex_buffer<T> &vbuff, const c_buffer_layout &layout) const -> void;
+        /**
+         * @brief Attach a vertex buffer (static or streaming) and describe its layout.
+         */
+        template <typename B>
+        auto add_buffer(const B &vbuff, const c_buffer_layout &layout) const -> void;
 
         auto bind() const -> void;
         auto unbind() const -> void;
 
+        /**
+         * @brief Whether the vertex array exists yet; creation is deferred through the command queue.
+         */
+        [[nodiscard]] auto is_ready() const -> bool;
+
     private:
         unsigned int m_vao_id{};
     };
@@ -44,11 +52,12 @@ namespace opengl
         {
             glGenVertexArrays(1, &m_vao_id);
         };
-        utility::c_notifier::subscribe(init);
+        c_command_queue::instance().submit(std::move(init), e_command_kind::upload);
     }
 
     c_vertex_array::~c_vertex_array()
     {
+        c_gl_state::instance().on_vertex_array_deleted(m_vao_id);
         glDeleteVertexArrays(1, &m_vao_id);
     }
 
@@ -61,14 +70,15 @@ namespace opengl
     {
         if (this != &other)
         {
+            c_gl_state::instance().on_vertex_array_deleted(m_vao_id);
             glDeleteVertexArrays(1, &m_vao_id);
             m_vao_id = std::exchange(other.m_vao_id, 0);
         }
         return *this;
     }
 
-    template <typename T>
-    auto c_vertex_array::add_buffer(const c_vertex_buffer<T> &vbuff, const c_buffer_layout &layout) const -> void
+    template <typename B>
+    auto c_vertex_array::add_buffer(const B &vbuff, const c_buffer_layout &layout) const -> void
     {
         bind();
         vbuff.bind();
@@ -83,11 +93,16 @@ namespace opengl
 
     auto c_vertex_array::bind() const -> void
     {
-        glBindVertexArray(m_vao_id);
+        c_gl_state::instance().bind_vertex_array(m_vao_id);
     }
 
     auto c_vertex_array::unbind() const -> void
     {
-        glBindVertexArray(0);
+        c_gl_state::instance().bind_vertex_array(0);
+    }
+
+    auto c_vertex_array::is_ready() const -> bool
+    {
+        return m_vao_id != 0;
     }
 } // namespace opengl
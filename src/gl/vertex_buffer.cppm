@@ -6,7 +6,8 @@ module;
 #include <vector>
 export module opengl:vertex_buffer;
 
-import utility;
+import :command_queue;
+import :state;
 
 export namespace opengl
 {
@@ -45,7 +46,7 @@ namespace opengl
             glGenBuffers(1, &m_vbo_id);
             if (m_count > 0)
             {
-                glBindBuffer(GL_ARRAY_BUFFER, m_vbo_id);
+                c_gl_state::instance().bind_buffer(GL_ARRAY_BUFFER, m_vbo_id);
                 if (data.empty())
                 {
                     glBufferData(GL_ARRAY_BUFFER, m_count * sizeof(T), nullptr, m_usage);
@@ -53,15 +54,17 @@ namespace opengl
                 else
                 {
                     glBufferData(GL_ARRAY_BUFFER, m_count * sizeof(T), data.data(), m_usage);
+                    c_gl_state::instance().count_upload(m_count * sizeof(T));
                 }
             }
         };
-        utility::c_notifier::subscribe(init);
+        c_command_queue::instance().submit(std::move(init), e_command_kind::upload);
     }
 
     template <typename T>
     c_vertex_buffer<T>::~c_vertex_buffer()
     {
+        c_gl_state::instance().on_buffer_deleted(m_vbo_id);
         glDeleteBuffers(1, &m_vbo_id);
     }
 
@@ -78,6 +81,7 @@ namespace opengl
     {
         if (this != &other)
         {
+            c_gl_state::instance().on_buffer_deleted(m_vbo_id);
             glDeleteBuffers(1, &m_vbo_id);
             m_vbo_id = std::exchange(other.m_vbo_id, 0);
             m_count = std::exchange(other.m_count, 0);
@@ -99,18 +103,19 @@ namespace opengl
         {
             glBufferSubData(GL_ARRAY_BUFFER, offset, count * sizeof(T), data.data());
         }
+        c_gl_state::instance().count_upload(count * sizeof(T));
         unbind();
     }
 
     template <typename T>
     auto c_vertex_buffer<T>::bind() const -> void
     {
-        glBindBuffer(GL_ARRAY_BUFFER, m_vbo_id);
+        c_gl_state::instance().bind_buffer(GL_ARRAY_BUFFER, m_vbo_id);
     }
 
     template <typename T>
     auto c_vertex_buffer<T>::unbind() const -> void
     {
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        c_gl_state::instance().bind_buffer(GL_ARRAY_BUFFER, 0);
     }
 } // namespace opengl
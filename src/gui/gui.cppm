@@ -5,6 +5,9 @@ module;
 #include <stdexcept>
 export module gui;
 export import :window;
+export import :panel;
+export import :waveform;
+export import :tracks;
 
 namespace
 {
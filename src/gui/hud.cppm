@@ -0,0 +1,238 @@
+module;
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <functional>
+#include <vector>
+export module gui:hud;
+
+import :panel;
+import music;
+import opengl;
+import glm;
+
+export namespace gui
+{
+    enum class e_frame_stage : std::uint8_t
+    {
+        events,
+        uploads,
+        update,
+        render,
+        present,
+        count
+    };
+
+    /**
+     * @brief Timing of one frame of the window, in seconds.
+     */
+    struct s_frame_timing
+    {
+        float interval{}; // Start of the previous frame to the start of this one
+        std::array<float, static_cast<std::size_t>(e_frame_stage::count)> stages{};
+    };
+
+    /**
+     * @brief Performance overlay: frame time percentiles and stages, audio callback load, and GL work per frame.
+     *
+     * The window hands over its frame timings, the audio manager and the GL state cache keep their own counters, so
+     * nothing is measured here. While the panel is closed, push_frame() returns at once and nothing is drawn.
+     */
+    class c_hud_panel final : public c_panel
+    {
+    public:
+        static constexpr std::size_t s_history = 240; // Frames kept for the graphs and percentiles
+
+        c_hud_panel(glm::vec2 position, glm::vec2 size, music::c_audio_manager &audio_manager);
+
+        /**
+         * @brief Record the frame that just ended, with the GL counters of the last complete frame.
+         */
+        auto push_frame(const s_frame_timing &timing) -> void;
+
+        /**
+         * @brief Open or close the overlay; it starts over with an empty history when opened.
+         */
+        auto toggle() -> void;
+
+        auto render_content() const -> void override;
+
+        auto on_mouse_move(glm::vec2 mouse_position) -> void override
+        {
+            c_panel::on_mouse_move(mouse_position);
+        };
+        auto on_mouse_press(glm::vec2 mouse_position, e_mouse_button button) -> void override
+        {
+            c_panel::on_mouse_press(mouse_position, button);
+        };
+        auto on_mouse_release(glm::vec2 mouse_position, e_mouse_button button) -> void override
+        {
+            c_panel::on_mouse_release(mouse_position, button);
+        };
+        auto on_resize(float width, float height) -> void override
+        {
+            c_panel::on_resize(width, height);
+        };
+        auto on_mouse_scroll(glm::vec2 position, glm::vec2 scroll_delta) -> void override
+        {
+            c_panel::on_mouse_scroll(position, scroll_delta);
+        };
+
+    private:
+        music::c_audio_manager &m_audio_manager;
+
+        // Rolling history, oldest at m_cursor once full
+        std::array<s_frame_timing, s_history> m_frames{};
+        std::array<float, s_history> m_callback_load{}; // Longest callback of the frame over its period
+        std::size_t m_cursor{};
+        std::size_t m_count{};
+
+        music::s_callback_stats m_callback_stats;
+        opengl::s_state_counters m_gl_counters;
+
+        mutable std::vector<float> m_sorted; // Scratch for the percentiles
+        mutable opengl::shapes::c_batch m_batch;
+
+        [[nodiscard]] auto history_index(std::size_t age) const -> std::size_t;
+        auto add_graph(glm::vec2 position, glm::vec2 size, float scale, float budget, auto &&value) const -> void;
+    };
+} // namespace gui
+
+// Implementation
+namespace gui
+{
+    c_hud_panel::c_hud_panel(glm::vec2 position, glm::vec2 size, music::c_audio_manager &audio_manager)
+        : c_panel(position, size, "Performance"),
+          m_audio_manager(audio_manager)
+    {
+        m_sorted.reserve(s_history);
+
+        // Readings change every frame, caching them would only add a copy
+        set_retained(false);
+        close();
+    }
+
+    auto c_hud_panel::push_frame(const s_frame_timing &timing) -> void
+    {
+        if (is_closed())
+        {
+            return;
+        }
+        m_callback_stats = m_audio_manager.take_callback_stats();
+
+        // Published when the frame that just ended began rendering: the previous render and this frame's uploads
+        m_gl_counters = opengl::c_gl_state::instance().frame_counters();
+
+        m_frames.at(m_cursor) = timing;
+        m_callback_load.at(m_cursor) = m_callback_stats.period > 0.F ? m_callback_stats.max_duration / m_callback_stats.period : 0.F;
+        m_cursor = (m_cursor + 1) % s_history;
+        m_count = std::min(m_count + 1, s_history);
+    }
+
+    auto c_hud_panel::toggle() -> void
+    {
+        if (not is_closed())
+        {
+            close();
+            return;
+        }
+        m_cursor = 0;
+        m_count = 0;
+        open();
+    }
+
+    auto c_hud_panel::history_index(std::size_t age) const -> std::size_t
+    {
+        return (m_cursor + s_history - m_count + age) % s_history;
+    }
+
+    auto c_hud_panel::add_graph(glm::vec2 position, glm::vec2 size, float scale, float budget, auto &&value) const -> void
+    {
+        // One bar per frame, newest on the right; bars over the budget line are red
+        m_batch.add_rectangle(position, size, { 0.15F, 0.15F, 0.15F, 1.F });
+        auto bar_width = size.x / static_cast<float>(s_history);
+        for (std::size_t age = 0; age < m_count; ++age)
+        {
+            auto sample = value(history_index(age));
+            auto height = std::min(sample / scale, 1.F) * size.y;
+            glm::vec4 color = sample > budget ? glm::vec4{ 0.9F, 0.2F, 0.2F, 1.F } : glm::vec4{ 0.2F, 0.8F, 0.4F, 1.F };
+            auto x = position.x + (static_cast<float>(s_history - m_count + age) * bar_width);
+            m_batch.add_rectangle({ x, position.y }, { bar_width, height }, color);
+        }
+        auto budget_y = position.y + (std::min(budget / scale, 1.F) * size.y);
+        m_batch.add_line({ position.x, budget_y }, { position.x + size.x, budget_y }, { 0.9F, 0.9F, 0.3F, 1.F });
+    }
+
+    auto c_hud_panel::render_content() const -> void
+    {
+        constexpr float to_ms = 1000.F;
+        constexpr float frame_budget = 1.F / 60.F;
+
+        // Percentiles of the frame interval, stage times averaged over the history
+        m_sorted.clear();
+        std::array<float, static_cast<std::size_t>(e_frame_stage::count)> stages{};
+        for (std::size_t age = 0; age < m_count; ++age)
+        {
+            const auto &frame = m_frames.at(history_index(age));
+            m_sorted.push_back(frame.interval);
+            std::ranges::transform(stages, frame.stages, stages.begin(), std::plus<float>{});
+        }
+        std::ranges::sort(m_sorted);
+        auto percentile = [this](float fraction) -> float
+        {
+            if (m_sorted.empty())
+            {
+                return 0.F;
+            }
+            auto index = static_cast<std::size_t>(fraction * static_cast<float>(m_sorted.size() - 1));
+            return m_sorted[index] * to_ms;
+        };
+        auto average = [this](float total) -> float
+        {
+            return m_count > 0 ? total / static_cast<float>(m_count) * to_ms : 0.F;
+        };
+
+        const auto &stats = m_callback_stats;
+        const std::array lines = {
+            std::format("Frame  p50 {:.1f}  p95 {:.1f}  p99 {:.1f} ms", percentile(0.5F), percentile(0.95F), percentile(0.99F)),
+            std::format("Events {:.2f}  Uploads {:.2f}  Update {:.2f}  Render {:.2f}  Present {:.2f} ms",
+                        average(stages[0]), average(stages[1]), average(stages[2]), average(stages[3]), average(stages[4])),
+            std::format("Audio  {:.2f} of {:.2f} ms  overruns {}  xruns {}  underflows {}",
+                        stats.last_duration * to_ms, stats.period * to_ms, stats.overruns, stats.xruns, stats.underflows),
+            std::format("GL  {} draws  {} uploads ({:.1f} KiB)  {} state changes, {} skipped",
+                        m_gl_counters.draw_calls, m_gl_counters.uploads, static_cast<float>(m_gl_counters.upload_bytes) / 1024.F,
+                        m_gl_counters.issued, m_gl_counters.skipped),
+        };
+
+        auto content_location = get_location();
+        auto content_size = get_content_area_size();
+        constexpr float margin = 10.F;
+        constexpr float line_height = 22.F;
+        auto text_height = (static_cast<float>(lines.size()) * line_height) + margin;
+        auto graph_size = glm::vec2{ (content_size.x - (3 * margin)) / 2.F, std::max(0.F, content_size.y - text_height - (2 * margin)) };
+
+        // Clear previous text submissions for clipping to work correctly
+        opengl::c_text_renderer::instance().draw_texts();
+        opengl::c_renderer::set_scissor_area(get_location(), get_size());
+        m_batch.clear();
+        glm::vec2 graph_position = { content_location.x + margin, content_location.y + margin };
+        add_graph(graph_position, graph_size, 4 * frame_budget, frame_budget, [this](std::size_t index)
+                  { return m_frames.at(index).interval; });
+        graph_position.x += graph_size.x + margin;
+        add_graph(graph_position, graph_size, 1.5F, 1.F, [this](std::size_t index)
+                  { return m_callback_load.at(index); });
+        m_batch.draw(renderer());
+
+        glm::vec3 text_color = { 0.9F, 0.9F, 0.9F };
+        auto text_y = content_location.y + content_size.y - line_height;
+        for (const auto &line : lines)
+        {
+            opengl::c_text_renderer::instance().submit(line, { content_location.x + margin, text_y }, 0.6F, text_color);
+            text_y -= line_height;
+        }
+        opengl::c_text_renderer::instance().draw_texts();
+        opengl::c_renderer::reset_scissor_area();
+    }
+} // namespace gui
@@ -3,12 +3,12 @@ module;
 #include <cstdint>
 #include <functional>
 #include <string>
+#include <utility>
 #include <vector>
 export module gui:menu;
 
 import opengl;
 import glm;
-import utility;
 
 export namespace gui
 {
@@ -36,7 +36,6 @@ export namespace gui
         ~c_popup_menu() = default;
 
         void render() const;
-        void set_projection(const glm::mat4 &proj);
 
         // Event handling
         auto on_mouse_move(glm::vec2 mouse_position) -> void;
@@ -57,7 +56,6 @@ export namespace gui
         glm::vec2 m_position;
         glm::vec2 m_target_position;
         glm::vec2 m_click_origin; // Where the right-click happened
-        glm::mat4 m_projection;
         std::vector<s_menu_item> m_menu_items;
 
         // Animation properties
@@ -71,6 +69,9 @@ export namespace gui
         float m_menu_width = 180.0F;
         float m_menu_margin = 8.0F;
 
+        // Rendering
+        mutable opengl::shapes::c_batch m_batch{ 256 };
+
         // Internal methods
         void update_menu_item_sizes();
         auto get_menu_item_at_position(glm::vec2 position) -> s_menu_item *;
@@ -88,8 +89,7 @@ namespace gui
     c_popup_menu::c_popup_menu()
         : m_position(0.0F),
           m_target_position(0.0F),
-          m_click_origin(0.0F),
-          m_projection(1.F)
+          m_click_origin(0.0F)
     {
         auto init = [&]
         {
@@ -101,7 +101,7 @@ namespace gui
 
             update_menu_item_sizes();
         };
-        utility::c_notifier::subscribe(init);
+        opengl::c_command_queue::instance().submit(std::move(init));
     }
 
     void c_popup_menu::render() const
@@ -115,33 +115,30 @@ namespace gui
         auto current_size = get_current_size();
         auto alpha = get_current_alpha();
 
+        m_batch.clear();
+
         // Menu background with better colors inspired by panels
         glm::vec4 menu_bg_color = { 0.06F, 0.06F, 0.12F, 0.95F * alpha }; // Dark blue-ish like panels
-        opengl::shapes::c_rectangle(current_pos, current_size, menu_bg_color).draw(opengl::c_renderer{}, m_projection);
+        m_batch.add_rectangle(current_pos, current_size, menu_bg_color);
 
         // Menu border with subtle glow effect
         glm::vec4 border_color = { 0.22F, 0.22F, 0.28F, 0.8F * alpha }; // Subtle purple-gray border
         float border_thickness = 1.5F;
 
         // Top border
-        opengl::shapes::c_rectangle(current_pos + glm::vec2{ 0, current_size.y - border_thickness },
-                                    { current_size.x, border_thickness }, border_color)
-            .draw(opengl::c_renderer{}, m_projection);
+        m_batch.add_rectangle(current_pos + glm::vec2{ 0, current_size.y - border_thickness }, { current_size.x, border_thickness }, border_color);
         // Bottom border
-        opengl::shapes::c_rectangle(current_pos, { current_size.x, border_thickness }, border_color)
-            .draw(opengl::c_renderer{}, m_projection);
+        m_batch.add_rectangle(current_pos, { current_size.x, border_thickness }, border_color);
         // Left border
-        opengl::shapes::c_rectangle(current_pos, { border_thickness, current_size.y }, border_color)
-            .draw(opengl::c_renderer{}, m_projection);
+        m_batch.add_rectangle(current_pos, { border_thickness, current_size.y }, border_color);
         // Right border
-        opengl::shapes::c_rectangle(current_pos + glm::vec2{ current_size.x - border_thickness, 0 },
-                                    { border_thickness, current_size.y }, border_color)
-            .draw(opengl::c_renderer{}, m_projection);
+        m_batch.add_rectangle(current_pos + glm::vec2{ current_size.x - border_thickness, 0 }, { border_thickness, current_size.y }, border_color);
 
         // Only render menu items if the menu is big enough to show them
         float full_height = (static_cast<float>(m_menu_items.size()) * m_menu_item_height) + (2.0F * m_menu_margin);
         if (current_size.y < m_menu_item_height / 2.0F || current_size.x < m_menu_width / 3.0F)
         {
+            m_batch.draw(opengl::c_renderer{});
             return; // Too small to show items yet
         }
 
@@ -164,7 +161,7 @@ namespace gui
             if (item.is_hovered)
             {
                 glm::vec4 hover_color = { 0.15F, 0.15F, 0.25F, 0.9F * alpha }; // Slightly brighter blue-purple
-                opengl::shapes::c_rectangle(item_pos, item_size, hover_color).draw(opengl::c_renderer{}, m_projection);
+                m_batch.add_rectangle(item_pos, item_size, hover_color);
             }
 
             // Text with better contrast
@@ -179,11 +176,8 @@ namespace gui
 
             opengl::c_text_renderer::instance().submit(item.text, text_pos, 1.0F, menu_text_color);
         }
-    }
 
-    void c_popup_menu::set_projection(const glm::mat4 &proj)
-    {
-        m_projection = proj;
+        m_batch.draw(opengl::c_renderer{});
     }
 
     auto c_popup_menu::on_mouse_move(glm::vec2 mouse_position) -> void
@@ -0,0 +1,158 @@
+module;
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <format>
+#include <span>
+#include <string>
+#include <vector>
+export module gui:meter;
+
+import :panel;
+import music;
+import math;
+import opengl;
+import glm;
+
+export namespace gui
+{
+    /**
+     * @brief Loudness meter of the mixed output: momentary, short-term and integrated LUFS, and true peak.
+     *
+     * The mix is received through an output tap of the audio manager, so the audio callback never waits on the meter;
+     * measuring happens on the UI thread in update_meter(). Samples are lost if a frame takes longer than the tap holds.
+     */
+    class c_meter_panel final : public c_panel
+    {
+    public:
+        c_meter_panel(glm::vec2 position, glm::vec2 size, music::c_audio_manager &audio_manager);
+
+        /**
+         * @brief Measure what was played since the last frame.
+         */
+        auto update_meter() -> void;
+
+        /**
+         * @brief Restart the integrated loudness and peaks, as at the start of a programme.
+         */
+        auto reset() -> void;
+
+        auto render_content() const -> void override;
+
+        auto on_mouse_move(glm::vec2 mouse_position) -> void override
+        {
+            c_panel::on_mouse_move(mouse_position);
+        };
+        auto on_mouse_press(glm::vec2 mouse_position, e_mouse_button button) -> void override
+        {
+            c_panel::on_mouse_press(mouse_position, button);
+        };
+        auto on_mouse_release(glm::vec2 mouse_position, e_mouse_button button) -> void override
+        {
+            c_panel::on_mouse_release(mouse_position, button);
+        };
+        auto on_resize(float width, float height) -> void override
+        {
+            c_panel::on_resize(width, height);
+        };
+        auto on_mouse_scroll(glm::vec2 position, glm::vec2 scroll_delta) -> void override
+        {
+            c_panel::on_mouse_scroll(position, scroll_delta);
+        };
+
+    private:
+        music::c_tap_subscription m_tap;
+        std::vector<float> m_samples;
+        math::c_loudness_meter m_meter;
+
+        // Bar scale
+        float m_floor{ -60.F };
+        float m_ceiling{ 3.F };
+
+        mutable opengl::shapes::c_batch m_batch;
+    };
+} // namespace gui
+
+// Implementation
+namespace gui
+{
+    c_meter_panel::c_meter_panel(glm::vec2 position, glm::vec2 size, music::c_audio_manager &audio_manager)
+        : c_panel(position, size, "Loudness"),
+          m_tap(audio_manager.subscribe_output()),
+          m_meter(static_cast<float>(audio_manager.sample_rate()), audio_manager.channels())
+    {
+        m_samples.resize(m_tap.capacity());
+
+        // Readings change every frame, caching them would only add a copy
+        set_retained(false);
+    }
+
+    auto c_meter_panel::update_meter() -> void
+    {
+        if (not m_tap)
+        {
+            return;
+        }
+        auto count = m_tap.read(m_samples);
+        m_meter.process(std::span(m_samples).first(count));
+    }
+
+    auto c_meter_panel::reset() -> void
+    {
+        m_meter.reset();
+    }
+
+    auto c_meter_panel::render_content() const -> void
+    {
+        struct s_reading
+        {
+            const char *label;
+            float value;
+            const char *unit;
+            bool is_peak;
+        };
+        const std::array readings = {
+            s_reading{ "M", m_meter.momentary(), "LUFS", false },
+            s_reading{ "S", m_meter.short_term(), "LUFS", false },
+            s_reading{ "I", m_meter.integrated(), "LUFS", false },
+            s_reading{ "TP", m_meter.true_peak(), "dBTP", true },
+        };
+
+        auto content_location = get_location();
+        auto content_size = get_content_area_size();
+        constexpr float margin = 10.F;
+        constexpr float label_width = 50.F;
+        constexpr float value_width = 150.F;
+        auto row_height = (content_size.y - margin) / static_cast<float>(readings.size());
+        auto bar_width = std::max(0.F, content_size.x - label_width - value_width - (3 * margin));
+
+        // Clear previous text submissions for clipping to work correctly
+        opengl::c_text_renderer::instance().draw_texts();
+        opengl::c_renderer::set_scissor_area(get_location(), get_size());
+        m_batch.clear();
+        for (std::size_t index = 0; index < readings.size(); ++index)
+        {
+            const auto &reading = readings.at(index);
+            auto y = content_location.y + content_size.y - (static_cast<float>(index + 1) * row_height);
+            glm::vec2 bar_position = { content_location.x + label_width + margin, y + (row_height * 0.25F) };
+            glm::vec2 bar_size = { bar_width, row_height * 0.5F };
+
+            // Above -1 dBTP the peak risks clipping after lossy encoding or resampling
+            auto level = std::isfinite(reading.value) ? std::clamp((reading.value - m_floor) / (m_ceiling - m_floor), 0.F, 1.F) : 0.F;
+            bool is_hot = reading.is_peak and reading.value > -1.F;
+            glm::vec4 bar_color = is_hot ? glm::vec4{ 0.9F, 0.2F, 0.2F, 1.F } : glm::vec4{ 0.2F, 0.8F, 0.4F, 1.F };
+            m_batch.add_rectangle(bar_position, bar_size, { 0.2F, 0.2F, 0.2F, 1.F });
+            m_batch.add_rectangle(bar_position, { bar_size.x * level, bar_size.y }, bar_color);
+
+            glm::vec3 text_color = { 0.9F, 0.9F, 0.9F };
+            auto text_y = y + (row_height * 0.35F);
+            auto value = std::isfinite(reading.value) ? std::format("{:.1f} {}", reading.value, reading.unit) : std::format("- {}", reading.unit);
+            opengl::c_text_renderer::instance().submit(reading.label, { content_location.x + margin, text_y }, 0.8F, text_color);
+            opengl::c_text_renderer::instance().submit(value, { bar_position.x + bar_width + margin, text_y }, 0.8F, text_color);
+        }
+        m_batch.draw(renderer());
+        opengl::c_text_renderer::instance().draw_texts();
+        opengl::c_renderer::reset_scissor_area();
+    }
+} // namespace gui
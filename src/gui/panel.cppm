@@ -1,5 +1,8 @@
 module;
+#include <GL/glew.h>
+
 #include <array>
+#include <cmath>
 #include <cstdint>
 #include <functional>
 #include <optional>
@@ -86,6 +89,10 @@ export namespace gui
      *   - Closing: Remove the panel from view.
      *   - Customizable title bar with buttons for minimize and close actions.
      *   - Event handling for mouse interactions.
+     *
+     * Panels are retained by default: they are drawn into a cached framebuffer, re-rendered only after mark_dirty()
+     * or when needs_redraw() reports a change, and composited into the window every frame. Panels whose content
+     * changes every frame should disable this with set_retained(false).
      */
     class c_panel
     {
@@ -102,6 +109,7 @@ export namespace gui
         auto minimize() -> void;
         auto restore() -> void;
         auto close() -> void;
+        auto open() -> void; // Show a closed panel again
 
         // Event handling interfaces
         virtual auto on_mouse_move(glm::vec2 mouse_position) -> void = 0;
@@ -113,6 +121,11 @@ export namespace gui
         // Rendering
         virtual auto render() const -> void;
 
+        /**
+         * @brief Request the cached image of the panel to be re-rendered before the next composite.
+         */
+        auto mark_dirty() const -> void;
+
         // Accessors
         auto is_minimized() const -> bool;
         auto is_closed() const -> bool;
@@ -125,10 +138,10 @@ export namespace gui
         auto set_resizable(bool resizable) -> void;
         auto set_movable(bool movable) -> void;
         auto set_closable(bool closable) -> void;
+        auto set_retained(bool retained) -> void;
+        [[nodiscard]] auto is_retained() const -> bool;
 
-        auto set_projection_matrix(const glm::mat4 &projection) -> void;
         auto set_mouse_position(glm::vec2 mouse_position) -> void;
-        auto get_projection_matrix() const -> glm::mat4;
 
     protected:
         virtual auto render_content() const -> void {};
@@ -136,6 +149,14 @@ export namespace gui
         virtual auto on_panel_minimized() -> void {};
         virtual auto on_panel_restored() -> void {};
 
+        /**
+         * @brief Polled before compositing a retained panel; return true if content changed since it was last drawn.
+         */
+        virtual auto needs_redraw() const -> bool
+        {
+            return false;
+        };
+
         auto renderer() const -> opengl::c_renderer &;
         auto inline get_content_area_size() const -> glm::vec2;
         auto inline get_mouse_position() const -> glm::vec2;
@@ -146,8 +167,8 @@ export namespace gui
         glm::vec2 m_size{};
         glm::vec2 m_original_size{};
         glm::vec2 m_original_location{};
-        glm::mat4 m_projection{};
         std::string m_title;
+        std::uint32_t m_profile_zone; // Named after the title given at construction
 
         // State
         e_panel_state m_state = e_panel_state::normal;
@@ -160,6 +181,7 @@ export namespace gui
         bool m_resizable = true;
         bool m_movable = true;
         bool m_closable = true;
+        bool m_retained = true;
 
         // UI elements
         std::vector<s_button> m_buttons;
@@ -172,6 +194,16 @@ export namespace gui
         // Rendering
         mutable opengl::c_renderer m_renderer;
         opengl::c_shader m_shader{ SOURCE_DIR "/src/shaders/panel_shader.glsl" };
+        mutable opengl::c_streaming_buffer<glm::vec2> m_background_stream{ 6 };
+        mutable opengl::c_vertex_array m_background_vertex_array;
+        mutable std::uint32_t m_background_generation{};
+        mutable opengl::shapes::c_batch m_chrome_batch{ 256 }; // Title bar and buttons
+
+        // Retained rendering
+        mutable std::optional<opengl::c_framebuffer> m_cache;
+        mutable bool m_dirty = true;
+        opengl::c_shader m_composite_shader{ SOURCE_DIR "/src/shaders/composite_shader.glsl" };
+        mutable opengl::c_vertex_array m_composite_vertex_array;
 
         // Helper methods
         auto init_buttons() -> void;
@@ -181,6 +213,8 @@ export namespace gui
         auto get_resize_direction(glm::vec2 point) const -> std::optional<e_resize_direction>;
         auto get_button_at_position(glm::vec2 position) -> s_button *;
         auto drag_or_resize_panel(glm::vec2 mouse_position) -> void;
+        auto draw() const -> void;
+        auto redraw_cache() const -> bool;
         auto render_title_bar() const -> void;
         auto render_buttons() const -> void;
         static auto get_button_color(const s_button &button) -> glm::vec4;
@@ -195,19 +229,16 @@ namespace gui
           m_size{ size },
           m_original_size{ size },
           m_original_location{ position },
-          m_projection{ 1.F },
-          m_title{ std::move(title) }
+          m_title{ std::move(title) },
+          m_profile_zone{ utility::profiling_enabled ? utility::c_profiler::instance().register_zone("Panel " + m_title) : 0 }
     {
         init_buttons();
         update_button_positions();
-        auto init = [this]
-        {
-            m_shader.set_uniform_4f("u_fill_color", { 0.05F, 0.05F, 0.1F, 0.9F });
-            m_shader.set_uniform_4f("u_border_color", { 0.17F, 0.17F, 0.17F, 0.5F });
-            m_shader.set_uniform_1f("u_border_radius", 10);
-            m_shader.set_uniform_1f("u_border_thickness", 8);
-        };
-        utility::c_notifier::subscribe(init);
+        m_shader.set_uniform_4f("u_fill_color", { 0.05F, 0.05F, 0.1F, 0.9F });
+        m_shader.set_uniform_4f("u_border_color", { 0.17F, 0.17F, 0.17F, 0.5F });
+        m_shader.set_uniform_1f("u_border_radius", 10);
+        m_shader.set_uniform_1f("u_border_thickness", 8);
+        m_composite_shader.set_uniform_1i("u_texture", 0);
     }
 
     auto c_panel::update_location(glm::vec2 new_location) -> void
@@ -215,6 +246,7 @@ namespace gui
         m_location = new_location;
         m_shader.set_uniform_2f("u_panel_pos", m_location);
         update_button_positions();
+        mark_dirty();
     }
 
     auto c_panel::update_size(glm::vec2 new_size) -> void
@@ -222,11 +254,13 @@ namespace gui
         m_size = new_size;
         m_shader.set_uniform_2f("u_panel_size", m_size);
         update_button_positions();
+        mark_dirty();
     }
 
     auto c_panel::set_title(const std::string &title) -> void
     {
         m_title = title;
+        mark_dirty();
     }
 
     auto c_panel::minimize() -> void
@@ -239,6 +273,7 @@ namespace gui
             m_size.y = m_title_bar_height;
             on_panel_minimized();
             update_button_positions();
+            mark_dirty();
         }
     }
 
@@ -251,6 +286,7 @@ namespace gui
             m_size = m_original_size;
             on_panel_restored();
             update_button_positions();
+            mark_dirty();
         }
     }
 
@@ -260,15 +296,29 @@ namespace gui
         on_panel_closed();
     }
 
+    auto c_panel::open() -> void
+    {
+        if (m_closed)
+        {
+            m_closed = false;
+            mark_dirty();
+        }
+    }
+
     auto c_panel::on_mouse_move(glm::vec2 mouse_position) -> void
     {
         // Update button hover states
         for (auto &button : m_buttons)
         {
-            button.hovered = (mouse_position.x >= button.position.x
-                              and mouse_position.x <= button.position.x + button.size.x
-                              and mouse_position.y >= button.position.y
-                              and mouse_position.y <= button.position.y + button.size.y);
+            bool hovered = (mouse_position.x >= button.position.x
+                            and mouse_position.x <= button.position.x + button.size.x
+                            and mouse_position.y >= button.position.y
+                            and mouse_position.y <= button.position.y + button.size.y);
+            if (hovered != button.hovered)
+            {
+                button.hovered = hovered;
+                mark_dirty();
+            }
         }
 
         drag_or_resize_panel(mouse_position);
@@ -291,6 +341,7 @@ namespace gui
             if (clicked_button)
             {
                 clicked_button->pressed = true;
+                mark_dirty();
                 if (clicked_button->callback)
                 {
                     clicked_button->callback();
@@ -323,7 +374,11 @@ namespace gui
         // Reset button pressed states
         for (auto &panel_button : m_buttons)
         {
-            panel_button.pressed = false;
+            if (panel_button.pressed)
+            {
+                panel_button.pressed = false;
+                mark_dirty();
+            }
         }
     }
 
@@ -344,28 +399,93 @@ namespace gui
         {
             return;
         }
+        utility::c_profile_zone zone(m_profile_zone);
+
+        if (not m_retained or not redraw_cache())
+        {
+            draw();
+            return;
+        }
 
+        // Composite the cached image, which holds premultiplied alpha
+        auto &state = opengl::c_gl_state::instance();
+        glm::vec2 origin = { std::floor(m_location.x), std::floor(m_location.y) };
+        auto size = glm::vec2(m_cache->size());
+        state.blend_func(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+        m_composite_shader.set_uniform_4f("u_area", { origin.x, origin.y, size.x, size.y });
+        m_cache->texture().bind(0);
+        m_renderer.draw_arrays(m_composite_vertex_array, m_composite_shader, opengl::e_render_primitive::triangles, 0, 6);
+        state.blend_func(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    }
+
+    auto c_panel::redraw_cache() const -> bool
+    {
+        glm::ivec2 size = { static_cast<int>(std::ceil(m_size.x)) + 1, static_cast<int>(std::ceil(m_size.y)) + 1 };
+        if (size.x <= 0 or size.y <= 0)
+        {
+            return false;
+        }
+        if (not m_cache or m_cache->size() != size)
+        {
+            m_cache.emplace(size);
+            m_dirty = true;
+        }
+        if (not m_cache->is_ready())
+        {
+            // Still queued for creation, draw directly until it exists
+            return false;
+        }
+
+        if (needs_redraw())
+        {
+            m_dirty = true;
+        }
+        if (not m_dirty)
+        {
+            return true;
+        }
+
+        // Text submitted by panels drawn before this one belongs to the window
+        opengl::c_text_renderer::instance().draw_texts();
+
+        m_cache->begin({ std::floor(m_location.x), std::floor(m_location.y) });
+        draw();
+        opengl::c_text_renderer::instance().draw_texts();
+        opengl::c_renderer::reset_scissor_area();
+        m_cache->end();
+
+        m_dirty = false;
+        return true;
+    }
+
+    auto c_panel::draw() const -> void
+    {
         // Draw panel background
-        std::vector<glm::vec2> panel_corners = {
+        std::array<glm::vec2, 6> panel_corners = {
             m_location,
             { m_location.x + m_size.x, m_location.y },
             { m_location.x + m_size.x, m_location.y + m_size.y },
-            { m_location.x, m_location.y + m_size.y }
+            { m_location.x + m_size.x, m_location.y + m_size.y },
+            { m_location.x, m_location.y + m_size.y },
+            m_location
         };
-        opengl::c_buffer_layout layout;
-        layout.push<float>(2); // Position
-        opengl::c_vertex_buffer<glm::vec2> vertex_buffer(panel_corners, panel_corners.size());
-        opengl::c_index_buffer index_buffer({ 0, 1, 2, 2, 3, 0 }, 6);
-        opengl::c_vertex_array vertex_array;
-        vertex_array.add_buffer(vertex_buffer, layout);
-        opengl::c_renderer renderer;
-        renderer.draw(vertex_array, vertex_buffer, index_buffer, m_shader);
-
-        // Render title bar
-        render_title_bar();
+        if (auto first = m_background_stream.upload(panel_corners); first != opengl::c_streaming_buffer<glm::vec2>::npos)
+        {
+            if (m_background_stream.generation() != m_background_generation)
+            {
+                opengl::c_buffer_layout layout;
+                layout.push<float>(2); // Position
+                m_background_vertex_array.add_buffer(m_background_stream, layout);
+                m_background_generation = m_background_stream.generation();
+            }
+            m_renderer.draw_arrays(m_background_vertex_array, m_shader, opengl::e_render_primitive::triangles, first, panel_corners.size());
+        }
 
-        // Render buttons
+        // Render title bar and buttons in one batch
+        m_chrome_batch.clear();
+        render_title_bar();
         render_buttons();
+        m_chrome_batch.draw(m_renderer);
 
         // Render content area (only if not minimized)
         if (!is_minimized())
@@ -506,7 +626,7 @@ namespace gui
         glm::vec2 title_bar_size = { m_size.x, m_title_bar_height };
         glm::vec4 title_bar_color = { 0.2F, 0.2F, 0.3F, 1.0F };
 
-        opengl::shapes::c_rectangle(title_bar_pos, title_bar_size, title_bar_color).draw(m_renderer, m_projection);
+        m_chrome_batch.add_rectangle(title_bar_pos, title_bar_size, title_bar_color);
         auto title_text_size = opengl::c_text_renderer::instance().get_size(m_title, 1.F);
         opengl::c_text_renderer::instance().submit(m_title, title_bar_pos + glm::vec2{ (title_bar_size.x - title_text_size.x) / 2, (title_text_size.y) / 2 }, 1.F, glm::vec3{ 1.F, 1.F, 1.F });
     }
@@ -516,7 +636,7 @@ namespace gui
         for (const auto &button : m_buttons)
         {
             glm::vec4 button_color = get_button_color(button);
-            opengl::shapes::c_rectangle(button.position, button.size, button_color).draw(m_renderer, m_projection);
+            m_chrome_batch.add_rectangle(button.position, button.size, button_color);
 
             // Draw button symbols
             glm::vec2 button_center = button.position + button.size * 0.5F;
@@ -531,15 +651,15 @@ namespace gui
                 glm::vec2 line2_start = button_center + glm::vec2(-symbol_size, symbol_size);
                 glm::vec2 line2_end = button_center + glm::vec2(symbol_size, -symbol_size);
 
-                opengl::shapes::c_line(line1_start, line1_end, symbol_color).draw(m_renderer, m_projection);
-                opengl::shapes::c_line(line2_start, line2_end, symbol_color).draw(m_renderer, m_projection);
+                m_chrome_batch.add_line(line1_start, line1_end, symbol_color);
+                m_chrome_batch.add_line(line2_start, line2_end, symbol_color);
             }
             else if (button.type == e_button_type::minimize)
             {
                 // Draw a horizontal line
                 glm::vec2 line_start = button_center + glm::vec2(-symbol_size, 0.0F);
                 glm::vec2 line_end = button_center + glm::vec2(symbol_size, 0.0F);
-                opengl::shapes::c_line(line_start, line_end, symbol_color).draw(m_renderer, m_projection);
+                m_chrome_batch.add_line(line_start, line_end, symbol_color);
             }
         }
     }
@@ -595,6 +715,26 @@ namespace gui
         m_movable = movable;
     }
 
+    auto c_panel::set_retained(bool retained) -> void
+    {
+        m_retained = retained;
+        if (not retained)
+        {
+            m_cache.reset();
+        }
+        mark_dirty();
+    }
+
+    auto c_panel::is_retained() const -> bool
+    {
+        return m_retained;
+    }
+
+    auto c_panel::mark_dirty() const -> void
+    {
+        m_dirty = true;
+    }
+
     auto c_panel::set_resizable(bool resizable) -> void
     {
         m_resizable = resizable;
@@ -673,6 +813,10 @@ namespace gui
         m_shader.set_uniform_2f("u_panel_pos", m_location);
         m_shader.set_uniform_2f("u_panel_size", m_size);
         update_button_positions();
+        if (m_drag_state != none)
+        {
+            mark_dirty();
+        }
     }
 
     auto c_panel::is_closed() const -> bool
@@ -685,22 +829,11 @@ namespace gui
         return m_state == e_panel_state::minimized;
     }
 
-    auto c_panel::set_projection_matrix(const glm::mat4 &projection) -> void
-    {
-        m_projection = projection;
-        m_shader.set_uniform_mat4f("projection", m_projection);
-    }
-
     auto c_panel::set_mouse_position(glm::vec2 mouse_position) -> void
     {
         on_mouse_move(mouse_position);
     }
 
-    auto c_panel::get_projection_matrix() const -> glm::mat4
-    {
-        return m_projection;
-    }
-
     auto c_panel::renderer() const -> opengl::c_renderer &
     {
         return m_renderer;
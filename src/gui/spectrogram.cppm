@@ -0,0 +1,131 @@
+module;
+#include <GL/glew.h>
+
+#include <cstddef>
+#include <optional>
+#include <span>
+#include <vector>
+export module gui:spectrogram;
+
+import :panel;
+import math;
+import opengl;
+import glm;
+
+export namespace gui
+{
+    /**
+     * @brief Scrolling time-frequency view.
+     *
+     * Every analysis frame is written as one column into a 2D texture used as a ring buffer, so the history is never
+     * re-uploaded: each frame costs a single glTexSubImage2D of one column. The shader scrolls the ring by offsetting
+     * the horizontal texture coordinate, with the newest column on the right. Magnitudes are coloured through a
+     * lookup texture of the magma map.
+     */
+    class c_spectrogram_panel final : public c_panel
+    {
+    public:
+        c_spectrogram_panel(glm::vec2 position, glm::vec2 size, std::size_t history_length = 1024);
+
+        /**
+         * @brief Append one column of band magnitudes, normalized to [0, 1].
+         *
+         * The number of bands is fixed by the first column; the history is cleared if it changes.
+         */
+        auto push_column(std::span<const float> magnitudes) -> void;
+        auto render_content() const -> void override;
+
+        auto on_mouse_move(glm::vec2 mouse_position) -> void override
+        {
+            c_panel::on_mouse_move(mouse_position);
+        };
+        auto on_mouse_press(glm::vec2 mouse_position, e_mouse_button button) -> void override
+        {
+            c_panel::on_mouse_press(mouse_position, button);
+        };
+        auto on_mouse_release(glm::vec2 mouse_position, e_mouse_button button) -> void override
+        {
+            c_panel::on_mouse_release(mouse_position, button);
+        };
+        auto on_resize(float width, float height) -> void override
+        {
+            c_panel::on_resize(width, height);
+        };
+        auto on_mouse_scroll(glm::vec2 position, glm::vec2 scroll_delta) -> void override
+        {
+            c_panel::on_mouse_scroll(position, scroll_delta);
+        };
+
+    private:
+        std::size_t m_history_length;
+        std::size_t m_write_column{};
+        std::optional<opengl::c_texture> m_history; // history_length x band count, R32F
+        math::c_colormap m_colormap{ math::e_colormap::magma };
+        std::optional<opengl::c_texture> m_colormap_texture; // m_colormap, uploaded with the first column
+        opengl::c_vertex_array m_empty_vertex_array;
+        opengl::c_shader m_shader;
+    };
+} // namespace gui
+
+// Implementation
+namespace gui
+{
+    c_spectrogram_panel::c_spectrogram_panel(glm::vec2 position, glm::vec2 size, std::size_t history_length)
+        : c_panel(position, size, "Spectrogram"),
+          m_history_length(history_length),
+          m_shader(SOURCE_DIR "/src/shaders/spectrogram_shader.glsl")
+    {
+        m_shader.set_uniform_1i("u_history", 0);
+        m_shader.set_uniform_1i("u_colormap", 1);
+
+        // A column is added every frame, caching it would only add a copy
+        set_retained(false);
+    }
+
+    auto c_spectrogram_panel::push_column(std::span<const float> magnitudes) -> void
+    {
+        if (magnitudes.empty())
+        {
+            return;
+        }
+
+        auto bands = static_cast<int>(magnitudes.size());
+        if (not m_history or m_history->size().y != bands)
+        {
+            m_history.emplace(opengl::e_texture_target::texture_2d, GL_R32F, glm::ivec2{ static_cast<int>(m_history_length), bands }, GL_LINEAR, GL_REPEAT);
+            m_write_column = 0;
+
+            // Storage starts undefined, start from silence
+            std::vector<float> silence(m_history_length * magnitudes.size(), 0.F);
+            m_history->update(silence, { 0, 0 }, m_history->size());
+        }
+
+        if (not m_colormap_texture)
+        {
+            auto entries = static_cast<int>(m_colormap.size());
+            m_colormap_texture.emplace(opengl::e_texture_target::texture_1d, GL_RGBA32F, glm::ivec2{ entries, 1 }, GL_LINEAR);
+            m_colormap_texture->update(m_colormap.table(), { 0, 0 }, { entries, 1 });
+        }
+
+        m_history->update(magnitudes, { static_cast<int>(m_write_column), 0 }, { 1, bands });
+        m_write_column = (m_write_column + 1) % m_history_length;
+
+        auto content_location = get_location();
+        auto content_size = get_content_area_size();
+        m_shader.set_uniform_1f("u_offset", static_cast<float>(m_write_column) / static_cast<float>(m_history_length));
+        m_shader.set_uniform_4f("u_area", { content_location.x, content_location.y, content_size.x, content_size.y });
+    }
+
+    auto c_spectrogram_panel::render_content() const -> void
+    {
+        if (not m_history)
+        {
+            return;
+        }
+        opengl::c_renderer::set_scissor_area(get_location(), get_size());
+        m_history->bind(0);
+        m_colormap_texture->bind(1);
+        renderer().draw_arrays(m_empty_vertex_array, m_shader, opengl::e_render_primitive::triangles, 0, 6);
+        opengl::c_renderer::reset_scissor_area();
+    }
+} // namespace gui
@@ -2,9 +2,12 @@ module;
 #include <algorithm>
 #include <chrono>
 #include <cmath>
+#include <cstdint>
 #include <memory>
+#include <optional>
 #include <string>
-#include <variant>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 export module gui:tracks;
 
@@ -15,14 +18,22 @@ import glm;
 
 export namespace gui
 {
+    /**
+     * @brief Scrollable list of the loaded tracks.
+     *
+     * Entries still loading, or that failed to load, are listed as placeholder rows with a status text.
+     *
+     * Only the rows inside the visible range are visited, so the cost of a frame depends on the panel height and not
+     * on the number of tracks. The static part of a row (box, borders, play button, truncated name) is cached and
+     * only re-generated when its width or play state changes; the progress bar and time are rebuilt every draw.
+     */
     class c_track_panel final : public c_panel
     {
     public:
-        c_track_panel(glm::vec2 position, glm::vec2 size, const std::vector<std::shared_ptr<music::c_track>> &tracks);
+        c_track_panel(glm::vec2 position, glm::vec2 size, const std::vector<music::s_track_entry> &tracks, music::c_audio_manager &audio_manager);
         ~c_track_panel() override = default;
 
         void render_content() const override;
-        void set_projection(const glm::mat4 &proj);
 
         auto on_mouse_press(glm::vec2 mouse_position, e_mouse_button button) -> void override;
         auto on_mouse_release(glm::vec2 mouse_position, e_mouse_button button) -> void override;
@@ -30,29 +41,88 @@ export namespace gui
         auto on_mouse_move(glm::vec2 mouse_position) -> void override;
         auto on_resize(float width, float height) -> void override;
 
+    protected:
+        auto needs_redraw() const -> bool override;
+
     private:
-        const std::vector<std::shared_ptr<music::c_track>> &m_tracks;
-        glm::mat4 m_proj;
+        // What a row showed when the panel was last drawn
+        struct s_row_state
+        {
+            music::e_load_state load_state{};
+            bool is_playing{};
+            bool has_peaks{};
+            int progress_pixel{};
+            int elapsed_seconds{};
+
+            auto operator==(const s_row_state &) const -> bool = default;
+        };
+
+        // Parts of a row that only change with its width, load state or play state
+        struct s_row_cache
+        {
+            float width{};
+            std::optional<music::e_load_state> load_state;
+            bool is_playing{};
+            std::vector<opengl::s_vertex> geometry; // Relative to the entry position
+            std::string display_name;
+            std::string total_time;
+            float time_text_width{}; // Widest time text of the track, fixes the progress bar width
+            std::uint64_t total_frames{};
+            std::uint64_t last_used{}; // Draw that last visited the row
+        };
+
+        const std::vector<music::s_track_entry> &m_tracks;
+        music::c_audio_manager &m_audio_manager;
 
         // Layout constants
         float m_margin{ 20.F };
         float m_track_entry_height{ 60.F };
         float m_spacing{ 10.F };
         float m_button_radius{ 15.F };
+        float m_progress_bar_height{ 8.F };
+        float m_progress_text_margin{ 10.F };
 
         // Scrolling state
         mutable float m_scroll_offset{};
         mutable float m_max_scroll{};
+
+        // Whole-track overview, drawn in place of the progress bar once the peaks are available
+        float m_overview_half_height{ 9.F };
+        mutable std::vector<music::s_peak> m_overview_columns;
+
+        // Visible rows as last drawn, to detect changes
+        mutable std::size_t m_drawn_first{};
+        mutable std::size_t m_drawn_track_count{};
+        mutable std::vector<s_row_state> m_drawn_rows;
+
+        // Cache of the visible rows by index, evicted once they scroll out of view
+        mutable std::unordered_map<std::size_t, s_row_cache> m_row_cache;
+        mutable std::uint64_t m_draw_count{};
+
+        // Rendering
+        mutable opengl::shapes::c_batch m_batch;
+
+        [[nodiscard]] auto visible_rows() const -> std::pair<std::size_t, std::size_t>;
+        [[nodiscard]] auto entry_position(std::size_t index) const -> glm::vec2;
+        [[nodiscard]] auto entry_size() const -> glm::vec2;
+        [[nodiscard]] auto row_cache(const music::s_track_entry &entry, std::size_t index) const -> s_row_cache &;
+        [[nodiscard]] auto progress_bar_area(const s_row_cache &row, glm::vec2 entry_position) const -> std::pair<glm::vec2, glm::vec2>;
+        [[nodiscard]] auto row_state(const music::s_track_entry &entry, std::size_t index) const -> s_row_state;
+
+        auto add_row_shapes(const music::s_track_entry &entry, glm::vec2 entry_position) const -> void;
+        auto add_status(const music::s_track_entry &entry, const s_row_cache &row, glm::vec2 entry_position) const -> void;
+        auto add_progress(music::c_track &track, const s_row_cache &row, glm::vec2 entry_position) const -> void;
+        auto add_overview(const music::c_peak_pyramid &peaks, glm::vec2 position, glm::vec2 size, float progress, bool is_playing) const -> void;
     };
 } // namespace gui
 
 // Implementation
 namespace gui
 {
-    c_track_panel::c_track_panel(glm::vec2 position, glm::vec2 size, const std::vector<std::shared_ptr<music::c_track>> &tracks)
+    c_track_panel::c_track_panel(glm::vec2 position, glm::vec2 size, const std::vector<music::s_track_entry> &tracks, music::c_audio_manager &audio_manager)
         : c_panel(position, size, "Audio Tracks"),
           m_tracks(tracks),
-          m_proj(glm::gtc::ortho(0.0F, size.x, 0.0F, size.y, -1.0F, 1.0F))
+          m_audio_manager(audio_manager)
     {
     }
 
@@ -80,133 +150,272 @@ namespace gui
         m_max_scroll = std::max(0.0F, total_content_height - content_size.y);
         m_scroll_offset = std::clamp(m_scroll_offset, 0.0F, m_max_scroll);
 
-        float current_y = (content_position.y + content_size.y) - m_margin - m_track_entry_height + m_scroll_offset;
-
-        std::vector<opengl::shapes::variant> shape_batch;
-        for (const auto &track : m_tracks)
+        ++m_draw_count;
+        m_batch.clear();
+        auto [first, last] = visible_rows();
+        for (auto index = first; index < last; ++index)
         {
-            if (!track)
+            const auto &entry = m_tracks[index];
+            const auto &track = entry.track;
+            bool is_playing = track and track->is_playing();
+
+            glm::vec2 position = entry_position(index);
+            auto &row = row_cache(entry, index);
+            row.last_used = m_draw_count;
+
+            // Box, borders and play button: replay the cached triangles unless the row changed
+            if (row.geometry.empty() or row.is_playing != is_playing)
+            {
+                auto first_vertex = m_batch.vertex_count();
+                add_row_shapes(entry, position);
+                auto added = m_batch.vertices().subspan(first_vertex);
+                row.geometry.assign(added.begin(), added.end());
+                for (auto &vertex : row.geometry)
+                {
+                    vertex.position.x -= position.x;
+                    vertex.position.y -= position.y;
+                }
+                row.is_playing = is_playing;
+            }
+            else
             {
-                continue;
+                m_batch.append(row.geometry, position);
             }
 
-            // Track entry background box
-            glm::vec2 entry_position = { content_position.x + m_margin, current_y };
-            glm::vec2 entry_size = { content_size.x - (m_margin * 2.0F), m_track_entry_height };
+            // Track name text (moved up for better proportional placement)
+            glm::vec2 text_pos = { position.x + (2.0F * m_margin) + (2.0F * m_button_radius), position.y + (m_track_entry_height / 2.0F) + 4.0F };
+            glm::vec3 text_color = { 0.9F, 0.9F, 0.9F };
+            opengl::c_text_renderer::instance().submit(row.display_name, text_pos, 1.0F, text_color);
 
-            glm::vec4 bg_color = { 0.15F, 0.15F, 0.2F, 0.9F };
-            shape_batch.emplace_back(opengl::shapes::c_rectangle(entry_position, entry_size, bg_color));
+            if (entry.state == music::e_load_state::ready and track)
+            {
+                add_progress(*track, row, position);
+            }
+            else
+            {
+                add_status(entry, row, position);
+            }
+        }
 
-            // Border around the entry
-            glm::vec4 border_color = { 0.4F, 0.4F, 0.5F, 1.0F };
-            float border_width = 2.0F;
+        // Rows that scrolled out of view are rebuilt if they come back
+        std::erase_if(m_row_cache, [this](const auto &entry)
+                      { return entry.second.last_used != m_draw_count; });
 
-            // Top border
-            float top_border_y = entry_position.y + entry_size.y - border_width;
-            shape_batch.emplace_back(opengl::shapes::c_rectangle({ entry_position.x, top_border_y }, { entry_size.x, border_width }, border_color));
+        m_batch.draw(renderer());
+        opengl::c_text_renderer::instance().draw_texts();
+        opengl::c_renderer::reset_scissor_area();
+    }
 
-            // Bottom border
-            shape_batch.emplace_back(opengl::shapes::c_rectangle(entry_position, { entry_size.x, border_width }, border_color));
+    auto c_track_panel::visible_rows() const -> std::pair<std::size_t, std::size_t>
+    {
+        // Row i spans [top - margin - (i + 1) * height - i * spacing, ...] below the scrolled content top
+        float stride = m_track_entry_height + m_spacing;
+        float content_height = get_content_area_size().y;
+        auto first = static_cast<std::size_t>(std::max(0.0F, std::floor((m_scroll_offset - m_margin - m_track_entry_height) / stride) + 1.0F));
+        auto last = static_cast<std::size_t>(std::max(0.0F, std::floor((m_scroll_offset - m_margin + content_height) / stride) + 1.0F));
+        last = std::min(last, m_tracks.size());
+        return { std::min(first, last), last };
+    }
 
-            // Left border
-            shape_batch.emplace_back(opengl::shapes::c_rectangle(entry_position, { border_width, entry_size.y }, border_color));
+    auto c_track_panel::entry_position(std::size_t index) const -> glm::vec2
+    {
+        glm::vec2 content_position = get_location();
+        float content_top = content_position.y + get_content_area_size().y;
+        float offset = static_cast<float>(index) * (m_track_entry_height + m_spacing);
+        return { content_position.x + m_margin, content_top - m_margin - m_track_entry_height - offset + m_scroll_offset };
+    }
 
-            // Right border
-            float right_border_x = entry_position.x + entry_size.x - border_width;
-            shape_batch.emplace_back(opengl::shapes::c_rectangle({ right_border_x, entry_position.y }, { border_width, entry_size.y }, border_color));
+    auto c_track_panel::entry_size() const -> glm::vec2
+    {
+        return { get_content_area_size().x - (m_margin * 2.0F), m_track_entry_height };
+    }
 
-            // Play button (circular)
-            glm::vec2 button_center = { entry_position.x + m_margin + m_button_radius, entry_position.y + (entry_size.y / 2.0F) };
-            glm::vec4 button_color = track->is_playing() ? glm::vec4{ 0.2F, 0.8F, 0.2F, 1.0F }  // Green
-                                                         : glm::vec4{ 0.6F, 0.6F, 0.6F, 1.0F }; // Gray
-            shape_batch.emplace_back(opengl::shapes::c_circle(button_center, m_button_radius, button_color));
+    auto c_track_panel::row_cache(const music::s_track_entry &entry, std::size_t index) const -> s_row_cache &
+    {
+        auto &row = m_row_cache[index];
+        float width = entry_size().x;
+        if (row.width == width and row.load_state == entry.state)
+        {
+            return row;
+        }
 
-            // Play symbol (triangle) or pause symbol (two rectangles)
-            glm::vec4 symbol_color = { 1.0F, 1.0F, 1.0F, 1.0F };
-            if (track->is_playing())
+        if (row.load_state != entry.state)
+        {
+            row.load_state = entry.state;
+            row.total_frames = 0;
+            row.total_time.clear();
+            row.time_text_width = 0.0F;
+            if (entry.state == music::e_load_state::ready and entry.track)
             {
-                // Pause symbol
-                float rect_width = 4.0F;
-                float rect_height = 12.0F;
-                glm::vec2 pause_left = button_center + glm::vec2(-6.0F, -rect_height / 2.0F);
-                glm::vec2 pause_right = button_center + glm::vec2(2.0F, -rect_height / 2.0F);
-
-                shape_batch.emplace_back(opengl::shapes::c_rectangle(pause_left, { rect_width, rect_height }, symbol_color));
-                shape_batch.emplace_back(opengl::shapes::c_rectangle(pause_right, { rect_width, rect_height }, symbol_color));
+                // Constant for the lifetime of the track, avoid asking the decoder every frame
+                row.total_frames = entry.track->get_total_frames();
+                constexpr float sample_rate = 44100.0F;
+                float total_seconds = static_cast<float>(row.total_frames) / sample_rate;
+                int total_minutes = static_cast<int>(total_seconds) / 60;
+                int total_secs = static_cast<int>(total_seconds) % 60;
+                row.total_time = std::to_string(total_minutes) + ":" + (total_secs < 10 ? "0" : "") + std::to_string(total_secs);
+                row.time_text_width = opengl::c_text_renderer::instance().get_size(row.total_time + " / " + row.total_time, 0.8F).x;
             }
-            else
-            {
-                // Play symbol
-                float triangle_size = 8.0F;
-                glm::vec2 tri_p1 = button_center + glm::vec2(-triangle_size * 0.5F, -triangle_size * 0.6F);
-                glm::vec2 tri_p2 = button_center + glm::vec2(-triangle_size * 0.5F, triangle_size * 0.6F);
-                glm::vec2 tri_p3 = button_center + glm::vec2(triangle_size * 0.7F, 0.0F);
+        }
 
-                shape_batch.emplace_back(opengl::shapes::c_triangle(tri_p1, tri_p2, tri_p3, symbol_color));
-            }
+        row.width = width;
+        row.geometry.clear();
 
-            // Track name text (moved up for better proportional placement)
-            glm::vec2 text_pos = { button_center.x + m_button_radius + m_margin, entry_position.y + (entry_size.y / 2.0F) + 4.0F };
-            std::string track_name = track->get_filename();
+        std::string track_name = entry.path.filename().string();
+        auto text_size = opengl::c_text_renderer::instance().get_size(track_name, 1.0F);
+        float available_width = width - ((2.0F * m_button_radius) + (m_margin * 3.0F));
+        if (text_size.x > available_width)
+        {
+            // Truncate and add "..."
+            float ratio = available_width / text_size.x;
+            std::size_t new_length = static_cast<std::size_t>(std::max(0.0F, std::floor(static_cast<float>(track_name.length()) * ratio) - 3.0F)); // length * ratio - 3 for "..."
+            track_name = track_name.substr(0, new_length) + "...";
+        }
+        row.display_name = std::move(track_name);
+        return row;
+    }
 
-            auto text_size = opengl::c_text_renderer::instance().get_size(track_name, 1.0F);
-            float available_width = entry_size.x - (button_center.x + m_button_radius + m_margin * 2.0F - entry_position.x);
+    auto c_track_panel::progress_bar_area(const s_row_cache &row, glm::vec2 entry_position) const -> std::pair<glm::vec2, glm::vec2>
+    {
+        // Progress bar starts at track name x-position and ends before time text
+        glm::vec2 size = entry_size();
+        glm::vec2 progress_bg_pos = {
+            entry_position.x + (2.0F * m_margin) + (2.0F * m_button_radius),
+            entry_position.y + (size.y / 2.0F) - 12.0F
+        };
+        glm::vec2 progress_bg_size = {
+            size.x - (progress_bg_pos.x - entry_position.x) - row.time_text_width - m_progress_text_margin - m_margin,
+            m_progress_bar_height
+        };
+        return { progress_bg_pos, progress_bg_size };
+    }
 
-            if (text_size.x > available_width)
-            {
-                // Truncate and add "..."
-                float ratio = available_width / text_size.x;
-                std::size_t new_length = static_cast<std::size_t>(std::max(0.0F, std::floor(static_cast<float>(track_name.length()) * ratio) - 3.0F)); // length * ratio - 3 for "..."
-                track_name = track_name.substr(0, new_length) + "...";
-            }
+    auto c_track_panel::row_state(const music::s_track_entry &entry, std::size_t index) const -> s_row_state
+    {
+        if (entry.state != music::e_load_state::ready or not entry.track)
+        {
+            return { .load_state = entry.state };
+        }
+        auto &track = *entry.track;
+        auto it = m_row_cache.find(index);
+        auto total_frames = it != m_row_cache.end() and it->second.load_state == entry.state ? it->second.total_frames : track.get_total_frames();
+        auto current_frame = track.get_cursor_frame();
+        auto progress = total_frames > 0 ? static_cast<float>(current_frame) / static_cast<float>(total_frames) : 0.0F;
+        return {
+            .load_state = entry.state,
+            .is_playing = track.is_playing(),
+            .has_peaks = track.peaks() != nullptr,
+            .progress_pixel = static_cast<int>(progress * entry_size().x),
+            .elapsed_seconds = static_cast<int>(current_frame / 44100),
+        };
+    }
 
-            glm::vec3 text_color = { 0.9F, 0.9F, 0.9F };
-            opengl::c_text_renderer::instance().submit(track_name, text_pos, 1.0F, text_color);
-
-            // Progress bar section
-            float progress_bar_height = 8.0F;
-            float progress_text_margin = 10.0F;
-
-            // Calculate progress
-            std::uint64_t current_frame = track->get_cursor_frame();
-            std::uint64_t total_frames = track->get_total_frames();
-            float progress = (total_frames > 0) ? static_cast<float>(current_frame) / static_cast<float>(total_frames) : 0.0F;
-            progress = std::clamp(progress, 0.0F, 1.0F);
-
-            // Calculate time text to determine progress bar width
-            constexpr float sample_rate = 44100.0F;
-            float current_seconds = static_cast<float>(current_frame) / sample_rate;
-            float total_seconds = static_cast<float>(total_frames) / sample_rate;
-
-            int current_minutes = static_cast<int>(current_seconds) / 60;
-            int current_secs = static_cast<int>(current_seconds) % 60;
-            int total_minutes = static_cast<int>(total_seconds) / 60;
-            int total_secs = static_cast<int>(total_seconds) % 60;
-
-            std::string progress_text = std::to_string(current_minutes) + ":" + (current_secs < 10 ? "0" : "") + std::to_string(current_secs) + " / " + std::to_string(total_minutes) + ":" + (total_secs < 10 ? "0" : "") + std::to_string(total_secs);
-
-            auto time_text_size = opengl::c_text_renderer::instance().get_size(progress_text, 0.8F);
-
-            // Progress bar starts at track name x-position and ends before time text
-            glm::vec2 progress_bg_pos = {
-                button_center.x + m_button_radius + m_margin,
-                entry_position.y + (entry_size.y / 2.0F) - 12.0F
-            };
-            glm::vec2 progress_bg_size = {
-                entry_size.x - (progress_bg_pos.x - entry_position.x) - time_text_size.x - progress_text_margin - m_margin,
-                progress_bar_height
-            };
+    auto c_track_panel::add_row_shapes(const music::s_track_entry &entry, glm::vec2 entry_position) const -> void
+    {
+        glm::vec2 size = entry_size();
+        bool is_playing = entry.track and entry.track->is_playing();
+
+        // Track entry background box
+        glm::vec4 bg_color = { 0.15F, 0.15F, 0.2F, 0.9F };
+        m_batch.add_rectangle(entry_position, size, bg_color);
+
+        // Border around the entry
+        glm::vec4 border_color = { 0.4F, 0.4F, 0.5F, 1.0F };
+        float border_width = 2.0F;
+
+        // Top border
+        float top_border_y = entry_position.y + size.y - border_width;
+        m_batch.add_rectangle({ entry_position.x, top_border_y }, { size.x, border_width }, border_color);
+
+        // Bottom border
+        m_batch.add_rectangle(entry_position, { size.x, border_width }, border_color);
+
+        // Left border
+        m_batch.add_rectangle(entry_position, { border_width, size.y }, border_color);
+
+        // Right border
+        float right_border_x = entry_position.x + size.x - border_width;
+        m_batch.add_rectangle({ right_border_x, entry_position.y }, { border_width, size.y }, border_color);
+
+        // Play button (circular)
+        glm::vec2 button_center = { entry_position.x + m_margin + m_button_radius, entry_position.y + (size.y / 2.0F) };
+        glm::vec4 button_color = is_playing ? glm::vec4{ 0.2F, 0.8F, 0.2F, 1.0F }  // Green
+                                            : glm::vec4{ 0.6F, 0.6F, 0.6F, 1.0F }; // Gray
+        if (entry.state != music::e_load_state::ready)
+        {
+            // Dimmed while loading, red if the file could not be opened; no symbol since it cannot be played
+            button_color = entry.state == music::e_load_state::failed ? glm::vec4{ 0.6F, 0.2F, 0.2F, 1.0F } : glm::vec4{ 0.3F, 0.3F, 0.35F, 1.0F };
+            m_batch.add_circle(button_center, m_button_radius, button_color);
+            return;
+        }
+        m_batch.add_circle(button_center, m_button_radius, button_color);
+
+        // Play symbol (triangle) or pause symbol (two rectangles)
+        glm::vec4 symbol_color = { 1.0F, 1.0F, 1.0F, 1.0F };
+        if (is_playing)
+        {
+            // Pause symbol
+            float rect_width = 4.0F;
+            float rect_height = 12.0F;
+            glm::vec2 pause_left = button_center + glm::vec2(-6.0F, -rect_height / 2.0F);
+            glm::vec2 pause_right = button_center + glm::vec2(2.0F, -rect_height / 2.0F);
+
+            m_batch.add_rectangle(pause_left, { rect_width, rect_height }, symbol_color);
+            m_batch.add_rectangle(pause_right, { rect_width, rect_height }, symbol_color);
+        }
+        else
+        {
+            // Play symbol
+            float triangle_size = 8.0F;
+            glm::vec2 tri_p1 = button_center + glm::vec2(-triangle_size * 0.5F, -triangle_size * 0.6F);
+            glm::vec2 tri_p2 = button_center + glm::vec2(-triangle_size * 0.5F, triangle_size * 0.6F);
+            glm::vec2 tri_p3 = button_center + glm::vec2(triangle_size * 0.7F, 0.0F);
+
+            m_batch.add_triangle(tri_p1, tri_p2, tri_p3, symbol_color);
+        }
+    }
+
+    auto c_track_panel::add_status(const music::s_track_entry &entry, const s_row_cache &row, glm::vec2 entry_position) const -> void
+    {
+        // Placeholder rows show their status where the progress bar will be
+        auto [status_pos, status_size] = progress_bar_area(row, entry_position);
+        std::string status = entry.state == music::e_load_state::failed ? "Failed to load" : "Loading...";
+        glm::vec3 status_color = entry.state == music::e_load_state::failed ? glm::vec3{ 0.9F, 0.4F, 0.4F } : glm::vec3{ 0.6F, 0.6F, 0.7F };
+        opengl::c_text_renderer::instance().submit(status, { status_pos.x, status_pos.y - 2.0F }, 0.8F, status_color);
+    }
+
+    auto c_track_panel::add_progress(music::c_track &track, const s_row_cache &row, glm::vec2 entry_position) const -> void
+    {
+        // Calculate progress
+        std::uint64_t current_frame = track.get_cursor_frame();
+        float progress = (row.total_frames > 0) ? static_cast<float>(current_frame) / static_cast<float>(row.total_frames) : 0.0F;
+        progress = std::clamp(progress, 0.0F, 1.0F);
+
+        constexpr float sample_rate = 44100.0F;
+        float current_seconds = static_cast<float>(current_frame) / sample_rate;
+        int current_minutes = static_cast<int>(current_seconds) / 60;
+        int current_secs = static_cast<int>(current_seconds) % 60;
+        std::string progress_text = std::to_string(current_minutes) + ":" + (current_secs < 10 ? "0" : "") + std::to_string(current_secs) + " / " + row.total_time;
+
+        auto [progress_bg_pos, progress_bg_size] = progress_bar_area(row, entry_position);
+        auto peaks = track.peaks();
+        if (peaks and peaks->total_frames() > 0)
+        {
+            add_overview(*peaks, progress_bg_pos, progress_bg_size, progress, track.is_playing());
+        }
+        else
+        {
             glm::vec4 progress_bg_color = { 0.25F, 0.25F, 0.3F, 0.8F };
-            shape_batch.emplace_back(opengl::shapes::c_rectangle(progress_bg_pos, progress_bg_size, progress_bg_color));
+            m_batch.add_rectangle(progress_bg_pos, progress_bg_size, progress_bg_color);
 
             // Progress bar fill (colored based on play state)
             if (progress > 0.0F)
             {
-                glm::vec2 progress_fill_size = { progress_bg_size.x * progress, progress_bar_height };
-                glm::vec4 progress_fill_color = track->is_playing()
+                glm::vec2 progress_fill_size = { progress_bg_size.x * progress, m_progress_bar_height };
+                glm::vec4 progress_fill_color = track.is_playing()
                                                     ? glm::vec4{ 0.2F, 0.7F, 1.0F, 0.9F }  // Bright blue when playing
                                                     : glm::vec4{ 0.6F, 0.6F, 0.7F, 0.7F }; // Gray when paused
-                shape_batch.emplace_back(opengl::shapes::c_rectangle(progress_bg_pos, progress_fill_size, progress_fill_color));
+                m_batch.add_rectangle(progress_bg_pos, progress_fill_size, progress_fill_color);
             }
 
             // Progress bar border for definition
@@ -214,55 +423,96 @@ namespace gui
             float progress_border_width = 1.0F;
 
             // Top border
-            shape_batch.emplace_back(opengl::shapes::c_rectangle(
-                { progress_bg_pos.x, progress_bg_pos.y + progress_bar_height - progress_border_width },
+            m_batch.add_rectangle(
+                { progress_bg_pos.x, progress_bg_pos.y + m_progress_bar_height - progress_border_width },
                 { progress_bg_size.x, progress_border_width },
-                progress_border_color));
+                progress_border_color);
 
             // Bottom border
-            shape_batch.emplace_back(opengl::shapes::c_rectangle(
+            m_batch.add_rectangle(
                 progress_bg_pos,
                 { progress_bg_size.x, progress_border_width },
-                progress_border_color));
+                progress_border_color);
 
             // Left border
-            shape_batch.emplace_back(opengl::shapes::c_rectangle(
+            m_batch.add_rectangle(
                 progress_bg_pos,
-                { progress_border_width, progress_bar_height },
-                progress_border_color));
+                { progress_border_width, m_progress_bar_height },
+                progress_border_color);
 
             // Right border
-            shape_batch.emplace_back(opengl::shapes::c_rectangle(
+            m_batch.add_rectangle(
                 { progress_bg_pos.x + progress_bg_size.x - progress_border_width, progress_bg_pos.y },
-                { progress_border_width, progress_bar_height },
-                progress_border_color));
+                { progress_border_width, m_progress_bar_height },
+                progress_border_color);
+        }
 
-            // Progress text (current time / total time) - positioned at the right end
-            glm::vec2 progress_text_pos = {
-                progress_bg_pos.x + progress_bg_size.x + progress_text_margin,
-                progress_bg_pos.y - 2.0F // Slightly offset for better alignment
-            };
+        // Progress text (current time / total time) - positioned at the right end
+        glm::vec2 progress_text_pos = {
+            progress_bg_pos.x + progress_bg_size.x + m_progress_text_margin,
+            progress_bg_pos.y - 2.0F // Slightly offset for better alignment
+        };
 
-            glm::vec3 progress_text_color = { 0.7F, 0.7F, 0.8F };
-            opengl::c_text_renderer::instance().submit(progress_text, progress_text_pos, 0.8F, progress_text_color);
+        glm::vec3 progress_text_color = { 0.7F, 0.7F, 0.8F };
+        opengl::c_text_renderer::instance().submit(progress_text, progress_text_pos, 0.8F, progress_text_color);
+    }
 
-            // Move to next track position
-            current_y -= (m_track_entry_height + m_spacing);
+    auto c_track_panel::add_overview(const music::c_peak_pyramid &peaks, glm::vec2 position, glm::vec2 size, float progress, bool is_playing) const -> void
+    {
+        // One column per pixel, the pyramid level is chosen from the frames each pixel covers
+        auto columns = static_cast<std::size_t>(std::max(0.0F, std::floor(size.x)));
+        if (columns == 0)
+        {
+            return;
         }
-        for (auto &shape : shape_batch)
+        m_overview_columns.resize(columns);
+        peaks.sample(0, peaks.total_frames(), m_overview_columns);
+
+        glm::vec4 played_color = is_playing ? glm::vec4{ 0.2F, 0.7F, 1.0F, 0.9F } : glm::vec4{ 0.6F, 0.6F, 0.7F, 0.8F };
+        glm::vec4 unplayed_color = { 0.4F, 0.4F, 0.5F, 0.8F };
+        float center_y = position.y + (size.y / 2.0F);
+        auto played_columns = static_cast<std::size_t>(progress * static_cast<float>(columns));
+
+        for (std::size_t column = 0; column < columns; ++column)
         {
-            std::visit([this](auto &shape_obj)
-                       { shape_obj.draw(renderer(), m_proj); },
-                       shape);
+            const auto &peak = m_overview_columns[column];
+            float x = position.x + static_cast<float>(column);
+            float bottom = center_y + (std::clamp(peak.min, -1.0F, 1.0F) * m_overview_half_height);
+            float top = center_y + (std::clamp(peak.max, -1.0F, 1.0F) * m_overview_half_height);
+            glm::vec4 color = column < played_columns ? played_color : unplayed_color;
+            glm::vec4 envelope_color = { color.r, color.g, color.b, color.a * 0.6F };
+
+            // Min/max envelope, at least a pixel high so silence still shows the extent of the track
+            m_batch.add_rectangle({ x, bottom }, { 1.0F, std::max(top - bottom, 1.0F) }, envelope_color);
+
+            // RMS body on top
+            float rms = std::min(peak.rms, 1.0F) * m_overview_half_height;
+            m_batch.add_rectangle({ x, center_y - rms }, { 1.0F, std::max(2.0F * rms, 1.0F) }, color);
         }
-        opengl::c_text_renderer::instance().draw_texts();
-        opengl::c_renderer::reset_scissor_area();
+
+        // Playhead
+        m_batch.add_rectangle({ position.x + (progress * size.x), center_y - m_overview_half_height }, { 1.0F, 2.0F * m_overview_half_height }, { 1.0F, 1.0F, 1.0F, 0.9F });
     }
 
-    void c_track_panel::set_projection(const glm::mat4 &proj)
+    auto c_track_panel::needs_redraw() const -> bool
     {
-        m_proj = proj;
-        set_projection_matrix(proj);
+        // Only the visible rows can change the image; progress is compared in pixels, so a playing track only causes
+        // a redraw when its bar actually moves
+        auto [first, last] = visible_rows();
+        bool changed = first != m_drawn_first or m_tracks.size() != m_drawn_track_count or m_drawn_rows.size() != last - first;
+        m_drawn_first = first;
+        m_drawn_track_count = m_tracks.size();
+        m_drawn_rows.resize(last - first);
+        for (auto index = first; index < last; ++index)
+        {
+            auto state = row_state(m_tracks[index], index);
+            if (state != m_drawn_rows[index - first])
+            {
+                m_drawn_rows[index - first] = state;
+                changed = true;
+            }
+        }
+        return changed;
     }
 
     auto c_track_panel::on_mouse_press(glm::vec2 mouse_position, e_mouse_button button) -> void
@@ -283,87 +533,61 @@ namespace gui
         {
             return;
         }
-
-        float current_y = content_pos.y + content_size.y - m_margin - m_track_entry_height + m_scroll_offset;
-
-        for (const auto &track : m_tracks)
+        if (mouse_position.y < content_pos.y || mouse_position.y > content_pos.y + content_size.y)
         {
-            if (!track)
-            {
-                current_y -= (m_track_entry_height + m_spacing);
-                continue;
-            }
-
-            // Check if this entry is visible (at least partially)
-            if (current_y + m_track_entry_height < content_pos.y || current_y > content_pos.y + content_size.y)
-            {
-                current_y -= (m_track_entry_height + m_spacing);
-                continue;
-            }
-
-            // Calculate entry position for current track
-            glm::vec2 entry_position = { content_pos.x + m_margin, current_y };
-            glm::vec2 entry_size = { content_size.x - (m_margin * 2.0F), m_track_entry_height };
+            return;
+        }
 
-            // Calculate play button position and check if click is within it
-            glm::vec2 button_center = { content_pos.x + (2 * m_margin) + m_button_radius, current_y + (m_track_entry_height / 2.0F) };
+        // Find the row under the cursor directly instead of walking the list
+        float from_top = content_pos.y + content_size.y - m_margin + m_scroll_offset - mouse_position.y;
+        float stride = m_track_entry_height + m_spacing;
+        if (from_top < 0.0F || std::fmod(from_top, stride) > m_track_entry_height)
+        {
+            return;
+        }
+        auto index = static_cast<std::size_t>(from_top / stride);
+        if (index >= m_tracks.size() || m_tracks[index].state != music::e_load_state::ready || !m_tracks[index].track)
+        {
+            return;
+        }
+        const auto &entry = m_tracks[index];
+        const auto &track = entry.track;
+        glm::vec2 position = entry_position(index);
 
-            // Check if mouse click is within the circular play button
-            float distance = std::hypot(mouse_position.x - button_center.x, mouse_position.y - button_center.y);
+        // Check if mouse click is within the circular play button
+        glm::vec2 button_center = { position.x + m_margin + m_button_radius, position.y + (m_track_entry_height / 2.0F) };
+        float distance = std::hypot(mouse_position.x - button_center.x, mouse_position.y - button_center.y);
 
-            if (distance <= m_button_radius)
+        if (distance <= m_button_radius)
+        {
+            // Toggle play/pause for this track
+            if (track->is_playing())
             {
-                // Toggle play/pause for this track
-                if (track->is_playing())
-                {
-                    track->pause();
-                }
-                else
-                {
-                    track->play();
-                }
-                return; // Exit after handling the click
+                m_audio_manager.pause(*track);
             }
-
-            // Check if click is on progress bar for seeking
-            float progress_bar_height = 8.0F;
-            float progress_text_margin = 10.0F;
-
-            // Calculate time text to determine progress bar width (same calculation as in render)
-            std::uint64_t total_frames = track->get_total_frames();
-            constexpr float sample_rate = 44100.0F;
-            float total_seconds = static_cast<float>(total_frames) / sample_rate;
-            int total_minutes = static_cast<int>(total_seconds) / 60;
-            int total_secs = static_cast<int>(total_seconds) % 60;
-            std::string time_text = "0:00 / " + std::to_string(total_minutes) + ":" + (total_secs < 10 ? "0" : "") + std::to_string(total_secs);
-            auto time_text_size = opengl::c_text_renderer::instance().get_size(time_text, 0.8F);
-
-            // Progress bar position and size (same calculation as in render)
-            glm::vec2 progress_bg_pos = {
-                button_center.x + m_button_radius + m_margin,
-                entry_position.y + (entry_size.y / 2.0F) - 12.0F
-            };
-            glm::vec2 progress_bg_size = {
-                entry_size.x - (progress_bg_pos.x - entry_position.x) - time_text_size.x - progress_text_margin - m_margin,
-                progress_bar_height
-            };
-
-            // Check if click is within progress bar bounds
-            if (mouse_position.x >= progress_bg_pos.x && mouse_position.x <= progress_bg_pos.x + progress_bg_size.x && mouse_position.y >= progress_bg_pos.y && mouse_position.y <= progress_bg_pos.y + progress_bg_size.y)
+            else
             {
-                // Calculate seek position based on click x position
-                float click_ratio = (mouse_position.x - progress_bg_pos.x) / progress_bg_size.x;
-                click_ratio = std::clamp(click_ratio, 0.0F, 1.0F);
+                m_audio_manager.play(*track);
+            }
+            return;
+        }
 
-                // Calculate target frame
-                auto target_frame = static_cast<std::uint64_t>(static_cast<float>(total_frames) * click_ratio);
+        // Check if click is on progress bar for seeking; the overview extends above and below the bar
+        const auto &row = row_cache(entry, index);
+        auto [progress_bg_pos, progress_bg_size] = progress_bar_area(row, position);
+        float hit_center_y = progress_bg_pos.y + (progress_bg_size.y / 2.0F);
+        float hit_half_height = track->peaks() ? m_overview_half_height : progress_bg_size.y / 2.0F;
+        if (mouse_position.x >= progress_bg_pos.x && mouse_position.x <= progress_bg_pos.x + progress_bg_size.x && mouse_position.y >= hit_center_y - hit_half_height && mouse_position.y <= hit_center_y + hit_half_height)
+        {
+            // Calculate seek position based on click x position
+            float click_ratio = (mouse_position.x - progress_bg_pos.x) / progress_bg_size.x;
+            click_ratio = std::clamp(click_ratio, 0.0F, 1.0F);
 
-                // Seek to target frame
-                track->seek(target_frame);
-            }
+            // Calculate target frame
+            auto target_frame = static_cast<std::uint64_t>(static_cast<float>(row.total_frames) * click_ratio);
 
-            // Move to next track position
-            current_y -= (m_track_entry_height + m_spacing);
+            // Seek to target frame
+            m_audio_manager.seek(*track, target_frame);
         }
     }
 
@@ -387,6 +611,7 @@ namespace gui
 
         // Clamp scroll offset to valid range
         m_scroll_offset = std::clamp(m_scroll_offset, 0.0F, m_max_scroll);
+        mark_dirty();
     }
 
     auto c_track_panel::on_mouse_move(glm::vec2 mouse_position) -> void
@@ -1,11 +1,21 @@
 module;
+#include <GL/glew.h>
+
 #include <algorithm>
+#include <array>
 #include <chrono>
 #include <cmath>
 #include <complex>
+#include <cstddef>
+#include <cstdint>
 #include <cstring>
-#include <mutex>
+#include <format>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <print>
 #include <ranges>
+#include <span>
 #include <string>
 #include <vector>
 export module gui:waveform;
@@ -15,9 +25,22 @@ import music;
 import math;
 import opengl;
 import glm;
+import utility;
 
 export namespace gui
 {
+    enum class e_spectrum_render_mode : std::uint8_t
+    {
+        cpu, // Bars and caps are tessellated on the CPU into a shape batch
+        gpu, // Only band intensities are uploaded, spectrum_shader builds the bars
+    };
+
+    enum class e_analysis_backend : std::uint8_t
+    {
+        semitone_fft, // Loudest linear FFT bin per semitone-wide interval
+        constant_q,   // Constant-Q transform, one bin per semitone from C2
+    };
+
     class c_waveform_panel final : public c_panel
     {
     public:
@@ -25,7 +48,42 @@ export namespace gui
 
         auto update_waveform() -> void;
         auto render_content() const -> void override;
-        auto set_projection(const glm::mat4 &proj) -> void;
+
+        /**
+         * @brief Semitone band magnitudes of the last analysis frame, normalized to the loudest band.
+         */
+        [[nodiscard]] auto band_intensities() const -> std::span<const float>;
+
+        auto set_render_mode(e_spectrum_render_mode mode) -> void;
+        [[nodiscard]] auto get_render_mode() const -> e_spectrum_render_mode;
+
+        /**
+         * @brief Choose how bands are computed. The sample history is restarted, as the backends need different lengths.
+         */
+        auto set_analysis_backend(e_analysis_backend backend) -> void;
+        [[nodiscard]] auto get_analysis_backend() const -> e_analysis_backend;
+
+        /**
+         * @brief Analyse a single track through its analysis tap instead of the mix; nullptr goes back to the mix.
+         */
+        auto set_source(std::shared_ptr<music::c_track> track) -> void;
+        [[nodiscard]] auto get_source() const -> const std::shared_ptr<music::c_track> &;
+
+        /**
+         * @brief Rhythm of the analysed signal, as of the last update_waveform().
+         *
+         * Onsets come from the spectral flux of band frames and beats and tempo are tracked on that flux, both stepped
+         * at a fixed rate, as frames arrive at the display rate.
+         */
+        [[nodiscard]] auto is_onset() const -> bool;
+        [[nodiscard]] auto is_beat() const -> bool;
+        [[nodiscard]] auto tempo() const -> float;
+        [[nodiscard]] auto beat_phase() const -> float;
+
+        /**
+         * @brief Fundamental frequency of the newest samples, as of the last update_waveform().
+         */
+        [[nodiscard]] auto pitch() const -> math::s_pitch;
 
         auto on_mouse_move(glm::vec2 mouse_position) -> void override
         {
@@ -49,14 +107,45 @@ export namespace gui
         };
 
     private:
+        // Steps per second of the onset detector and beat tracker, whatever the frame rate
+        static constexpr float s_rhythm_rate = 60.F;
+
         music::c_audio_manager &m_audio_manager;
+        std::shared_ptr<music::c_track> m_source;
+        music::c_tap_subscription m_tap; // After m_source, detached before the track is released
+        std::vector<float> m_tap_samples;
 
         float m_max_intensity{};
         std::vector<float> m_audio_samples;
+        std::vector<float> m_windowed_samples;
+        std::vector<float> m_band_intensities;
         std::vector<float> m_smoothed_intensities;
-        std::vector<opengl::shapes::c_rectangle> m_rectangles;
-        std::vector<opengl::shapes::c_circle> m_circles;
+        e_spectrum_render_mode m_render_mode{ e_spectrum_render_mode::gpu };
+        e_analysis_backend m_analysis_backend{ e_analysis_backend::semitone_fft };
+        std::optional<math::c_constant_q> m_constant_q; // Kernel built when the backend is first selected
+        math::c_onset_detector m_onsets{ { .hop_rate = s_rhythm_rate } };
+        math::c_beat_tracker m_beats{ { .hop_rate = s_rhythm_rate } };
+        float m_rhythm_clock{}; // Seconds of frames not yet stepped through
+        bool m_is_onset{};
+        bool m_is_beat{};
+        int m_shown_tempo{};
+        math::c_pitch_detector m_pitch_detector;
+        math::s_pitch m_pitch;
+        int m_shown_note{}; // MIDI number in the title, 0 for none
+        math::c_colormap m_colormap = math::c_colormap::hsv_sweep(.75F, 1.F); // Bar colour by intensity
+        mutable opengl::shapes::c_batch m_batch;             // Bars and caps, rebuilt by update_waveform in cpu mode
+        std::optional<opengl::c_texture> m_band_texture;     // One texel per band, updated every frame in gpu mode
+        std::optional<opengl::c_texture> m_colormap_texture; // m_colormap for the gpu mode, uploaded once
+        opengl::c_vertex_array m_empty_vertex_array;         // spectrum_shader has no vertex attributes
         opengl::c_shader m_shader;
+
+        auto build_batch() -> void;
+        auto upload_bands() -> void;
+        auto analyse() -> void;
+        auto track_rhythm(std::span<const float> intensities, float delta_time) -> void;
+        auto track_pitch() -> void;
+        auto update_title() -> void;
+        [[nodiscard]] auto read_samples() -> std::vector<float>;
     };
 } // namespace gui
 
@@ -66,16 +155,21 @@ namespace gui
     c_waveform_panel::c_waveform_panel(glm::vec2 position, glm::vec2 size, music::c_audio_manager &audio_manager)
         : c_panel(position, size, "Waveform Panel"),
           m_audio_manager(audio_manager),
-          m_shader(SOURCE_DIR "/src/shaders/frequency_shader.glsl")
+          m_shader(SOURCE_DIR "/src/shaders/spectrum_shader.glsl")
     {
         m_audio_samples.resize(1U << 13U);
+        m_band_intensities.reserve(1U << 12U);
         m_smoothed_intensities.reserve(1U << 12U);
+        m_shader.set_uniform_1i("u_bands", 0);
+        m_shader.set_uniform_1i("u_colormap", 1);
+
+        // The spectrum changes every frame, caching it would only add a copy
+        set_retained(false);
     }
 
     auto c_waveform_panel::update_waveform() -> void
     {
-        using math::helpers::operator""_percent;
-        std::vector<float> current_frame_audio_samples = m_audio_manager.output_buffer()
+        std::vector<float> current_frame_audio_samples = read_samples()
                                                          | std::views::chunk(2)
                                                          | std::views::transform([](auto &&stereo_sample)
                                                                                  { return (static_cast<float>(stereo_sample[0]) + static_cast<float>(stereo_sample[1])) / 2.F; })
@@ -93,61 +187,180 @@ namespace gui
             std::memmove(m_audio_samples.data() + count_to_skip, current_frame_audio_samples.data(), current_frame_audio_samples.size() * sizeof(float));
         }
 
-        math::helpers::hanning_window(m_audio_samples);
-        auto fft = math::fft(m_audio_samples)
-                   | std::views::transform([](std::complex<float> &datum) -> float
-                                           { return std::abs(datum); })
-                   | std::ranges::to<std::vector>();
+        track_pitch();
+        analyse();
+        auto &intensities = m_band_intensities;
 
-        const float base_freq = 1.F;
-        auto step = std::pow(2.F, 1.F / 12.F); // Semitone step
-        m_max_intensity = 1.F;
-        auto freq_max = static_cast<float>(fft.size()) / 2;
+        static auto last_time = std::chrono::steady_clock::now();
+        auto current_time = std::chrono::steady_clock::now();
+        auto delta_time = std::chrono::duration<float>(current_time - last_time).count();
+        last_time = current_time;
 
-        std::vector<float> intensities;
-        intensities.reserve(m_smoothed_intensities.size());
+        // Before normalization, so that the flux follows the level of the signal rather than of the loudest band
+        track_rhythm(intensities, delta_time);
 
-        for (float freq = base_freq; freq < freq_max;)
+        // Bands change in number with the backend, smoothing restarts from silence
+        if (m_smoothed_intensities.size() != intensities.size())
         {
-            float next = std::ceil(freq * step);
-            auto value = *std::max_element(fft.begin() + static_cast<long>(freq), std::min(fft.begin() + static_cast<long>(next), fft.begin() + static_cast<long>(freq_max)));
-            m_max_intensity = std::max(value, m_max_intensity);
-            intensities.push_back(value);
-            freq = std::ceil(freq * step);
+            m_smoothed_intensities.assign(intensities.size(), 0.F);
         }
 
-        static std::once_flag flag;
-        std::call_once(flag, [&]()
-                       { m_smoothed_intensities = std::vector<float>(intensities.size(), 0.F); });
-
         // Normalize intensities
         for (auto &intensity : intensities)
         {
             intensity /= m_max_intensity;
         }
 
-        static auto last_time = std::chrono::steady_clock::now();
-        auto current_time = std::chrono::steady_clock::now();
-        auto delta_time = std::chrono::duration<float>(current_time - last_time).count();
-        last_time = current_time;
-
         constexpr float smoothing_factor = 8.F;
         for (auto i = 0U; i < intensities.size(); i++)
         {
             m_smoothed_intensities[i] += (intensities[i] - m_smoothed_intensities[i]) * smoothing_factor * delta_time;
         }
 
-        auto count = m_smoothed_intensities.size();
+        if (m_render_mode == e_spectrum_render_mode::gpu)
+        {
+            upload_bands();
+        }
+        else
+        {
+            build_batch();
+        }
+    }
+
+    auto c_waveform_panel::analyse() -> void
+    {
+        auto &intensities = m_band_intensities;
+        if (m_analysis_backend == e_analysis_backend::constant_q and m_constant_q)
+        {
+            // Kernels carry their own windows
+            utility::c_profile_zone zone(utility::zone_id<"Constant-Q transform">());
+            intensities.resize(m_constant_q->bin_count());
+            m_constant_q->transform(math::fft(m_audio_samples), intensities);
+
+            // Quietest level still scaled to full height, the equivalent of the FFT floor below
+            constexpr float constant_q_floor = 1e-4F;
+            m_max_intensity = std::max(constant_q_floor, std::ranges::max(intensities));
+            return;
+        }
+
+        // Windowed on a copy, the history keeps raw samples for the next frames and for pitch tracking
+        std::vector<float> fft;
+        {
+            utility::c_profile_zone zone(utility::zone_id<"FFT">());
+            m_windowed_samples.assign(m_audio_samples.begin(), m_audio_samples.end());
+            math::helpers::hanning_window(m_windowed_samples);
+            fft = math::fft(m_windowed_samples)
+                  | std::views::transform([](std::complex<float> &datum) -> float
+                                          { return std::abs(datum); })
+                  | std::ranges::to<std::vector>();
+        }
+        utility::c_profile_zone zone(utility::zone_id<"Band binning">());
+        math::semitone_bands(fft, intensities);
+        m_max_intensity = std::max(1.F, std::ranges::max(intensities));
+    }
 
-        m_rectangles.clear();
-        m_rectangles.reserve(count);
-        m_circles.clear();
-        m_circles.reserve(count);
+    auto c_waveform_panel::track_rhythm(std::span<const float> intensities, float delta_time) -> void
+    {
+        // Frames faster than the rate skip steps, the next step sees all their change at once. Slower frames repeat
+        // steps, the repeats see no change
+        m_rhythm_clock = std::min(m_rhythm_clock + delta_time, 1.F);
+        m_is_onset = false;
+        m_is_beat = false;
+        while (m_rhythm_clock >= 1.F / s_rhythm_rate)
+        {
+            m_rhythm_clock -= 1.F / s_rhythm_rate;
+            m_is_onset = m_onsets.push(intensities) or m_is_onset;
+            m_is_beat = m_beats.push(m_onsets.flux()) or m_is_beat;
+        }
+
+        auto shown_tempo = static_cast<int>(std::lround(m_beats.tempo()));
+        if (shown_tempo != m_shown_tempo)
+        {
+            m_shown_tempo = shown_tempo;
+            update_title();
+        }
+    }
+
+    auto c_waveform_panel::track_pitch() -> void
+    {
+        // Unclear pitches, noise or chords, are not shown
+        constexpr float min_confidence = 0.8F;
+        auto frame = std::span(m_audio_samples).last(m_pitch_detector.frame_size());
+        m_pitch = m_pitch_detector.detect(frame);
+
+        auto shown_note = m_pitch.confidence >= min_confidence ? math::nearest_note(m_pitch.frequency).midi : 0;
+        if (shown_note != m_shown_note)
+        {
+            m_shown_note = shown_note;
+            update_title();
+        }
+    }
+
+    auto c_waveform_panel::update_title() -> void
+    {
+        static constexpr std::array note_names = { "C", "C#", "D", "D#", "E", "F", "F#", "G", "G#", "A", "A#", "B" };
+
+        auto title = m_source ? "Waveform Panel - " + m_source->get_filename() : std::string("Waveform Panel");
+        if (m_shown_tempo > 0)
+        {
+            title += std::format(" - {} BPM", m_shown_tempo);
+        }
+        if (m_shown_note > 0)
+        {
+            title += std::format(" - {}{}", note_names.at(static_cast<std::size_t>(m_shown_note % 12)), (m_shown_note / 12) - 1);
+        }
+        set_title(title);
+    }
+
+    auto c_waveform_panel::read_samples() -> std::vector<float>
+    {
+        if (not m_tap)
+        {
+            return m_audio_manager.output_buffer();
+        }
+
+        // Keep the most recent window of what the track played since the last frame
+        m_tap_samples.resize(m_tap.capacity());
+        m_tap_samples.resize(m_tap.read(m_tap_samples));
+        auto window = std::min(m_tap_samples.size(), m_audio_samples.size() * 2);
+        return { m_tap_samples.end() - static_cast<std::ptrdiff_t>(window), m_tap_samples.end() };
+    }
+
+    auto c_waveform_panel::upload_bands() -> void
+    {
+        auto count = static_cast<int>(m_smoothed_intensities.size());
+        if (count == 0)
+        {
+            return;
+        }
+        if (not m_band_texture or m_band_texture->size().x != count)
+        {
+            m_band_texture.emplace(opengl::e_texture_target::texture_1d, GL_R32F, glm::ivec2{ count, 1 }, GL_NEAREST);
+        }
+        m_band_texture->update(m_smoothed_intensities, { 0, 0 }, { count, 1 });
+        if (not m_colormap_texture)
+        {
+            auto entries = static_cast<int>(m_colormap.size());
+            m_colormap_texture.emplace(opengl::e_texture_target::texture_1d, GL_RGBA32F, glm::ivec2{ entries, 1 }, GL_LINEAR);
+            m_colormap_texture->update(m_colormap.table(), { 0, 0 }, { entries, 1 });
+        }
 
         auto content_location = get_location();
         auto content_size = get_content_area_size();
+        m_shader.set_uniform_1i("u_band_count", count);
+        m_shader.set_uniform_4f("u_area", { content_location.x, content_location.y, content_size.x, content_size.y });
+    }
 
-        static std::size_t offset = 0;
+    auto c_waveform_panel::build_batch() -> void
+    {
+        utility::c_profile_zone zone(utility::zone_id<"Shape build">());
+        using math::helpers::operator""_percent;
+        auto count = m_smoothed_intensities.size();
+
+        m_batch.clear();
+
+        auto content_location = get_location();
+        auto content_size = get_content_area_size();
 
         for (std::size_t index = 0; index < count; ++index)
         {
@@ -156,39 +369,113 @@ namespace gui
             auto x_base = content_location.x + (content_size.x * 2.5_percent) + (cell_width * static_cast<float>(index));
             auto y_base = content_location.y + (content_size.y * 2.5_percent);
             auto height = (content_size.y * 95._percent) * value * 9 / 10;
-            glm::vec3 color_hsv = { value * 360.F, .75F, 1.F };
             float radius = (std::sqrt(value) * 18) * 9 / 10;
             float max_width = cell_width * 75._percent;
             float min_width = cell_width * 15._percent;
             float rect_width = min_width + ((max_width - min_width) * (1.F - value));
 
-            m_rectangles.emplace_back(opengl::shapes::c_rectangle({ x_base + ((cell_width - rect_width) / 2), y_base },
-                                                                  { rect_width, height },
-                                                                  math::helpers::hsv_to_rgba(color_hsv)));
-            m_circles.emplace_back(opengl::shapes::c_circle({ x_base + (cell_width / 2), y_base + height },
-                                                            radius,
-                                                            math::helpers::hsv_to_rgba(color_hsv)));
+            const auto &color = m_colormap.sample(value);
+            m_batch.add_rectangle({ x_base + ((cell_width - rect_width) / 2), y_base }, { rect_width, height }, color);
+            m_batch.add_circle({ x_base + (cell_width / 2), y_base + height }, radius, color);
         }
-        offset = (offset + 1) % count;
     }
 
     auto c_waveform_panel::render_content() const -> void
     {
         opengl::c_renderer::set_scissor_area(get_location(), get_size());
-        for (const auto &rectangle : m_rectangles)
+        if (m_render_mode == e_spectrum_render_mode::gpu)
         {
-            rectangle.draw(renderer(), get_projection_matrix());
+            if (m_band_texture)
+            {
+                m_band_texture->bind(0);
+                m_colormap_texture->bind(1);
+                renderer().draw_instanced(m_empty_vertex_array, m_shader, opengl::e_render_primitive::triangles, 6, static_cast<std::size_t>(m_band_texture->size().x));
+            }
         }
-        for (const auto &circle : m_circles)
+        else
         {
-            circle.draw(renderer(), get_projection_matrix());
+            m_batch.draw(renderer());
         }
         opengl::c_renderer::reset_scissor_area();
     }
 
-    auto c_waveform_panel::set_projection(const glm::mat4 &proj) -> void
+    auto c_waveform_panel::band_intensities() const -> std::span<const float>
+    {
+        return m_band_intensities;
+    }
+
+    auto c_waveform_panel::set_render_mode(e_spectrum_render_mode mode) -> void
+    {
+        m_render_mode = mode;
+    }
+
+    auto c_waveform_panel::get_render_mode() const -> e_spectrum_render_mode
+    {
+        return m_render_mode;
+    }
+
+    auto c_waveform_panel::set_analysis_backend(e_analysis_backend backend) -> void
+    {
+        if (backend == e_analysis_backend::constant_q and not m_constant_q)
+        {
+            m_constant_q.emplace();
+        }
+        m_analysis_backend = backend;
+
+        constexpr std::size_t fft_frame_size = 1U << 13U;
+        m_audio_samples.assign(backend == e_analysis_backend::constant_q ? m_constant_q->frame_size() : fft_frame_size, 0.F);
+    }
+
+    auto c_waveform_panel::get_analysis_backend() const -> e_analysis_backend
+    {
+        return m_analysis_backend;
+    }
+
+    auto c_waveform_panel::set_source(std::shared_ptr<music::c_track> track) -> void
+    {
+        m_tap = {};
+        m_source = std::move(track);
+        m_onsets.reset();
+        m_beats.reset();
+        if (m_source)
+        {
+            m_tap = m_source->subscribe_tap();
+            if (not m_tap)
+            {
+                std::println(std::cerr, "Warning: no analysis tap left on {}, showing the mix", m_source->get_filename());
+                m_source.reset();
+            }
+        }
+        update_title();
+    }
+
+    auto c_waveform_panel::get_source() const -> const std::shared_ptr<music::c_track> &
+    {
+        return m_source;
+    }
+
+    auto c_waveform_panel::is_onset() const -> bool
+    {
+        return m_is_onset;
+    }
+
+    auto c_waveform_panel::is_beat() const -> bool
+    {
+        return m_is_beat;
+    }
+
+    auto c_waveform_panel::tempo() const -> float
+    {
+        return m_beats.tempo();
+    }
+
+    auto c_waveform_panel::beat_phase() const -> float
+    {
+        return m_beats.beat_phase();
+    }
+
+    auto c_waveform_panel::pitch() const -> math::s_pitch
     {
-        m_shader.set_uniform_mat4f("projection", proj);
-        set_projection_matrix(proj);
+        return m_pitch;
     }
 } // namespace gui
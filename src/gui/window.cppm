@@ -2,23 +2,30 @@ module;
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
 
+#include <algorithm>
 #include <chrono>
 #include <cmath>
+#include <cstddef>
 #include <filesystem>
 #include <iostream>
 #include <memory>
+#include <print>
+#include <utility>
 #include <vector>
 export module gui:window;
 
 import :waveform;
+import :spectrogram;
 import :tracks;
 import :menu;
+import :meter;
+import :hud;
 
-import utility;
 import music;
 import math;
 import opengl;
 import glm;
+import utility;
 
 export namespace gui
 {
@@ -30,23 +37,62 @@ export namespace gui
         auto show() -> void;
 
     private:
+        // Time per frame allowed for deferred GL uploads
+        static constexpr std::chrono::microseconds s_upload_budget{ 2000 };
+
         std::unique_ptr<GLFWwindow, decltype(&glfwDestroyWindow)> m_window;
-        std::vector<std::shared_ptr<music::c_track>> m_tracks;
+        std::vector<music::s_track_entry> m_tracks;
+        music::c_track_loader m_track_loader;
 
         // Components
         c_popup_menu m_popup_menu;
         c_waveform_panel m_waveform_pane;
+        c_spectrogram_panel m_spectrogram_pane;
         c_track_panel m_track_panel;
 
-        // Parent resources shared to components
+        // Parent resources shared to components; the playlist outlives the audio device that mixes it
+        music::c_playlist m_playlist;
         music::c_audio_manager m_audio_manager;
 
+        // Subscribes to the output of the audio manager, so it is created after it and destroyed before it
+        c_meter_panel m_meter_panel;
+        c_hud_panel m_hud_panel;
+
+        // Timing of the frame in progress, handed to the HUD when it ends
+        s_frame_timing m_frame_timing;
+        std::chrono::steady_clock::time_point m_stage_start;
+
+        // What the last pause stopped, so that resuming restarts just that
+        bool m_resume_tracks{ false };
+        bool m_resume_playlist{ false };
+
         auto register_event_callbacks() -> void;
         auto render() -> void;
+        auto end_stage(e_frame_stage stage) -> void;
+
+        /**
+         * @brief Switch the spectrum to the next loaded track, through its analysis tap, and back to the mix after the last.
+         */
+        auto cycle_spectrum_source() -> void;
+
+        /**
+         * @brief Pause the tracks and the playlist if either is playing, otherwise resume what was paused.
+         */
+        auto toggle_playback() -> void;
+
+        /**
+         * @brief Append the loaded tracks not queued yet to the playlist, in list order, and start it.
+         */
+        auto queue_loaded_tracks() -> void;
+
+        /**
+         * @brief Write the profiler zones recorded so far as a Chrome trace, in the working directory.
+         */
+        auto write_profile() -> void;
 
         // Helper functions
         auto screen_to_opengl_coords(glm::vec2 screen_coords) const -> glm::vec2;
-        auto set_projections() -> void;
+        auto set_view() -> void;
 
         // Callbacks for GLFW events
 
@@ -74,10 +120,16 @@ namespace gui
 {
     c_window::c_window(int width, int height, const std::string &title)
         : m_window(nullptr, &glfwDestroyWindow),
-          m_waveform_pane({ static_cast<float>(width) / 2.F, static_cast<float>(height) / 4.F },
+          m_waveform_pane({ static_cast<float>(width) / 2.F, static_cast<float>(height) / 2.F },
                           { static_cast<float>(width) / 2.F, static_cast<float>(height) / 2.F }, m_audio_manager),
+          m_spectrogram_pane({ static_cast<float>(width) / 2.F, 0.F },
+                             { static_cast<float>(width) / 2.F, static_cast<float>(height) / 2.F }),
           m_track_panel({ 0.F, static_cast<float>(height) / 4.F },
-                        { static_cast<float>(width) / 2.F, static_cast<float>(height) / 2.F }, m_tracks)
+                        { static_cast<float>(width) / 2.F, static_cast<float>(height) / 2.F }, m_tracks, m_audio_manager),
+          m_meter_panel({ 0.F, 0.F },
+                        { static_cast<float>(width) / 2.F, static_cast<float>(height) / 4.F }, m_audio_manager),
+          m_hud_panel({ 0.F, static_cast<float>(height) * 3.F / 4.F },
+                      { static_cast<float>(width) / 2.F, static_cast<float>(height) / 4.F }, m_audio_manager)
     {
         m_window = std::unique_ptr<GLFWwindow, decltype(&glfwDestroyWindow)>(glfwCreateWindow(width, height, title.c_str(), nullptr, nullptr), &glfwDestroyWindow);
         if (not m_window)
@@ -99,9 +151,12 @@ namespace gui
         glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
         glDebugMessageCallback(opengl::gl_debug_callback_fn, nullptr);
 
-        // OpenGL initialized, now notify all subscribers to initialize themselves
+        // OpenGL initialized, bind the command queue to this thread. Objects recorded so far are created by the
+        // budgeted drain at the start of the following frames
         opengl::c_text_renderer::instance().load_font(SOURCE_DIR "/assets/fonts/NotoSans.ttf", 24);
-        utility::c_notifier::notify();
+        opengl::c_command_queue::instance().make_current();
+
+        m_audio_manager.set_playlist(&m_playlist);
     }
 
     auto c_window::screen_to_opengl_coords(glm::vec2 screen_coords) const -> glm::vec2
@@ -113,25 +168,31 @@ namespace gui
         return { screen_coords.x, static_cast<float>(height) - screen_coords.y };
     }
 
-    auto c_window::set_projections() -> void
+    auto c_window::set_view() -> void
     {
         int width = 0;
         int height = 0;
         glfwGetFramebufferSize(m_window.get(), &width, &height);
-        glm::mat4 proj = glm::gtc::ortho(0.F, static_cast<float>(width), 0.F, static_cast<float>(height), -1.F, 1.F);
-        m_waveform_pane.set_projection(proj);
-        m_track_panel.set_projection(proj);
-        m_popup_menu.set_projection(proj);
-        opengl::c_text_renderer::instance().resize({ width, height });
+        opengl::c_frame_uniforms::instance().set_view({ 0.F, 0.F }, { static_cast<float>(width), static_cast<float>(height) });
     }
 
     auto c_window::show() -> void
     {
         register_event_callbacks();
-        set_projections();
+        set_view();
+        utility::c_profiler::instance().name_thread("Main");
+        auto start_time = std::chrono::steady_clock::now();
         while (not glfwWindowShouldClose(m_window.get()))
         {
-            glfwPollEvents();
+            utility::c_profile_zone frame_zone(utility::zone_id<"Frame">());
+            m_stage_start = std::chrono::steady_clock::now();
+            {
+                utility::c_profile_zone zone(utility::zone_id<"Poll events">());
+                glfwPollEvents();
+            }
+            end_stage(e_frame_stage::events);
+            opengl::c_command_queue::instance().drain(s_upload_budget);
+            end_stage(e_frame_stage::uploads);
             double xpos = NAN;
             double ypos = NAN;
             glfwGetCursorPos(m_window.get(), &xpos, &ypos);
@@ -142,13 +203,33 @@ namespace gui
             auto current_time = std::chrono::steady_clock::now();
             auto delta_time = std::chrono::duration<float>(current_time - last_time).count();
             last_time = current_time;
+            m_frame_timing.interval = delta_time;
+            opengl::c_frame_uniforms::instance().set_time(std::chrono::duration<float>(current_time - start_time).count(), delta_time);
 
             m_popup_menu.update(delta_time);
             m_popup_menu.on_mouse_move(opengl_coords);
             m_track_panel.set_mouse_position(opengl_coords);
             m_waveform_pane.set_mouse_position(opengl_coords);
-            m_waveform_pane.update_waveform();
+            m_spectrogram_pane.set_mouse_position(opengl_coords);
+            m_meter_panel.set_mouse_position(opengl_coords);
+            if (not m_hud_panel.is_closed())
+            {
+                m_hud_panel.set_mouse_position(opengl_coords);
+            }
+            for (auto &track : m_track_loader.poll(m_tracks))
+            {
+                m_audio_manager.add_track(track);
+            }
+            m_audio_manager.auto_cleanup();
+            {
+                utility::c_profile_zone zone(utility::zone_id<"Update waveform">());
+                m_waveform_pane.update_waveform();
+            }
+            m_spectrogram_pane.push_column(m_waveform_pane.band_intensities());
+            m_meter_panel.update_meter();
+            end_stage(e_frame_stage::update);
             render();
+            m_hud_panel.push_frame(m_frame_timing);
         }
     }
 
@@ -158,14 +239,50 @@ namespace gui
         {
             if (key == GLFW_KEY_SPACE)
             {
-                if (m_audio_manager.is_playing())
-                {
-                    m_audio_manager.pause();
-                }
-                else
-                {
-                    m_audio_manager.play();
-                }
+                toggle_playback();
+            }
+            if (key == GLFW_KEY_S)
+            {
+                cycle_spectrum_source();
+            }
+            if (key == GLFW_KEY_B)
+            {
+                // Switch the spectrum between linear FFT bins and the constant-Q transform
+                auto backend = m_waveform_pane.get_analysis_backend() == e_analysis_backend::constant_q ? e_analysis_backend::semitone_fft : e_analysis_backend::constant_q;
+                m_waveform_pane.set_analysis_backend(backend);
+            }
+            if (key == GLFW_KEY_R)
+            {
+                m_meter_panel.reset();
+            }
+            if (key == GLFW_KEY_Q)
+            {
+                queue_loaded_tracks();
+            }
+            if (key == GLFW_KEY_N)
+            {
+                m_playlist.skip();
+            }
+            if (key == GLFW_KEY_C)
+            {
+                // Toggle between gapless and crossfaded transitions
+                using namespace std::chrono_literals;
+                m_playlist.set_crossfade(m_playlist.get_crossfade() == 0ms ? 3000ms : 0ms);
+            }
+            if (key == GLFW_KEY_P)
+            {
+                // Keep peak overviews of files opened from now on next to them, to skip decoding on the next load
+                auto persist = m_track_loader.get_peak_overview() != music::e_peak_overview::cached;
+                m_track_loader.set_peak_overview(persist ? music::e_peak_overview::cached : music::e_peak_overview::in_memory);
+                std::println("Peak overview cache {}", persist ? "enabled, writing <file>.peaks next to new files" : "disabled");
+            }
+            if (key == GLFW_KEY_F3)
+            {
+                m_hud_panel.toggle();
+            }
+            if (key == GLFW_KEY_F9)
+            {
+                write_profile();
             }
             if (key == GLFW_KEY_ESCAPE)
             {
@@ -174,22 +291,81 @@ namespace gui
         }
     }
 
-    auto c_window::framebuffer_size_callback(int width, int height) -> void
+    auto c_window::cycle_spectrum_source() -> void
+    {
+        const auto &current = m_waveform_pane.get_source();
+        std::shared_ptr<music::c_track> next;
+        bool is_after_current = current == nullptr;
+        for (const auto &entry : m_tracks)
+        {
+            if (entry.state != music::e_load_state::ready or not entry.track)
+            {
+                continue;
+            }
+            if (is_after_current)
+            {
+                next = entry.track;
+                break;
+            }
+            is_after_current = entry.track == current;
+        }
+        m_waveform_pane.set_source(std::move(next));
+    }
+
+    auto c_window::toggle_playback() -> void
     {
-        glm::mat4 proj = glm::gtc::ortho(0.F, static_cast<float>(width), 0.F, static_cast<float>(height), -1.F, 1.F);
-        glViewport(0, 0, width, height);
+        if (m_audio_manager.is_playing() or m_playlist.is_playing())
+        {
+            m_resume_tracks = m_audio_manager.is_playing();
+            m_resume_playlist = m_playlist.is_playing();
+            m_audio_manager.pause();
+            m_playlist.pause();
+            return;
+        }
 
-        // Update popup menu projection
-        m_popup_menu.set_projection(proj);
+        // Nothing paused before: play the tracks, as Space always has
+        if (m_resume_tracks or not m_resume_playlist)
+        {
+            m_audio_manager.play();
+        }
+        if (m_resume_playlist)
+        {
+            m_playlist.play();
+        }
+        m_resume_tracks = false;
+        m_resume_playlist = false;
+    }
+
+    auto c_window::queue_loaded_tracks() -> void
+    {
+        auto queued = m_playlist.items();
+        for (const auto &entry : m_tracks)
+        {
+            if (entry.state == music::e_load_state::ready and std::ranges::find(queued, entry.path) == queued.end())
+            {
+                m_playlist.enqueue(entry.path);
+                queued.push_back(entry.path);
+            }
+        }
+        m_playlist.play();
+    }
+
+    auto c_window::framebuffer_size_callback(int width, int height) -> void
+    {
+        opengl::c_gl_state::instance().viewport(0, 0, width, height);
+        opengl::c_frame_uniforms::instance().set_view({ 0.F, 0.F }, { static_cast<float>(width), static_cast<float>(height) });
 
         // Update panels (use full height without menu bar)
-        m_track_panel.set_projection(proj);
         m_track_panel.update_size({ static_cast<float>(width) / 2, static_cast<float>(height) / 2 });
         m_track_panel.update_location({ 0, static_cast<float>(height) / 4.F });
-        m_waveform_pane.set_projection(proj);
         m_waveform_pane.update_size({ static_cast<float>(width) / 2, static_cast<float>(height) / 2 });
-        m_waveform_pane.update_location({ static_cast<float>(width) / 2.F, static_cast<float>(height) / 4.F });
-        opengl::c_text_renderer::instance().resize({ width, height });
+        m_waveform_pane.update_location({ static_cast<float>(width) / 2.F, static_cast<float>(height) / 2.F });
+        m_spectrogram_pane.update_size({ static_cast<float>(width) / 2, static_cast<float>(height) / 2 });
+        m_spectrogram_pane.update_location({ static_cast<float>(width) / 2.F, 0.F });
+        m_meter_panel.update_size({ static_cast<float>(width) / 2, static_cast<float>(height) / 4 });
+        m_meter_panel.update_location({ 0.F, 0.F });
+        m_hud_panel.update_size({ static_cast<float>(width) / 2, static_cast<float>(height) / 4 });
+        m_hud_panel.update_location({ 0.F, static_cast<float>(height) * 3.F / 4.F });
     }
 
     auto c_window::mouse_position_callback(double xpos, double ypos) -> void
@@ -198,6 +374,12 @@ namespace gui
         m_popup_menu.on_mouse_move(opengl_coords);
         m_track_panel.on_mouse_move(opengl_coords);
         m_waveform_pane.on_mouse_move(opengl_coords);
+        m_spectrogram_pane.on_mouse_move(opengl_coords);
+        m_meter_panel.on_mouse_move(opengl_coords);
+        if (not m_hud_panel.is_closed())
+        {
+            m_hud_panel.on_mouse_move(opengl_coords);
+        }
     }
 
     auto c_window::mouse_button_callback(int button, int action, int /*mods*/) -> void
@@ -239,18 +421,33 @@ namespace gui
                 {
                     m_track_panel.on_mouse_press(coords, e_button);
                     m_waveform_pane.on_mouse_press(coords, e_button);
+                    m_spectrogram_pane.on_mouse_press(coords, e_button);
+                    m_meter_panel.on_mouse_press(coords, e_button);
+                    if (not m_hud_panel.is_closed())
+                    {
+                        m_hud_panel.on_mouse_press(coords, e_button);
+                    }
                 }
             }
             else
             {
                 m_track_panel.on_mouse_press(coords, e_button);
                 m_waveform_pane.on_mouse_press(coords, e_button);
+                m_spectrogram_pane.on_mouse_press(coords, e_button);
+                m_meter_panel.on_mouse_press(coords, e_button);
+                if (not m_hud_panel.is_closed())
+                {
+                    m_hud_panel.on_mouse_press(coords, e_button);
+                }
             }
         }
         else if (action == GLFW_RELEASE)
         {
             m_track_panel.on_mouse_release(screen_to_opengl_coords({ xpos, ypos }), e_button);
             m_waveform_pane.on_mouse_release(screen_to_opengl_coords({ xpos, ypos }), e_button);
+            m_spectrogram_pane.on_mouse_release(screen_to_opengl_coords({ xpos, ypos }), e_button);
+            m_meter_panel.on_mouse_release(screen_to_opengl_coords({ xpos, ypos }), e_button);
+            m_hud_panel.on_mouse_release(screen_to_opengl_coords({ xpos, ypos }), e_button);
         }
     }
 
@@ -261,32 +458,24 @@ namespace gui
         glfwGetCursorPos(m_window.get(), &xpos, &ypos);
         m_track_panel.on_mouse_scroll({ xpos, ypos }, { x_offset, y_offset });
         m_waveform_pane.on_mouse_scroll({ xpos, ypos }, { x_offset, y_offset });
+        m_spectrogram_pane.on_mouse_scroll({ xpos, ypos }, { x_offset, y_offset });
+        m_meter_panel.on_mouse_scroll({ xpos, ypos }, { x_offset, y_offset });
+        if (not m_hud_panel.is_closed())
+        {
+            m_hud_panel.on_mouse_scroll({ xpos, ypos }, { x_offset, y_offset });
+        }
     }
 
     auto c_window::path_drop_callback(int count, const char **paths) -> void
     {
-        static int curr_id = 0;
         if (count <= 0 or paths == nullptr)
         {
             return;
         }
+        // Files and directories are opened in the background, rows appear as the loader finds them
         for (int i = 0; i < count; i++)
         {
-            std::filesystem::path curr_path(paths[i]);
-            if (not std::filesystem::exists(curr_path) or not std::filesystem::is_regular_file(curr_path))
-            {
-                continue;
-            }
-            try
-            {
-                auto track = std::make_shared<music::c_track>(curr_id++, curr_path);
-                m_tracks.push_back(track);
-                m_audio_manager.add_track(track);
-            }
-            catch (const std::exception &e)
-            {
-                std::cerr << "Error adding track: " << e.what() << '\n';
-            }
+            m_track_loader.request(std::filesystem::path(paths[i]));
         }
     }
 
@@ -329,12 +518,47 @@ namespace gui
 
     auto c_window::render() -> void
     {
-        opengl::c_renderer::clear();
+        {
+            utility::c_profile_zone zone(utility::zone_id<"Render">());
+            opengl::c_renderer::begin_frame();
+            opengl::c_renderer::clear();
+
+            m_waveform_pane.render();
+            m_spectrogram_pane.render();
+            m_track_panel.render();
+            m_meter_panel.render();
+            m_hud_panel.render();
+            m_popup_menu.render();
+            opengl::c_text_renderer::instance().draw_texts();
+        }
+        end_stage(e_frame_stage::render);
+        {
+            utility::c_profile_zone zone(utility::zone_id<"Swap buffers">());
+            glfwSwapBuffers(m_window.get());
+        }
+        end_stage(e_frame_stage::present);
+    }
 
-        m_waveform_pane.render();
-        m_track_panel.render();
-        m_popup_menu.render();
-        opengl::c_text_renderer::instance().draw_texts();
-        glfwSwapBuffers(m_window.get());
+    auto c_window::end_stage(e_frame_stage stage) -> void
+    {
+        auto now = std::chrono::steady_clock::now();
+        m_frame_timing.stages.at(static_cast<std::size_t>(stage)) = std::chrono::duration<float>(now - m_stage_start).count();
+        m_stage_start = now;
+    }
+
+    auto c_window::write_profile() -> void
+    {
+        if constexpr (not utility::profiling_enabled)
+        {
+            std::println(std::cerr, "Warning: profiling is compiled out, configure with -DSPECTRA_PROFILE=ON");
+            return;
+        }
+        auto path = std::filesystem::current_path() / "spectra-trace.json";
+        if (not utility::c_profiler::instance().write_chrome_trace(path))
+        {
+            std::println(std::cerr, "Warning: could not write the profile to {}", path.string());
+            return;
+        }
+        std::println("Profile written to {}, open it in chrome://tracing or ui.perfetto.dev", path.string());
     }
 } // namespace gui
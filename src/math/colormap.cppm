@@ -0,0 +1,175 @@
+module;
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+export module math:colormap;
+
+import :helpers;
+import glm;
+
+export namespace math
+{
+    enum class e_colormap : std::uint8_t
+    {
+        hsv,     // Full hue circle, red to red
+        viridis, // Perceptually uniform, dark blue to yellow
+        magma,   // Perceptually uniform, black to pale yellow through purple
+        inferno, // Perceptually uniform, black to pale yellow through red
+    };
+
+    /**
+     * @brief Colour map precomputed into an RGBA lookup table, so colouring a value is a clamp and a single index.
+     *
+     * The perceptual maps are evaluated from 6th degree polynomial fits of the matplotlib maps. The table can be
+     * uploaded as is into a 1D texture and sampled with linear filtering at the texel centres, see texture_coordinate().
+     */
+    class c_colormap
+    {
+    public:
+        static constexpr std::size_t s_default_size = 256;
+
+        explicit c_colormap(e_colormap map, std::size_t size = s_default_size);
+
+        /**
+         * @brief Hue sweep over the full circle at fixed saturation and value, as hsv_to_rgba({ t * 360, s, v }).
+         */
+        static auto hsv_sweep(float saturation, float value, std::size_t size = s_default_size) -> c_colormap;
+
+        /**
+         * @brief Colour of t in [0, 1], clamped, from the nearest table entry.
+         */
+        [[nodiscard]] auto sample(float t) const -> const glm::vec4 &
+        {
+            auto scaled = std::clamp(t, 0.F, 1.F) * m_scale; // NaN maps to the first entry
+            return m_table[scaled >= 0.F ? static_cast<std::size_t>(scaled + 0.5F) : 0];
+        }
+
+        /**
+         * @brief Texture coordinate of t for a linearly filtered texture of the table, so 0 and 1 land on the first
+         * and last texel centres.
+         */
+        [[nodiscard]] auto texture_coordinate(float t) const -> float;
+
+        [[nodiscard]] auto table() const -> std::span<const glm::vec4>;
+        [[nodiscard]] auto size() const -> std::size_t;
+
+    private:
+        std::vector<glm::vec4> m_table;
+        float m_scale; // Index of the last entry
+
+        explicit c_colormap(std::vector<glm::vec4> table);
+    };
+} // namespace math
+
+// Implementation
+namespace math
+{
+    namespace
+    {
+        using t_polynomial = std::array<glm::vec3, 7>;
+
+        // Least-squares fits of the matplotlib maps, lowest degree first
+        constexpr t_polynomial s_viridis = {
+            glm::vec3{ 0.2777273272234177F, 0.005407344544966578F, 0.3340998053353061F },
+            glm::vec3{ 0.1050930431085774F, 1.404613529898575F, 1.384590162594685F },
+            glm::vec3{ -0.3308618287255563F, 0.214847559468213F, 0.09509516302823659F },
+            glm::vec3{ -4.634230498983486F, -5.799100973351585F, -19.33244095627987F },
+            glm::vec3{ 6.228269936347081F, 14.17993336680509F, 56.69055260068105F },
+            glm::vec3{ 4.776384997670288F, -13.74514537774601F, -65.35303263337234F },
+            glm::vec3{ -5.435455855934631F, 4.645852612178535F, 26.3124352495832F },
+        };
+        constexpr t_polynomial s_magma = {
+            glm::vec3{ -0.002136485053939582F, -0.000749655052795221F, -0.005386127855323933F },
+            glm::vec3{ 0.2516605407371642F, 0.6775232436837668F, 2.494026599312351F },
+            glm::vec3{ 8.353717279216625F, -3.577719514958484F, 0.3144679030132573F },
+            glm::vec3{ -27.66873308576866F, 14.26473078096533F, -13.64921318813922F },
+            glm::vec3{ 52.17613981234068F, -27.94360607168351F, 12.94416944238394F },
+            glm::vec3{ -50.76852536473588F, 29.04658282127291F, 4.23415299384598F },
+            glm::vec3{ 18.65570506591883F, -11.48977351997711F, -5.601961508734096F },
+        };
+        constexpr t_polynomial s_inferno = {
+            glm::vec3{ 0.0002189403691192265F, 0.001651004631001012F, -0.01948089843709184F },
+            glm::vec3{ 0.1065134194856116F, 0.5639564367884091F, 3.932712388889277F },
+            glm::vec3{ 11.60249308247187F, -3.972853965665698F, -15.9423941062914F },
+            glm::vec3{ -41.70399613139459F, 17.43639888205313F, 44.35414519872813F },
+            glm::vec3{ 77.162935699427F, -33.40235894210092F, -81.80730925738993F },
+            glm::vec3{ -71.31942824499214F, 32.62606426397723F, 73.20951985803202F },
+            glm::vec3{ 25.13112622477341F, -12.24266895238567F, -23.07032500287172F },
+        };
+
+        auto evaluate(const t_polynomial &polynomial, float t) -> glm::vec4
+        {
+            // Horner's scheme
+            glm::vec3 color = polynomial.back();
+            for (auto coefficient = polynomial.rbegin() + 1; coefficient != polynomial.rend(); ++coefficient)
+            {
+                color = (color * t) + *coefficient;
+            }
+            return { glm::clamp(color, 0.F, 1.F), 1.F };
+        }
+
+        auto build_table(std::size_t size, auto &&color) -> std::vector<glm::vec4>
+        {
+            if (size < 2)
+            {
+                throw std::invalid_argument("Colour map needs at least two entries");
+            }
+            std::vector<glm::vec4> table(size);
+            for (std::size_t index = 0; index < size; ++index)
+            {
+                table[index] = color(static_cast<float>(index) / static_cast<float>(size - 1));
+            }
+            return table;
+        }
+    } // namespace
+
+    c_colormap::c_colormap(std::vector<glm::vec4> table)
+        : m_table(std::move(table)),
+          m_scale(static_cast<float>(m_table.size() - 1))
+    {
+    }
+
+    c_colormap::c_colormap(e_colormap map, std::size_t size)
+        : c_colormap(build_table(size, [map](float t) -> glm::vec4
+                                 {
+                                     switch (map)
+                                     {
+                                     case e_colormap::viridis:
+                                         return evaluate(s_viridis, t);
+                                     case e_colormap::magma:
+                                         return evaluate(s_magma, t);
+                                     case e_colormap::inferno:
+                                         return evaluate(s_inferno, t);
+                                     case e_colormap::hsv:
+                                     default:
+                                         return helpers::hsv_to_rgba({ t * 360.F, 1.F, 1.F });
+                                     } }))
+    {
+    }
+
+    auto c_colormap::hsv_sweep(float saturation, float value, std::size_t size) -> c_colormap
+    {
+        return c_colormap(build_table(size, [saturation, value](float t) -> glm::vec4
+                                      { return helpers::hsv_to_rgba({ t * 360.F, saturation, value }); }));
+    }
+
+    auto c_colormap::texture_coordinate(float t) const -> float
+    {
+        return ((std::clamp(t, 0.F, 1.F) * m_scale) + 0.5F) / static_cast<float>(m_table.size());
+    }
+
+    auto c_colormap::table() const -> std::span<const glm::vec4>
+    {
+        return m_table;
+    }
+
+    auto c_colormap::size() const -> std::size_t
+    {
+        return m_table.size();
+    }
+} // namespace math
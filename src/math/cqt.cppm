@@ -0,0 +1,210 @@
+module;
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <numbers>
+#include <span>
+#include <stdexcept>
+#include <valarray>
+#include <vector>
+export module math:cqt;
+
+import :fft;
+
+export namespace math
+{
+    struct s_cqt_config
+    {
+        float sample_rate = 44100.F;
+        float min_frequency = 65.406F; // C2
+        std::size_t bins_per_octave = 12;
+        std::size_t bin_count = 84; // Seven octaves, up to B8
+        float sparsity = 0.005F;    // Kernel weights below this fraction of a bin's peak are dropped
+    };
+
+    /**
+     * @brief Constant-Q transform with geometrically spaced bins, computed from one FFT per frame.
+     *
+     * Every bin is a windowed complex sinusoid whose length holds the same number of periods, so low bins get long
+     * windows and high bins short ones. Their spectra are precomputed once as a sparse kernel (Brown and Puckette),
+     * which turns each transform into a sparse matrix-vector product over the FFT of the frame. Kernels end on the last
+     * sample of the frame, so short high-frequency windows follow the newest audio instead of the middle of the frame.
+     */
+    class c_constant_q
+    {
+    public:
+        explicit c_constant_q(s_cqt_config config = {});
+
+        /**
+         * @brief Samples per transform, the FFT length; enough for the longest kernel.
+         */
+        [[nodiscard]] auto frame_size() const -> std::size_t;
+        [[nodiscard]] auto bin_count() const -> std::size_t;
+        [[nodiscard]] auto frequency(std::size_t bin) const -> float;
+        [[nodiscard]] auto quality() const -> float;
+
+        /**
+         * @brief Non-zero kernel weights, the multiply-adds per transform.
+         */
+        [[nodiscard]] auto kernel_size() const -> std::size_t;
+
+        /**
+         * @brief Bin magnitudes from the FFT of frame_size() samples. The samples must not be windowed, each kernel
+         * carries its own window.
+         */
+        auto transform(std::span<const std::complex<float>> spectrum, std::span<float> magnitudes) const -> void;
+        [[nodiscard]] auto transform(const std::vector<float> &samples) const -> std::vector<float>;
+
+    private:
+        s_cqt_config m_config;
+        float m_quality;
+        std::size_t m_frame_size;
+
+        // Conjugated kernel spectra in compressed sparse rows, one row per bin
+        std::vector<std::size_t> m_row_offsets;
+        std::vector<std::uint32_t> m_columns;
+        std::vector<std::complex<float>> m_weights;
+    };
+
+    /**
+     * @brief Semitone bands taken as the loudest linear FFT bin between f and ceil(f * 2^(1/12)), starting at bin 1.
+     *
+     * Cheap, but it has a single bin per band in the bass and merges many in the treble. Kept as the default analysis
+     * of the spectrum panel and as the baseline the constant-Q transform is measured against.
+     */
+    auto semitone_bands(std::span<const float> magnitudes, std::vector<float> &bands) -> void;
+} // namespace math
+
+// Implementation
+namespace math
+{
+    c_constant_q::c_constant_q(s_cqt_config config)
+        : m_config(config),
+          m_quality(1.F / (std::exp2(1.F / static_cast<float>(config.bins_per_octave)) - 1.F))
+    {
+        if (config.bins_per_octave == 0 or config.bin_count == 0 or config.min_frequency <= 0.F)
+        {
+            throw std::invalid_argument("Constant-Q transform needs bins and a positive minimum frequency");
+        }
+        if (frequency(config.bin_count - 1) >= config.sample_rate / 2.F)
+        {
+            throw std::invalid_argument("Constant-Q bins reach above the Nyquist frequency");
+        }
+
+        auto window_length = [this](std::size_t bin)
+        {
+            return static_cast<std::size_t>(std::ceil(m_quality * m_config.sample_rate / frequency(bin)));
+        };
+        m_frame_size = std::bit_ceil(window_length(0));
+
+        m_row_offsets.reserve(config.bin_count + 1);
+        m_row_offsets.push_back(0);
+        std::valarray<std::complex<float>> kernel(m_frame_size);
+        for (std::size_t bin = 0; bin < config.bin_count; ++bin)
+        {
+            // Hann-windowed complex sinusoid of Q periods, normalized by its length and aligned to the frame end
+            auto length = window_length(bin);
+            auto offset = m_frame_size - length;
+            kernel = std::complex<float>{};
+            for (std::size_t n = 0; n < length; ++n)
+            {
+                auto phase = 2.F * std::numbers::pi_v<float> * static_cast<float>(n) / static_cast<float>(length);
+                auto window = 0.5F * (1.F - std::cos(phase));
+                kernel[offset + n] = std::polar(window / static_cast<float>(length), phase * m_quality);
+            }
+            fft_impl(kernel);
+
+            // Parseval: sum(x * conj(k)) equals sum(X * conj(K)) / N, so the conjugated spectrum is the row
+            float peak = 0.F;
+            for (const auto &weight : kernel)
+            {
+                peak = std::max(peak, std::abs(weight));
+            }
+            for (std::size_t column = 0; column < m_frame_size; ++column)
+            {
+                if (std::abs(kernel[column]) >= peak * config.sparsity)
+                {
+                    m_columns.push_back(static_cast<std::uint32_t>(column));
+                    m_weights.push_back(std::conj(kernel[column]) / static_cast<float>(m_frame_size));
+                }
+            }
+            m_row_offsets.push_back(m_columns.size());
+        }
+    }
+
+    auto c_constant_q::frame_size() const -> std::size_t
+    {
+        return m_frame_size;
+    }
+
+    auto c_constant_q::bin_count() const -> std::size_t
+    {
+        return m_config.bin_count;
+    }
+
+    auto c_constant_q::frequency(std::size_t bin) const -> float
+    {
+        return m_config.min_frequency * std::exp2(static_cast<float>(bin) / static_cast<float>(m_config.bins_per_octave));
+    }
+
+    auto c_constant_q::quality() const -> float
+    {
+        return m_quality;
+    }
+
+    auto c_constant_q::kernel_size() const -> std::size_t
+    {
+        return m_weights.size();
+    }
+
+    auto c_constant_q::transform(std::span<const std::complex<float>> spectrum, std::span<float> magnitudes) const -> void
+    {
+        if (spectrum.size() != m_frame_size or magnitudes.size() != bin_count())
+        {
+            throw std::invalid_argument("Constant-Q transform expects frame_size() spectrum bins and bin_count() outputs");
+        }
+        for (std::size_t bin = 0; bin < bin_count(); ++bin)
+        {
+            // Split real and imaginary sums, std::complex multiplication does not vectorize with its NaN checks
+            float real = 0.F;
+            float imaginary = 0.F;
+            for (auto index = m_row_offsets[bin]; index < m_row_offsets[bin + 1]; ++index)
+            {
+                const auto &value = spectrum[m_columns[index]];
+                const auto &weight = m_weights[index];
+                real += (value.real() * weight.real()) - (value.imag() * weight.imag());
+                imaginary += (value.real() * weight.imag()) + (value.imag() * weight.real());
+            }
+            magnitudes[bin] = std::hypot(real, imaginary);
+        }
+    }
+
+    auto c_constant_q::transform(const std::vector<float> &samples) const -> std::vector<float>
+    {
+        if (samples.size() != m_frame_size)
+        {
+            throw std::invalid_argument("Constant-Q transform expects frame_size() samples");
+        }
+        std::vector<float> magnitudes(bin_count());
+        transform(fft(samples), magnitudes);
+        return magnitudes;
+    }
+
+    auto semitone_bands(std::span<const float> magnitudes, std::vector<float> &bands) -> void
+    {
+        bands.clear();
+        const float step = std::pow(2.F, 1.F / 12.F); // Semitone step
+        auto freq_max = static_cast<float>(magnitudes.size()) / 2;
+        for (float freq = 1.F; freq < freq_max;)
+        {
+            float next = std::ceil(freq * step);
+            auto first = magnitudes.begin() + static_cast<std::ptrdiff_t>(freq);
+            auto last = std::min(magnitudes.begin() + static_cast<std::ptrdiff_t>(next), magnitudes.begin() + static_cast<std::ptrdiff_t>(freq_max));
+            bands.push_back(*std::max_element(first, last));
+            freq = next;
+        }
+    }
+} // namespace math
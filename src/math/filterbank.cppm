@@ -0,0 +1,339 @@
+module;
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <numbers>
+#include <span>
+#include <stdexcept>
+#include <vector>
+export module math:filterbank;
+
+import :fft;
+
+export namespace math
+{
+    enum class e_frequency_scale : std::uint8_t
+    {
+        mel,  // HTK: 2595 * log10(1 + f / 700)
+        bark, // Traunmüller: 26.81 * f / (1960 + f) - 0.53
+    };
+
+    auto hz_to_scale(float frequency, e_frequency_scale scale) -> float;
+    auto scale_to_hz(float value, e_frequency_scale scale) -> float;
+
+    struct s_filterbank_config
+    {
+        float sample_rate = 44100.F;
+        std::size_t fft_size = 2048;
+        std::size_t band_count = 40;
+        float min_frequency = 0.F;
+        float max_frequency = 0.F; // Nyquist when not positive
+        e_frequency_scale scale = e_frequency_scale::mel;
+    };
+
+    /**
+     * @brief Triangular filters evenly spaced on a perceptual scale, applied to a power spectrum.
+     *
+     * Each filter rises from the centre of its lower neighbour to its own centre and falls to the centre of its upper
+     * neighbour, linearly on the chosen scale, so neighbouring filters add up to one. A filter only covers a few FFT
+     * bins, so the weights are kept as compressed sparse rows and each frame costs one multiply-add per weight.
+     */
+    class c_filterbank
+    {
+    public:
+        explicit c_filterbank(s_filterbank_config config = {});
+
+        /**
+         * @brief Power spectrum bins read per frame, DC to Nyquist: fft_size / 2 + 1.
+         */
+        [[nodiscard]] auto spectrum_size() const -> std::size_t;
+        [[nodiscard]] auto band_count() const -> std::size_t;
+        [[nodiscard]] auto center_frequency(std::size_t band) const -> float;
+        [[nodiscard]] auto weight_count() const -> std::size_t;
+
+        /**
+         * @brief Band energies from spectrum_size() power bins. Does not allocate.
+         */
+        auto apply(std::span<const float> power, std::span<float> energies) const -> void;
+
+    private:
+        s_filterbank_config m_config;
+        std::vector<float> m_centers; // band_count + 2 edges on the scale, in Hz
+
+        std::vector<std::size_t> m_row_offsets;
+        std::vector<std::uint32_t> m_columns;
+        std::vector<float> m_weights;
+    };
+
+    struct s_mfcc_config
+    {
+        s_filterbank_config filterbank = {};
+        std::size_t coefficient_count = 13;
+        float log_floor = 1e-10F; // Energies are clamped to this before the logarithm, silence stays finite
+    };
+
+    /**
+     * @brief Mel-frequency cepstral coefficients: filterbank energies, log-compressed and decorrelated by a DCT-II.
+     *
+     * The DCT is orthonormal and kept as a dense coefficient_count x band_count matrix, it is small and the rows
+     * vectorize. compute() works on one frame of an FFT the caller already has and reuses internal scratch buffers, so
+     * a streaming caller does not allocate; it is therefore not safe to call on one object from several threads.
+     * analyse() is the batch variant for whole signals.
+     */
+    class c_mfcc
+    {
+    public:
+        explicit c_mfcc(s_mfcc_config config = {});
+
+        [[nodiscard]] auto filterbank() const -> const c_filterbank &;
+        [[nodiscard]] auto coefficient_count() const -> std::size_t;
+
+        /**
+         * @brief Coefficients of one frame from its fft_size() complex FFT bins. Does not allocate.
+         */
+        auto compute(std::span<const std::complex<float>> spectrum, std::span<float> coefficients) -> void;
+
+        /**
+         * @brief Coefficients from precomputed filterbank energies; the log is taken in place.
+         */
+        auto compute_from_energies(std::span<float> energies, std::span<float> coefficients) const -> void;
+
+        /**
+         * @brief Hann-windowed frames of fft_size() samples every hop samples, one row of coefficients per frame.
+         */
+        [[nodiscard]] auto analyse(std::span<const float> samples, std::size_t hop) -> std::vector<std::vector<float>>;
+
+    private:
+        s_mfcc_config m_config;
+        c_filterbank m_filterbank;
+        std::vector<float> m_dct; // Row-major, coefficient_count x band_count
+        std::vector<float> m_window;
+
+        // Scratch for compute()
+        std::vector<float> m_power;
+        std::vector<float> m_energies;
+    };
+} // namespace math
+
+// Implementation
+namespace math
+{
+    auto hz_to_scale(float frequency, e_frequency_scale scale) -> float
+    {
+        switch (scale)
+        {
+        case e_frequency_scale::bark:
+            return (26.81F * frequency / (1960.F + frequency)) - 0.53F;
+        case e_frequency_scale::mel:
+        default:
+            return 2595.F * std::log10(1.F + (frequency / 700.F));
+        }
+    }
+
+    auto scale_to_hz(float value, e_frequency_scale scale) -> float
+    {
+        switch (scale)
+        {
+        case e_frequency_scale::bark:
+            return 1960.F * (value + 0.53F) / (26.28F - value);
+        case e_frequency_scale::mel:
+        default:
+            return 700.F * (std::pow(10.F, value / 2595.F) - 1.F);
+        }
+    }
+
+    c_filterbank::c_filterbank(s_filterbank_config config)
+        : m_config(config)
+    {
+        auto nyquist = config.sample_rate / 2.F;
+        if (config.max_frequency <= 0.F)
+        {
+            m_config.max_frequency = nyquist;
+        }
+        if (config.fft_size < 2 or config.band_count == 0 or config.min_frequency < 0.F or m_config.max_frequency > nyquist or m_config.min_frequency >= m_config.max_frequency)
+        {
+            throw std::invalid_argument("Filterbank needs bands and a frequency range below the Nyquist frequency");
+        }
+
+        // Edges evenly spaced on the scale; band b spans edges b to b + 2 and peaks at b + 1
+        auto low = hz_to_scale(m_config.min_frequency, config.scale);
+        auto high = hz_to_scale(m_config.max_frequency, config.scale);
+        m_centers.resize(config.band_count + 2);
+        for (std::size_t edge = 0; edge < m_centers.size(); ++edge)
+        {
+            auto value = low + ((high - low) * static_cast<float>(edge) / static_cast<float>(config.band_count + 1));
+            m_centers[edge] = scale_to_hz(value, config.scale);
+        }
+
+        auto bin_width = config.sample_rate / static_cast<float>(config.fft_size);
+        m_row_offsets.reserve(config.band_count + 1);
+        m_row_offsets.push_back(0);
+        for (std::size_t band = 0; band < config.band_count; ++band)
+        {
+            auto lower = hz_to_scale(m_centers[band], config.scale);
+            auto center = hz_to_scale(m_centers[band + 1], config.scale);
+            auto upper = hz_to_scale(m_centers[band + 2], config.scale);
+
+            auto first = static_cast<std::size_t>(std::ceil(m_centers[band] / bin_width));
+            auto last = std::min(static_cast<std::size_t>(std::floor(m_centers[band + 2] / bin_width)), spectrum_size() - 1);
+            for (auto bin = first; bin <= last; ++bin)
+            {
+                auto value = hz_to_scale(static_cast<float>(bin) * bin_width, config.scale);
+                auto weight = value <= center ? (value - lower) / (center - lower) : (upper - value) / (upper - center);
+                if (weight > 0.F)
+                {
+                    m_columns.push_back(static_cast<std::uint32_t>(bin));
+                    m_weights.push_back(std::min(weight, 1.F));
+                }
+            }
+            m_row_offsets.push_back(m_columns.size());
+        }
+    }
+
+    auto c_filterbank::spectrum_size() const -> std::size_t
+    {
+        return (m_config.fft_size / 2) + 1;
+    }
+
+    auto c_filterbank::band_count() const -> std::size_t
+    {
+        return m_config.band_count;
+    }
+
+    auto c_filterbank::center_frequency(std::size_t band) const -> float
+    {
+        return m_centers[band + 1];
+    }
+
+    auto c_filterbank::weight_count() const -> std::size_t
+    {
+        return m_weights.size();
+    }
+
+    auto c_filterbank::apply(std::span<const float> power, std::span<float> energies) const -> void
+    {
+        if (power.size() != spectrum_size() or energies.size() != band_count())
+        {
+            throw std::invalid_argument("Filterbank expects spectrum_size() power bins and band_count() outputs");
+        }
+        for (std::size_t band = 0; band < band_count(); ++band)
+        {
+            float energy = 0.F;
+            for (auto index = m_row_offsets[band]; index < m_row_offsets[band + 1]; ++index)
+            {
+                energy += power[m_columns[index]] * m_weights[index];
+            }
+            energies[band] = energy;
+        }
+    }
+
+    c_mfcc::c_mfcc(s_mfcc_config config)
+        : m_config(config),
+          m_filterbank(config.filterbank),
+          m_power(m_filterbank.spectrum_size()),
+          m_energies(m_filterbank.band_count())
+    {
+        auto bands = m_filterbank.band_count();
+        if (config.coefficient_count == 0 or config.coefficient_count > bands)
+        {
+            throw std::invalid_argument("MFCC needs between one and band_count coefficients");
+        }
+
+        // Orthonormal DCT-II: c[k] = s(k) * sum(x[n] * cos(pi * k * (2n + 1) / 2N)), s(0) = sqrt(1/N), s(k) = sqrt(2/N)
+        m_dct.resize(config.coefficient_count * bands);
+        auto count = static_cast<float>(bands);
+        for (std::size_t k = 0; k < config.coefficient_count; ++k)
+        {
+            auto scale = std::sqrt((k == 0 ? 1.F : 2.F) / count);
+            for (std::size_t n = 0; n < bands; ++n)
+            {
+                auto angle = std::numbers::pi_v<float> * static_cast<float>(k) * (static_cast<float>(2 * n) + 1.F) / (2.F * count);
+                m_dct[(k * bands) + n] = scale * std::cos(angle);
+            }
+        }
+
+        // Periodic Hann, so consecutive frames at half overlap add up to a constant
+        m_window.resize(config.filterbank.fft_size);
+        for (std::size_t n = 0; n < m_window.size(); ++n)
+        {
+            auto phase = 2.F * std::numbers::pi_v<float> * static_cast<float>(n) / static_cast<float>(m_window.size());
+            m_window[n] = 0.5F * (1.F - std::cos(phase));
+        }
+    }
+
+    auto c_mfcc::filterbank() const -> const c_filterbank &
+    {
+        return m_filterbank;
+    }
+
+    auto c_mfcc::coefficient_count() const -> std::size_t
+    {
+        return m_config.coefficient_count;
+    }
+
+    auto c_mfcc::compute(std::span<const std::complex<float>> spectrum, std::span<float> coefficients) -> void
+    {
+        if (spectrum.size() != m_config.filterbank.fft_size)
+        {
+            throw std::invalid_argument("MFCC expects fft_size FFT bins");
+        }
+        for (std::size_t bin = 0; bin < m_power.size(); ++bin)
+        {
+            m_power[bin] = std::norm(spectrum[bin]);
+        }
+        m_filterbank.apply(m_power, m_energies);
+        compute_from_energies(m_energies, coefficients);
+    }
+
+    auto c_mfcc::compute_from_energies(std::span<float> energies, std::span<float> coefficients) const -> void
+    {
+        if (energies.size() != m_filterbank.band_count() or coefficients.size() != coefficient_count())
+        {
+            throw std::invalid_argument("MFCC expects band_count() energies and coefficient_count() outputs");
+        }
+        for (auto &energy : energies)
+        {
+            energy = std::log(std::max(energy, m_config.log_floor));
+        }
+
+        auto bands = energies.size();
+        for (std::size_t k = 0; k < coefficients.size(); ++k)
+        {
+            const auto *row = m_dct.data() + (k * bands);
+            float sum = 0.F;
+            for (std::size_t n = 0; n < bands; ++n)
+            {
+                sum += row[n] * energies[n];
+            }
+            coefficients[k] = sum;
+        }
+    }
+
+    auto c_mfcc::analyse(std::span<const float> samples, std::size_t hop) -> std::vector<std::vector<float>>
+    {
+        if (hop == 0)
+        {
+            throw std::invalid_argument("MFCC hop must be positive");
+        }
+
+        auto frame_size = m_window.size();
+        std::vector<std::vector<float>> frames;
+        if (samples.size() < frame_size)
+        {
+            return frames;
+        }
+        frames.reserve(((samples.size() - frame_size) / hop) + 1);
+
+        std::vector<float> frame(frame_size);
+        for (std::size_t start = 0; start + frame_size <= samples.size(); start += hop)
+        {
+            std::ranges::transform(samples.subspan(start, frame_size), m_window, frame.begin(), std::multiplies{});
+            auto &coefficients = frames.emplace_back(coefficient_count());
+            compute(fft(frame), coefficients);
+        }
+        return frames;
+    }
+} // namespace math
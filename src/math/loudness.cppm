@@ -0,0 +1,327 @@
+module;
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <numbers>
+#include <span>
+#include <stdexcept>
+#include <vector>
+export module math:loudness;
+
+export namespace math
+{
+    /**
+     * @brief Loudness and true peak after ITU-R BS.1770-4, with the EBU R128 momentary, short-term and integrated
+     * measures.
+     *
+     * Samples are K-weighted by two biquads, a high shelf modelling the head and a high-pass, and their mean square is
+     * collected in 100 ms blocks. Momentary loudness spans the last 4 blocks and short-term the last 30. Integrated
+     * loudness is gated at -70 LUFS and then 10 LU below the mean of what passed. It is kept as a histogram of block
+     * loudness in 0.1 LU steps, so memory stays fixed however long the programme runs.
+     *
+     * True peak is the largest magnitude of the signal oversampled four times by a 48-tap polyphase interpolator.
+     *
+     * Filter and interpolator states are laid out per channel side by side, with the channel as the innermost loop, so
+     * the work of all channels on one frame vectorizes.
+     */
+    class c_loudness_meter
+    {
+    public:
+        static constexpr std::size_t s_max_channels = 8;
+
+        explicit c_loudness_meter(float sample_rate = 44100.F, std::size_t channels = 2);
+
+        /**
+         * @brief Measure interleaved samples; a trailing partial frame is ignored.
+         */
+        auto process(std::span<const float> samples) -> void;
+        auto reset() -> void;
+
+        /**
+         * @brief Loudness in LUFS, minus infinity until there is any signal over the window.
+         */
+        [[nodiscard]] auto momentary() const -> float;
+        [[nodiscard]] auto short_term() const -> float;
+        [[nodiscard]] auto integrated() const -> float;
+
+        /**
+         * @brief Largest true peak since the last reset, in dBTP, over all channels.
+         */
+        [[nodiscard]] auto true_peak() const -> float;
+
+        /**
+         * @brief Largest sample magnitude since the last reset, in dBFS, for comparison with true_peak().
+         */
+        [[nodiscard]] auto sample_peak() const -> float;
+
+    private:
+        struct s_biquad
+        {
+            std::array<double, 3> b{};
+            std::array<double, 2> a{};
+        };
+
+        // Per channel filter state, transposed direct form II
+        struct s_biquad_state
+        {
+            std::array<double, s_max_channels> z1{};
+            std::array<double, s_max_channels> z2{};
+        };
+
+        static constexpr std::size_t s_oversampling = 4;
+        static constexpr std::size_t s_phase_taps = 12;
+        static constexpr std::size_t s_momentary_blocks = 4;
+        static constexpr std::size_t s_short_term_blocks = 30;
+        static constexpr float s_absolute_gate = -70.F;
+        static constexpr float s_relative_gate = -10.F;
+        static constexpr float s_histogram_top = 5.F;
+        static constexpr float s_histogram_step = 0.1F;
+
+        std::size_t m_channels;
+        std::size_t m_block_frames;
+        s_biquad m_shelf;
+        s_biquad m_highpass;
+        s_biquad_state m_shelf_state;
+        s_biquad_state m_highpass_state;
+
+        std::array<std::array<float, s_phase_taps>, s_oversampling> m_interpolator{};
+        std::array<std::array<float, s_max_channels>, s_phase_taps> m_peak_history{}; // Newest first
+        std::array<float, s_max_channels> m_true_peak{};
+        std::array<float, s_max_channels> m_sample_peak{};
+
+        std::array<double, s_max_channels> m_block_sum{}; // Squares of the block so far, per channel
+        std::size_t m_block_position{};
+        std::array<double, s_short_term_blocks> m_blocks{}; // Mean square of 100 ms blocks, summed over channels
+        std::size_t m_block_write{};
+        std::size_t m_block_count{};
+
+        std::vector<std::uint64_t> m_histogram_count;
+        std::vector<double> m_histogram_energy;
+
+        [[nodiscard]] auto window_energy(std::size_t blocks) const -> double;
+        auto end_block() -> void;
+        static auto to_lufs(double energy) -> float;
+    };
+} // namespace math
+
+// Implementation
+namespace math
+{
+    c_loudness_meter::c_loudness_meter(float sample_rate, std::size_t channels)
+        : m_channels(channels),
+          m_block_frames(static_cast<std::size_t>(std::lround(sample_rate / 10.F)))
+    {
+        if (channels == 0 or channels > s_max_channels or sample_rate <= 0.F)
+        {
+            throw std::invalid_argument("Loudness meter needs a positive sample rate and up to s_max_channels channels");
+        }
+
+        // K-weighting for any sample rate, from the analogue prototypes of the 48 kHz coefficients in BS.1770
+        auto rate = static_cast<double>(sample_rate);
+        {
+            constexpr double frequency = 1681.974450955533;
+            constexpr double gain = 3.999843853973347;
+            constexpr double quality = 0.7071752369554196;
+            auto k = std::tan(std::numbers::pi * frequency / rate);
+            auto high = std::pow(10.0, gain / 20.0);
+            auto band = std::pow(high, 0.4996667741545416);
+            auto norm = 1.0 + (k / quality) + (k * k);
+            m_shelf.b = { (high + (band * k / quality) + (k * k)) / norm, 2.0 * ((k * k) - high) / norm, (high - (band * k / quality) + (k * k)) / norm };
+            m_shelf.a = { 2.0 * ((k * k) - 1.0) / norm, (1.0 - (k / quality) + (k * k)) / norm };
+        }
+        {
+            constexpr double frequency = 38.13547087602444;
+            constexpr double quality = 0.5003270373238773;
+            auto k = std::tan(std::numbers::pi * frequency / rate);
+            auto norm = 1.0 + (k / quality) + (k * k);
+            m_highpass.b = { 1.0, -2.0, 1.0 };
+            m_highpass.a = { 2.0 * ((k * k) - 1.0) / norm, (1.0 - (k / quality) + (k * k)) / norm };
+        }
+
+        // Windowed sinc at the original Nyquist frequency, split into one phase per oversampled position
+        constexpr auto taps = s_oversampling * s_phase_taps;
+        for (std::size_t n = 0; n < taps; ++n)
+        {
+            auto position = (static_cast<double>(n) - (static_cast<double>(taps - 1) / 2.0)) / static_cast<double>(s_oversampling);
+            auto sinc = position == 0.0 ? 1.0 : std::sin(std::numbers::pi * position) / (std::numbers::pi * position);
+            auto window = 0.5 * (1.0 - std::cos(2.0 * std::numbers::pi * (static_cast<double>(n) + 0.5) / static_cast<double>(taps)));
+            m_interpolator[n % s_oversampling][n / s_oversampling] = static_cast<float>(sinc * window);
+        }
+
+        auto bins = static_cast<std::size_t>(std::lround((s_histogram_top - s_absolute_gate) / s_histogram_step));
+        m_histogram_count.resize(bins);
+        m_histogram_energy.resize(bins);
+        reset();
+    }
+
+    auto c_loudness_meter::reset() -> void
+    {
+        m_shelf_state = {};
+        m_highpass_state = {};
+        m_peak_history = {};
+        m_true_peak = {};
+        m_sample_peak = {};
+        m_block_sum = {};
+        m_block_position = 0;
+        m_blocks = {};
+        m_block_write = 0;
+        m_block_count = 0;
+        std::ranges::fill(m_histogram_count, 0);
+        std::ranges::fill(m_histogram_energy, 0.0);
+    }
+
+    auto c_loudness_meter::process(std::span<const float> samples) -> void
+    {
+        auto frames = samples.size() / m_channels;
+        for (std::size_t frame = 0; frame < frames; ++frame)
+        {
+            const auto *input = samples.data() + (frame * m_channels);
+
+            // Interpolator history moves one sample along, the phases then read the same taps
+            for (auto tap = s_phase_taps - 1; tap > 0; --tap)
+            {
+                m_peak_history[tap] = m_peak_history[tap - 1];
+            }
+            for (std::size_t channel = 0; channel < m_channels; ++channel)
+            {
+                m_peak_history[0][channel] = input[channel];
+                m_sample_peak[channel] = std::max(m_sample_peak[channel], std::abs(input[channel]));
+            }
+            for (const auto &phase : m_interpolator)
+            {
+                std::array<float, s_max_channels> value{};
+                for (std::size_t tap = 0; tap < s_phase_taps; ++tap)
+                {
+                    for (std::size_t channel = 0; channel < m_channels; ++channel)
+                    {
+                        value[channel] += phase[tap] * m_peak_history[tap][channel];
+                    }
+                }
+                for (std::size_t channel = 0; channel < m_channels; ++channel)
+                {
+                    m_true_peak[channel] = std::max(m_true_peak[channel], std::abs(value[channel]));
+                }
+            }
+
+            for (std::size_t channel = 0; channel < m_channels; ++channel)
+            {
+                auto x = static_cast<double>(input[channel]);
+                auto shelved = (m_shelf.b[0] * x) + m_shelf_state.z1[channel];
+                m_shelf_state.z1[channel] = (m_shelf.b[1] * x) - (m_shelf.a[0] * shelved) + m_shelf_state.z2[channel];
+                m_shelf_state.z2[channel] = (m_shelf.b[2] * x) - (m_shelf.a[1] * shelved);
+
+                auto weighted = (m_highpass.b[0] * shelved) + m_highpass_state.z1[channel];
+                m_highpass_state.z1[channel] = (m_highpass.b[1] * shelved) - (m_highpass.a[0] * weighted) + m_highpass_state.z2[channel];
+                m_highpass_state.z2[channel] = (m_highpass.b[2] * shelved) - (m_highpass.a[1] * weighted);
+
+                m_block_sum[channel] += weighted * weighted;
+            }
+
+            if (++m_block_position == m_block_frames)
+            {
+                end_block();
+            }
+        }
+    }
+
+    auto c_loudness_meter::end_block() -> void
+    {
+        // Front channels weigh 1; surround weights need a channel layout, which the mix does not carry
+        double energy = 0.0;
+        for (std::size_t channel = 0; channel < m_channels; ++channel)
+        {
+            energy += m_block_sum[channel] / static_cast<double>(m_block_frames);
+        }
+        m_block_sum = {};
+        m_block_position = 0;
+
+        m_blocks[m_block_write] = energy;
+        m_block_write = (m_block_write + 1) % m_blocks.size();
+        m_block_count = std::min(m_block_count + 1, m_blocks.size());
+
+        // Gating blocks are 400 ms long and overlap by 75%, one ends with every 100 ms block
+        if (m_block_count < s_momentary_blocks)
+        {
+            return;
+        }
+        auto gating_energy = window_energy(s_momentary_blocks);
+        auto loudness = to_lufs(gating_energy);
+        if (loudness < s_absolute_gate)
+        {
+            return;
+        }
+        auto bin = std::min(static_cast<std::size_t>((loudness - s_absolute_gate) / s_histogram_step), m_histogram_count.size() - 1);
+        ++m_histogram_count[bin];
+        m_histogram_energy[bin] += gating_energy;
+    }
+
+    auto c_loudness_meter::window_energy(std::size_t blocks) const -> double
+    {
+        blocks = std::min(blocks, m_block_count);
+        if (blocks == 0)
+        {
+            return 0.0;
+        }
+        double sum = 0.0;
+        for (std::size_t i = 1; i <= blocks; ++i)
+        {
+            sum += m_blocks[(m_block_write + m_blocks.size() - i) % m_blocks.size()];
+        }
+        return sum / static_cast<double>(blocks);
+    }
+
+    auto c_loudness_meter::to_lufs(double energy) -> float
+    {
+        return energy > 0.0 ? static_cast<float>(-0.691 + (10.0 * std::log10(energy))) : -std::numeric_limits<float>::infinity();
+    }
+
+    auto c_loudness_meter::momentary() const -> float
+    {
+        return m_block_count < s_momentary_blocks ? -std::numeric_limits<float>::infinity() : to_lufs(window_energy(s_momentary_blocks));
+    }
+
+    auto c_loudness_meter::short_term() const -> float
+    {
+        return to_lufs(window_energy(s_short_term_blocks));
+    }
+
+    auto c_loudness_meter::integrated() const -> float
+    {
+        // Every block in the histogram passed the absolute gate
+        auto mean_from = [this](std::size_t first_bin)
+        {
+            double energy = 0.0;
+            std::uint64_t count = 0;
+            for (auto bin = first_bin; bin < m_histogram_count.size(); ++bin)
+            {
+                energy += m_histogram_energy[bin];
+                count += m_histogram_count[bin];
+            }
+            return count == 0 ? 0.0 : energy / static_cast<double>(count);
+        };
+
+        auto ungated = mean_from(0);
+        if (ungated <= 0.0)
+        {
+            return -std::numeric_limits<float>::infinity();
+        }
+        auto threshold = std::max(to_lufs(ungated) + s_relative_gate, s_absolute_gate);
+        auto first_bin = static_cast<std::size_t>(std::ceil((threshold - s_absolute_gate) / s_histogram_step));
+        return to_lufs(mean_from(std::min(first_bin, m_histogram_count.size() - 1)));
+    }
+
+    auto c_loudness_meter::true_peak() const -> float
+    {
+        auto peak = std::ranges::max(std::span(m_true_peak).first(m_channels));
+        return peak > 0.F ? 20.F * std::log10(peak) : -std::numeric_limits<float>::infinity();
+    }
+
+    auto c_loudness_meter::sample_peak() const -> float
+    {
+        auto peak = std::ranges::max(std::span(m_sample_peak).first(m_channels));
+        return peak > 0.F ? 20.F * std::log10(peak) : -std::numeric_limits<float>::infinity();
+    }
+} // namespace math
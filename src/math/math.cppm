@@ -1,4 +1,10 @@
 export module math;
 
+export import :colormap;
+export import :cqt;
 export import :fft;
+export import :filterbank;
 export import :helpers;
+export import :loudness;
+export import :onset;
+export import :pitch;
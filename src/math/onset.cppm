@@ -0,0 +1,404 @@
+module;
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <complex>
+#include <cstddef>
+#include <functional>
+#include <numbers>
+#include <span>
+#include <stdexcept>
+#include <vector>
+export module math:onset;
+
+import :fft;
+
+export namespace math
+{
+    struct s_onset_config
+    {
+        float hop_rate = 60.F;        // Analysis frames per second
+        float threshold_window = 0.5F; // Seconds of flux the adaptive threshold is the median of
+        float threshold_scale = 1.5F;
+        float threshold_offset = 0.01F; // Added to the threshold, so steady noise does not trigger onsets
+        float min_interval = 0.1F;      // Seconds between two onsets
+    };
+
+    /**
+     * @brief Streaming onset detection by spectral flux with an adaptive threshold.
+     *
+     * The flux of a frame is the half-wave rectified increase of log-compressed magnitudes over the previous frame,
+     * averaged over bins, so only energy that appears counts. An onset is reported when the flux rises above a
+     * multiple of the median flux of the last threshold_window seconds. Memory is fixed by the configuration and push()
+     * does not allocate once the number of bins is settled.
+     */
+    class c_onset_detector
+    {
+    public:
+        explicit c_onset_detector(s_onset_config config = {});
+
+        /**
+         * @brief Feed the magnitudes of the next frame. Returns whether the frame is an onset.
+         *
+         * A change in the number of magnitudes restarts detection, the first frame only primes it.
+         */
+        auto push(std::span<const float> magnitudes) -> bool;
+        auto reset() -> void;
+
+        /**
+         * @brief Onset strength of the last frame, the signal the beat tracker follows.
+         */
+        [[nodiscard]] auto flux() const -> float;
+        [[nodiscard]] auto threshold() const -> float;
+
+    private:
+        s_onset_config m_config;
+        std::vector<float> m_previous; // Log magnitudes of the previous frame
+        std::vector<float> m_history;  // Ring of recent flux values
+        std::vector<float> m_sorted;   // Scratch for the median
+        std::size_t m_write{};
+        std::size_t m_count{};
+        std::size_t m_min_gap;
+        std::size_t m_since_onset{};
+        float m_flux{};
+        float m_threshold{};
+    };
+
+    struct s_tempo_config
+    {
+        float hop_rate = 60.F; // Onset strength values per second
+        float min_bpm = 60.F;
+        float max_bpm = 200.F;
+        float preferred_bpm = 120.F; // Centre of the prior against octave errors
+        float history = 8.F;         // Seconds of onset strength the tempo is estimated over
+        float update_interval = 0.25F;
+    };
+
+    /**
+     * @brief Streaming tempo and beat tracker over an onset strength envelope.
+     *
+     * The envelope is kept in a ring of `history` seconds. Every update_interval its autocorrelation is taken over the
+     * lags of the allowed tempo range. The lags are weighted by a log-normal prior around preferred_bpm, one octave
+     * wide, because half and double tempo correlate nearly as well. The peak lag is refined by parabolic
+     * interpolation. The beat phase is the offset whose comb of pulses one period apart collects the most envelope.
+     * Beats are then predicted one period apart between updates, so push() can report them on the frame they fall on.
+     */
+    class c_beat_tracker
+    {
+    public:
+        explicit c_beat_tracker(s_tempo_config config = {});
+
+        /**
+         * @brief Feed the next onset strength value. Returns whether a beat falls on this frame.
+         */
+        auto push(float onset_strength) -> bool;
+        auto reset() -> void;
+
+        /**
+         * @brief Estimated tempo in beats per minute, 0 until enough of the envelope is known.
+         */
+        [[nodiscard]] auto tempo() const -> float;
+
+        /**
+         * @brief Position within the current beat, 0 on the beat and rising towards 1.
+         */
+        [[nodiscard]] auto beat_phase() const -> float;
+
+    private:
+        s_tempo_config m_config;
+        std::vector<float> m_envelope; // Ring of onset strength
+        std::vector<float> m_centered; // Scratch: the ring unrolled, oldest first, mean removed
+        std::vector<float> m_scores;   // Scratch: weighted autocorrelation per lag
+        std::size_t m_write{};
+        std::size_t m_count{};
+        std::size_t m_min_lag;
+        std::size_t m_max_lag;
+        std::size_t m_update_frames;
+        std::size_t m_until_update{};
+        float m_period{};     // Frames per beat, 0 while unknown
+        float m_next_beat{};  // Frames until the predicted beat
+        float m_since_beat{}; // Frames since the last reported beat
+
+        auto update() -> void;
+    };
+
+    struct s_rhythm_analysis
+    {
+        float tempo{};
+        std::vector<float> onset_times; // Seconds
+        std::vector<float> beat_times;  // Seconds
+    };
+
+    /**
+     * @brief Offline onsets, tempo and beats of a mono signal, through the same streaming stages as live analysis.
+     *
+     * Hann-windowed frames of frame_size samples are taken every hop samples; frame_size must be a power of two.
+     */
+    auto analyse_rhythm(std::span<const float> samples, float sample_rate, std::size_t frame_size = 2048, std::size_t hop = 512) -> s_rhythm_analysis;
+} // namespace math
+
+// Implementation
+namespace math
+{
+    c_onset_detector::c_onset_detector(s_onset_config config)
+        : m_config(config),
+          m_history(std::max<std::size_t>(1, static_cast<std::size_t>(config.threshold_window * config.hop_rate))),
+          m_sorted(m_history.size()),
+          m_min_gap(static_cast<std::size_t>(config.min_interval * config.hop_rate))
+    {
+        if (config.hop_rate <= 0.F)
+        {
+            throw std::invalid_argument("Onset detection needs a positive hop rate");
+        }
+        reset();
+    }
+
+    auto c_onset_detector::reset() -> void
+    {
+        m_previous.clear();
+        std::ranges::fill(m_history, 0.F);
+        m_write = 0;
+        m_count = 0;
+        m_since_onset = m_min_gap;
+        m_flux = 0.F;
+        m_threshold = m_config.threshold_offset;
+    }
+
+    auto c_onset_detector::push(std::span<const float> magnitudes) -> bool
+    {
+        if (m_previous.size() != magnitudes.size())
+        {
+            reset();
+            m_previous.resize(magnitudes.size());
+            std::ranges::transform(magnitudes, m_previous.begin(), [](float magnitude)
+                                   { return std::log1p(magnitude); });
+            return false;
+        }
+
+        float flux = 0.F;
+        for (std::size_t bin = 0; bin < magnitudes.size(); ++bin)
+        {
+            auto value = std::log1p(magnitudes[bin]);
+            flux += std::max(0.F, value - m_previous[bin]);
+            m_previous[bin] = value;
+        }
+        m_flux = magnitudes.empty() ? 0.F : flux / static_cast<float>(magnitudes.size());
+
+        // Median of the recent flux, without the current frame so that a burst does not raise its own bar
+        auto window = std::span(m_sorted).first(m_count);
+        std::ranges::copy(std::span(m_history).first(m_count), window.begin());
+        auto middle = window.begin() + static_cast<std::ptrdiff_t>(m_count / 2);
+        std::ranges::nth_element(window, middle);
+        auto median = m_count == 0 ? 0.F : *middle;
+        m_threshold = (m_config.threshold_scale * median) + m_config.threshold_offset;
+
+        m_history[m_write] = m_flux;
+        m_write = (m_write + 1) % m_history.size();
+        m_count = std::min(m_count + 1, m_history.size());
+
+        ++m_since_onset;
+        if (m_flux > m_threshold and m_since_onset > m_min_gap)
+        {
+            m_since_onset = 0;
+            return true;
+        }
+        return false;
+    }
+
+    auto c_onset_detector::flux() const -> float
+    {
+        return m_flux;
+    }
+
+    auto c_onset_detector::threshold() const -> float
+    {
+        return m_threshold;
+    }
+
+    c_beat_tracker::c_beat_tracker(s_tempo_config config)
+        : m_config(config),
+          m_envelope(static_cast<std::size_t>(config.history * config.hop_rate)),
+          m_centered(m_envelope.size()),
+          m_min_lag(static_cast<std::size_t>(std::floor(60.F * config.hop_rate / config.max_bpm))),
+          m_max_lag(static_cast<std::size_t>(std::ceil(60.F * config.hop_rate / config.min_bpm))),
+          m_update_frames(std::max<std::size_t>(1, static_cast<std::size_t>(config.update_interval * config.hop_rate)))
+    {
+        if (config.hop_rate <= 0.F or config.min_bpm <= 0.F or config.min_bpm >= config.max_bpm or m_min_lag < 2)
+        {
+            throw std::invalid_argument("Beat tracking needs a tempo range of at least two frames per beat");
+        }
+        if (m_envelope.size() < 2 * m_max_lag)
+        {
+            throw std::invalid_argument("Beat tracking history must hold two periods of the slowest tempo");
+        }
+        m_scores.resize(m_max_lag + 2);
+        reset();
+    }
+
+    auto c_beat_tracker::reset() -> void
+    {
+        std::ranges::fill(m_envelope, 0.F);
+        m_write = 0;
+        m_count = 0;
+        m_until_update = m_update_frames;
+        m_period = 0.F;
+        m_next_beat = 0.F;
+        m_since_beat = 0.F;
+    }
+
+    auto c_beat_tracker::push(float onset_strength) -> bool
+    {
+        m_envelope[m_write] = onset_strength;
+        m_write = (m_write + 1) % m_envelope.size();
+        m_count = std::min(m_count + 1, m_envelope.size());
+        m_since_beat += 1.F;
+        m_next_beat -= 1.F;
+
+        if (--m_until_update == 0)
+        {
+            m_until_update = m_update_frames;
+            update();
+        }
+        if (m_period <= 0.F)
+        {
+            return false;
+        }
+
+        // A new phase estimate must not report the same beat twice
+        if (m_next_beat <= 0.5F)
+        {
+            m_next_beat += m_period;
+            if (m_since_beat >= m_period / 2.F)
+            {
+                m_since_beat = 0.F;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    auto c_beat_tracker::update() -> void
+    {
+        // Two periods of the slowest tempo are needed before a peak can be told apart
+        if (m_count < 2 * m_max_lag)
+        {
+            return;
+        }
+
+        // Unroll the ring, oldest first, and remove the mean so that a constant level does not correlate
+        auto size = m_count;
+        auto start = (m_write + m_envelope.size() - size) % m_envelope.size();
+        float mean = 0.F;
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            m_centered[i] = m_envelope[(start + i) % m_envelope.size()];
+            mean += m_centered[i];
+        }
+        mean /= static_cast<float>(size);
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            m_centered[i] -= mean;
+        }
+
+        auto preferred_lag = 60.F * m_config.hop_rate / m_config.preferred_bpm;
+        std::ranges::fill(m_scores, 0.F);
+        std::size_t best_lag = 0;
+        for (auto lag = m_min_lag - 1; lag <= m_max_lag + 1; ++lag)
+        {
+            float sum = 0.F;
+            for (auto i = lag; i < size; ++i)
+            {
+                sum += m_centered[i] * m_centered[i - lag];
+            }
+            // Unbiased, so long lags are not penalized for having fewer products
+            auto octaves = std::log2(static_cast<float>(lag) / preferred_lag);
+            m_scores[lag] = sum / static_cast<float>(size - lag) * std::exp(-0.5F * octaves * octaves);
+            if (lag >= m_min_lag and lag <= m_max_lag and (best_lag == 0 or m_scores[lag] > m_scores[best_lag]))
+            {
+                best_lag = lag;
+            }
+        }
+        if (m_scores[best_lag] <= 0.F)
+        {
+            return;
+        }
+
+        // Parabolic interpolation through the peak and its neighbours
+        auto left = m_scores[best_lag - 1];
+        auto centre = m_scores[best_lag];
+        auto right = m_scores[best_lag + 1];
+        auto curvature = left - (2.F * centre) + right;
+        auto shift = curvature < 0.F ? std::clamp(0.5F * (left - right) / curvature, -0.5F, 0.5F) : 0.F;
+        m_period = static_cast<float>(best_lag) + shift;
+
+        // Phase: how many frames ago the comb of beats that collects the most onset strength last struck
+        std::size_t best_offset = 0;
+        float best_score = -1.F;
+        for (std::size_t offset = 0; offset < static_cast<std::size_t>(m_period); ++offset)
+        {
+            float score = 0.F;
+            for (auto beat = static_cast<float>(offset); beat < static_cast<float>(size) - 0.5F; beat += m_period)
+            {
+                score += m_centered[size - 1 - static_cast<std::size_t>(std::lround(beat))];
+            }
+            if (score > best_score)
+            {
+                best_score = score;
+                best_offset = offset;
+            }
+        }
+        m_next_beat = m_period - static_cast<float>(best_offset);
+    }
+
+    auto c_beat_tracker::tempo() const -> float
+    {
+        return m_period > 0.F ? 60.F * m_config.hop_rate / m_period : 0.F;
+    }
+
+    auto c_beat_tracker::beat_phase() const -> float
+    {
+        return m_period > 0.F ? std::clamp(1.F - (m_next_beat / m_period), 0.F, 1.F) : 0.F;
+    }
+
+    auto analyse_rhythm(std::span<const float> samples, float sample_rate, std::size_t frame_size, std::size_t hop) -> s_rhythm_analysis
+    {
+        if (hop == 0 or not std::has_single_bit(frame_size))
+        {
+            throw std::invalid_argument("Rhythm analysis needs a positive hop and a power of two frame size");
+        }
+
+        auto hop_rate = sample_rate / static_cast<float>(hop);
+        c_onset_detector onsets({ .hop_rate = hop_rate });
+        c_beat_tracker beats({ .hop_rate = hop_rate });
+
+        s_rhythm_analysis analysis;
+        std::vector<float> window(frame_size);
+        for (std::size_t n = 0; n < frame_size; ++n)
+        {
+            window[n] = 0.5F * (1.F - std::cos(2.F * std::numbers::pi_v<float> * static_cast<float>(n) / static_cast<float>(frame_size)));
+        }
+
+        std::vector<float> frame(frame_size);
+        std::vector<float> magnitudes((frame_size / 2) + 1);
+        for (std::size_t start = 0; start + frame_size <= samples.size(); start += hop)
+        {
+            std::ranges::transform(samples.subspan(start, frame_size), window, frame.begin(), std::multiplies{});
+            auto spectrum = fft(frame);
+            std::ranges::transform(spectrum.begin(), spectrum.begin() + static_cast<std::ptrdiff_t>(magnitudes.size()), magnitudes.begin(), [](const std::complex<float> &value)
+                                   { return std::abs(value); });
+
+            // Frames are stamped at their centre
+            auto time = static_cast<float>(start + (frame_size / 2)) / sample_rate;
+            if (onsets.push(magnitudes))
+            {
+                analysis.onset_times.push_back(time);
+            }
+            if (beats.push(onsets.flux()))
+            {
+                analysis.beat_times.push_back(time);
+            }
+        }
+        analysis.tempo = beats.tempo();
+        return analysis;
+    }
+} // namespace math
@@ -0,0 +1,179 @@
+module;
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <complex>
+#include <cstddef>
+#include <span>
+#include <stdexcept>
+#include <vector>
+export module math:pitch;
+
+import :fft;
+
+export namespace math
+{
+    struct s_pitch_config
+    {
+        float sample_rate = 44100.F;
+        std::size_t frame_size = 2048; // Half is the integration window, half the longest period
+        float min_frequency = 50.F;
+        float max_frequency = 2000.F;
+        float threshold = 0.1F; // Dips of the normalized difference below this are taken as the period
+    };
+
+    struct s_pitch
+    {
+        float frequency{};  // Hz, 0 when no periodicity was found
+        float confidence{}; // 1 minus the normalized difference at the period, 1 for a pure periodic signal
+    };
+
+    /**
+     * @brief Fundamental frequency by YIN, with the difference function computed through the FFT.
+     *
+     * The squared difference between the first half of the frame and the frame shifted by a lag expands into two
+     * energy terms and a cross-correlation. The energies are running sums and the cross-correlation is one product of
+     * spectra, so a frame costs O(N log N) instead of the O(N^2) of evaluating every lag directly. The difference is
+     * normalized by its cumulative mean; the first dip below the threshold is the period, refined by parabolic
+     * interpolation. Buffers are kept between frames, so detect() is not safe to call on one object from several
+     * threads.
+     */
+    class c_pitch_detector
+    {
+    public:
+        explicit c_pitch_detector(s_pitch_config config = {});
+
+        [[nodiscard]] auto frame_size() const -> std::size_t;
+
+        /**
+         * @brief Pitch of frame_size() samples, the newest last.
+         */
+        auto detect(std::span<const float> samples) -> s_pitch;
+
+    private:
+        s_pitch_config m_config;
+        std::size_t m_min_lag;
+        std::size_t m_max_lag;
+        std::vector<float> m_padded;     // Zero padded to twice the frame, so the correlation does not wrap
+        std::vector<float> m_difference; // Cumulative mean normalized difference per lag
+    };
+
+    /**
+     * @brief Nearest equal-tempered note, as a MIDI number where A4 at 440 Hz is 69, and the offset from it in cents.
+     */
+    struct s_note
+    {
+        int midi{};
+        float cents{};
+    };
+    auto nearest_note(float frequency) -> s_note;
+} // namespace math
+
+// Implementation
+namespace math
+{
+    c_pitch_detector::c_pitch_detector(s_pitch_config config)
+        : m_config(config),
+          m_min_lag(static_cast<std::size_t>(std::floor(config.sample_rate / config.max_frequency))),
+          m_max_lag(static_cast<std::size_t>(std::ceil(config.sample_rate / config.min_frequency)))
+    {
+        if (not std::has_single_bit(config.frame_size) or config.min_frequency <= 0.F or config.min_frequency >= config.max_frequency or m_min_lag < 2)
+        {
+            throw std::invalid_argument("Pitch detection needs a power of two frame and a frequency range below a quarter of the sample rate");
+        }
+        if (m_max_lag + 1 >= config.frame_size / 2)
+        {
+            throw std::invalid_argument("Pitch detection frame must hold two periods of the lowest frequency");
+        }
+        m_padded.resize(2 * config.frame_size);
+        m_difference.resize(m_max_lag + 2);
+    }
+
+    auto c_pitch_detector::frame_size() const -> std::size_t
+    {
+        return m_config.frame_size;
+    }
+
+    auto c_pitch_detector::detect(std::span<const float> samples) -> s_pitch
+    {
+        if (samples.size() != m_config.frame_size)
+        {
+            throw std::invalid_argument("Pitch detection expects frame_size() samples");
+        }
+        auto window = m_config.frame_size / 2;
+
+        // Cross-correlation of the first half with the whole frame: ifft(conj(A) * B)[lag] = sum(a[j] * b[j + lag])
+        std::ranges::fill(m_padded, 0.F);
+        std::ranges::copy(samples.first(window), m_padded.begin());
+        auto head = fft(m_padded);
+        std::ranges::copy(samples, m_padded.begin());
+        auto whole = fft(m_padded);
+        for (std::size_t bin = 0; bin < whole.size(); ++bin)
+        {
+            whole[bin] *= std::conj(head[bin]);
+        }
+        auto correlation = ifft(whole);
+
+        // d(lag) = sum(a[j]^2) + sum(b[j + lag]^2) - 2 * r(lag), the shifted energy slides one sample per lag
+        float head_energy = 0.F;
+        for (std::size_t j = 0; j < window; ++j)
+        {
+            head_energy += samples[j] * samples[j];
+        }
+        auto shifted_energy = head_energy;
+
+        m_difference[0] = 1.F;
+        float running_sum = 0.F;
+        for (std::size_t lag = 1; lag < m_difference.size(); ++lag)
+        {
+            shifted_energy += (samples[lag + window - 1] * samples[lag + window - 1]) - (samples[lag - 1] * samples[lag - 1]);
+            auto difference = std::max(0.F, head_energy + shifted_energy - (2.F * correlation[lag]));
+            running_sum += difference;
+            m_difference[lag] = running_sum > 0.F ? difference * static_cast<float>(lag) / running_sum : 1.F;
+        }
+
+        // First dip below the threshold, followed down to its minimum; the deepest dip when none is that low
+        auto best = m_min_lag;
+        for (auto lag = m_min_lag; lag <= m_max_lag; ++lag)
+        {
+            if (m_difference[lag] < m_config.threshold)
+            {
+                while (lag + 1 <= m_max_lag and m_difference[lag + 1] < m_difference[lag])
+                {
+                    ++lag;
+                }
+                best = lag;
+                break;
+            }
+            if (m_difference[lag] < m_difference[best])
+            {
+                best = lag;
+            }
+        }
+        if (m_difference[best] >= 1.F)
+        {
+            return {};
+        }
+
+        auto left = m_difference[best - 1];
+        auto centre = m_difference[best];
+        auto right = m_difference[best + 1];
+        auto curvature = left - (2.F * centre) + right;
+        auto shift = curvature > 0.F ? std::clamp(0.5F * (left - right) / curvature, -0.5F, 0.5F) : 0.F;
+        return {
+            .frequency = m_config.sample_rate / (static_cast<float>(best) + shift),
+            .confidence = std::clamp(1.F - centre, 0.F, 1.F),
+        };
+    }
+
+    auto nearest_note(float frequency) -> s_note
+    {
+        if (frequency <= 0.F)
+        {
+            return {};
+        }
+        auto semitones = 69.F + (12.F * std::log2(frequency / 440.F));
+        auto midi = static_cast<int>(std::lround(semitones));
+        return { .midi = midi, .cents = 100.F * (semitones - static_cast<float>(midi)) };
+    }
+} // namespace math
@@ -2,37 +2,193 @@ module;
 #include <miniaudio.h>
 
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
 #include <iostream>
+#include <iterator>
 #include <memory>
 #include <mutex>
 #include <print>
+#include <span>
+#include <utility>
 #include <vector>
 export module music:audio;
+import :playlist;
+import :tap;
 import :track;
+import utility;
 
 export namespace music
 {
+    enum class e_audio_command : std::uint8_t
+    {
+        start,
+        stop,
+        seek,
+        gain,
+    };
+
+    /**
+     * @brief Playback change applied by the audio thread at an exact frame of the device clock.
+     */
+    struct s_audio_command
+    {
+        static constexpr int s_all_tracks = -1;
+        static constexpr std::uint64_t s_now = 0; // Start of the next period
+
+        e_audio_command kind{};
+        int track_id{ s_all_tracks };
+        std::uint64_t frame{ s_now }; // Device clock, see c_audio_manager::clock()
+        std::uint64_t position{};     // Seek target, in track frames
+        float gain{ 1.F };
+    };
+
+    enum class e_audio_backend : std::uint8_t
+    {
+        system, // Default output device
+        null,   // miniaudio's null device: the callback runs in real time and its output is discarded
+    };
+
+    /**
+     * @brief Timing of the audio callback, counted by the audio thread without locking.
+     */
+    struct s_callback_stats
+    {
+        std::uint64_t callbacks{};
+        std::uint64_t overruns{};   // Callbacks that took longer than the period they rendered
+        std::uint64_t xruns{};      // Callbacks starting over two periods after the previous one, the device ran dry
+        std::uint64_t underflows{}; // Playlist blocks the decoder had not filled in time
+        float last_duration{};      // Seconds
+        float max_duration{};       // Seconds, the longest since the previous take_callback_stats()
+        float period{};             // Seconds of audio rendered by the last callback, its time budget
+    };
+
+    /**
+     * @brief Plays the registered tracks mixed together on the default output device.
+     *
+     * The tracks are published to the audio callback as an immutable snapshot swapped in atomically (read-copy-update),
+     * so the callback never locks, allocates or touches reference counts. Replaced snapshots are retired and freed by
+     * auto_cleanup() on the calling thread once the callback can no longer be reading them.
+     *
+     * Playback state is owned by the audio thread. Other threads schedule commands through a wait-free queue; the
+     * callback splits its period at each command's frame, so tracks started by the same command, or by commands for the
+     * same frame, begin on the same sample.
+     */
     class c_audio_manager
     {
     public:
-        c_audio_manager();
+        explicit c_audio_manager(e_audio_backend backend = e_audio_backend::system);
         ~c_audio_manager();
 
+        static constexpr std::size_t s_command_capacity = 256;
+        static constexpr std::uint32_t s_sample_rate = 44100;
+        static constexpr std::uint32_t s_channels = 2;
+
         auto is_playing() const -> bool;
-        auto play() const -> void;
-        auto pause() const -> void;
-        auto add_track(std::shared_ptr<c_track> &track) -> void;
+        auto play(std::uint64_t at = s_audio_command::s_now) -> void;
+        auto pause(std::uint64_t at = s_audio_command::s_now) -> void;
+        auto play(const c_track &track, std::uint64_t at = s_audio_command::s_now) -> void;
+        auto pause(const c_track &track, std::uint64_t at = s_audio_command::s_now) -> void;
+        auto seek(const c_track &track, std::uint64_t position, std::uint64_t at = s_audio_command::s_now) -> void;
+        auto set_gain(const c_track &track, float gain, std::uint64_t at = s_audio_command::s_now) -> void;
+        auto add_track(const std::shared_ptr<c_track> &track) -> void;
+
+        /**
+         * @brief Queue commands to be applied together; all or none are queued. Returns false if the queue is full.
+         */
+        auto schedule(std::span<const s_audio_command> commands) -> bool;
+
+        /**
+         * @brief Frames played by the device so far, the time base of scheduled commands.
+         */
+        [[nodiscard]] auto clock() const -> std::uint64_t;
+
+        /**
+         * @brief Mix a playlist on top of the tracks; nullptr detaches it. The playlist must outlive the manager.
+         */
+        auto set_playlist(c_playlist *playlist) -> void;
+
+        /**
+         * @brief Free retired snapshots and drop tracks nobody else owns anymore. Call regularly from the UI thread.
+         */
+        auto auto_cleanup() -> void;
 
         [[nodiscard]] auto output_buffer() const -> std::vector<float>;
 
+        /**
+         * @brief Format of the mixed output, as the device runs it; the requested one if no device could be opened.
+         */
+        [[nodiscard]] auto sample_rate() const -> std::uint32_t;
+        [[nodiscard]] auto channels() const -> std::uint32_t;
+
+        /**
+         * @brief Receive the mixed output as it is played, without the callback taking a lock. The subscription is
+         * empty if all taps are taken, and must not outlive the manager.
+         */
+        [[nodiscard]] auto subscribe_output() -> c_tap_subscription;
+
+        /**
+         * @brief Callback timing so far; restarts the longest duration, so call it from one place only.
+         */
+        auto take_callback_stats() -> s_callback_stats;
+
     private:
-        mutable std::mutex m_mutex;
+        static constexpr std::size_t s_mix_chunk_frames = 1024;
+
+        struct s_track_snapshot
+        {
+            std::vector<std::shared_ptr<c_track>> tracks;
+        };
+
+        struct s_retired_snapshot
+        {
+            std::unique_ptr<const s_track_snapshot> snapshot;
+            std::uint64_t callback_epoch;
+        };
+
+        mutable std::mutex m_mutex; // Serializes writers of the snapshot, never taken by the callback
         ma_context m_context{};
         ma_device m_device{};
-        std::vector<std::weak_ptr<c_track>> m_tracks;
+        std::uint32_t m_sample_rate{ s_sample_rate };
+        std::uint32_t m_channels{ s_channels };
+        std::unique_ptr<const s_track_snapshot> m_tracks;
+        std::atomic<const s_track_snapshot *> m_published;
+        std::atomic<std::uint64_t> m_callback_epoch{}; // Odd while the callback runs
+        std::vector<s_retired_snapshot> m_retired;
+
+        // Sized once the device is up, the callback only writes into them
+        mutable std::mutex m_output_mutex; // Only try-locked by the callback
         std::vector<float> m_output_buffer;
+        std::size_t m_output_size{}; // Samples of the last published period
+        std::vector<float> m_mix_buffer; // Callback only, one chunk of s_mix_chunk_frames
+        c_tap_set m_output_taps;
 
-        auto auto_cleanup() -> void;
+        std::mutex m_command_mutex; // Serializes producers of the command queue, never taken by the callback
+        utility::c_spsc_ring<s_audio_command> m_commands;
+        std::vector<s_audio_command> m_pending_commands; // Callback only, received but not due yet
+        std::atomic<std::uint64_t> m_clock{};
+        std::atomic<c_playlist *> m_playlist{};
+
+        // Callback timing, only written by the callback
+        std::atomic<std::uint64_t> m_callback_count{};
+        std::atomic<std::uint64_t> m_overruns{};
+        std::atomic<std::uint64_t> m_xruns{};
+        std::atomic<std::int64_t> m_last_callback_ns{};
+        std::atomic<std::int64_t> m_max_callback_ns{};
+        std::atomic<std::int64_t> m_period_ns{};
+        std::chrono::steady_clock::time_point m_last_callback_start; // Callback only
+
+        auto publish(std::vector<std::shared_ptr<c_track>> tracks) -> void;
+        auto reclaim() -> void;
+        auto receive_commands() -> void;
+        auto apply_due_commands(const s_track_snapshot &snapshot, std::uint64_t frame) -> void;
+        [[nodiscard]] auto next_command_frame() const -> std::uint64_t;
+        auto mix(const s_track_snapshot &snapshot, std::span<float> output, std::uint64_t frame_count, std::uint32_t channels) -> void;
+        auto record_callback_timing(std::chrono::steady_clock::time_point start, std::uint64_t frame_count, std::uint32_t sample_rate) -> void;
         static auto s_callback_fn(ma_device *device, void *output, const void *input, ma_uint32 frame_count) -> void;
     };
 } // namespace music
@@ -40,10 +196,17 @@ export namespace music
 // Implementation
 namespace music
 {
-    c_audio_manager::c_audio_manager()
+    c_audio_manager::c_audio_manager(e_audio_backend backend)
+        : m_tracks(std::make_unique<const s_track_snapshot>()),
+          m_published(m_tracks.get()),
+          m_commands(s_command_capacity)
     {
+        m_pending_commands.reserve(s_command_capacity);
+
         ma_context_config context_config = ma_context_config_init();
-        auto result = ma_context_init(nullptr, 0, &context_config, &m_context);
+        std::array null_backends = { ma_backend_null };
+        auto result = backend == e_audio_backend::null ? ma_context_init(null_backends.data(), static_cast<ma_uint32>(null_backends.size()), &context_config, &m_context)
+                                                       : ma_context_init(nullptr, 0, &context_config, &m_context);
         if (result != MA_SUCCESS)
         {
             std::println(std::cerr, "Failed to initialize audio context: {}", ma_result_description(result));
@@ -51,8 +214,8 @@ namespace music
         }
         ma_device_config device_config = ma_device_config_init(ma_device_type_playback);
         device_config.playback.format = ma_format_f32;
-        device_config.playback.channels = 2;
-        device_config.sampleRate = 44100;
+        device_config.playback.channels = s_channels;
+        device_config.sampleRate = s_sample_rate;
         device_config.dataCallback = s_callback_fn;
         device_config.pUserData = this;
 
@@ -63,6 +226,22 @@ namespace music
             ma_context_uninit(&m_context);
             return;
         }
+        m_sample_rate = m_device.sampleRate;
+        m_channels = m_device.playback.channels;
+
+        // Tracks are mixed in chunks, so a period longer than expected needs no larger buffer; the output keeps
+        // the latest samples of such a period
+        auto channels = static_cast<std::size_t>(m_channels);
+        auto period_frames = std::max<std::size_t>(m_device.playback.internalPeriodSizeInFrames, s_mix_chunk_frames);
+        m_mix_buffer.assign(s_mix_chunk_frames * channels, 0.F);
+        m_output_buffer.assign(period_frames * channels, 0.F);
+
+        // The callback's first zone takes this ring, so the audio thread neither allocates nor registers itself
+        if constexpr (utility::profiling_enabled)
+        {
+            utility::c_profiler::instance().reserve_thread("Audio callback");
+        }
+
         result = ma_device_start(&m_device);
         if (result != MA_SUCCESS)
         {
@@ -75,87 +254,296 @@ namespace music
 
     c_audio_manager::~c_audio_manager()
     {
+        // The callback has stopped once the device is uninitialized, snapshots can go with the members
         ma_device_uninit(&m_device);
         ma_context_uninit(&m_context);
-        m_tracks.clear();
     }
 
     auto c_audio_manager::is_playing() const -> bool
     {
         std::lock_guard lock(m_mutex);
-        return std::ranges::any_of(m_tracks,
-                                   [](const std::weak_ptr<c_track> &track_ptr_weak)
-                                   {
-                                   auto track_ptr = track_ptr_weak.lock();
-                                   return track_ptr and track_ptr->is_playing(); });
+        return std::ranges::any_of(m_tracks->tracks, [](const std::shared_ptr<c_track> &track)
+                                   { return track->is_playing(); });
     }
 
-    auto c_audio_manager::play() const -> void
+    auto c_audio_manager::play(std::uint64_t at) -> void
     {
-        std::lock_guard lock(m_mutex);
-        for (const auto &track_ptr_weak : m_tracks)
-        {
-            if (auto track_ptr = track_ptr_weak.lock())
-            {
-                track_ptr->play();
-            }
-        }
+        // A single command for every track, so they all start on the same frame
+        schedule(std::array{ s_audio_command{ .kind = e_audio_command::start, .frame = at } });
     }
 
-    auto c_audio_manager::pause() const -> void
+    auto c_audio_manager::pause(std::uint64_t at) -> void
     {
-        std::lock_guard lock(m_mutex);
-        for (const auto &track_ptr_weak : m_tracks)
+        schedule(std::array{ s_audio_command{ .kind = e_audio_command::stop, .frame = at } });
+    }
+
+    auto c_audio_manager::play(const c_track &track, std::uint64_t at) -> void
+    {
+        schedule(std::array{ s_audio_command{ .kind = e_audio_command::start, .track_id = track.get_track_id(), .frame = at } });
+    }
+
+    auto c_audio_manager::pause(const c_track &track, std::uint64_t at) -> void
+    {
+        schedule(std::array{ s_audio_command{ .kind = e_audio_command::stop, .track_id = track.get_track_id(), .frame = at } });
+    }
+
+    auto c_audio_manager::seek(const c_track &track, std::uint64_t position, std::uint64_t at) -> void
+    {
+        schedule(std::array{ s_audio_command{ .kind = e_audio_command::seek, .track_id = track.get_track_id(), .frame = at, .position = position } });
+    }
+
+    auto c_audio_manager::set_gain(const c_track &track, float gain, std::uint64_t at) -> void
+    {
+        schedule(std::array{ s_audio_command{ .kind = e_audio_command::gain, .track_id = track.get_track_id(), .frame = at, .gain = gain } });
+    }
+
+    auto c_audio_manager::schedule(std::span<const s_audio_command> commands) -> bool
+    {
+        std::lock_guard lock(m_command_mutex);
+
+        // Free space only grows while the callback consumes, so checking first keeps the batch whole
+        if (m_commands.capacity() - m_commands.size() < commands.size())
         {
-            if (auto track_ptr = track_ptr_weak.lock())
-            {
-                track_ptr->pause();
-            }
+            std::println(std::cerr, "Warning: audio command queue full, dropping {} command(s)", commands.size());
+            return false;
         }
+        m_commands.push(commands);
+        return true;
+    }
+
+    auto c_audio_manager::clock() const -> std::uint64_t
+    {
+        return m_clock.load(std::memory_order_acquire);
+    }
+
+    auto c_audio_manager::set_playlist(c_playlist *playlist) -> void
+    {
+        m_playlist.store(playlist, std::memory_order_release);
     }
 
     auto c_audio_manager::output_buffer() const -> std::vector<float>
     {
-        std::lock_guard lock(m_mutex);
-        return m_output_buffer;
+        std::lock_guard lock(m_output_mutex);
+        return { m_output_buffer.begin(), m_output_buffer.begin() + static_cast<std::ptrdiff_t>(m_output_size) };
     }
 
-    auto c_audio_manager::add_track(std::shared_ptr<c_track> &track) -> void
+    auto c_audio_manager::sample_rate() const -> std::uint32_t
+    {
+        return m_sample_rate;
+    }
+
+    auto c_audio_manager::channels() const -> std::uint32_t
+    {
+        return m_channels;
+    }
+
+    auto c_audio_manager::subscribe_output() -> c_tap_subscription
+    {
+        return m_output_taps.subscribe();
+    }
+
+    auto c_audio_manager::take_callback_stats() -> s_callback_stats
+    {
+        constexpr float seconds_per_ns = 1e-9F;
+        const auto *playlist = m_playlist.load(std::memory_order_acquire);
+        return {
+            .callbacks = m_callback_count.load(std::memory_order_relaxed),
+            .overruns = m_overruns.load(std::memory_order_relaxed),
+            .xruns = m_xruns.load(std::memory_order_relaxed),
+            .underflows = playlist != nullptr ? playlist->underflows() : 0,
+            .last_duration = static_cast<float>(m_last_callback_ns.load(std::memory_order_relaxed)) * seconds_per_ns,
+            .max_duration = static_cast<float>(m_max_callback_ns.exchange(0, std::memory_order_relaxed)) * seconds_per_ns,
+            .period = static_cast<float>(m_period_ns.load(std::memory_order_relaxed)) * seconds_per_ns,
+        };
+    }
+
+    auto c_audio_manager::add_track(const std::shared_ptr<c_track> &track) -> void
     {
         std::lock_guard lock(m_mutex);
-        m_tracks.push_back(track);
+        auto tracks = m_tracks->tracks;
+        tracks.push_back(track);
+        publish(std::move(tracks));
     }
 
     auto c_audio_manager::auto_cleanup() -> void
     {
         std::lock_guard lock(m_mutex);
-        auto [first, last] = std::ranges::remove_if(m_tracks,
-                                                    [](const std::weak_ptr<c_track> &track_ptr_weak)
-                                                    { return track_ptr_weak.expired(); });
-        m_tracks.erase(first, last);
+        reclaim();
+
+        // Retired snapshots are gone, so a count of one is the current snapshot alone
+        auto is_orphan = [](const std::shared_ptr<c_track> &track)
+        { return track.use_count() == 1; };
+        if (std::ranges::any_of(m_tracks->tracks, is_orphan))
+        {
+            std::vector<std::shared_ptr<c_track>> tracks;
+            std::ranges::remove_copy_if(m_tracks->tracks, std::back_inserter(tracks), is_orphan);
+            publish(std::move(tracks));
+        }
     }
 
-    auto c_audio_manager::s_callback_fn(ma_device *device, void *output, const void * /*input*/, ma_uint32 frame_count) -> void
+    auto c_audio_manager::publish(std::vector<std::shared_ptr<c_track>> tracks) -> void
     {
-        auto *audio_manager = reinterpret_cast<c_audio_manager *>(device->pUserData);
-        auto &storage = audio_manager->m_output_buffer;
-        auto *output_samples = reinterpret_cast<float *>(output);
-        auto frames = frame_count * device->playback.channels;
+        auto next = std::make_unique<const s_track_snapshot>(s_track_snapshot{ .tracks = std::move(tracks) });
+        m_published.store(next.get(), std::memory_order_seq_cst);
 
-        std::fill(output_samples, output_samples + frames, 0.F);
-        for (std::lock_guard lock(audio_manager->m_mutex); const auto &track_ptr_weak : audio_manager->m_tracks)
+        // A callback that began before the store may still read the old snapshot, remember where it was
+        auto epoch = m_callback_epoch.load(std::memory_order_seq_cst);
+        m_retired.push_back({ .snapshot = std::exchange(m_tracks, std::move(next)), .callback_epoch = epoch });
+    }
+
+    auto c_audio_manager::reclaim() -> void
+    {
+        // Even epoch: no callback was running at retirement. Otherwise, the running one has finished once it moved on
+        auto epoch = m_callback_epoch.load(std::memory_order_acquire);
+        std::erase_if(m_retired, [epoch](const s_retired_snapshot &retired)
+                      { return retired.callback_epoch % 2 == 0 or retired.callback_epoch != epoch; });
+    }
+
+    auto c_audio_manager::receive_commands() -> void
+    {
+        // Resizing within the reserved capacity does not allocate
+        auto received = m_pending_commands.size();
+        m_pending_commands.resize(m_pending_commands.capacity());
+        received += m_commands.pop(std::span(m_pending_commands).subspan(received));
+        m_pending_commands.resize(received);
+    }
+
+    auto c_audio_manager::apply_due_commands(const s_track_snapshot &snapshot, std::uint64_t frame) -> void
+    {
+        // In queue order, so commands due on the same frame apply as they were scheduled
+        for (const auto &command : m_pending_commands)
         {
-            if (auto track_ptr = track_ptr_weak.lock(); track_ptr->is_playing())
+            if (command.frame > frame)
             {
-                std::vector<float> temp(frames, 0.F);
-                ma_uint64 frames_read = 0;
-                ma_data_source_read_pcm_frames(track_ptr->data_ptr(), temp.data(), frame_count, &frames_read);
-                std::transform(output_samples, output_samples + frames, temp.begin(), output_samples, std::plus<float>{});
+                continue;
             }
+            for (const auto &track : snapshot.tracks)
+            {
+                if (command.track_id != s_audio_command::s_all_tracks and command.track_id != track->get_track_id())
+                {
+                    continue;
+                }
+                switch (command.kind)
+                {
+                case e_audio_command::start:
+                    track->play();
+                    break;
+                case e_audio_command::stop:
+                    track->pause();
+                    break;
+                case e_audio_command::seek:
+                    track->seek(command.position);
+                    break;
+                case e_audio_command::gain:
+                    track->set_gain(command.gain);
+                    break;
+                }
+            }
+        }
+        std::erase_if(m_pending_commands, [frame](const s_audio_command &command)
+                      { return command.frame <= frame; });
+    }
+
+    auto c_audio_manager::next_command_frame() const -> std::uint64_t
+    {
+        auto next = std::numeric_limits<std::uint64_t>::max();
+        for (const auto &command : m_pending_commands)
+        {
+            next = std::min(next, command.frame);
+        }
+        return next;
+    }
+
+    auto c_audio_manager::mix(const s_track_snapshot &snapshot, std::span<float> output, std::uint64_t frame_count, std::uint32_t channels) -> void
+    {
+        // Chunks of the preallocated buffer, so a long period does not make the callback allocate
+        auto chunk_frames = static_cast<std::uint64_t>(m_mix_buffer.size() / channels);
+        for (std::uint64_t position = 0; position < frame_count; position += chunk_frames)
+        {
+            auto frames = std::min(chunk_frames, frame_count - position);
+            auto chunk_output = output.subspan(static_cast<std::size_t>(position) * channels, static_cast<std::size_t>(frames) * channels);
+            auto chunk = std::span(m_mix_buffer).first(chunk_output.size());
+            for (const auto &track : snapshot.tracks)
+            {
+                if (track->is_playing())
+                {
+                    auto frames_read = track->render(chunk, frames);
+                    track->feed_taps(std::span<const float>(chunk).first(static_cast<std::size_t>(frames_read) * channels));
+                    std::ranges::transform(chunk_output, chunk, chunk_output.begin(), std::plus<float>{});
+                }
+            }
+        }
+    }
+
+    auto c_audio_manager::s_callback_fn(ma_device *device, void *output, const void * /*input*/, ma_uint32 frame_count) -> void
+    {
+        auto *audio_manager = reinterpret_cast<c_audio_manager *>(device->pUserData);
+        auto channels = device->playback.channels;
+        auto output_samples = std::span(reinterpret_cast<float *>(output), static_cast<std::size_t>(frame_count) * channels);
+        utility::c_profile_zone zone(utility::zone_id<"Audio callback">());
+        auto callback_start = std::chrono::steady_clock::now();
+
+        audio_manager->m_callback_epoch.fetch_add(1, std::memory_order_seq_cst);
+
+        // Commands first: a track added before its command was queued is then in the snapshot loaded below
+        audio_manager->receive_commands();
+        const auto *snapshot = audio_manager->m_published.load(std::memory_order_seq_cst);
+
+        // Render up to the next command due within the period, apply it on that frame, continue from there
+        std::ranges::fill(output_samples, 0.F);
+        auto period_start = audio_manager->m_clock.load(std::memory_order_relaxed);
+        std::uint64_t position = 0;
+        while (position < frame_count)
+        {
+            audio_manager->apply_due_commands(*snapshot, period_start + position);
+            auto end = std::min<std::uint64_t>(frame_count, audio_manager->next_command_frame() - period_start);
+            auto segment = output_samples.subspan(static_cast<std::size_t>(position) * channels, static_cast<std::size_t>(end - position) * channels);
+            audio_manager->mix(*snapshot, segment, end - position, channels);
+            position = end;
+        }
+        if (auto *playlist = audio_manager->m_playlist.load(std::memory_order_acquire))
+        {
+            playlist->mix(output_samples, frame_count);
+        }
+        audio_manager->m_output_taps.feed(output_samples);
+        audio_manager->m_clock.store(period_start + frame_count, std::memory_order_release);
+
+        audio_manager->m_callback_epoch.fetch_add(1, std::memory_order_release);
+
+        // Skip publishing the period rather than wait on a reader
+        if (std::unique_lock lock(audio_manager->m_output_mutex, std::try_to_lock); lock)
+        {
+            auto published = output_samples.last(std::min(output_samples.size(), audio_manager->m_output_buffer.size()));
+            std::ranges::copy(published, audio_manager->m_output_buffer.begin());
+            audio_manager->m_output_size = published.size();
+        }
+        audio_manager->record_callback_timing(callback_start, frame_count, device->sampleRate);
+    }
+
+    auto c_audio_manager::record_callback_timing(std::chrono::steady_clock::time_point start, std::uint64_t frame_count, std::uint32_t sample_rate) -> void
+    {
+        using std::chrono::nanoseconds;
+        auto duration = std::chrono::duration_cast<nanoseconds>(std::chrono::steady_clock::now() - start).count();
+        auto period = sample_rate > 0 ? static_cast<std::int64_t>(frame_count * 1'000'000'000ULL / sample_rate) : 0;
+
+        m_callback_count.fetch_add(1, std::memory_order_relaxed);
+        if (duration > period)
+        {
+            m_overruns.fetch_add(1, std::memory_order_relaxed);
+        }
+        if (m_last_callback_start != std::chrono::steady_clock::time_point{} and std::chrono::duration_cast<nanoseconds>(start - m_last_callback_start).count() > 2 * period)
+        {
+            m_xruns.fetch_add(1, std::memory_order_relaxed);
+        }
+        m_last_callback_start = start;
+
+        m_last_callback_ns.store(duration, std::memory_order_relaxed);
+        m_period_ns.store(period, std::memory_order_relaxed);
+        // The reader exchanges the maximum with zero, a plain store could undo that
+        auto longest = m_max_callback_ns.load(std::memory_order_relaxed);
+        while (duration > longest and not m_max_callback_ns.compare_exchange_weak(longest, duration, std::memory_order_relaxed))
+        {
         }
-        storage.resize(frames);
-        std::ranges::fill(storage, 0.F);
-        std::copy(output_samples, output_samples + frames, storage.begin());
     }
 
 } // namespace music
@@ -0,0 +1,263 @@
+module;
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cctype>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <print>
+#include <string>
+#include <system_error>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+export module music:loader;
+
+import :track;
+import utility;
+
+export namespace music
+{
+    enum class e_load_state : std::uint8_t
+    {
+        loading,
+        ready,
+        failed,
+    };
+
+    /**
+     * @brief A track as listed by the UI: a placeholder until the file is opened, then the track itself.
+     */
+    struct s_track_entry
+    {
+        std::filesystem::path path;
+        e_load_state state{ e_load_state::loading };
+        std::shared_ptr<c_track> track;
+        std::string error;
+    };
+
+    /**
+     * @brief Opens tracks on a thread pool so that the UI thread never touches the disk.
+     *
+     * request() returns at once; directories are scanned recursively in the background. Progress is applied to the
+     * caller's list of entries by poll(), on the UI thread: every file found gets a placeholder entry first, which
+     * later turns ready or failed. Files are opened in parallel, so they may become ready in any order, but entries
+     * keep the order in which files were found.
+     */
+    class c_track_loader
+    {
+    public:
+        explicit c_track_loader(utility::c_thread_pool &pool = utility::c_thread_pool::instance());
+
+        /**
+         * @brief Queue a file, or every audio file below a directory, for loading.
+         */
+        auto request(const std::filesystem::path &path) -> void;
+
+        /**
+         * @brief Apply finished work to entries. Returns the tracks that became ready since the last call.
+         */
+        auto poll(std::vector<s_track_entry> &entries) -> std::vector<std::shared_ptr<c_track>>;
+
+        /**
+         * @brief How tracks opened from now on build their overview. Defaults to in_memory; cached also writes
+         * "<file>.peaks" next to each file, so it is only used when asked for.
+         */
+        auto set_peak_overview(e_peak_overview peaks) -> void;
+        [[nodiscard]] auto get_peak_overview() const -> e_peak_overview;
+
+        /**
+         * @brief Number of files found but not opened yet.
+         */
+        [[nodiscard]] auto pending() const -> std::size_t;
+
+        /**
+         * @brief Whether a file found while scanning a directory looks like audio, by extension.
+         */
+        static auto is_audio_file(const std::filesystem::path &path) -> bool;
+
+    private:
+        struct s_event
+        {
+            std::size_t ticket;
+            e_load_state state;
+            std::filesystem::path path;
+            std::shared_ptr<c_track> track;
+            std::string error;
+        };
+
+        // Shared with the jobs, so that a job finishing after the loader is gone has somewhere to report to
+        struct s_shared
+        {
+            std::mutex mutex;
+            std::vector<s_event> events;
+            std::atomic<std::size_t> next_ticket{};
+            std::atomic<int> next_track_id{};
+            std::atomic<std::size_t> pending{};
+            std::atomic<e_peak_overview> peaks{ e_peak_overview::in_memory };
+        };
+
+        utility::c_thread_pool &m_pool;
+        std::shared_ptr<s_shared> m_shared;
+        std::unordered_map<std::size_t, std::size_t> m_entry_of_ticket; // UI thread only
+
+        static auto open(const std::shared_ptr<s_shared> &shared, utility::c_thread_pool &pool, std::filesystem::path path) -> void;
+        static auto scan(const std::shared_ptr<s_shared> &shared, utility::c_thread_pool &pool, const std::filesystem::path &directory) -> void;
+        static auto push(s_shared &shared, s_event event) -> void;
+    };
+} // namespace music
+
+// Implementation
+namespace music
+{
+    c_track_loader::c_track_loader(utility::c_thread_pool &pool)
+        : m_pool(pool),
+          m_shared(std::make_shared<s_shared>())
+    {
+    }
+
+    auto c_track_loader::request(const std::filesystem::path &path) -> void
+    {
+        // Even the type of the path is checked in the background, it may be on a slow or sleeping drive
+        m_pool.submit([shared = m_shared, &pool = m_pool, path]()
+                      {
+                          std::error_code error;
+                          if (std::filesystem::is_directory(path, error))
+                          {
+                              scan(shared, pool, path);
+                          }
+                          else if (std::filesystem::is_regular_file(path, error))
+                          {
+                              open(shared, pool, path);
+                          }
+                          else
+                          {
+                              std::println(std::cerr, "Warning: ignoring dropped path {}, not a file or directory", path.string());
+                          } });
+    }
+
+    auto c_track_loader::set_peak_overview(e_peak_overview peaks) -> void
+    {
+        m_shared->peaks.store(peaks, std::memory_order_relaxed);
+    }
+
+    auto c_track_loader::get_peak_overview() const -> e_peak_overview
+    {
+        return m_shared->peaks.load(std::memory_order_relaxed);
+    }
+
+    auto c_track_loader::push(s_shared &shared, s_event event) -> void
+    {
+        std::scoped_lock lock(shared.mutex);
+        shared.events.push_back(std::move(event));
+    }
+
+    auto c_track_loader::open(const std::shared_ptr<s_shared> &shared, utility::c_thread_pool &pool, std::filesystem::path path) -> void
+    {
+        // The placeholder is published before the job is queued, so it always precedes the result
+        auto ticket = shared->next_ticket.fetch_add(1, std::memory_order_relaxed);
+        shared->pending.fetch_add(1, std::memory_order_relaxed);
+        push(*shared, { .ticket = ticket, .state = e_load_state::loading, .path = path, .track = nullptr, .error = {} });
+
+        pool.submit([shared, ticket, path = std::move(path)]()
+                    {
+                        s_event event{ .ticket = ticket, .state = e_load_state::ready, .path = path, .track = nullptr, .error = {} };
+                        try
+                        {
+                            event.track = std::make_shared<c_track>(shared->next_track_id.fetch_add(1, std::memory_order_relaxed), path, shared->peaks.load(std::memory_order_relaxed));
+                        }
+                        catch (const std::exception &e)
+                        {
+                            event.state = e_load_state::failed;
+                            event.error = e.what();
+                        }
+                        shared->pending.fetch_sub(1, std::memory_order_relaxed);
+                        push(*shared, std::move(event)); });
+    }
+
+    auto c_track_loader::scan(const std::shared_ptr<s_shared> &shared, utility::c_thread_pool &pool, const std::filesystem::path &directory) -> void
+    {
+        // Sorted, so a dropped album lists in track order
+        std::vector<std::filesystem::path> files;
+        std::error_code error;
+        for (std::filesystem::recursive_directory_iterator it(directory, std::filesystem::directory_options::skip_permission_denied, error), end; not error and it != end; it.increment(error))
+        {
+            if (it->is_regular_file(error) and is_audio_file(it->path()))
+            {
+                files.push_back(it->path());
+            }
+        }
+        if (error)
+        {
+            std::println(std::cerr, "Warning: stopped scanning {}: {}", directory.string(), error.message());
+        }
+
+        std::ranges::sort(files);
+        for (auto &file : files)
+        {
+            open(shared, pool, std::move(file));
+        }
+    }
+
+    auto c_track_loader::poll(std::vector<s_track_entry> &entries) -> std::vector<std::shared_ptr<c_track>>
+    {
+        std::vector<s_event> events;
+        {
+            std::scoped_lock lock(m_shared->mutex);
+            std::swap(events, m_shared->events);
+        }
+
+        std::vector<std::shared_ptr<c_track>> ready;
+        for (auto &event : events)
+        {
+            if (event.state == e_load_state::loading)
+            {
+                m_entry_of_ticket[event.ticket] = entries.size();
+                entries.push_back({ .path = std::move(event.path), .state = e_load_state::loading, .track = nullptr, .error = {} });
+                continue;
+            }
+
+            auto it = m_entry_of_ticket.find(event.ticket);
+            if (it == m_entry_of_ticket.end() or it->second >= entries.size())
+            {
+                continue;
+            }
+            auto &entry = entries[it->second];
+            m_entry_of_ticket.erase(it);
+
+            entry.state = event.state;
+            entry.track = std::move(event.track);
+            entry.error = std::move(event.error);
+            if (entry.state == e_load_state::failed)
+            {
+                std::println(std::cerr, "Error adding track: {}", entry.error);
+            }
+            else
+            {
+                ready.push_back(entry.track);
+            }
+        }
+        return ready;
+    }
+
+    auto c_track_loader::pending() const -> std::size_t
+    {
+        return m_shared->pending.load(std::memory_order_relaxed);
+    }
+
+    auto c_track_loader::is_audio_file(const std::filesystem::path &path) -> bool
+    {
+        // Containers libsndfile can decode
+        static constexpr std::array extensions = { ".wav", ".flac", ".ogg", ".oga", ".opus", ".mp3", ".aiff", ".aif", ".aifc", ".au", ".snd", ".caf", ".w64", ".rf64" };
+
+        auto extension = path.extension().string();
+        std::ranges::transform(extension, extension.begin(), [](unsigned char c)
+                               { return static_cast<char>(std::tolower(c)); });
+        return std::ranges::find(extensions, extension) != extensions.end();
+    }
+} // namespace music
@@ -1,4 +1,8 @@
 export module music;
 
 export import :audio;
+export import :loader;
+export import :peaks;
+export import :playlist;
+export import :tap;
 export import :track;
@@ -0,0 +1,473 @@
+module;
+#include <sndfile.hh>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <optional>
+#include <span>
+#include <system_error>
+#include <vector>
+export module music:peaks;
+
+import utility;
+
+export namespace music
+{
+    /**
+     * @brief Amplitude summary of a range of frames, mixed down to mono.
+     */
+    struct s_peak
+    {
+        float min{};
+        float max{};
+        float rms{};
+    };
+
+    /**
+     * @brief Min/max/RMS mip-pyramid of a whole track.
+     *
+     * Level 0 summarizes s_base_frames frames per bin, and every further level merges pairs of bins of the level below,
+     * until a level holds a single bin. Drawing n pixels of any span of the track then touches O(n) bins, whatever the
+     * length of the file.
+     */
+    class c_peak_pyramid
+    {
+    public:
+        static constexpr std::uint64_t s_base_frames = 256;
+
+        c_peak_pyramid() = default;
+        c_peak_pyramid(std::vector<s_peak> base_level, std::uint64_t total_frames);
+
+        /**
+         * @brief Summarize mono samples into level 0 bins, s_base_frames samples per bin; the last bin may be partial.
+         */
+        static auto reduce(std::span<const float> samples, std::span<s_peak> bins) -> void;
+        static auto bin_count(std::uint64_t frames) -> std::size_t;
+
+        [[nodiscard]] auto total_frames() const -> std::uint64_t;
+        [[nodiscard]] auto level_count() const -> std::size_t;
+        [[nodiscard]] auto level(std::size_t index) const -> std::span<const s_peak>;
+        [[nodiscard]] auto frames_per_bin(std::size_t level) const -> std::uint64_t;
+
+        /**
+         * @brief Coarsest level whose bins are not wider than the given number of frames.
+         */
+        [[nodiscard]] auto level_for(double frames_per_pixel) const -> std::size_t;
+
+        /**
+         * @brief Summarize [first_frame, last_frame) into columns.size() equal columns.
+         */
+        auto sample(std::uint64_t first_frame, std::uint64_t last_frame, std::span<s_peak> columns) const -> void;
+
+        /**
+         * @brief Write level 0 to a cache file, tagged with the size and modification time of the source.
+         */
+        auto save(const std::filesystem::path &cache_path, const std::filesystem::path &source_path) const -> bool;
+
+        /**
+         * @brief Read a cache written by save(); empty if it is missing, malformed or older than the source.
+         */
+        static auto load(const std::filesystem::path &cache_path, const std::filesystem::path &source_path) -> std::optional<c_peak_pyramid>;
+
+    private:
+        std::uint64_t m_total_frames{};
+        std::vector<std::vector<s_peak>> m_levels;
+    };
+
+    /**
+     * @brief Background construction of the peak pyramid of an audio file.
+     *
+     * The file is split into chunks decoded in parallel on a thread pool, each through its own handle. The pyramid is
+     * published once the last chunk completes. When persisting is enabled it is also cached next to the file (as
+     * "<file>.peaks"), and read back from there on the next load instead of decoding.
+     */
+    class c_peak_job
+    {
+    public:
+        static constexpr std::uint64_t s_chunk_frames = c_peak_pyramid::s_base_frames * 4096;
+
+        c_peak_job(std::filesystem::path path, bool persist);
+
+        /**
+         * @brief Start building the pyramid of the file at path.
+         */
+        static auto start(const std::filesystem::path &path, bool persist, utility::c_thread_pool &pool = utility::c_thread_pool::instance()) -> std::shared_ptr<c_peak_job>;
+
+        /**
+         * @brief The finished pyramid, or nullptr while it is being built or if the file could not be read.
+         */
+        [[nodiscard]] auto result() const -> std::shared_ptr<const c_peak_pyramid>;
+
+        /**
+         * @brief Skip the chunks that have not started yet; the result is never published.
+         */
+        auto cancel() -> void;
+
+    private:
+        std::filesystem::path m_path;
+        bool m_persist;
+        std::uint64_t m_total_frames{};
+        std::vector<s_peak> m_base_level;
+        std::atomic<std::size_t> m_remaining_chunks{};
+        std::atomic<bool> m_cancelled{ false };
+        std::atomic<bool> m_failed{ false };
+        std::atomic<std::shared_ptr<const c_peak_pyramid>> m_result;
+
+        static auto cache_path(const std::filesystem::path &path) -> std::filesystem::path;
+        static auto run(const std::shared_ptr<c_peak_job> &job, utility::c_thread_pool &pool) -> void;
+        auto decode_chunk(std::size_t chunk) -> void;
+        auto finish() -> void;
+    };
+} // namespace music
+
+// Implementation
+namespace music
+{
+    c_peak_pyramid::c_peak_pyramid(std::vector<s_peak> base_level, std::uint64_t total_frames)
+        : m_total_frames(total_frames)
+    {
+        m_levels.push_back(std::move(base_level));
+        while (m_levels.back().size() > 1)
+        {
+            const auto &below = m_levels.back();
+            std::vector<s_peak> level((below.size() + 1) / 2);
+            for (std::size_t i = 0; i < level.size(); ++i)
+            {
+                const auto &left = below[2 * i];
+                if (2 * i + 1 == below.size())
+                {
+                    level[i] = left;
+                    continue;
+                }
+                const auto &right = below[(2 * i) + 1];
+                level[i] = {
+                    .min = std::min(left.min, right.min),
+                    .max = std::max(left.max, right.max),
+                    .rms = std::sqrt(((left.rms * left.rms) + (right.rms * right.rms)) * 0.5F),
+                };
+            }
+            m_levels.push_back(std::move(level));
+        }
+    }
+
+    auto c_peak_pyramid::reduce(std::span<const float> samples, std::span<s_peak> bins) -> void
+    {
+        for (std::size_t bin = 0; bin < bins.size(); ++bin)
+        {
+            auto first = bin * s_base_frames;
+            if (first >= samples.size())
+            {
+                bins[bin] = {};
+                continue;
+            }
+            auto values = samples.subspan(first, std::min<std::size_t>(s_base_frames, samples.size() - first));
+
+            s_peak peak{ .min = values.front(), .max = values.front(), .rms = 0.F };
+            float sum_of_squares = 0.F;
+            for (auto value : values)
+            {
+                peak.min = std::min(peak.min, value);
+                peak.max = std::max(peak.max, value);
+                sum_of_squares += value * value;
+            }
+            peak.rms = std::sqrt(sum_of_squares / static_cast<float>(values.size()));
+            bins[bin] = peak;
+        }
+    }
+
+    auto c_peak_pyramid::bin_count(std::uint64_t frames) -> std::size_t
+    {
+        return static_cast<std::size_t>((frames + s_base_frames - 1) / s_base_frames);
+    }
+
+    auto c_peak_pyramid::total_frames() const -> std::uint64_t
+    {
+        return m_total_frames;
+    }
+
+    auto c_peak_pyramid::level_count() const -> std::size_t
+    {
+        return m_levels.size();
+    }
+
+    auto c_peak_pyramid::level(std::size_t index) const -> std::span<const s_peak>
+    {
+        return m_levels.at(index);
+    }
+
+    auto c_peak_pyramid::frames_per_bin(std::size_t level) const -> std::uint64_t
+    {
+        return s_base_frames << level;
+    }
+
+    auto c_peak_pyramid::level_for(double frames_per_pixel) const -> std::size_t
+    {
+        std::size_t level = 0;
+        while (level + 1 < m_levels.size() and static_cast<double>(frames_per_bin(level + 1)) <= frames_per_pixel)
+        {
+            ++level;
+        }
+        return level;
+    }
+
+    auto c_peak_pyramid::sample(std::uint64_t first_frame, std::uint64_t last_frame, std::span<s_peak> columns) const -> void
+    {
+        std::ranges::fill(columns, s_peak{});
+        if (m_levels.empty() or columns.empty() or last_frame <= first_frame)
+        {
+            return;
+        }
+
+        auto frames_per_column = static_cast<double>(last_frame - first_frame) / static_cast<double>(columns.size());
+        auto level_index = level_for(frames_per_column);
+        const auto &bins = m_levels[level_index];
+        auto bin_frames = static_cast<double>(frames_per_bin(level_index));
+
+        for (std::size_t column = 0; column < columns.size(); ++column)
+        {
+            // Every column covers at least one bin, and at most two more than its share, since bins are not wider
+            // than a column
+            auto column_start = static_cast<double>(first_frame) + (frames_per_column * static_cast<double>(column));
+            auto first_bin = static_cast<std::size_t>(column_start / bin_frames);
+            auto last_bin = static_cast<std::size_t>((column_start + frames_per_column) / bin_frames);
+            last_bin = std::max(last_bin, first_bin + 1);
+            if (first_bin >= bins.size())
+            {
+                break;
+            }
+            last_bin = std::min(last_bin, bins.size());
+
+            s_peak peak{ .min = bins[first_bin].min, .max = bins[first_bin].max, .rms = 0.F };
+            float sum_of_squares = 0.F;
+            for (auto bin = first_bin; bin < last_bin; ++bin)
+            {
+                peak.min = std::min(peak.min, bins[bin].min);
+                peak.max = std::max(peak.max, bins[bin].max);
+                sum_of_squares += bins[bin].rms * bins[bin].rms;
+            }
+            peak.rms = std::sqrt(sum_of_squares / static_cast<float>(last_bin - first_bin));
+            columns[column] = peak;
+        }
+    }
+
+    namespace
+    {
+        constexpr std::array<char, 8> s_cache_magic = { 'S', 'P', 'K', 'S', 'v', '0', '0', '1' };
+
+        struct s_cache_header
+        {
+            std::array<char, 8> magic{};
+            std::uint64_t source_size{};
+            std::int64_t source_time{};
+            std::uint64_t total_frames{};
+            std::uint64_t bin_count{};
+        };
+
+        auto source_stamp(const std::filesystem::path &source_path) -> std::optional<s_cache_header>
+        {
+            std::error_code error;
+            auto size = std::filesystem::file_size(source_path, error);
+            if (error)
+            {
+                return std::nullopt;
+            }
+            auto time = std::filesystem::last_write_time(source_path, error);
+            if (error)
+            {
+                return std::nullopt;
+            }
+            return s_cache_header{
+                .magic = s_cache_magic,
+                .source_size = size,
+                .source_time = static_cast<std::int64_t>(time.time_since_epoch().count()),
+            };
+        }
+    } // namespace
+
+    auto c_peak_pyramid::save(const std::filesystem::path &cache_path, const std::filesystem::path &source_path) const -> bool
+    {
+        auto header = source_stamp(source_path);
+        if (not header or m_levels.empty())
+        {
+            return false;
+        }
+        header->total_frames = m_total_frames;
+        header->bin_count = m_levels.front().size();
+
+        // Write to a temporary file first, so a concurrent reader never sees a partial cache
+        auto temporary_path = cache_path;
+        temporary_path += ".tmp";
+        {
+            std::ofstream file(temporary_path, std::ios::binary | std::ios::trunc);
+            if (not file)
+            {
+                return false;
+            }
+            file.write(reinterpret_cast<const char *>(&*header), sizeof(s_cache_header));
+            file.write(reinterpret_cast<const char *>(m_levels.front().data()), static_cast<std::streamsize>(m_levels.front().size() * sizeof(s_peak)));
+            if (not file)
+            {
+                return false;
+            }
+        }
+        std::error_code error;
+        std::filesystem::rename(temporary_path, cache_path, error);
+        return not error;
+    }
+
+    auto c_peak_pyramid::load(const std::filesystem::path &cache_path, const std::filesystem::path &source_path) -> std::optional<c_peak_pyramid>
+    {
+        auto expected = source_stamp(source_path);
+        std::ifstream file(cache_path, std::ios::binary);
+        if (not expected or not file)
+        {
+            return std::nullopt;
+        }
+
+        s_cache_header header{};
+        file.read(reinterpret_cast<char *>(&header), sizeof(s_cache_header));
+        if (not file or header.magic != s_cache_magic or header.source_size != expected->source_size or header.source_time != expected->source_time or header.bin_count != bin_count(header.total_frames) or header.bin_count == 0)
+        {
+            return std::nullopt;
+        }
+
+        std::vector<s_peak> base_level(header.bin_count);
+        file.read(reinterpret_cast<char *>(base_level.data()), static_cast<std::streamsize>(base_level.size() * sizeof(s_peak)));
+        if (not file)
+        {
+            return std::nullopt;
+        }
+        return c_peak_pyramid(std::move(base_level), header.total_frames);
+    }
+
+    c_peak_job::c_peak_job(std::filesystem::path path, bool persist)
+        : m_path(std::move(path)),
+          m_persist(persist)
+    {
+    }
+
+    auto c_peak_job::start(const std::filesystem::path &path, bool persist, utility::c_thread_pool &pool) -> std::shared_ptr<c_peak_job>
+    {
+        auto job = std::make_shared<c_peak_job>(path, persist);
+        // The cache lookup and the header read happen on the pool as well, the caller never touches the disk
+        pool.submit([job, &pool]()
+                    { run(job, pool); });
+        return job;
+    }
+
+    auto c_peak_job::result() const -> std::shared_ptr<const c_peak_pyramid>
+    {
+        return m_result.load(std::memory_order_acquire);
+    }
+
+    auto c_peak_job::cancel() -> void
+    {
+        m_cancelled.store(true, std::memory_order_relaxed);
+    }
+
+    auto c_peak_job::cache_path(const std::filesystem::path &path) -> std::filesystem::path
+    {
+        auto cache = path;
+        cache += ".peaks";
+        return cache;
+    }
+
+    auto c_peak_job::run(const std::shared_ptr<c_peak_job> &job, utility::c_thread_pool &pool) -> void
+    {
+        if (job->m_cancelled.load(std::memory_order_relaxed))
+        {
+            return;
+        }
+        if (auto cached = job->m_persist ? c_peak_pyramid::load(cache_path(job->m_path), job->m_path) : std::nullopt)
+        {
+            job->m_result.store(std::make_shared<const c_peak_pyramid>(std::move(*cached)), std::memory_order_release);
+            return;
+        }
+
+        SndfileHandle file(job->m_path.string());
+        if (not file or file.frames() <= 0)
+        {
+            return;
+        }
+        job->m_total_frames = static_cast<std::uint64_t>(file.frames());
+        job->m_base_level.resize(c_peak_pyramid::bin_count(job->m_total_frames));
+
+        auto chunks = static_cast<std::size_t>((job->m_total_frames + s_chunk_frames - 1) / s_chunk_frames);
+        job->m_remaining_chunks.store(chunks, std::memory_order_relaxed);
+        for (std::size_t chunk = 0; chunk < chunks; ++chunk)
+        {
+            pool.submit([job, chunk]()
+                        {
+                            job->decode_chunk(chunk);
+                            if (job->m_remaining_chunks.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                            {
+                                job->finish();
+                            } });
+        }
+    }
+
+    auto c_peak_job::decode_chunk(std::size_t chunk) -> void
+    {
+        if (m_cancelled.load(std::memory_order_relaxed) or m_failed.load(std::memory_order_relaxed))
+        {
+            return;
+        }
+
+        SndfileHandle file(m_path.string());
+        auto first_frame = chunk * s_chunk_frames;
+        if (not file or file.seek(static_cast<sf_count_t>(first_frame), SEEK_SET) < 0)
+        {
+            m_failed.store(true, std::memory_order_relaxed);
+            return;
+        }
+
+        auto channels = static_cast<std::size_t>(file.channels());
+        auto frames = static_cast<std::size_t>(std::min(s_chunk_frames, m_total_frames - first_frame));
+        std::vector<float> interleaved(frames * channels);
+        auto frames_read = file.readf(interleaved.data(), static_cast<sf_count_t>(frames));
+        if (frames_read < 0)
+        {
+            m_failed.store(true, std::memory_order_relaxed);
+            return;
+        }
+
+        // Decoders may report more frames than they deliver; the missing tail is silence
+        std::vector<float> mono(frames, 0.F);
+        for (std::size_t frame = 0; frame < static_cast<std::size_t>(frames_read); ++frame)
+        {
+            float sum = 0.F;
+            for (std::size_t channel = 0; channel < channels; ++channel)
+            {
+                sum += interleaved[(frame * channels) + channel];
+            }
+            mono[frame] = sum / static_cast<float>(channels);
+        }
+
+        // Chunks are a multiple of the bin width, so each chunk owns a disjoint range of level 0
+        auto first_bin = static_cast<std::size_t>(first_frame / c_peak_pyramid::s_base_frames);
+        std::span<s_peak> bins(m_base_level.data() + first_bin, c_peak_pyramid::bin_count(frames));
+        c_peak_pyramid::reduce(mono, bins);
+    }
+
+    auto c_peak_job::finish() -> void
+    {
+        if (m_cancelled.load(std::memory_order_relaxed) or m_failed.load(std::memory_order_relaxed))
+        {
+            return;
+        }
+        auto pyramid = std::make_shared<const c_peak_pyramid>(std::move(m_base_level), m_total_frames);
+        if (m_persist)
+        {
+            // Best effort, the directory of the track may be read-only
+            pyramid->save(cache_path(m_path), m_path);
+        }
+        m_result.store(std::move(pyramid), std::memory_order_release);
+    }
+} // namespace music
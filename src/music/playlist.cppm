@@ -0,0 +1,460 @@
+module;
+#include <miniaudio.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <numbers>
+#include <optional>
+#include <print>
+#include <span>
+#include <stop_token>
+#include <thread>
+#include <utility>
+#include <vector>
+export module music:playlist;
+
+import :track;
+import utility;
+
+export namespace music
+{
+    /**
+     * @brief Queue of files played back to back, with gapless or equal-power crossfaded transitions.
+     *
+     * A decoder thread opens each file while the previous one is still playing and keeps a few seconds of it decoded
+     * in a wait-free ring, so the next file is ready before it is needed. The audio thread only copies out of the
+     * rings and computes the crossfade in mix(); files are opened, warmed up and closed on the decoder thread.
+     */
+    class c_playlist
+    {
+    public:
+        static constexpr std::uint32_t s_sample_rate = 44100;
+        static constexpr std::uint32_t s_channels = 2;
+        static constexpr std::size_t s_buffer_frames = 1U << 17U; // Decoded ahead per file, about 3 s
+        static constexpr std::size_t s_decode_frames = 4096;      // Decoded per step
+        static constexpr std::size_t s_block_frames = 1024;       // Mixed per step
+
+        c_playlist();
+        ~c_playlist();
+
+        c_playlist(const c_playlist &) = delete;
+        c_playlist(c_playlist &&) = delete;
+        auto operator=(const c_playlist &) -> c_playlist & = delete;
+        auto operator=(c_playlist &&) -> c_playlist & = delete;
+
+        auto enqueue(const std::filesystem::path &path) -> void;
+        [[nodiscard]] auto items() const -> std::vector<std::filesystem::path>;
+
+        /**
+         * @brief Files the decoder thread has not yet decoded ahead and handed over, or skipped as unreadable.
+         */
+        [[nodiscard]] auto pending() const -> std::size_t;
+
+        auto play() -> void;
+        auto pause() -> void;
+        [[nodiscard]] auto is_playing() const -> bool;
+
+        /**
+         * @brief End the current file now; the next one starts where it is, without a crossfade.
+         */
+        auto skip() -> void;
+
+        /**
+         * @brief Overlap of consecutive files; zero makes transitions gapless.
+         */
+        auto set_crossfade(std::chrono::milliseconds duration) -> void;
+        [[nodiscard]] auto get_crossfade() const -> std::chrono::milliseconds;
+
+        /**
+         * @brief Index of the file being heard, the outgoing one during a crossfade.
+         */
+        [[nodiscard]] auto now_playing() const -> std::optional<std::size_t>;
+
+        /**
+         * @brief Blocks the audio thread found not yet decoded and played as silence.
+         */
+        [[nodiscard]] auto underflows() const -> std::uint64_t;
+
+        /**
+         * @brief Audio thread. Add the next frame_count frames of the playlist to output, interleaved stereo.
+         */
+        auto mix(std::span<float> output, std::uint64_t frame_count) -> void;
+
+        /**
+         * @brief Gains of the outgoing and incoming file at progress in [0, 1] of a crossfade; their powers sum to one.
+         */
+        static auto crossfade_gains(float progress) -> std::pair<float, float>;
+
+        /**
+         * @brief Add a slice of a crossfade to output. fade_position is the frame of the fade the slice starts at.
+         */
+        static auto crossfade(std::span<const float> outgoing, std::span<const float> incoming, std::span<float> output, std::uint64_t fade_position, std::uint64_t fade_length) -> void;
+
+    private:
+        static constexpr std::size_t s_nothing = std::numeric_limits<std::size_t>::max();
+
+        struct s_stream
+        {
+            s_stream(std::size_t item_index, const std::filesystem::path &path);
+
+            std::size_t item;
+            std::unique_ptr<s_ma_snd_data_source> decoder; // Decoder thread only; a bare source, no overview or taps
+            utility::c_spsc_ring<float> buffer;
+            std::uint64_t total_frames;      // Fixed once the stream is handed over
+            std::uint64_t decoded_frames{};  // Decoder thread only
+            std::uint64_t played_frames{};   // Audio thread only
+            std::atomic<bool> is_done{ false }; // Set by the audio thread when it lets go of the stream
+        };
+
+        mutable std::mutex m_mutex; // Guards the items, wakes the decoder thread
+        std::condition_variable_any m_condition;
+        std::vector<std::filesystem::path> m_items;
+        std::size_t m_next_item{};
+        std::size_t m_processed_items{}; // Handed over or skipped
+
+        // Decoder thread only
+        std::vector<std::unique_ptr<s_stream>> m_streams;
+        std::vector<float> m_decode_buffer;
+
+        // Passed from the decoder thread to the audio thread, one stream at a time
+        std::atomic<s_stream *> m_handoff{};
+
+        // Audio thread only
+        s_stream *m_current{};
+        s_stream *m_incoming{};
+        std::uint64_t m_fade_length{}; // Non-zero while crossfading
+        std::vector<float> m_outgoing_block;
+        std::vector<float> m_incoming_block;
+
+        std::atomic<bool> m_is_playing{ false };
+        std::atomic<bool> m_skip_requested{ false };
+        std::atomic<std::uint64_t> m_crossfade_frames{};
+        std::atomic<std::size_t> m_now_playing{ s_nothing };
+        std::atomic<std::uint64_t> m_underflows{};
+
+        std::jthread m_decoder; // Last member, so the thread stops before the streams are destroyed
+
+        auto decoder_loop(std::stop_token stop_token) -> void;
+        auto open_next() -> void;
+        auto decode(s_stream &stream) -> void;
+        auto take_streams() -> void;
+        auto finish_current() -> void;
+        auto read(s_stream &stream, std::span<float> block) -> std::uint64_t;
+    };
+} // namespace music
+
+// Implementation
+namespace music
+{
+    c_playlist::s_stream::s_stream(std::size_t item_index, const std::filesystem::path &path)
+        : item(item_index),
+          decoder(std::make_unique<s_ma_snd_data_source>(path)),
+          buffer(s_buffer_frames * s_channels),
+          total_frames(0)
+    {
+        ma_uint64 length = 0;
+        ma_data_source_get_length_in_pcm_frames(reinterpret_cast<ma_data_source *>(decoder.get()), &length);
+        total_frames = length;
+    }
+
+    c_playlist::c_playlist()
+        : m_decode_buffer(s_decode_frames * s_channels),
+          m_outgoing_block(s_block_frames * s_channels),
+          m_incoming_block(s_block_frames * s_channels),
+          m_decoder([this](std::stop_token stop_token)
+                    { decoder_loop(std::move(stop_token)); })
+    {
+    }
+
+    c_playlist::~c_playlist()
+    {
+        m_decoder.request_stop();
+        m_condition.notify_all();
+    }
+
+    auto c_playlist::enqueue(const std::filesystem::path &path) -> void
+    {
+        {
+            std::scoped_lock lock(m_mutex);
+            m_items.push_back(path);
+        }
+        m_condition.notify_one();
+    }
+
+    auto c_playlist::items() const -> std::vector<std::filesystem::path>
+    {
+        std::scoped_lock lock(m_mutex);
+        return m_items;
+    }
+
+    auto c_playlist::pending() const -> std::size_t
+    {
+        std::scoped_lock lock(m_mutex);
+        return m_items.size() - m_processed_items;
+    }
+
+    auto c_playlist::play() -> void
+    {
+        m_is_playing.store(true, std::memory_order_relaxed);
+    }
+
+    auto c_playlist::pause() -> void
+    {
+        m_is_playing.store(false, std::memory_order_relaxed);
+    }
+
+    auto c_playlist::is_playing() const -> bool
+    {
+        return m_is_playing.load(std::memory_order_relaxed);
+    }
+
+    auto c_playlist::skip() -> void
+    {
+        m_skip_requested.store(true, std::memory_order_relaxed);
+    }
+
+    auto c_playlist::set_crossfade(std::chrono::milliseconds duration) -> void
+    {
+        auto frames = std::max<std::int64_t>(duration.count(), 0) * s_sample_rate / 1000;
+        m_crossfade_frames.store(static_cast<std::uint64_t>(frames), std::memory_order_relaxed);
+    }
+
+    auto c_playlist::get_crossfade() const -> std::chrono::milliseconds
+    {
+        auto frames = m_crossfade_frames.load(std::memory_order_relaxed);
+        return std::chrono::milliseconds(static_cast<std::int64_t>(frames * 1000 / s_sample_rate));
+    }
+
+    auto c_playlist::now_playing() const -> std::optional<std::size_t>
+    {
+        auto item = m_now_playing.load(std::memory_order_relaxed);
+        return item == s_nothing ? std::nullopt : std::optional(item);
+    }
+
+    auto c_playlist::underflows() const -> std::uint64_t
+    {
+        return m_underflows.load(std::memory_order_relaxed);
+    }
+
+    auto c_playlist::decoder_loop(std::stop_token stop_token) -> void
+    {
+        using namespace std::chrono_literals;
+        utility::c_profiler::instance().name_thread("Playlist decoder");
+        while (not stop_token.stop_requested())
+        {
+            // Files the audio thread is done with are closed here, never on the audio thread
+            std::erase_if(m_streams, [](const std::unique_ptr<s_stream> &stream)
+                          { return stream->is_done.load(std::memory_order_acquire); });
+
+            for (auto &stream : m_streams)
+            {
+                decode(*stream);
+            }
+
+            // The playing file and the one after it, nothing further
+            if (m_streams.size() < 2 and m_handoff.load(std::memory_order_acquire) == nullptr)
+            {
+                open_next();
+            }
+
+            // Refill at least every few periods; wake early when a file is queued and there is room for it
+            std::unique_lock lock(m_mutex);
+            m_condition.wait_for(lock, stop_token, 10ms, [this]()
+                                 { return m_next_item < m_items.size() and m_streams.size() < 2 and m_handoff.load(std::memory_order_acquire) == nullptr; });
+        }
+    }
+
+    auto c_playlist::open_next() -> void
+    {
+        std::size_t item = 0;
+        std::filesystem::path path;
+        {
+            std::scoped_lock lock(m_mutex);
+            if (m_next_item >= m_items.size())
+            {
+                return;
+            }
+            item = m_next_item++;
+            path = m_items[item];
+        }
+
+        try
+        {
+            auto stream = std::make_unique<s_stream>(item, path);
+
+            // Pre-roll, so the first period of the file is already in memory when the audio thread gets it
+            decode(*stream);
+            m_handoff.store(stream.get(), std::memory_order_release);
+            m_streams.push_back(std::move(stream));
+        }
+        catch (const std::exception &e)
+        {
+            std::println(std::cerr, "Warning: skipping {} in the playlist: {}", path.string(), e.what());
+        }
+        std::scoped_lock lock(m_mutex);
+        ++m_processed_items;
+    }
+
+    auto c_playlist::decode(s_stream &stream) -> void
+    {
+        // Free space only grows while the audio thread reads, so what is seen here is always available
+        while (stream.decoded_frames < stream.total_frames)
+        {
+            auto free_frames = (stream.buffer.capacity() - stream.buffer.size()) / s_channels;
+            auto frames = std::min<std::uint64_t>({ free_frames, s_decode_frames, stream.total_frames - stream.decoded_frames });
+            if (frames == 0)
+            {
+                return;
+            }
+            auto block = std::span(m_decode_buffer).first(static_cast<std::size_t>(frames) * s_channels);
+            ma_data_source_read_pcm_frames(reinterpret_cast<ma_data_source *>(stream.decoder.get()), block.data(), frames, nullptr);
+            stream.buffer.push(block);
+            stream.decoded_frames += frames;
+        }
+    }
+
+    auto c_playlist::take_streams() -> void
+    {
+        if (m_current and m_incoming)
+        {
+            return;
+        }
+        if (auto *stream = m_handoff.exchange(nullptr, std::memory_order_acq_rel))
+        {
+            if (m_current)
+            {
+                m_incoming = stream;
+            }
+            else
+            {
+                m_current = stream;
+                m_now_playing.store(stream->item, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    auto c_playlist::finish_current() -> void
+    {
+        // Whatever is left in the ring is never played; the decoder thread closes the file
+        m_current->buffer.discard();
+        m_current->is_done.store(true, std::memory_order_release);
+        m_current = std::exchange(m_incoming, nullptr);
+        m_fade_length = 0;
+        m_now_playing.store(m_current ? m_current->item : s_nothing, std::memory_order_relaxed);
+    }
+
+    auto c_playlist::read(s_stream &stream, std::span<float> block) -> std::uint64_t
+    {
+        // Frames the decoder has not caught up with stay silent
+        auto samples = stream.buffer.pop(block);
+        if (samples < block.size())
+        {
+            m_underflows.fetch_add(1, std::memory_order_relaxed);
+        }
+        std::ranges::fill(block.subspan(samples), 0.F);
+        stream.played_frames += samples / s_channels;
+        return samples / s_channels;
+    }
+
+    auto c_playlist::mix(std::span<float> output, std::uint64_t frame_count) -> void
+    {
+        take_streams();
+        if (m_skip_requested.exchange(false, std::memory_order_relaxed) and m_current)
+        {
+            finish_current();
+            take_streams();
+        }
+        if (not m_is_playing.load(std::memory_order_relaxed))
+        {
+            return;
+        }
+
+        std::uint64_t position = 0;
+        while (position < frame_count)
+        {
+            take_streams();
+            if (not m_current)
+            {
+                return;
+            }
+            auto remaining = m_current->total_frames - m_current->played_frames;
+            if (remaining == 0)
+            {
+                // Gapless: the next file continues on the following frame of the same period
+                finish_current();
+                continue;
+            }
+
+            // Overlap only as much as both files allow; without a next file there is nothing to fade into
+            std::uint64_t fade_target = 0;
+            if (m_incoming)
+            {
+                fade_target = std::min(m_crossfade_frames.load(std::memory_order_relaxed), m_incoming->total_frames);
+            }
+            if (m_fade_length == 0 and fade_target > 0 and remaining <= fade_target)
+            {
+                m_fade_length = remaining;
+            }
+
+            auto slice = std::min<std::uint64_t>(frame_count - position, s_block_frames);
+            if (m_fade_length == 0)
+            {
+                slice = std::min(slice, remaining > fade_target ? remaining - fade_target : remaining);
+            }
+            else
+            {
+                slice = std::min(slice, remaining);
+            }
+            auto samples = static_cast<std::size_t>(slice) * s_channels;
+            auto target = output.subspan(static_cast<std::size_t>(position) * s_channels, samples);
+            auto outgoing = std::span(m_outgoing_block).first(samples);
+
+            if (m_fade_length == 0)
+            {
+                read(*m_current, outgoing);
+                std::ranges::transform(target, outgoing, target.begin(), std::plus<float>{});
+            }
+            else
+            {
+                auto incoming = std::span(m_incoming_block).first(samples);
+                auto fade_position = m_fade_length - remaining;
+                read(*m_current, outgoing);
+                read(*m_incoming, incoming);
+                crossfade(outgoing, incoming, target, fade_position, m_fade_length);
+            }
+            position += slice;
+        }
+    }
+
+    auto c_playlist::crossfade_gains(float progress) -> std::pair<float, float>
+    {
+        auto angle = std::clamp(progress, 0.F, 1.F) * std::numbers::pi_v<float> / 2.F;
+        return { std::cos(angle), std::sin(angle) };
+    }
+
+    auto c_playlist::crossfade(std::span<const float> outgoing, std::span<const float> incoming, std::span<float> output, std::uint64_t fade_position, std::uint64_t fade_length) -> void
+    {
+        auto frames = output.size() / s_channels;
+        for (std::size_t frame = 0; frame < frames; ++frame)
+        {
+            auto progress = static_cast<float>(fade_position + frame) / static_cast<float>(std::max<std::uint64_t>(fade_length, 1));
+            auto [outgoing_gain, incoming_gain] = crossfade_gains(progress);
+            for (std::size_t channel = 0; channel < s_channels; ++channel)
+            {
+                auto index = (frame * s_channels) + channel;
+                output[index] += (outgoing[index] * outgoing_gain) + (incoming[index] * incoming_gain);
+            }
+        }
+    }
+} // namespace music
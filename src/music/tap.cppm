@@ -0,0 +1,283 @@
+module;
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <utility>
+export module music:tap;
+
+import utility;
+
+export namespace music
+{
+    /**
+     * @brief Pre-mix copy of one track's samples, written by the audio callback and read by one subscriber.
+     */
+    class c_analysis_tap
+    {
+    public:
+        static constexpr std::size_t s_default_capacity = 1U << 14U; // Interleaved stereo samples, about 186 ms
+
+        explicit c_analysis_tap(std::size_t capacity = s_default_capacity);
+
+        /**
+         * @brief Audio thread. Samples that do not fit, because the subscriber fell behind, are dropped.
+         */
+        auto write(std::span<const float> samples) -> void;
+
+        /**
+         * @brief Subscriber. Returns how many interleaved stereo samples were copied, oldest first.
+         */
+        auto read(std::span<float> samples) -> std::size_t;
+
+        auto activate() -> void;
+        auto deactivate() -> void;
+        [[nodiscard]] auto is_active() const -> bool;
+        [[nodiscard]] auto capacity() const -> std::size_t;
+
+        /**
+         * @brief Samples lost to a full ring since the tap was activated.
+         */
+        [[nodiscard]] auto dropped() const -> std::uint64_t;
+
+    private:
+        utility::c_spsc_ring<float> m_ring;
+        std::atomic<bool> m_active{ false };
+        std::atomic<std::uint64_t> m_dropped{};
+    };
+
+    class c_tap_set;
+
+    /**
+     * @brief Exclusive reader of one tap of a track, detached on destruction. Must not outlive the track.
+     */
+    class c_tap_subscription
+    {
+    public:
+        c_tap_subscription() = default;
+        c_tap_subscription(c_tap_set &set, c_analysis_tap &tap);
+        ~c_tap_subscription();
+
+        c_tap_subscription(const c_tap_subscription &) = delete;
+        auto operator=(const c_tap_subscription &) -> c_tap_subscription & = delete;
+        c_tap_subscription(c_tap_subscription &&other) noexcept;
+        auto operator=(c_tap_subscription &&other) noexcept -> c_tap_subscription &;
+
+        explicit operator bool() const;
+
+        /**
+         * @brief Interleaved stereo samples played since the last read, up to the capacity of the tap.
+         */
+        auto read(std::span<float> samples) -> std::size_t;
+        [[nodiscard]] auto capacity() const -> std::size_t;
+        [[nodiscard]] auto dropped() const -> std::uint64_t;
+
+    private:
+        c_tap_set *m_set{};
+        c_analysis_tap *m_tap{};
+
+        auto reset() -> void;
+    };
+
+    /**
+     * @brief Analysis taps of a track, a fixed number of independent subscribers.
+     *
+     * Taps are created on first subscription and kept until the set is destroyed, so the audio callback never sees one
+     * go away. With no subscriber attached, feed() costs a single atomic load.
+     */
+    class c_tap_set
+    {
+    public:
+        static constexpr std::size_t s_max_taps = 4;
+
+        explicit c_tap_set(std::size_t tap_capacity = c_analysis_tap::s_default_capacity);
+
+        /**
+         * @brief Attach a subscriber; the subscription is empty when every tap is taken.
+         */
+        auto subscribe() -> c_tap_subscription;
+
+        /**
+         * @brief Audio thread. Copy a period of the track's output to the attached taps.
+         */
+        auto feed(std::span<const float> samples) -> void;
+
+        [[nodiscard]] auto subscriber_count() const -> std::size_t;
+
+    private:
+        friend class c_tap_subscription;
+
+        std::size_t m_tap_capacity;
+        std::mutex m_mutex; // Serializes subscribers, never taken by the audio thread
+        std::array<std::unique_ptr<c_analysis_tap>, s_max_taps> m_taps;
+        std::array<std::atomic<c_analysis_tap *>, s_max_taps> m_published{};
+        std::atomic<std::size_t> m_subscriber_count{};
+
+        auto release(c_analysis_tap &tap) -> void;
+    };
+} // namespace music
+
+// Implementation
+namespace music
+{
+    c_analysis_tap::c_analysis_tap(std::size_t capacity)
+        : m_ring(capacity)
+    {
+    }
+
+    auto c_analysis_tap::write(std::span<const float> samples) -> void
+    {
+        auto written = m_ring.push(samples);
+        if (written < samples.size())
+        {
+            m_dropped.fetch_add(samples.size() - written, std::memory_order_relaxed);
+        }
+    }
+
+    auto c_analysis_tap::read(std::span<float> samples) -> std::size_t
+    {
+        return m_ring.pop(samples);
+    }
+
+    auto c_analysis_tap::activate() -> void
+    {
+        // Leftovers of a previous subscriber are stale, the new one starts from the current position
+        m_ring.discard();
+        m_dropped.store(0, std::memory_order_relaxed);
+        m_active.store(true, std::memory_order_release);
+    }
+
+    auto c_analysis_tap::deactivate() -> void
+    {
+        m_active.store(false, std::memory_order_release);
+    }
+
+    auto c_analysis_tap::is_active() const -> bool
+    {
+        return m_active.load(std::memory_order_acquire);
+    }
+
+    auto c_analysis_tap::capacity() const -> std::size_t
+    {
+        return m_ring.capacity();
+    }
+
+    auto c_analysis_tap::dropped() const -> std::uint64_t
+    {
+        return m_dropped.load(std::memory_order_relaxed);
+    }
+
+    c_tap_subscription::c_tap_subscription(c_tap_set &set, c_analysis_tap &tap)
+        : m_set(&set),
+          m_tap(&tap)
+    {
+    }
+
+    c_tap_subscription::~c_tap_subscription()
+    {
+        reset();
+    }
+
+    c_tap_subscription::c_tap_subscription(c_tap_subscription &&other) noexcept
+        : m_set(std::exchange(other.m_set, nullptr)),
+          m_tap(std::exchange(other.m_tap, nullptr))
+    {
+    }
+
+    auto c_tap_subscription::operator=(c_tap_subscription &&other) noexcept -> c_tap_subscription &
+    {
+        if (this != &other)
+        {
+            reset();
+            m_set = std::exchange(other.m_set, nullptr);
+            m_tap = std::exchange(other.m_tap, nullptr);
+        }
+        return *this;
+    }
+
+    auto c_tap_subscription::reset() -> void
+    {
+        if (m_set and m_tap)
+        {
+            m_set->release(*m_tap);
+        }
+        m_set = nullptr;
+        m_tap = nullptr;
+    }
+
+    c_tap_subscription::operator bool() const
+    {
+        return m_tap != nullptr;
+    }
+
+    auto c_tap_subscription::read(std::span<float> samples) -> std::size_t
+    {
+        return m_tap ? m_tap->read(samples) : 0;
+    }
+
+    auto c_tap_subscription::capacity() const -> std::size_t
+    {
+        return m_tap ? m_tap->capacity() : 0;
+    }
+
+    auto c_tap_subscription::dropped() const -> std::uint64_t
+    {
+        return m_tap ? m_tap->dropped() : 0;
+    }
+
+    c_tap_set::c_tap_set(std::size_t tap_capacity)
+        : m_tap_capacity(tap_capacity)
+    {
+    }
+
+    auto c_tap_set::subscribe() -> c_tap_subscription
+    {
+        std::scoped_lock lock(m_mutex);
+        for (std::size_t i = 0; i < s_max_taps; ++i)
+        {
+            auto &tap = m_taps[i];
+            if (not tap)
+            {
+                tap = std::make_unique<c_analysis_tap>(m_tap_capacity);
+                m_published[i].store(tap.get(), std::memory_order_release);
+            }
+            if (not tap->is_active())
+            {
+                tap->activate();
+                m_subscriber_count.fetch_add(1, std::memory_order_relaxed);
+                return { *this, *tap };
+            }
+        }
+        return {};
+    }
+
+    auto c_tap_set::release(c_analysis_tap &tap) -> void
+    {
+        std::scoped_lock lock(m_mutex);
+        tap.deactivate();
+        m_subscriber_count.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    auto c_tap_set::feed(std::span<const float> samples) -> void
+    {
+        if (m_subscriber_count.load(std::memory_order_relaxed) == 0)
+        {
+            return;
+        }
+        for (auto &published : m_published)
+        {
+            if (auto *tap = published.load(std::memory_order_acquire); tap and tap->is_active())
+            {
+                tap->write(samples);
+            }
+        }
+    }
+
+    auto c_tap_set::subscriber_count() const -> std::size_t
+    {
+        return m_subscriber_count.load(std::memory_order_relaxed);
+    }
+} // namespace music
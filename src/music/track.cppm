@@ -2,11 +2,21 @@ module;
 #include <miniaudio.h>
 #include <sndfile.hh>
 
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
 #include <filesystem>
+#include <memory>
+#include <span>
 #include <string>
 #include <vector>
 export module music:track;
 
+import :peaks;
+import :tap;
+import utility;
+
 namespace music
 {
     struct s_ma_snd_data_source
@@ -36,49 +46,95 @@ namespace music
         };
 
     private:
+        // Output frames converted per pass, the size of a mix chunk in c_audio_manager
+        static constexpr ma_uint64 s_chunk_frames = 1024;
+
         ma_data_source_base m_base{};
         SndfileHandle m_sndfile;
         ma_linear_resampler m_resampler{};
         ma_channel_converter m_channel_converter{};
+        std::vector<float> m_decode_buffer;    // Source frames for one pass, sized at construction
+        std::vector<float> m_resampled_buffer; // Resampled frames for one pass, sized at construction
         bool m_looping{ false };
         ma_uint64 m_length{ 0 };
         ma_uint64 m_cursor{ 0 };
         ma_uint32 m_output_channels{ 2 };
         ma_uint32 m_output_sample_rate{ 44100 };
+
+        auto decode(float *out, ma_uint64 frame_count) -> void;
     };
 } // namespace
 
 export namespace music
 {
+    enum class e_peak_overview : std::uint8_t
+    {
+        none,      // No overview is built
+        in_memory, // Built in the background, kept for the lifetime of the track
+        cached,    // Also read from and written to "<file>.peaks" next to the file
+    };
+
     class c_track
     {
     public:
-        explicit c_track(int track_id, const std::filesystem::path &path);
+        explicit c_track(int track_id, const std::filesystem::path &path, e_peak_overview peaks = e_peak_overview::in_memory);
+        ~c_track();
 
         c_track(c_track &&other) noexcept;
         auto operator=(c_track &&other) noexcept -> c_track &;
 
         [[nodiscard]] auto get_track_id() const -> int;
 
+        // Playback state is changed by the audio thread only; schedule changes through c_audio_manager
         auto play() -> void;
         auto pause() -> void;
+        auto seek(std::uint64_t frame_index) -> void;
+        auto set_gain(float gain) -> void;
         [[nodiscard]] auto is_playing() const -> bool;
+        [[nodiscard]] auto get_gain() const -> float;
+
+        /**
+         * @brief Audio thread. Decode frame_count stereo frames into out, scaled by the gain; returns the frames read.
+         */
+        auto render(std::span<float> out, std::uint64_t frame_count) -> std::uint64_t;
 
-        auto seek(std::uint64_t frame_index) -> void;
         auto set_looping(bool is_looping) -> void;
         [[nodiscard]] auto get_cursor_frame() -> std::uint64_t;
         [[nodiscard]] auto is_looping() const -> bool;
         [[nodiscard]] auto get_total_frames() -> std::uint64_t;
 
         [[nodiscard]] auto get_filename() const -> std::string;
+        [[nodiscard]] auto get_path() const -> const std::filesystem::path &;
         [[nodiscard]] auto data_ptr() -> ma_data_source *;
 
+        /**
+         * @brief Amplitude overview of the whole file, in source frames; nullptr until the background build finishes.
+         */
+        [[nodiscard]] auto peaks() const -> std::shared_ptr<const c_peak_pyramid>;
+
+        /**
+         * @brief Receive this track's output before it is mixed; the subscription is empty if all taps are taken.
+         */
+        [[nodiscard]] auto subscribe_tap() -> c_tap_subscription;
+
+        /**
+         * @brief Audio thread. Hand a period of this track's output to its analysis taps.
+         */
+        auto feed_taps(std::span<const float> samples) -> void;
+
     private:
         int m_track_id{ 0 };
         s_ma_snd_data_source m_snd_data_source;
+        std::filesystem::path m_path;
         std::string m_filename;
-        bool m_is_playing{ false };
-        bool m_is_looping{ false };
+        std::shared_ptr<c_peak_job> m_peaks;
+        std::unique_ptr<c_tap_set> m_taps;
+
+        // Written by the audio thread, read by the UI
+        std::atomic<bool> m_is_playing{ false };
+        std::atomic<bool> m_is_looping{ false };
+        std::atomic<float> m_gain{ 1.F };
+        std::atomic<std::uint64_t> m_cursor_frame{};
     };
 } // namespace music
 
@@ -133,24 +189,50 @@ namespace music
     {
         auto *self = reinterpret_cast<s_ma_snd_data_source *>(data_source);
         auto *out = reinterpret_cast<float *>(out_frames);
+        for (ma_uint64 done = 0; done < frame_count;)
+        {
+            auto frames = std::min(frame_count - done, s_chunk_frames);
+            self->decode(out + (done * self->m_output_channels), frames);
+            done += frames;
+        }
+
+        *frames_read = frame_count;
+        self->m_cursor += frame_count;
+        if (self->m_cursor >= self->m_length)
+        {
+            if (self->m_looping)
+            {
+                self->m_cursor %= self->m_length;
+            }
+            else
+            {
+                self->m_cursor = self->m_length;
+            }
+        }
+        return MA_SUCCESS;
+    }
+
+    auto s_ma_snd_data_source::decode(float *out, ma_uint64 frame_count) -> void
+    {
+        auto channels = static_cast<std::size_t>(m_sndfile.channels());
         std::size_t frames_read_total = 0;
         bool looped = false;
         ma_uint64 re_size = 0;
-        ma_linear_resampler_get_required_input_frame_count(&self->m_resampler, frame_count, &re_size);
+        ma_linear_resampler_get_required_input_frame_count(&m_resampler, frame_count, &re_size);
+        re_size = std::min<ma_uint64>(re_size, m_decode_buffer.size() / channels);
 
-        std::vector<float> temp_buffer(re_size * static_cast<std::size_t>(self->m_sndfile.channels()), 0.F);
         while (frames_read_total < re_size)
         {
-            auto frames = self->m_sndfile.readf(temp_buffer.data() + (frames_read_total * static_cast<std::size_t>(self->m_sndfile.channels())), static_cast<sf_count_t>(re_size - frames_read_total));
+            auto frames = m_sndfile.readf(m_decode_buffer.data() + (frames_read_total * channels), static_cast<sf_count_t>(re_size - frames_read_total));
             if (frames <= 0)
             {
                 if (looped)
                 {
                     break;
                 }
-                if (self->m_looping)
+                if (m_looping)
                 {
-                    self->m_sndfile.seek(0, SEEK_SET);
+                    m_sndfile.seek(0, SEEK_SET);
                     looped = true;
                 }
                 else
@@ -160,29 +242,16 @@ namespace music
             }
             frames_read_total += static_cast<std::size_t>(frames);
         }
+        // Past the end of the file the source is silent
+        std::fill(m_decode_buffer.begin() + static_cast<std::ptrdiff_t>(frames_read_total * channels), m_decode_buffer.begin() + static_cast<std::ptrdiff_t>(re_size * channels), 0.F);
 
         // Resample to sample rate of 44.1kHz
-        std::vector<float> resampled_buffer(frame_count * static_cast<std::size_t>(self->m_sndfile.channels()), 0.F);
-        ma_uint64 resampled_frames = resampled_buffer.size();
-        ma_linear_resampler_process_pcm_frames(&self->m_resampler, temp_buffer.data(), &re_size, resampled_buffer.data(), &resampled_frames);
+        ma_uint64 resampled_frames = frame_count;
+        ma_linear_resampler_process_pcm_frames(&m_resampler, m_decode_buffer.data(), &re_size, m_resampled_buffer.data(), &resampled_frames);
+        std::fill(m_resampled_buffer.begin() + static_cast<std::ptrdiff_t>(resampled_frames * channels), m_resampled_buffer.begin() + static_cast<std::ptrdiff_t>(frame_count * channels), 0.F);
 
         // Perform channel conversion to stereo
-        ma_channel_converter_process_pcm_frames(&self->m_channel_converter, out, resampled_buffer.data(), frame_count);
-
-        *frames_read = frame_count;
-        self->m_cursor += frame_count;
-        if (self->m_cursor >= self->m_length)
-        {
-            if (self->m_looping)
-            {
-                self->m_cursor %= self->m_length;
-            }
-            else
-            {
-                self->m_cursor = self->m_length;
-            }
-        }
-        return MA_SUCCESS;
+        ma_channel_converter_process_pcm_frames(&m_channel_converter, out, m_resampled_buffer.data(), frame_count);
     }
 
     s_ma_snd_data_source::~s_ma_snd_data_source()
@@ -210,6 +279,13 @@ namespace music
         ma_linear_resampler_config resampler_config = ma_linear_resampler_config_init(ma_format_f32, static_cast<ma_uint32>(m_sndfile.channels()), static_cast<ma_uint32>(m_sndfile.samplerate()), m_output_sample_rate);
         ma_linear_resampler_init(&resampler_config, nullptr, &m_resampler);
 
+        // The callback reuses these; a pass needs the chunk scaled by the rate ratio, plus what the resampler holds back
+        auto channels = static_cast<std::size_t>(m_sndfile.channels());
+        auto source_rate = static_cast<ma_uint64>(m_sndfile.samplerate());
+        auto decode_frames = ((s_chunk_frames * source_rate) + m_output_sample_rate - 1) / m_output_sample_rate + ma_linear_resampler_get_input_latency(&m_resampler) + 2;
+        m_decode_buffer.assign(decode_frames * channels, 0.F);
+        m_resampled_buffer.assign(s_chunk_frames * channels, 0.F);
+
         // Initialize channel converter
         ma_channel_converter_config channel_config = ma_channel_converter_config_init(ma_format_f32, static_cast<ma_uint32>(m_sndfile.channels()), nullptr, m_output_channels, nullptr, ma_channel_mix_mode_default);
         ma_channel_converter_init(&channel_config, nullptr, &m_channel_converter);
@@ -220,21 +296,34 @@ namespace music
 
 namespace music
 {
-    c_track::c_track(int track_id, const std::filesystem::path &path)
-        : m_track_id(track_id), m_snd_data_source(path), m_filename(path.filename().string())
+    c_track::c_track(int track_id, const std::filesystem::path &path, e_peak_overview peaks)
+        : m_track_id(track_id), m_snd_data_source(path), m_path(path), m_filename(path.filename().string()),
+          m_peaks(peaks == e_peak_overview::none ? nullptr : c_peak_job::start(path, peaks == e_peak_overview::cached)),
+          m_taps(std::make_unique<c_tap_set>())
     {
     }
 
+    c_track::~c_track()
+    {
+        if (m_peaks)
+        {
+            m_peaks->cancel();
+        }
+    }
+
     c_track::c_track(c_track &&other) noexcept
         : m_track_id(other.m_track_id),
           m_snd_data_source(std::move(other.m_snd_data_source)),
+          m_path(std::move(other.m_path)),
           m_filename(std::move(other.m_filename)),
-          m_is_playing(other.m_is_playing),
-          m_is_looping(other.m_is_looping)
+          m_peaks(std::move(other.m_peaks)),
+          m_taps(std::move(other.m_taps)),
+          m_is_playing(other.m_is_playing.exchange(false, std::memory_order_relaxed)),
+          m_is_looping(other.m_is_looping.exchange(false, std::memory_order_relaxed)),
+          m_gain(other.m_gain.load(std::memory_order_relaxed)),
+          m_cursor_frame(other.m_cursor_frame.exchange(0, std::memory_order_relaxed))
     {
         other.m_track_id = 0;
-        other.m_is_playing = false;
-        other.m_is_looping = false;
     }
 
     auto c_track::operator=(c_track &&other) noexcept -> c_track &
@@ -242,14 +331,21 @@ namespace music
         if (this != &other)
         {
             m_track_id = other.m_track_id;
+            if (m_peaks)
+            {
+                m_peaks->cancel();
+            }
             m_snd_data_source = std::move(other.m_snd_data_source);
+            m_path = std::move(other.m_path);
             m_filename = std::move(other.m_filename);
-            m_is_playing = other.m_is_playing;
-            m_is_looping = other.m_is_looping;
+            m_peaks = std::move(other.m_peaks);
+            m_taps = std::move(other.m_taps);
+            m_is_playing.store(other.m_is_playing.exchange(false, std::memory_order_relaxed), std::memory_order_relaxed);
+            m_is_looping.store(other.m_is_looping.exchange(false, std::memory_order_relaxed), std::memory_order_relaxed);
+            m_gain.store(other.m_gain.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            m_cursor_frame.store(other.m_cursor_frame.exchange(0, std::memory_order_relaxed), std::memory_order_relaxed);
 
             other.m_track_id = 0;
-            other.m_is_playing = false;
-            other.m_is_looping = false;
         }
         return *this;
     }
@@ -261,40 +357,73 @@ namespace music
 
     auto c_track::play() -> void
     {
-        m_is_playing = true;
+        m_is_playing.store(true, std::memory_order_relaxed);
     }
 
     auto c_track::pause() -> void
     {
-        m_is_playing = false;
+        m_is_playing.store(false, std::memory_order_relaxed);
     }
 
     auto c_track::is_playing() const -> bool
     {
-        return m_is_playing;
+        return m_is_playing.load(std::memory_order_relaxed);
     }
 
     auto c_track::seek(std::uint64_t frame_index) -> void
     {
         ma_data_source_seek_to_pcm_frame(&m_snd_data_source, frame_index);
+        ma_uint64 cursor = 0;
+        ma_data_source_get_cursor_in_pcm_frames(&m_snd_data_source, &cursor);
+        m_cursor_frame.store(cursor, std::memory_order_relaxed);
     }
 
-    auto c_track::get_cursor_frame() -> std::uint64_t
+    auto c_track::set_gain(float gain) -> void
+    {
+        m_gain.store(gain, std::memory_order_relaxed);
+    }
+
+    auto c_track::get_gain() const -> float
     {
+        return m_gain.load(std::memory_order_relaxed);
+    }
+
+    auto c_track::render(std::span<float> out, std::uint64_t frame_count) -> std::uint64_t
+    {
+        utility::c_profile_zone zone(utility::zone_id<"Decode">());
+        std::ranges::fill(out, 0.F);
+        ma_uint64 frames_read = 0;
+        ma_data_source_read_pcm_frames(data_ptr(), out.data(), frame_count, &frames_read);
+
+        if (auto gain = m_gain.load(std::memory_order_relaxed); gain != 1.F)
+        {
+            for (auto &sample : out)
+            {
+                sample *= gain;
+            }
+        }
+
         ma_uint64 cursor = 0;
         ma_data_source_get_cursor_in_pcm_frames(&m_snd_data_source, &cursor);
-        return cursor;
+        m_cursor_frame.store(cursor, std::memory_order_relaxed);
+        return frames_read;
+    }
+
+    auto c_track::get_cursor_frame() -> std::uint64_t
+    {
+        // Published by the audio thread, the decoder itself is not safe to query from here
+        return m_cursor_frame.load(std::memory_order_relaxed);
     }
 
     auto c_track::set_looping(bool is_looping) -> void
     {
-        m_is_looping = is_looping;
+        m_is_looping.store(is_looping, std::memory_order_relaxed);
         ma_data_source_set_looping(&m_snd_data_source, is_looping ? MA_TRUE : MA_FALSE);
     }
 
     auto c_track::is_looping() const -> bool
     {
-        return m_is_looping;
+        return m_is_looping.load(std::memory_order_relaxed);
     }
 
     auto c_track::get_total_frames() -> std::uint64_t
@@ -309,6 +438,29 @@ namespace music
         return m_filename;
     }
 
+    auto c_track::get_path() const -> const std::filesystem::path &
+    {
+        return m_path;
+    }
+
+    auto c_track::peaks() const -> std::shared_ptr<const c_peak_pyramid>
+    {
+        return m_peaks ? m_peaks->result() : nullptr;
+    }
+
+    auto c_track::subscribe_tap() -> c_tap_subscription
+    {
+        return m_taps ? m_taps->subscribe() : c_tap_subscription{};
+    }
+
+    auto c_track::feed_taps(std::span<const float> samples) -> void
+    {
+        if (m_taps)
+        {
+            m_taps->feed(samples);
+        }
+    }
+
     auto c_track::data_ptr() -> ma_data_source *
     {
         return reinterpret_cast<ma_data_source *>(&m_snd_data_source);
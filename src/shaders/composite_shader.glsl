@@ -0,0 +1,35 @@
+#shader vertex
+#version 420 core
+
+// Attributeless: six vertices covering the composited area
+
+layout(std140, binding = 0) uniform u_frame
+{
+    mat4 projection;
+    vec4 viewport; // xy: origin, zw: size in pixels
+    vec4 time;     // x: seconds since start, y: frame delta
+};
+
+uniform vec4 u_area; // xy: origin, zw: size of the area in pixels
+
+out vec2 v_uv;
+
+const vec2 corners[6] = vec2[](vec2(0, 0), vec2(1, 0), vec2(1, 1), vec2(1, 1), vec2(0, 1), vec2(0, 0));
+
+void main() {
+    v_uv = corners[gl_VertexID];
+    gl_Position = projection * vec4(u_area.xy + u_area.zw * v_uv, 0.0, 1.0);
+}
+
+#shader fragment
+#version 420 core
+
+in vec2 v_uv;
+
+out vec4 color;
+
+uniform sampler2D u_texture; // Premultiplied alpha
+
+void main() {
+    color = texture(u_texture, v_uv);
+}
@@ -3,7 +3,12 @@
 
 layout(location = 0) in vec2 aPos;
 
-uniform mat4 projection;
+layout(std140, binding = 0) uniform u_frame
+{
+    mat4 projection;
+    vec4 viewport; // xy: origin, zw: size in pixels
+    vec4 time;     // x: seconds since start, y: frame delta
+};
 uniform vec2 u_panel_size;
 uniform vec2 u_panel_pos;
 
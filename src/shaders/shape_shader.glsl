@@ -4,7 +4,12 @@
 layout(location = 0) in vec3 aPos;
 layout(location = 1) in vec4 aColor;
 
-uniform mat4 projection;
+layout(std140, binding = 0) uniform u_frame
+{
+    mat4 projection;
+    vec4 viewport; // xy: origin, zw: size in pixels
+    vec4 time;     // x: seconds since start, y: frame delta
+};
 
 out vec4 vertexColor;
 
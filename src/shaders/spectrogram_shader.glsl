@@ -0,0 +1,48 @@
+#shader vertex
+#version 420 core
+
+// Attributeless: six vertices covering the content area
+
+layout(std140, binding = 0) uniform u_frame
+{
+    mat4 projection;
+    vec4 viewport; // xy: origin, zw: size in pixels
+    vec4 time;     // x: seconds since start, y: frame delta
+};
+
+uniform vec4 u_area; // xy: origin, zw: size of the drawing area in pixels
+
+out vec2 v_uv;
+
+const vec2 corners[6] = vec2[](vec2(0, 0), vec2(1, 0), vec2(1, 1), vec2(1, 1), vec2(0, 1), vec2(0, 0));
+
+void main() {
+    v_uv = corners[gl_VertexID];
+    gl_Position = projection * vec4(u_area.xy + u_area.zw * v_uv, 0.0, 1.0);
+}
+
+#shader fragment
+#version 420 core
+
+in vec2 v_uv;
+
+out vec4 color;
+
+uniform sampler2D u_history;  // Ring of columns (time) by rows (frequency bands)
+uniform sampler1D u_colormap; // Colour by magnitude, linearly filtered
+uniform float u_offset;       // Oldest column, normalized to [0, 1)
+
+vec3 colormap(float value)
+{
+    // Sampled at texel centres, so 0 and 1 take the first and last entry of the map
+    float entries = float(textureSize(u_colormap, 0));
+    return texture(u_colormap, (clamp(value, 0.0, 1.0) * (entries - 1.0) + 0.5) / entries).rgb;
+}
+
+void main() {
+    // The texture repeats horizontally, so scrolling is only an offset; clamp vertically to avoid bleeding between the
+    // lowest and highest band
+    float half_texel = 0.5 / float(textureSize(u_history, 0).y);
+    vec2 uv = vec2(v_uv.x + u_offset, clamp(v_uv.y, half_texel, 1.0 - half_texel));
+    color = vec4(colormap(texture(u_history, uv).r), 1.0);
+}
@@ -0,0 +1,80 @@
+#shader vertex
+#version 420 core
+
+// Attributeless: one instance per band, six vertices forming the quad that covers the band's bar and cap
+
+layout(std140, binding = 0) uniform u_frame
+{
+    mat4 projection;
+    vec4 viewport; // xy: origin, zw: size in pixels
+    vec4 time;     // x: seconds since start, y: frame delta
+};
+
+uniform sampler1D u_bands;    // Smoothed, normalized band intensities
+uniform sampler1D u_colormap; // Bar colour by intensity, linearly filtered
+uniform int u_band_count;
+uniform vec4 u_area; // xy: origin, zw: size of the drawing area in pixels
+
+out vec2 v_pixel;                 // Fragment position in pixels
+flat out vec4 v_color;            // Bar colour
+flat out vec4 v_bar;              // xy: bottom-left, zw: size of the bar
+flat out vec3 v_cap;              // xy: center, z: radius of the cap
+
+const vec2 corners[6] = vec2[](vec2(0, 0), vec2(1, 0), vec2(1, 1), vec2(1, 1), vec2(0, 1), vec2(0, 0));
+
+void main() {
+    float value = texelFetch(u_bands, gl_InstanceID, 0).r;
+
+    float cell_width = u_area.z * 0.95 / float(u_band_count);
+    float x_base = u_area.x + u_area.z * 0.025 + cell_width * float(gl_InstanceID);
+    float y_base = u_area.y + u_area.w * 0.025;
+    float height = u_area.w * 0.95 * value * 0.9;
+    float radius = sqrt(value) * 18.0 * 0.9;
+    float max_width = cell_width * 0.75;
+    float min_width = cell_width * 0.15;
+    float bar_width = min_width + (max_width - min_width) * (1.0 - value);
+    float center_x = x_base + cell_width * 0.5;
+
+    // Sampled at texel centres, so 0 and 1 take the first and last entry of the map
+    float entries = float(textureSize(u_colormap, 0));
+    v_color = texture(u_colormap, (value * (entries - 1.0) + 0.5) / entries);
+    v_bar = vec4(center_x - bar_width * 0.5, y_base, bar_width, height);
+    v_cap = vec3(center_x, y_base + height, radius);
+
+    // Pad by a pixel so the anti-aliased edge is not clipped
+    float half_width = max(bar_width * 0.5, radius) + 1.0;
+    vec2 low = vec2(center_x - half_width, y_base - 1.0);
+    vec2 high = vec2(center_x + half_width, y_base + height + radius + 1.0);
+
+    v_pixel = mix(low, high, corners[gl_VertexID]);
+    gl_Position = projection * vec4(v_pixel, 0.0, 1.0);
+}
+
+#shader fragment
+#version 420 core
+
+in vec2 v_pixel;
+flat in vec4 v_color;
+flat in vec4 v_bar;
+flat in vec3 v_cap;
+
+out vec4 color;
+
+float box_sdf(vec2 p, vec2 center, vec2 half_size)
+{
+    vec2 d = abs(p - center) - half_size;
+    return length(max(d, 0.0)) + min(max(d.x, d.y), 0.0);
+}
+
+void main() {
+    float bar = box_sdf(v_pixel, v_bar.xy + v_bar.zw * 0.5, v_bar.zw * 0.5);
+    float cap = length(v_pixel - v_cap.xy) - v_cap.z;
+    float dist = min(bar, cap);
+
+    float alpha = clamp(0.5 - dist, 0.0, 1.0);
+    if (alpha <= 0.0)
+    {
+        discard;
+    }
+    color = vec4(v_color.rgb, alpha);
+}
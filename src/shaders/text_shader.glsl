@@ -4,7 +4,12 @@
 layout(location = 0) in vec2 aPos;  // Vertex position (x, y)
 layout(location = 1) in vec2 aTexCoord; // Texture coordinates (u, v)
 
-uniform mat4 projection;
+layout(std140, binding = 0) uniform u_frame
+{
+    mat4 projection;
+    vec4 viewport; // xy: origin, zw: size in pixels
+    vec4 time;     // x: seconds since start, y: frame delta
+};
 
 out vec2 TexCoord; // Output texture coordinates for fragment shader
 
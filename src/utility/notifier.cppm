@@ -1,68 +1,362 @@
 module;
+#include <atomic>
+#include <concepts>
+#include <cstddef>
 #include <functional>
-#include <mutex>
-#include <queue>
+#include <new>
+#include <type_traits>
 #include <utility>
 export module utility:notifier;
 
 export namespace utility
 {
-    class c_notifier
+    /**
+     * @brief Move-only void() callable that stores small callables inline instead of on the heap.
+     *
+     * Callables up to s_inline_size bytes that move without throwing are kept in the object itself, which covers
+     * lambdas capturing a few references or pointers. Larger ones are allocated.
+     */
+    class c_callback
+    {
+    public:
+        static constexpr std::size_t s_inline_size = 6 * sizeof(void *);
+
+        c_callback() noexcept = default;
+
+        template <typename F>
+            requires(not std::same_as<std::remove_cvref_t<F>, c_callback> and std::invocable<std::decay_t<F> &>)
+        c_callback(F &&callable); // NOLINT(google-explicit-constructor): Converts like std::function
+
+        ~c_callback();
+
+        c_callback(const c_callback &) = delete;
+        c_callback(c_callback &&other) noexcept;
+        auto operator=(const c_callback &) -> c_callback & = delete;
+        auto operator=(c_callback &&other) noexcept -> c_callback &;
+
+        auto operator()() -> void;
+        explicit operator bool() const noexcept;
+
+        /**
+         * @brief Destroy the held callable, leaving the callback empty.
+         */
+        auto reset() noexcept -> void;
+
+    private:
+        struct s_operations
+        {
+            void (*invoke)(void *storage);
+            void (*move)(void *from, void *to) noexcept; // Move-constructs into to and destroys from
+            void (*destroy)(void *storage) noexcept;
+        };
+
+        template <typename F>
+        static constexpr bool s_is_inline = sizeof(F) <= s_inline_size and alignof(F) <= alignof(std::max_align_t) and std::is_nothrow_move_constructible_v<F>;
+
+        template <typename F>
+        static constexpr s_operations s_inline_operations = {
+            .invoke = [](void *storage)
+            { std::invoke(*static_cast<F *>(storage)); },
+            .move = [](void *from, void *to) noexcept
+            {
+                ::new (to) F(std::move(*static_cast<F *>(from)));
+                static_cast<F *>(from)->~F();
+            },
+            .destroy = [](void *storage) noexcept
+            { static_cast<F *>(storage)->~F(); },
+        };
+
+        // The storage holds the pointer to the heap object
+        template <typename F>
+        static constexpr s_operations s_heap_operations = {
+            .invoke = [](void *storage)
+            { std::invoke(**static_cast<F **>(storage)); },
+            .move = [](void *from, void *to) noexcept
+            { ::new (to) F *(*static_cast<F **>(from)); },
+            .destroy = [](void *storage) noexcept
+            { delete *static_cast<F **>(storage); },
+        };
+
+        alignas(std::max_align_t) std::byte m_storage[s_inline_size]{};
+        const s_operations *m_operations{};
+    };
+
+    /**
+     * @brief One-shot notification: callbacks subscribed before notify() run then, later ones run at once.
+     *
+     * Subscribing is lock-free and safe from any thread: the callback is pushed onto an intrusive list with a single
+     * compare-and-swap. notify() takes the whole list with one exchange and runs it in subscription order. Nodes are
+     * recycled through a cache of the thread that ran them, so a thread that both subscribes and notifies stops
+     * allocating once warmed up. Channels are independent of each other.
+     */
+    class c_notifier_channel
     {
     public:
-        static void subscribe(std::function<void()> callback);
-        static void notify();
-        static void reset() noexcept;
+        c_notifier_channel() = default;
+        ~c_notifier_channel();
+
+        c_notifier_channel(const c_notifier_channel &) = delete;
+        c_notifier_channel(c_notifier_channel &&) = delete;
+        auto operator=(const c_notifier_channel &) -> c_notifier_channel & = delete;
+        auto operator=(c_notifier_channel &&) -> c_notifier_channel & = delete;
+
+        auto subscribe(c_callback callback) -> void;
+        auto notify() -> void;
+
+        /**
+         * @brief Drop pending callbacks and return to the not notified state.
+         */
+        auto reset() noexcept -> void;
+
+        [[nodiscard]] auto is_notified() const noexcept -> bool;
 
     private:
-        inline static std::mutex s_mutex;
-        inline static std::queue<std::function<void()>> s_subscribers;
-        inline static bool s_is_notified;
+        struct s_node;
+
+        std::atomic<s_node *> m_head{}; // Newest subscription first
+        std::atomic<bool> m_is_notified{};
+
+        auto run_pending() -> void;
+    };
+
+    /**
+     * @brief Process-wide notification channel, kept for the callers of the static interface.
+     */
+    class c_notifier
+    {
+    public:
+        static auto subscribe(c_callback callback) -> void;
+        static auto notify() -> void;
+        static auto reset() noexcept -> void;
+
+        static auto channel() -> c_notifier_channel &;
     };
 } // namespace utility
 
 // Implementation
 namespace utility
 {
-    void c_notifier::subscribe(std::function<void()> callback)
+    template <typename F>
+        requires(not std::same_as<std::remove_cvref_t<F>, c_callback> and std::invocable<std::decay_t<F> &>)
+    c_callback::c_callback(F &&callable)
     {
-        bool notified = false;
+        using t_callable = std::decay_t<F>;
+        if constexpr (s_is_inline<t_callable>)
         {
-            std::scoped_lock lock(s_mutex);
-            notified = s_is_notified;
+            ::new (static_cast<void *>(m_storage)) t_callable(std::forward<F>(callable));
+            m_operations = &s_inline_operations<t_callable>;
         }
-        if (notified)
+        else
         {
-            callback();
+            ::new (static_cast<void *>(m_storage)) t_callable *(new t_callable(std::forward<F>(callable)));
+            m_operations = &s_heap_operations<t_callable>;
         }
-        else
+    }
+
+    c_callback::~c_callback()
+    {
+        reset();
+    }
+
+    c_callback::c_callback(c_callback &&other) noexcept
+        : m_operations(std::exchange(other.m_operations, nullptr))
+    {
+        if (m_operations != nullptr)
+        {
+            m_operations->move(other.m_storage, m_storage);
+        }
+    }
+
+    auto c_callback::operator=(c_callback &&other) noexcept -> c_callback &
+    {
+        if (this != &other)
+        {
+            reset();
+            m_operations = std::exchange(other.m_operations, nullptr);
+            if (m_operations != nullptr)
+            {
+                m_operations->move(other.m_storage, m_storage);
+            }
+        }
+        return *this;
+    }
+
+    auto c_callback::operator()() -> void
+    {
+        if (m_operations == nullptr)
+        {
+            throw std::bad_function_call();
+        }
+        m_operations->invoke(m_storage);
+    }
+
+    c_callback::operator bool() const noexcept
+    {
+        return m_operations != nullptr;
+    }
+
+    auto c_callback::reset() noexcept -> void
+    {
+        if (m_operations != nullptr)
+        {
+            std::exchange(m_operations, nullptr)->destroy(m_storage);
+        }
+    }
+
+    struct c_notifier_channel::s_node
+    {
+        s_node *next{};
+        c_callback callback;
+    };
+
+    namespace
+    {
+        /**
+         * @brief Spent nodes of one thread, reused by its next subscriptions to any channel.
+         */
+        template <typename T>
+        class c_node_cache
         {
-            std::scoped_lock lock(s_mutex);
-            s_subscribers.push(std::move(callback));
+        public:
+            static constexpr std::size_t s_capacity = 1024;
+
+            c_node_cache() = default;
+            ~c_node_cache()
+            {
+                while (m_head != nullptr)
+                {
+                    delete std::exchange(m_head, m_head->next);
+                }
+            }
+            c_node_cache(const c_node_cache &) = delete;
+            c_node_cache(c_node_cache &&) = delete;
+            auto operator=(const c_node_cache &) -> c_node_cache & = delete;
+            auto operator=(c_node_cache &&) -> c_node_cache & = delete;
+
+            auto acquire() -> T *
+            {
+                if (m_head == nullptr)
+                {
+                    return new T;
+                }
+                --m_size;
+                return std::exchange(m_head, m_head->next);
+            }
+
+            auto release(T *node) noexcept -> void
+            {
+                node->callback.reset();
+                if (m_size == s_capacity)
+                {
+                    delete node;
+                    return;
+                }
+                ++m_size;
+                node->next = m_head;
+                m_head = node;
+            }
+
+        private:
+            T *m_head{};
+            std::size_t m_size{};
+        };
+
+        template <typename T>
+        auto node_cache() -> c_node_cache<T> &
+        {
+            thread_local c_node_cache<T> cache;
+            return cache;
         }
+    } // namespace
+
+    c_notifier_channel::~c_notifier_channel()
+    {
+        reset();
     }
 
-    void c_notifier::notify()
+    auto c_notifier_channel::subscribe(c_callback callback) -> void
     {
-        std::queue<std::function<void()>> current;
+        if (m_is_notified.load())
+        {
+            callback();
+            return;
+        }
+
+        auto *node = node_cache<s_node>().acquire();
+        node->callback = std::move(callback);
+        node->next = m_head.load(std::memory_order_relaxed);
+        while (not m_head.compare_exchange_weak(node->next, node))
+        {
+        }
+
+        // notify() may have taken the list before the push; both sides are sequentially consistent, so then the flag
+        // is seen here and the callback does not wait for another notification
+        if (m_is_notified.load())
         {
-            std::scoped_lock lock(s_mutex);
-            std::swap(current, s_subscribers);
-            s_is_notified = true;
+            run_pending();
         }
-        while (not current.empty())
+    }
+
+    auto c_notifier_channel::notify() -> void
+    {
+        m_is_notified.store(true);
+        run_pending();
+    }
+
+    auto c_notifier_channel::reset() noexcept -> void
+    {
+        m_is_notified.store(false);
+        auto *node = m_head.exchange(nullptr);
+        while (node != nullptr)
         {
-            current.front()();
-            current.pop();
+            // Not into the node cache: the static channel is reset after the thread locals of its thread are gone
+            delete std::exchange(node, node->next);
         }
     }
-    void c_notifier::reset() noexcept
+
+    auto c_notifier_channel::is_notified() const noexcept -> bool
+    {
+        return m_is_notified.load();
+    }
+
+    auto c_notifier_channel::run_pending() -> void
     {
-        std::lock_guard lock(s_mutex);
-        while (not s_subscribers.empty())
+        // The list is newest first; reversed, callbacks run in subscription order
+        s_node *pending = nullptr;
+        auto *node = m_head.exchange(nullptr);
+        while (node != nullptr)
+        {
+            auto *next = node->next;
+            node->next = pending;
+            pending = node;
+            node = next;
+        }
+        while (pending != nullptr)
         {
-            s_subscribers.pop();
+            node = std::exchange(pending, pending->next);
+            node->callback();
+            node_cache<s_node>().release(node);
         }
-        s_is_notified = false;
+    }
+
+    auto c_notifier::subscribe(c_callback callback) -> void
+    {
+        channel().subscribe(std::move(callback));
+    }
+
+    auto c_notifier::notify() -> void
+    {
+        channel().notify();
+    }
+
+    auto c_notifier::reset() noexcept -> void
+    {
+        channel().reset();
+    }
+
+    auto c_notifier::channel() -> c_notifier_channel &
+    {
+        static c_notifier_channel channel;
+        return channel;
     }
 } // namespace utility
@@ -0,0 +1,423 @@
+module;
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+export module utility:profiler;
+
+export namespace utility
+{
+#ifdef SPECTRA_PROFILE
+    inline constexpr bool profiling_enabled = true;
+#else
+    inline constexpr bool profiling_enabled = false; // Zones compile to nothing, configure with SPECTRA_PROFILE=ON
+#endif
+
+    /**
+     * @brief Scoped-zone profiler with a Chrome trace event export, viewable in chrome://tracing or Perfetto.
+     *
+     * Every thread records into its own ring buffer, so recording takes no lock: it is a clock read at each end of the
+     * zone and three stores. Rings are allocated when a thread registers with name_thread(). A thread that must not
+     * allocate, such as an audio callback, gets one reserved ahead by reserve_thread() on another thread; the first
+     * unregistered thread to record a zone takes it. Until a thread has a ring its zones are dropped, and so are zones
+     * whose name could not be registered without waiting: recording never waits for the registry lock.
+     *
+     * The rings keep the newest s_events_per_thread zones each; the export copies them while threads keep recording,
+     * leaves out the zones overwritten in the meantime, and formats the copy after releasing the lock.
+     *
+     * The profiler itself always works; SPECTRA_PROFILE only decides whether c_profile_zone records anything.
+     */
+    class c_profiler
+    {
+    public:
+        static constexpr std::size_t s_events_per_thread = std::size_t{ 1 } << 16;
+        static constexpr std::size_t s_max_zones = 1024;
+        static constexpr std::uint32_t s_no_zone = std::numeric_limits<std::uint32_t>::max(); // Recorded zones are dropped
+
+        static auto instance() -> c_profiler &;
+
+        /**
+         * @brief Identifier of a zone name, the same one for every call with that name; s_no_zone once s_max_zones
+         * names are registered. The name is copied.
+         */
+        auto register_zone(std::string_view name) -> std::uint32_t;
+
+        /**
+         * @brief As register_zone(), for a name that outlives the profiler. Never waits or allocates, so it returns
+         * s_no_zone while another thread holds the registry; try again later.
+         */
+        auto try_register_zone(std::string_view static_name) -> std::uint32_t;
+
+        /**
+         * @brief Name shown for the calling thread in the trace. Registers the thread and allocates its ring.
+         */
+        auto name_thread(std::string_view name) -> void;
+
+        /**
+         * @brief Allocate a named ring for a thread that cannot register itself without allocating, such as an audio
+         * callback. The first unregistered thread to record a zone takes it.
+         */
+        auto reserve_thread(std::string_view name) -> void;
+
+        /**
+         * @brief Record a zone of the calling thread, times in nanoseconds since the profiler was created. Dropped if
+         * the thread has no ring.
+         */
+        auto record(std::uint32_t zone, std::int64_t begin, std::int64_t end) -> void;
+
+        [[nodiscard]] auto now() const -> std::int64_t;
+
+        /**
+         * @brief Write every recorded zone as Chrome trace event JSON.
+         */
+        auto write_chrome_trace(std::ostream &stream) -> void;
+        auto write_chrome_trace(const std::filesystem::path &path) -> bool;
+
+    private:
+        struct s_event
+        {
+            std::atomic<std::uint32_t> zone;
+            std::atomic<std::int64_t> begin;
+            std::atomic<std::int64_t> end;
+        };
+
+        struct s_thread_events
+        {
+            std::uint32_t thread_id{};
+            std::string name;
+            std::unique_ptr<s_event[]> events = std::make_unique<s_event[]>(s_events_per_thread);
+            std::atomic<std::uint64_t> written{};
+            bool is_taken{}; // Guarded by m_mutex, false while reserved for a thread to come
+        };
+
+        c_profiler();
+
+        static auto current_thread() -> s_thread_events *&;
+        auto thread_events() -> s_thread_events *;
+        auto find_zone(std::string_view name) const -> std::uint32_t;
+
+        std::chrono::steady_clock::time_point m_epoch = std::chrono::steady_clock::now();
+        std::mutex m_mutex;
+        std::vector<std::string_view> m_zone_names; // Reserved for s_max_zones, so registering does not allocate
+        std::deque<std::string> m_owned_zone_names;  // Copies made by register_zone(), stable for the views
+        std::vector<std::shared_ptr<s_thread_events>> m_threads; // Kept after their threads exit, for the export
+    };
+
+    /**
+     * @brief Identifier of a zone name known at compile time, registered on first use.
+     */
+    template <std::size_t N>
+    struct s_zone_name
+    {
+        constexpr s_zone_name(const char (&name)[N])
+        {
+            std::copy_n(name, N, value);
+        }
+        char value[N]{};
+    };
+
+    template <s_zone_name name>
+    auto zone_id() -> std::uint32_t
+    {
+        if constexpr (profiling_enabled)
+        {
+            // Retried on the next use while the registry is busy, the calling thread may be real-time
+            static std::atomic<std::uint32_t> id{ c_profiler::s_no_zone };
+            auto current = id.load(std::memory_order_relaxed);
+            if (current == c_profiler::s_no_zone)
+            {
+                current = c_profiler::instance().try_register_zone(name.value);
+                id.store(current, std::memory_order_relaxed);
+            }
+            return current;
+        }
+        else
+        {
+            return 0;
+        }
+    }
+
+    /**
+     * @brief Records the time from its construction to its destruction under a zone.
+     *
+     * Usage: utility::c_profile_zone zone(utility::zone_id<"fft">());
+     */
+    class c_profile_zone
+    {
+    public:
+        explicit c_profile_zone(std::uint32_t zone) noexcept
+        {
+            if constexpr (profiling_enabled)
+            {
+                m_zone = zone;
+                m_begin = c_profiler::instance().now();
+            }
+        }
+        ~c_profile_zone()
+        {
+            if constexpr (profiling_enabled)
+            {
+                auto &profiler = c_profiler::instance();
+                profiler.record(m_zone, m_begin, profiler.now());
+            }
+        }
+
+        c_profile_zone(const c_profile_zone &) = delete;
+        c_profile_zone(c_profile_zone &&) = delete;
+        auto operator=(const c_profile_zone &) -> c_profile_zone & = delete;
+        auto operator=(c_profile_zone &&) -> c_profile_zone & = delete;
+
+    private:
+        std::uint32_t m_zone{};
+        std::int64_t m_begin{};
+    };
+} // namespace utility
+
+// Implementation
+namespace utility
+{
+    namespace
+    {
+        auto escape_json(std::string_view text) -> std::string
+        {
+            std::string escaped;
+            escaped.reserve(text.size());
+            for (char character : text)
+            {
+                if (character == '"' or character == '\\')
+                {
+                    escaped += '\\';
+                    escaped += character;
+                }
+                else if (static_cast<unsigned char>(character) < 0x20)
+                {
+                    escaped += std::format("\\u{:04x}", static_cast<unsigned>(character));
+                }
+                else
+                {
+                    escaped += character;
+                }
+            }
+            return escaped;
+        }
+    } // namespace
+
+    c_profiler::c_profiler()
+    {
+        m_zone_names.reserve(s_max_zones);
+    }
+
+    auto c_profiler::instance() -> c_profiler &
+    {
+        static c_profiler profiler;
+        return profiler;
+    }
+
+    auto c_profiler::find_zone(std::string_view name) const -> std::uint32_t
+    {
+        auto found = std::ranges::find(m_zone_names, name);
+        return found != m_zone_names.end() ? static_cast<std::uint32_t>(found - m_zone_names.begin()) : s_no_zone;
+    }
+
+    auto c_profiler::register_zone(std::string_view name) -> std::uint32_t
+    {
+        std::scoped_lock lock(m_mutex);
+        if (auto zone = find_zone(name); zone != s_no_zone or m_zone_names.size() == s_max_zones)
+        {
+            return zone;
+        }
+        m_zone_names.emplace_back(m_owned_zone_names.emplace_back(name));
+        return static_cast<std::uint32_t>(m_zone_names.size() - 1);
+    }
+
+    auto c_profiler::try_register_zone(std::string_view static_name) -> std::uint32_t
+    {
+        std::unique_lock lock(m_mutex, std::try_to_lock);
+        if (not lock)
+        {
+            return s_no_zone;
+        }
+        if (auto zone = find_zone(static_name); zone != s_no_zone or m_zone_names.size() == s_max_zones)
+        {
+            return zone;
+        }
+        m_zone_names.push_back(static_name);
+        return static_cast<std::uint32_t>(m_zone_names.size() - 1);
+    }
+
+    auto c_profiler::name_thread(std::string_view name) -> void
+    {
+        auto *&current = current_thread();
+        auto events = current == nullptr ? std::make_shared<s_thread_events>() : nullptr;
+
+        std::scoped_lock lock(m_mutex);
+        if (events)
+        {
+            events->thread_id = static_cast<std::uint32_t>(m_threads.size());
+            events->is_taken = true;
+            m_threads.push_back(events);
+            current = events.get();
+        }
+        current->name = name;
+    }
+
+    auto c_profiler::reserve_thread(std::string_view name) -> void
+    {
+        auto events = std::make_shared<s_thread_events>();
+        events->name = name;
+
+        std::scoped_lock lock(m_mutex);
+        events->thread_id = static_cast<std::uint32_t>(m_threads.size());
+        m_threads.push_back(std::move(events));
+    }
+
+    auto c_profiler::now() const -> std::int64_t
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_epoch).count();
+    }
+
+    auto c_profiler::record(std::uint32_t zone, std::int64_t begin, std::int64_t end) -> void
+    {
+        auto *events = thread_events();
+        if (events == nullptr or zone == s_no_zone)
+        {
+            return;
+        }
+        auto index = events->written.load(std::memory_order_relaxed);
+        auto &event = events->events[index % s_events_per_thread];
+
+        // Orders the slot stores after the count that covers the zone they overwrite, see write_chrome_trace()
+        std::atomic_thread_fence(std::memory_order_release);
+        event.zone.store(zone, std::memory_order_relaxed);
+        event.begin.store(begin, std::memory_order_relaxed);
+        event.end.store(end, std::memory_order_relaxed);
+        events->written.store(index + 1, std::memory_order_release);
+    }
+
+    auto c_profiler::current_thread() -> s_thread_events *&
+    {
+        thread_local s_thread_events *current = nullptr;
+        return current;
+    }
+
+    auto c_profiler::thread_events() -> s_thread_events *
+    {
+        auto *&current = current_thread();
+        if (current != nullptr)
+        {
+            return current;
+        }
+
+        // Only a reserved ring can be taken without allocating; try again on the next zone if the registry is busy
+        std::unique_lock lock(m_mutex, std::try_to_lock);
+        if (not lock)
+        {
+            return nullptr;
+        }
+        auto reserved = std::ranges::find_if(m_threads, [](const std::shared_ptr<s_thread_events> &thread)
+                                             { return not thread->is_taken; });
+        if (reserved != m_threads.end())
+        {
+            (*reserved)->is_taken = true;
+            current = reserved->get();
+        }
+        return current;
+    }
+
+    auto c_profiler::write_chrome_trace(std::ostream &stream) -> void
+    {
+        struct s_copy
+        {
+            std::uint32_t zone;
+            std::int64_t begin;
+            std::int64_t end;
+        };
+
+        struct s_thread_copy
+        {
+            std::uint32_t thread_id;
+            std::string name;
+            std::vector<s_copy> events;
+        };
+
+        // Copied under the lock, formatted and written after it, so registering threads only wait for the copy
+        std::vector<std::string_view> zone_names;
+        std::vector<s_thread_copy> threads;
+        {
+            std::scoped_lock lock(m_mutex);
+            zone_names = m_zone_names;
+            threads.reserve(m_threads.size());
+            for (const auto &thread : m_threads)
+            {
+                threads.push_back({ .thread_id = thread->thread_id, .name = thread->name, .events = {} });
+                auto &copy = threads.back();
+
+                auto written = thread->written.load(std::memory_order_acquire);
+                auto first = written > s_events_per_thread ? written - s_events_per_thread : 0;
+                copy.events.reserve(written - first);
+                for (auto index = first; index < written; ++index)
+                {
+                    const auto &event = thread->events[index % s_events_per_thread];
+                    copy.events.push_back({ event.zone.load(std::memory_order_relaxed), event.begin.load(std::memory_order_relaxed), event.end.load(std::memory_order_relaxed) });
+                }
+
+                // A slot read while its thread wrapped around onto it may be torn; the count read after the copy
+                // tells which slots that could be, everything older than one ring behind it
+                std::atomic_thread_fence(std::memory_order_acquire);
+                auto written_after = thread->written.load(std::memory_order_relaxed);
+                auto valid_from = written_after >= s_events_per_thread ? written_after - s_events_per_thread + 1 : 0;
+                copy.events.erase(copy.events.begin(), copy.events.begin() + static_cast<std::ptrdiff_t>(std::min(written, std::max(first, valid_from)) - first));
+            }
+        }
+
+        stream << R"({"displayTimeUnit":"ms","traceEvents":[)";
+        bool is_first = true;
+        auto separator = [&is_first]
+        {
+            auto text = is_first ? "\n" : ",\n";
+            is_first = false;
+            return text;
+        };
+        for (const auto &thread : threads)
+        {
+            stream << separator() << std::format(R"({{"name":"thread_name","ph":"M","pid":1,"tid":{},"args":{{"name":"{}"}}}})", thread.thread_id, escape_json(thread.name));
+            for (const auto &copy : thread.events)
+            {
+                if (copy.zone >= zone_names.size())
+                {
+                    continue;
+                }
+                stream << separator()
+                       << std::format(R"({{"name":"{}","cat":"spectra","ph":"X","ts":{:.3f},"dur":{:.3f},"pid":1,"tid":{}}})",
+                                      escape_json(zone_names[copy.zone]),
+                                      static_cast<double>(copy.begin) / 1000.,
+                                      static_cast<double>(copy.end - copy.begin) / 1000.,
+                                      thread.thread_id);
+            }
+        }
+        stream << "\n]}\n";
+    }
+
+    auto c_profiler::write_chrome_trace(const std::filesystem::path &path) -> bool
+    {
+        std::ofstream file(path);
+        if (not file)
+        {
+            return false;
+        }
+        write_chrome_trace(file);
+        return static_cast<bool>(file);
+    }
+} // namespace utility
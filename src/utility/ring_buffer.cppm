@@ -0,0 +1,132 @@
+module;
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <span>
+#include <type_traits>
+#include <vector>
+export module utility:ring_buffer;
+
+export namespace utility
+{
+    /**
+     * @brief Bounded single-producer single-consumer queue of trivially copyable values.
+     *
+     * push() and pop() are wait-free and never allocate, so either side may be a real-time thread. A full ring keeps
+     * its contents and drops what does not fit, since only the consumer may advance the read position.
+     */
+    template <typename T>
+        requires std::is_trivially_copyable_v<T>
+    class c_spsc_ring
+    {
+    public:
+        /**
+         * @brief Capacity is rounded up to a power of two.
+         */
+        explicit c_spsc_ring(std::size_t capacity);
+
+        /**
+         * @brief Producer side. Returns how many values were queued.
+         */
+        auto push(std::span<const T> values) -> std::size_t;
+
+        /**
+         * @brief Consumer side. Returns how many values were copied out, oldest first.
+         */
+        auto pop(std::span<T> values) -> std::size_t;
+
+        /**
+         * @brief Consumer side. Drops everything queued so far, returns how many values were dropped.
+         */
+        auto discard() -> std::size_t;
+
+        /**
+         * @brief Values queued; exact only when called from the producer or consumer while the other side is idle.
+         */
+        [[nodiscard]] auto size() const -> std::size_t;
+        [[nodiscard]] auto capacity() const noexcept -> std::size_t;
+
+    private:
+        // Producer and consumer positions on separate cache lines, so they do not invalidate each other
+        static constexpr std::size_t s_cache_line = 64;
+
+        std::vector<T> m_buffer;
+        std::size_t m_mask;
+        alignas(s_cache_line) std::atomic<std::size_t> m_write{};
+        alignas(s_cache_line) std::atomic<std::size_t> m_read{};
+    };
+} // namespace utility
+
+// Implementation
+namespace utility
+{
+    template <typename T>
+        requires std::is_trivially_copyable_v<T>
+    c_spsc_ring<T>::c_spsc_ring(std::size_t capacity)
+        : m_buffer(std::bit_ceil(std::max<std::size_t>(capacity, 1))),
+          m_mask(m_buffer.size() - 1)
+    {
+    }
+
+    template <typename T>
+        requires std::is_trivially_copyable_v<T>
+    auto c_spsc_ring<T>::push(std::span<const T> values) -> std::size_t
+    {
+        // Positions only grow, the distance between them is the fill level even across wrap-around
+        auto write = m_write.load(std::memory_order_relaxed);
+        auto read = m_read.load(std::memory_order_acquire);
+        auto count = std::min(values.size(), capacity() - (write - read));
+
+        auto first = write & m_mask;
+        auto head = std::min(count, capacity() - first);
+        std::copy_n(values.data(), head, m_buffer.data() + first);
+        std::copy_n(values.data() + head, count - head, m_buffer.data());
+
+        m_write.store(write + count, std::memory_order_release);
+        return count;
+    }
+
+    template <typename T>
+        requires std::is_trivially_copyable_v<T>
+    auto c_spsc_ring<T>::pop(std::span<T> values) -> std::size_t
+    {
+        auto read = m_read.load(std::memory_order_relaxed);
+        auto write = m_write.load(std::memory_order_acquire);
+        auto count = std::min(values.size(), write - read);
+
+        auto first = read & m_mask;
+        auto head = std::min(count, capacity() - first);
+        std::copy_n(m_buffer.data() + first, head, values.data());
+        std::copy_n(m_buffer.data(), count - head, values.data() + head);
+
+        m_read.store(read + count, std::memory_order_release);
+        return count;
+    }
+
+    template <typename T>
+        requires std::is_trivially_copyable_v<T>
+    auto c_spsc_ring<T>::discard() -> std::size_t
+    {
+        auto read = m_read.load(std::memory_order_relaxed);
+        auto write = m_write.load(std::memory_order_acquire);
+        m_read.store(write, std::memory_order_release);
+        return write - read;
+    }
+
+    template <typename T>
+        requires std::is_trivially_copyable_v<T>
+    auto c_spsc_ring<T>::size() const -> std::size_t
+    {
+        auto read = m_read.load(std::memory_order_acquire);
+        auto write = m_write.load(std::memory_order_acquire);
+        return write - read;
+    }
+
+    template <typename T>
+        requires std::is_trivially_copyable_v<T>
+    auto c_spsc_ring<T>::capacity() const noexcept -> std::size_t
+    {
+        return m_buffer.size();
+    }
+} // namespace utility
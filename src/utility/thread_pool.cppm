@@ -0,0 +1,144 @@
+module;
+#include <algorithm>
+#include <concepts>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <queue>
+#include <stop_token>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+export module utility:thread_pool;
+
+export namespace utility
+{
+    /**
+     * @brief Fixed set of worker threads running submitted jobs in FIFO order.
+     *
+     * Meant for background work that must not stall the render loop (decoding, analysis, file IO). Jobs must not
+     * block waiting on other jobs of the same pool; split work into independent tasks instead.
+     */
+    class c_thread_pool
+    {
+    public:
+        explicit c_thread_pool(std::size_t thread_count = default_thread_count());
+        ~c_thread_pool();
+
+        c_thread_pool(const c_thread_pool &) = delete;
+        c_thread_pool(c_thread_pool &&) = delete;
+        auto operator=(const c_thread_pool &) -> c_thread_pool & = delete;
+        auto operator=(c_thread_pool &&) -> c_thread_pool & = delete;
+
+        /**
+         * @brief Shared pool for background jobs of the application.
+         */
+        static auto instance() -> c_thread_pool &;
+
+        /**
+         * @brief Queue a job. Its result, or the exception it throws, is delivered through the returned future.
+         */
+        template <typename F>
+            requires std::invocable<F>
+        auto submit(F &&job) -> std::future<std::invoke_result_t<F>>;
+
+        [[nodiscard]] auto thread_count() const noexcept -> std::size_t;
+        [[nodiscard]] auto pending() const -> std::size_t;
+
+        static auto default_thread_count() noexcept -> std::size_t;
+
+    private:
+        mutable std::mutex m_mutex;
+        std::condition_variable_any m_condition;
+        std::queue<std::move_only_function<void()>> m_jobs;
+        std::vector<std::jthread> m_workers; // Last member, so the workers stop before the queue is destroyed
+
+        auto worker_loop(std::stop_token stop_token) -> void;
+    };
+} // namespace utility
+
+// Implementation
+namespace utility
+{
+    c_thread_pool::c_thread_pool(std::size_t thread_count)
+    {
+        thread_count = std::max<std::size_t>(thread_count, 1);
+        m_workers.reserve(thread_count);
+        for (std::size_t i = 0; i < thread_count; ++i)
+        {
+            m_workers.emplace_back([this](std::stop_token stop_token)
+                                   { worker_loop(std::move(stop_token)); });
+        }
+    }
+
+    c_thread_pool::~c_thread_pool()
+    {
+        // Queued jobs that have not started are dropped, their futures report broken_promise
+        for (auto &worker : m_workers)
+        {
+            worker.request_stop();
+        }
+        m_condition.notify_all();
+        m_workers.clear();
+    }
+
+    auto c_thread_pool::instance() -> c_thread_pool &
+    {
+        static c_thread_pool instance;
+        return instance;
+    }
+
+    template <typename F>
+        requires std::invocable<F>
+    auto c_thread_pool::submit(F &&job) -> std::future<std::invoke_result_t<F>>
+    {
+        std::packaged_task<std::invoke_result_t<F>()> task(std::forward<F>(job));
+        auto future = task.get_future();
+        {
+            std::scoped_lock lock(m_mutex);
+            m_jobs.emplace(std::move(task));
+        }
+        m_condition.notify_one();
+        return future;
+    }
+
+    auto c_thread_pool::thread_count() const noexcept -> std::size_t
+    {
+        return m_workers.size();
+    }
+
+    auto c_thread_pool::pending() const -> std::size_t
+    {
+        std::scoped_lock lock(m_mutex);
+        return m_jobs.size();
+    }
+
+    auto c_thread_pool::default_thread_count() noexcept -> std::size_t
+    {
+        // Leave a core for the render and audio threads
+        auto hardware = static_cast<std::size_t>(std::thread::hardware_concurrency());
+        return std::max<std::size_t>(hardware, 2) - 1;
+    }
+
+    auto c_thread_pool::worker_loop(std::stop_token stop_token) -> void
+    {
+        while (true)
+        {
+            std::move_only_function<void()> job;
+            {
+                std::unique_lock lock(m_mutex);
+                if (not m_condition.wait(lock, stop_token, [this]()
+                                         { return not m_jobs.empty(); }))
+                {
+                    return;
+                }
+                job = std::move(m_jobs.front());
+                m_jobs.pop();
+            }
+            job();
+        }
+    }
+} // namespace utility
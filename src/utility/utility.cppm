@@ -3,3 +3,6 @@ module;
 export module utility;
 
 export import :notifier;
+export import :profiler;
+export import :ring_buffer;
+export import :thread_pool;
@@ -0,0 +1,151 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <thread>
+#include <vector>
+
+#include "temporary_wav.hpp"
+
+import music;
+
+namespace
+{
+    // The null device runs the callback on its own thread in real time, so the tests poll for its progress
+    template <typename P>
+    auto wait_until(P predicate) -> bool
+    {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds{ 10 };
+        while (not predicate())
+        {
+            if (std::chrono::steady_clock::now() > deadline)
+            {
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds{ 1 });
+        }
+        return true;
+    }
+
+    // Once the clock is past the frame, the period holding it has been rendered completely
+    auto wait_past(const music::c_audio_manager &manager, std::uint64_t frame) -> bool
+    {
+        return wait_until([&manager, frame]()
+                          { return manager.clock() > frame; });
+    }
+} // namespace
+
+TEST_CASE("Audio manager: Scheduled commands", "[music][audio][unit]")
+{
+    SECTION("One play command starts every track on the same frame")
+    {
+        support::c_temporary_wav first_file("spectra_audio_start_0.wav", 44100);
+        support::c_temporary_wav second_file("spectra_audio_start_1.wav", 44100);
+        music::c_audio_manager manager(music::e_audio_backend::null);
+        auto first = std::make_shared<music::c_track>(0, first_file.path(), music::e_peak_overview::none);
+        auto second = std::make_shared<music::c_track>(1, second_file.path(), music::e_peak_overview::none);
+        manager.add_track(first);
+        manager.add_track(second);
+
+        manager.play();
+        REQUIRE(wait_until([&first]()
+                           { return first->get_cursor_frame() > 0; }));
+
+        // Stopped together too, so any difference in the cursors is a difference in the start frame
+        auto stop = manager.clock() + 4410;
+        manager.pause(stop);
+        REQUIRE(wait_past(manager, stop));
+
+        REQUIRE_FALSE(first->is_playing());
+        REQUIRE(first->get_cursor_frame() == second->get_cursor_frame());
+    }
+
+    SECTION("A command inside a period splits the period at its frame")
+    {
+        support::c_temporary_wav file("spectra_audio_split.wav", 44100);
+        music::c_audio_manager manager(music::e_audio_backend::null);
+        auto track = std::make_shared<music::c_track>(0, file.path(), music::e_peak_overview::none);
+        manager.add_track(track);
+
+        // Far enough ahead to be queued before the device gets there, and off the usual period boundaries
+        auto start = manager.clock() + 4410 + 17;
+        auto stop = start + 2205 + 29;
+        REQUIRE(manager.schedule(std::array{
+            music::s_audio_command{ .kind = music::e_audio_command::start, .track_id = 0, .frame = start },
+            music::s_audio_command{ .kind = music::e_audio_command::stop, .track_id = 0, .frame = stop },
+        }));
+        REQUIRE(wait_past(manager, stop));
+
+        REQUIRE(track->get_cursor_frame() == stop - start);
+    }
+
+    SECTION("A batch larger than the free space is rejected whole")
+    {
+        support::c_temporary_wav file("spectra_audio_batch.wav", 44100);
+        music::c_audio_manager manager(music::e_audio_backend::null);
+        auto track = std::make_shared<music::c_track>(0, file.path(), music::e_peak_overview::none);
+        manager.add_track(track);
+
+        std::vector<music::s_audio_command> batch(music::c_audio_manager::s_command_capacity + 1,
+                                                  music::s_audio_command{ .kind = music::e_audio_command::start, .track_id = 0 });
+        REQUIRE_FALSE(manager.schedule(batch));
+
+        // Any part of the batch that was queued would have started the track by now
+        REQUIRE(wait_past(manager, manager.clock() + 4410));
+        REQUIRE_FALSE(track->is_playing());
+
+        REQUIRE(manager.schedule(std::span(batch).first(1)));
+        REQUIRE(wait_until([&track]()
+                           { return track->is_playing(); }));
+    }
+}
+
+TEST_CASE("Audio manager: Track snapshots", "[music][audio][unit]")
+{
+    SECTION("Retired snapshots are freed by auto_cleanup once the callback has moved on")
+    {
+        support::c_temporary_wav file("spectra_audio_retired.wav", 44100);
+        music::c_audio_manager manager(music::e_audio_backend::null);
+        auto track = std::make_shared<music::c_track>(0, file.path(), music::e_peak_overview::none);
+        auto other = std::make_shared<music::c_track>(1, file.path(), music::e_peak_overview::none);
+        manager.add_track(track);
+        manager.add_track(other);
+
+        // Held here, by the current snapshot and by the one the second add_track retired
+        REQUIRE(track.use_count() == 3);
+
+        // The callback never frees a snapshot, however many periods pass
+        REQUIRE(wait_past(manager, manager.clock() + 4410));
+        REQUIRE(track.use_count() == 3);
+
+        manager.auto_cleanup();
+        REQUIRE(track.use_count() == 2);
+    }
+
+    SECTION("A track nobody else owns is dropped from the snapshot")
+    {
+        support::c_temporary_wav file("spectra_audio_orphan.wav", 44100);
+        music::c_audio_manager manager(music::e_audio_backend::null);
+        auto owned = std::make_shared<music::c_track>(0, file.path(), music::e_peak_overview::none);
+        std::weak_ptr<music::c_track> orphan;
+        {
+            auto track = std::make_shared<music::c_track>(1, file.path(), music::e_peak_overview::none);
+            orphan = track;
+            manager.add_track(track);
+        }
+        manager.add_track(owned);
+
+        // The snapshot that still lists the orphan is retired, and freed by a later cleanup
+        REQUIRE(wait_past(manager, manager.clock() + 4410));
+        manager.auto_cleanup();
+        REQUIRE_FALSE(orphan.expired());
+
+        REQUIRE(wait_past(manager, manager.clock() + 4410));
+        manager.auto_cleanup();
+        REQUIRE(orphan.expired());
+        REQUIRE(owned.use_count() == 2);
+    }
+}
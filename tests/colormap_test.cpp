@@ -0,0 +1,132 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/matchers/catch_matchers_floating_point.hpp>
+
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <stdexcept>
+
+import math;
+import glm;
+
+using Catch::Matchers::WithinAbs;
+
+namespace
+{
+    auto near(const glm::vec4 &color, const glm::vec3 &expected, float tolerance) -> bool
+    {
+        return std::abs(color.r - expected.r) <= tolerance and std::abs(color.g - expected.g) <= tolerance and std::abs(color.b - expected.b) <= tolerance;
+    }
+} // namespace
+
+TEST_CASE("Colormap: Perceptual maps", "[math][colormap][unit]")
+{
+    SECTION("Ends match the matplotlib maps")
+    {
+        // Reference colours of matplotlib's tables, the fits stay within a few hundredths of them
+        math::c_colormap viridis(math::e_colormap::viridis);
+        REQUIRE(near(viridis.sample(0.F), { 0.267F, 0.005F, 0.329F }, 0.02F));
+        REQUIRE(near(viridis.sample(1.F), { 0.993F, 0.906F, 0.144F }, 0.02F));
+
+        math::c_colormap magma(math::e_colormap::magma);
+        REQUIRE(near(magma.sample(0.F), { 0.001F, 0.000F, 0.014F }, 0.02F));
+        REQUIRE(near(magma.sample(1.F), { 0.987F, 0.991F, 0.750F }, 0.02F));
+
+        math::c_colormap inferno(math::e_colormap::inferno);
+        REQUIRE(near(inferno.sample(0.F), { 0.001F, 0.000F, 0.014F }, 0.03F));
+        REQUIRE(near(inferno.sample(1.F), { 0.988F, 0.998F, 0.645F }, 0.02F));
+    }
+
+    SECTION("Entries are opaque and within range")
+    {
+        for (auto map : { math::e_colormap::viridis, math::e_colormap::magma, math::e_colormap::inferno })
+        {
+            math::c_colormap colormap(map, 1024);
+            REQUIRE(colormap.size() == 1024);
+            for (const auto &color : colormap.table())
+            {
+                REQUIRE(color.r >= 0.F);
+                REQUIRE(color.r <= 1.F);
+                REQUIRE(color.g >= 0.F);
+                REQUIRE(color.g <= 1.F);
+                REQUIRE(color.b >= 0.F);
+                REQUIRE(color.b <= 1.F);
+                REQUIRE(color.a == 1.F);
+            }
+        }
+    }
+
+    SECTION("Viridis brightens monotonically")
+    {
+        math::c_colormap viridis(math::e_colormap::viridis);
+        auto luminance = [](const glm::vec4 &color)
+        {
+            return (0.2126F * color.r) + (0.7152F * color.g) + (0.0722F * color.b);
+        };
+        for (std::size_t index = 1; index < viridis.size(); ++index)
+        {
+            REQUIRE(luminance(viridis.table()[index]) >= luminance(viridis.table()[index - 1]));
+        }
+    }
+}
+
+TEST_CASE("Colormap: HSV sweep", "[math][colormap][unit]")
+{
+    SECTION("Matches hsv_to_rgba at the table entries")
+    {
+        auto sweep = math::c_colormap::hsv_sweep(0.75F, 1.F);
+        for (std::size_t index = 0; index < sweep.size(); ++index)
+        {
+            auto t = static_cast<float>(index) / static_cast<float>(sweep.size() - 1);
+            auto expected = math::helpers::hsv_to_rgba({ t * 360.F, 0.75F, 1.F });
+            REQUIRE(near(sweep.sample(t), { expected.r, expected.g, expected.b }, 1e-5F));
+        }
+    }
+
+    SECTION("Between entries the nearest one is used")
+    {
+        // Neighbouring entries are 360 / 255 degrees apart, a hue step moves a channel by at most 6 / 255
+        auto sweep = math::c_colormap::hsv_sweep(1.F, 1.F);
+        for (float t = 0.F; t <= 1.F; t += 0.001F)
+        {
+            auto expected = math::helpers::hsv_to_rgba({ t * 360.F, 1.F, 1.F });
+            REQUIRE(near(sweep.sample(t), { expected.r, expected.g, expected.b }, 3.F / 255.F + 1e-4F));
+        }
+    }
+
+    SECTION("The full circle wraps back to red")
+    {
+        math::c_colormap hsv(math::e_colormap::hsv);
+        REQUIRE(near(hsv.sample(0.F), { 1.F, 0.F, 0.F }, 1e-5F));
+        REQUIRE(near(hsv.sample(1.F), { 1.F, 0.F, 0.F }, 1e-5F));
+    }
+}
+
+TEST_CASE("Colormap: Sampling", "[math][colormap][unit]")
+{
+    math::c_colormap colormap(math::e_colormap::viridis, 256);
+
+    SECTION("Values outside [0, 1] are clamped")
+    {
+        REQUIRE(&colormap.sample(-1.F) == &colormap.table().front());
+        REQUIRE(&colormap.sample(2.F) == &colormap.table().back());
+        REQUIRE(&colormap.sample(std::numeric_limits<float>::infinity()) == &colormap.table().back());
+    }
+
+    SECTION("NaN maps to the first entry")
+    {
+        REQUIRE(&colormap.sample(std::numeric_limits<float>::quiet_NaN()) == &colormap.table().front());
+    }
+
+    SECTION("Texture coordinates land on texel centres")
+    {
+        REQUIRE_THAT(colormap.texture_coordinate(0.F), WithinAbs(0.5F / 256.F, 1e-7F));
+        REQUIRE_THAT(colormap.texture_coordinate(1.F), WithinAbs(255.5F / 256.F, 1e-7F));
+        REQUIRE_THAT(colormap.texture_coordinate(0.5F), WithinAbs(0.5F, 1e-7F));
+    }
+
+    SECTION("Too small tables are rejected")
+    {
+        REQUIRE_THROWS_AS(math::c_colormap(math::e_colormap::magma, 1), std::invalid_argument);
+    }
+}
@@ -0,0 +1,240 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <array>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+import opengl;
+
+TEST_CASE("Command queue: Recording and execution", "[opengl][command_queue][unit]")
+{
+    SECTION("Commands submitted before make_current are left for drain")
+    {
+        opengl::c_command_queue queue;
+
+        int counter = 0;
+        queue.submit([&counter]()
+                     { counter++; });
+        queue.submit([&counter]()
+                     { counter++; }, opengl::e_command_kind::upload);
+
+        REQUIRE(counter == 0);
+        REQUIRE(queue.pending() == 2);
+
+        queue.make_current();
+        REQUIRE(counter == 0);
+
+        queue.flush();
+        REQUIRE(counter == 2);
+        REQUIRE(queue.pending() == 0);
+    }
+
+    SECTION("Commands execute in submission order")
+    {
+        opengl::c_command_queue queue;
+
+        std::vector<int> execution_order;
+        for (int i = 1; i <= 4; ++i)
+        {
+            queue.submit([&execution_order, i]()
+                         { execution_order.push_back(i); },
+                         i % 2 == 0 ? opengl::e_command_kind::upload : opengl::e_command_kind::state);
+        }
+        queue.flush();
+
+        REQUIRE(execution_order == std::vector<int>{ 1, 2, 3, 4 });
+    }
+
+    SECTION("State commands submitted on the GL thread run immediately")
+    {
+        opengl::c_command_queue queue;
+        queue.make_current();
+
+        bool called = false;
+        queue.submit([&called]()
+                     { called = true; });
+        REQUIRE(called);
+        REQUIRE(queue.pending() == 0);
+    }
+
+    SECTION("Uploads submitted on the GL thread land in a later drain")
+    {
+        opengl::c_command_queue queue;
+        queue.make_current();
+
+        bool created = false;
+        queue.submit([&created]()
+                     { created = true; },
+                     opengl::e_command_kind::upload);
+        REQUIRE_FALSE(created);
+        REQUIRE(queue.pending() == 1);
+
+        queue.drain(std::chrono::microseconds{ 1000 });
+        REQUIRE(created);
+    }
+
+    SECTION("State commands on the GL thread do not overtake recorded commands")
+    {
+        opengl::c_command_queue queue;
+        queue.make_current();
+
+        std::vector<int> execution_order;
+        queue.submit([&execution_order]()
+                     { execution_order.push_back(1); },
+                     opengl::e_command_kind::upload);
+        REQUIRE_FALSE(queue.runs_inline(opengl::e_command_kind::state));
+        queue.submit([&execution_order]()
+                     { execution_order.push_back(2); });
+        REQUIRE(execution_order.empty());
+
+        queue.drain(std::chrono::microseconds{ 1000 });
+        REQUIRE(execution_order == std::vector<int>{ 1, 2 });
+        REQUIRE(queue.runs_inline(opengl::e_command_kind::state));
+    }
+
+    SECTION("Commands submitted while a command executes run as part of it")
+    {
+        opengl::c_command_queue queue;
+        queue.make_current();
+
+        std::vector<int> execution_order;
+        queue.submit([&queue, &execution_order]()
+                     {
+            execution_order.push_back(1);
+            queue.submit([&execution_order]()
+                         { execution_order.push_back(2); },
+                         opengl::e_command_kind::upload); },
+                     opengl::e_command_kind::upload);
+        queue.submit([&execution_order]()
+                     { execution_order.push_back(3); });
+
+        queue.drain(std::chrono::microseconds{ 1000 });
+        REQUIRE(execution_order == std::vector<int>{ 1, 2, 3 });
+        REQUIRE(queue.pending() == 0);
+    }
+
+    SECTION("Deferred commands are recorded even on the GL thread")
+    {
+        opengl::c_command_queue queue;
+        queue.make_current();
+
+        bool called = false;
+        queue.defer([&called]()
+                    { called = true; });
+        REQUIRE_FALSE(called);
+
+        queue.drain(std::chrono::microseconds{ 1000 });
+        REQUIRE(called);
+    }
+
+    SECTION("Commands submitted from other threads are drained on the GL thread")
+    {
+        opengl::c_command_queue queue;
+        queue.make_current();
+
+        std::thread::id executed_on;
+        std::thread worker([&queue, &executed_on]()
+                           { queue.submit([&executed_on]()
+                                          { executed_on = std::this_thread::get_id(); }); });
+        worker.join();
+
+        REQUIRE(queue.pending() == 1);
+        queue.drain(std::chrono::microseconds{ 1000 });
+        REQUIRE(executed_on == std::this_thread::get_id());
+    }
+
+    SECTION("Large captures are stored in the arena")
+    {
+        opengl::c_command_queue queue;
+
+        std::array<int, 32 * 1024> payload{};
+        payload.back() = 42;
+        int result = 0;
+        queue.submit([payload, &result]()
+                     { result = payload.back(); });
+
+        queue.flush();
+        REQUIRE(result == 42);
+    }
+}
+
+TEST_CASE("Command queue: Upload budget", "[opengl][command_queue][unit]")
+{
+    SECTION("Uploads beyond the budget are left for the next drain")
+    {
+        opengl::c_command_queue queue;
+
+        int uploads = 0;
+        for (int i = 0; i < 3; ++i)
+        {
+            queue.submit([&uploads]()
+                         {
+                std::this_thread::sleep_for(std::chrono::milliseconds(2));
+                uploads++; },
+                         opengl::e_command_kind::upload);
+        }
+
+        REQUIRE(queue.drain(std::chrono::microseconds{ 500 }) == 1);
+        REQUIRE(uploads == 1);
+        REQUIRE(queue.pending() == 2);
+
+        queue.flush();
+        REQUIRE(uploads == 3);
+    }
+
+    SECTION("State commands before an upload are not throttled")
+    {
+        opengl::c_command_queue queue;
+
+        int state_changes = 0;
+        int uploads = 0;
+        queue.submit([&uploads]()
+                     {
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            uploads++; },
+                     opengl::e_command_kind::upload);
+        queue.submit([&state_changes]()
+                     { state_changes++; });
+        queue.submit([&state_changes]()
+                     { state_changes++; });
+        queue.submit([&uploads]()
+                     { uploads++; },
+                     opengl::e_command_kind::upload);
+
+        queue.drain(std::chrono::microseconds{ 500 });
+        REQUIRE(uploads == 1);
+        REQUIRE(state_changes == 2);
+        REQUIRE(queue.pending() == 1);
+    }
+}
+
+TEST_CASE("Command queue: Reset", "[opengl][command_queue][unit]")
+{
+    SECTION("Reset destroys pending commands without running them")
+    {
+        opengl::c_command_queue queue;
+
+        auto resource = std::make_shared<int>(0);
+        bool called = false;
+        queue.submit([resource, &called]()
+                     { called = true; });
+        REQUIRE(resource.use_count() == 2);
+
+        queue.reset();
+        REQUIRE_FALSE(called);
+        REQUIRE(resource.use_count() == 1);
+        REQUIRE(queue.pending() == 0);
+    }
+
+    SECTION("Reset detaches the queue from the GL thread")
+    {
+        opengl::c_command_queue queue;
+        queue.make_current();
+        REQUIRE(queue.is_gl_thread());
+
+        queue.reset();
+        REQUIRE_FALSE(queue.is_gl_thread());
+    }
+}
@@ -0,0 +1,110 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/matchers/catch_matchers_floating_point.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <numbers>
+#include <vector>
+
+import math;
+
+namespace
+{
+    auto sine(float frequency, std::size_t size, float sample_rate = 44100.F) -> std::vector<float>
+    {
+        std::vector<float> samples(size);
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            samples[i] = std::sin(2.F * std::numbers::pi_v<float> * frequency * static_cast<float>(i) / sample_rate);
+        }
+        return samples;
+    }
+
+    auto loudest(const std::vector<float> &values) -> std::size_t
+    {
+        return static_cast<std::size_t>(std::distance(values.begin(), std::ranges::max_element(values)));
+    }
+} // namespace
+
+TEST_CASE("Constant-Q: Bins", "[math][cqt][unit]")
+{
+    math::c_constant_q cqt;
+
+    SECTION("Bins are a semitone apart from the minimum frequency")
+    {
+        REQUIRE(cqt.bin_count() == 84);
+        REQUIRE_THAT(cqt.frequency(0), Catch::Matchers::WithinAbs(65.406F, 1e-3F));
+        REQUIRE_THAT(cqt.frequency(12), Catch::Matchers::WithinAbs(2.F * 65.406F, 1e-3F));
+        REQUIRE_THAT(cqt.frequency(1) / cqt.frequency(0), Catch::Matchers::WithinAbs(std::pow(2.F, 1.F / 12.F), 1e-5F));
+    }
+
+    SECTION("Frame holds the longest kernel")
+    {
+        auto longest = static_cast<std::size_t>(std::ceil(cqt.quality() * 44100.F / cqt.frequency(0)));
+        REQUIRE(cqt.frame_size() >= longest);
+        REQUIRE(cqt.frame_size() < 2 * longest);
+    }
+
+    SECTION("Kernel is sparse")
+    {
+        REQUIRE(cqt.kernel_size() < cqt.bin_count() * cqt.frame_size() / 50);
+    }
+
+    SECTION("Bins above Nyquist are rejected")
+    {
+        REQUIRE_THROWS_AS(math::c_constant_q({ .sample_rate = 8000.F }), std::invalid_argument);
+    }
+}
+
+TEST_CASE("Constant-Q: Tones", "[math][cqt][unit]")
+{
+    math::c_constant_q cqt;
+
+    SECTION("Tones land on their bin, in the bass and in the treble")
+    {
+        for (std::size_t bin : { 0U, 5U, 24U, 57U, 83U })
+        {
+            auto magnitudes = cqt.transform(sine(cqt.frequency(bin), cqt.frame_size()));
+            REQUIRE(loudest(magnitudes) == bin);
+        }
+    }
+
+    SECTION("Semitones are resolved in the bass")
+    {
+        // Adjacent Hann-windowed bins overlap by design, a whole tone away leakage is small
+        auto magnitudes = cqt.transform(sine(cqt.frequency(3), cqt.frame_size()));
+        REQUIRE(magnitudes[3] > 1.5F * magnitudes[2]);
+        REQUIRE(magnitudes[3] > 1.5F * magnitudes[4]);
+        REQUIRE(magnitudes[3] > 10.F * magnitudes[1]);
+        REQUIRE(magnitudes[3] > 10.F * magnitudes[5]);
+    }
+
+    SECTION("Magnitude follows amplitude")
+    {
+        auto full = cqt.transform(sine(cqt.frequency(40), cqt.frame_size()));
+        auto samples = sine(cqt.frequency(40), cqt.frame_size());
+        std::ranges::transform(samples, samples.begin(), [](float sample)
+                               { return sample / 2.F; });
+        auto half = cqt.transform(samples);
+        REQUIRE_THAT(half[40] / full[40], Catch::Matchers::WithinAbs(0.5F, 1e-3F));
+    }
+
+    SECTION("Wrong frame sizes are rejected")
+    {
+        REQUIRE_THROWS_AS(cqt.transform(std::vector<float>(cqt.frame_size() / 2)), std::invalid_argument);
+    }
+}
+
+TEST_CASE("Semitone bands: Linear bins", "[math][cqt][unit]")
+{
+    std::vector<float> magnitudes(64, 0.F);
+    magnitudes[10] = 3.F;
+    std::vector<float> bands;
+    math::semitone_bands(magnitudes, bands);
+
+    // One bin per band up to where a semitone spans more than a bin, and only the lower half of the spectrum
+    REQUIRE(bands.front() == 0.F);
+    REQUIRE(std::ranges::max(bands) == 3.F);
+    REQUIRE(bands.size() < magnitudes.size() / 2);
+}
@@ -229,3 +229,62 @@ TEST_CASE("FFT: Symmetry properties", "[fft][unit]")
         }
     }
 }
+
+TEST_CASE("Pitch: Synthetic sines", "[fft][pitch][unit]")
+{
+    math::c_pitch_detector detector;
+    auto tone = [&](float frequency, int harmonics)
+    {
+        std::vector<float> input(detector.frame_size());
+        for (size_t i = 0; i < input.size(); ++i)
+        {
+            for (int harmonic = 1; harmonic <= harmonics; ++harmonic)
+            {
+                auto phase = 2.0F * std::numbers::pi_v<float> * frequency * static_cast<float>(harmonic) * static_cast<float>(i) / 44100.0F;
+                input[i] += std::sin(phase) / static_cast<float>(harmonic);
+            }
+        }
+        return input;
+    };
+    auto cents = [](float detected, float expected)
+    {
+        return 1200.0F * std::log2(detected / expected);
+    };
+
+    SECTION("Pure sines are found within a few cents")
+    {
+        for (float frequency : { 82.41F, 110.0F, 261.63F, 440.0F, 443.7F, 1000.0F, 1760.0F })
+        {
+            auto pitch = detector.detect(tone(frequency, 1));
+            REQUIRE_THAT(cents(pitch.frequency, frequency), Catch::Matchers::WithinAbs(0.0F, 5.0F));
+            REQUIRE(pitch.confidence > 0.9F);
+        }
+    }
+
+    SECTION("Harmonic tones report the fundamental, not an octave")
+    {
+        auto pitch = detector.detect(tone(196.0F, 8));
+        REQUIRE_THAT(cents(pitch.frequency, 196.0F), Catch::Matchers::WithinAbs(0.0F, 5.0F));
+    }
+
+    SECTION("Silence has no pitch")
+    {
+        auto pitch = detector.detect(std::vector<float>(detector.frame_size(), 0.0F));
+        REQUIRE(pitch.frequency == 0.0F);
+    }
+
+    SECTION("Wrong frame sizes are rejected")
+    {
+        REQUIRE_THROWS_AS(detector.detect(std::vector<float>(100)), std::invalid_argument);
+    }
+
+    SECTION("Nearest note")
+    {
+        auto note = math::nearest_note(440.0F);
+        REQUIRE(note.midi == 69);
+        REQUIRE_THAT(note.cents, Catch::Matchers::WithinAbs(0.0F, 1e-3F));
+        note = math::nearest_note(443.7F);
+        REQUIRE(note.midi == 69);
+        REQUIRE_THAT(note.cents, Catch::Matchers::WithinAbs(14.5F, 0.1F));
+    }
+}
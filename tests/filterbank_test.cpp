@@ -0,0 +1,181 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/matchers/catch_matchers_floating_point.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <cstddef>
+#include <iterator>
+#include <numbers>
+#include <vector>
+
+import math;
+
+namespace
+{
+    auto sine(float frequency, std::size_t size, float sample_rate = 44100.F) -> std::vector<float>
+    {
+        std::vector<float> samples(size);
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            samples[i] = std::sin(2.F * std::numbers::pi_v<float> * frequency * static_cast<float>(i) / sample_rate);
+        }
+        return samples;
+    }
+
+    auto power(const std::vector<std::complex<float>> &spectrum) -> std::vector<float>
+    {
+        std::vector<float> result((spectrum.size() / 2) + 1);
+        std::ranges::transform(spectrum.begin(), spectrum.begin() + static_cast<std::ptrdiff_t>(result.size()), result.begin(), [](const std::complex<float> &value)
+                               { return std::norm(value); });
+        return result;
+    }
+} // namespace
+
+TEST_CASE("Filterbank: Frequency scales", "[math][filterbank][unit]")
+{
+    SECTION("Reference values")
+    {
+        // 1000 Hz is 1000 mel by construction of the HTK formula
+        REQUIRE_THAT(math::hz_to_scale(1000.F, math::e_frequency_scale::mel), Catch::Matchers::WithinAbs(999.9855F, 1e-2F));
+        REQUIRE_THAT(math::hz_to_scale(1000.F, math::e_frequency_scale::bark), Catch::Matchers::WithinAbs(8.5274F, 1e-3F));
+        REQUIRE_THAT(math::hz_to_scale(0.F, math::e_frequency_scale::mel), Catch::Matchers::WithinAbs(0.F, 1e-6F));
+    }
+
+    SECTION("Conversions round trip")
+    {
+        for (auto scale : { math::e_frequency_scale::mel, math::e_frequency_scale::bark })
+        {
+            for (float frequency : { 50.F, 440.F, 4000.F, 16000.F })
+            {
+                auto value = math::hz_to_scale(frequency, scale);
+                REQUIRE_THAT(math::scale_to_hz(value, scale), Catch::Matchers::WithinRel(frequency, 1e-4F));
+            }
+        }
+    }
+}
+
+TEST_CASE("Filterbank: Triangular filters", "[math][filterbank][unit]")
+{
+    math::c_filterbank filterbank({ .sample_rate = 16000.F, .fft_size = 512, .band_count = 26, .min_frequency = 0.F, .max_frequency = 8000.F, .scale = math::e_frequency_scale::mel });
+    std::vector<float> energies(filterbank.band_count());
+
+    SECTION("Weights are sparse")
+    {
+        REQUIRE(filterbank.spectrum_size() == 257);
+        REQUIRE(filterbank.weight_count() < filterbank.spectrum_size() * filterbank.band_count() / 10);
+    }
+
+    SECTION("Neighbouring filters add up to one")
+    {
+        auto bin_width = 16000.F / 512.F;
+        for (std::size_t bin = 0; bin < filterbank.spectrum_size(); ++bin)
+        {
+            auto frequency = static_cast<float>(bin) * bin_width;
+            if (frequency < filterbank.center_frequency(0) or frequency > filterbank.center_frequency(25))
+            {
+                continue;
+            }
+            std::vector<float> impulse(filterbank.spectrum_size(), 0.F);
+            impulse[bin] = 1.F;
+            filterbank.apply(impulse, energies);
+
+            float sum = 0.F;
+            for (auto energy : energies)
+            {
+                sum += energy;
+            }
+            REQUIRE_THAT(sum, Catch::Matchers::WithinAbs(1.F, 1e-4F));
+        }
+    }
+
+    SECTION("Tones land in the band centred on them")
+    {
+        for (std::size_t band : { 4U, 12U, 20U })
+        {
+            auto spectrum = math::fft(sine(filterbank.center_frequency(band), 512, 16000.F));
+            filterbank.apply(power(spectrum), energies);
+            auto loudest = static_cast<std::size_t>(std::distance(energies.begin(), std::ranges::max_element(energies)));
+            REQUIRE(loudest == band);
+        }
+    }
+
+    SECTION("Bark filters cover the same range")
+    {
+        math::c_filterbank bark({ .sample_rate = 16000.F, .fft_size = 512, .band_count = 26, .min_frequency = 0.F, .max_frequency = 8000.F, .scale = math::e_frequency_scale::bark });
+        REQUIRE(bark.center_frequency(0) > 0.F);
+        REQUIRE(bark.center_frequency(25) < 8000.F);
+
+        auto spectrum = math::fft(sine(bark.center_frequency(12), 512, 16000.F));
+        bark.apply(power(spectrum), energies);
+        REQUIRE(static_cast<std::size_t>(std::distance(energies.begin(), std::ranges::max_element(energies))) == 12);
+    }
+
+    SECTION("Invalid configurations and sizes are rejected")
+    {
+        REQUIRE_THROWS_AS(math::c_filterbank({ .sample_rate = 16000.F, .fft_size = 512, .band_count = 26, .min_frequency = 0.F, .max_frequency = 9000.F, .scale = math::e_frequency_scale::mel }), std::invalid_argument);
+        std::vector<float> short_power(100);
+        REQUIRE_THROWS_AS(filterbank.apply(short_power, energies), std::invalid_argument);
+    }
+}
+
+TEST_CASE("MFCC: Cepstral coefficients", "[math][filterbank][unit]")
+{
+    math::c_mfcc mfcc({ .filterbank = { .sample_rate = 16000.F, .fft_size = 512, .band_count = 4, .min_frequency = 0.F, .max_frequency = 8000.F, .scale = math::e_frequency_scale::mel }, .coefficient_count = 4, .log_floor = 1e-10F });
+    std::vector<float> coefficients(mfcc.coefficient_count());
+
+    SECTION("Orthonormal DCT-II of log energies")
+    {
+        // Log energies 1, 2, 3, 4; reference values from the DCT-II definition with orthonormal scaling
+        std::vector<float> energies = { std::exp(1.F), std::exp(2.F), std::exp(3.F), std::exp(4.F) };
+        mfcc.compute_from_energies(energies, coefficients);
+        REQUIRE_THAT(coefficients[0], Catch::Matchers::WithinAbs(5.F, 1e-5F));
+        REQUIRE_THAT(coefficients[1], Catch::Matchers::WithinAbs(-2.2304425F, 1e-5F));
+        REQUIRE_THAT(coefficients[2], Catch::Matchers::WithinAbs(0.F, 1e-5F));
+        REQUIRE_THAT(coefficients[3], Catch::Matchers::WithinAbs(-0.1585127F, 1e-5F));
+    }
+
+    SECTION("Silence stays finite")
+    {
+        std::vector<std::complex<float>> silence(512);
+        mfcc.compute(silence, coefficients);
+        REQUIRE_THAT(coefficients[0], Catch::Matchers::WithinAbs(2.F * std::log(1e-10F), 1e-3F));
+        REQUIRE_THAT(coefficients[1], Catch::Matchers::WithinAbs(0.F, 1e-4F));
+    }
+
+    SECTION("More coefficients than bands are rejected")
+    {
+        REQUIRE_THROWS_AS(math::c_mfcc({ .filterbank = { .band_count = 4 }, .coefficient_count = 5 }), std::invalid_argument);
+    }
+}
+
+TEST_CASE("MFCC: Batch and streaming agree", "[math][filterbank][unit]")
+{
+    math::c_mfcc mfcc({ .filterbank = { .sample_rate = 16000.F, .fft_size = 512, .band_count = 26 }, .coefficient_count = 13 });
+    auto samples = sine(440.F, 4096, 16000.F);
+    auto frames = mfcc.analyse(samples, 256);
+    REQUIRE(frames.size() == ((4096 - 512) / 256) + 1);
+
+    // The same frame, windowed and transformed by the caller
+    std::vector<float> frame(samples.begin() + 512, samples.begin() + 1024);
+    for (std::size_t n = 0; n < frame.size(); ++n)
+    {
+        frame[n] *= 0.5F * (1.F - std::cos(2.F * std::numbers::pi_v<float> * static_cast<float>(n) / 512.F));
+    }
+    std::vector<float> coefficients(mfcc.coefficient_count());
+    mfcc.compute(math::fft(frame), coefficients);
+    for (std::size_t k = 0; k < coefficients.size(); ++k)
+    {
+        REQUIRE_THAT(coefficients[k], Catch::Matchers::WithinAbs(frames[2][k], 1e-3F));
+    }
+
+    // Scaling by two is exact in floating point, so only the log energy offset in c0 changes: sqrt(26) * ln(4)
+    std::ranges::transform(samples, samples.begin(), [](float sample)
+                           { return sample * 2.F; });
+    auto louder = mfcc.analyse(samples, 256);
+    REQUIRE_THAT(louder[2][0] - frames[2][0], Catch::Matchers::WithinAbs(std::sqrt(26.F) * std::log(4.F), 1e-3F));
+    for (std::size_t k = 1; k < coefficients.size(); ++k)
+    {
+        REQUIRE_THAT(louder[2][k], Catch::Matchers::WithinAbs(frames[2][k], 1e-3F));
+    }
+}
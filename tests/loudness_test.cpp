@@ -0,0 +1,125 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/matchers/catch_matchers_floating_point.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <numbers>
+#include <span>
+#include <vector>
+
+import math;
+
+namespace
+{
+    // Stereo sine with both channels equal, at a level in dBFS, appended to samples
+    auto append_sine(std::vector<float> &samples, float frequency, float level, float seconds, float sample_rate = 48000.F) -> void
+    {
+        auto amplitude = std::pow(10.F, level / 20.F);
+        auto frames = static_cast<std::size_t>(seconds * sample_rate);
+        for (std::size_t i = 0; i < frames; ++i)
+        {
+            auto value = amplitude * std::sin(2.F * std::numbers::pi_v<float> * frequency * static_cast<float>(i) / sample_rate);
+            samples.push_back(value);
+            samples.push_back(value);
+        }
+    }
+} // namespace
+
+TEST_CASE("Loudness: EBU Tech 3341 levels", "[math][loudness][unit]")
+{
+    SECTION("A -23 dBFS 1 kHz stereo sine reads -23 LUFS on every scale")
+    {
+        math::c_loudness_meter meter(48000.F);
+        std::vector<float> samples;
+        append_sine(samples, 1000.F, -23.F, 20.F);
+        meter.process(samples);
+        REQUIRE_THAT(meter.momentary(), Catch::Matchers::WithinAbs(-23.F, 0.1F));
+        REQUIRE_THAT(meter.short_term(), Catch::Matchers::WithinAbs(-23.F, 0.1F));
+        REQUIRE_THAT(meter.integrated(), Catch::Matchers::WithinAbs(-23.F, 0.1F));
+    }
+
+    SECTION("Same at 44.1 kHz, the filters follow the sample rate")
+    {
+        math::c_loudness_meter meter(44100.F);
+        std::vector<float> samples;
+        append_sine(samples, 1000.F, -33.F, 10.F, 44100.F);
+        meter.process(samples);
+        REQUIRE_THAT(meter.integrated(), Catch::Matchers::WithinAbs(-33.F, 0.1F));
+    }
+
+    SECTION("The relative gate drops quiet passages from the integrated loudness")
+    {
+        math::c_loudness_meter meter(48000.F);
+        std::vector<float> samples;
+        append_sine(samples, 1000.F, -36.F, 5.F);
+        append_sine(samples, 1000.F, -23.F, 20.F);
+        append_sine(samples, 1000.F, -36.F, 5.F);
+        meter.process(samples);
+        REQUIRE_THAT(meter.integrated(), Catch::Matchers::WithinAbs(-23.F, 0.1F));
+    }
+
+    SECTION("The absolute gate drops near silence")
+    {
+        math::c_loudness_meter meter(48000.F);
+        std::vector<float> samples;
+        append_sine(samples, 1000.F, -23.F, 10.F);
+        append_sine(samples, 1000.F, -80.F, 10.F);
+        meter.process(samples);
+        REQUIRE_THAT(meter.integrated(), Catch::Matchers::WithinAbs(-23.F, 0.1F));
+        REQUIRE(meter.momentary() < -70.F);
+    }
+
+    SECTION("Results do not depend on how samples are split into calls")
+    {
+        math::c_loudness_meter whole(48000.F);
+        math::c_loudness_meter chunked(48000.F);
+        std::vector<float> samples;
+        append_sine(samples, 440.F, -18.F, 3.F);
+        whole.process(samples);
+        for (std::size_t start = 0; start < samples.size(); start += 1470)
+        {
+            chunked.process(std::span(samples).subspan(start, std::min<std::size_t>(1470, samples.size() - start)));
+        }
+        REQUIRE(whole.short_term() == chunked.short_term());
+        REQUIRE(whole.true_peak() == chunked.true_peak());
+    }
+
+    SECTION("Silence has no loudness")
+    {
+        math::c_loudness_meter meter(48000.F);
+        meter.process(std::vector<float>(96000, 0.F));
+        REQUIRE(std::isinf(meter.integrated()));
+        REQUIRE(std::isinf(meter.true_peak()));
+    }
+}
+
+TEST_CASE("Loudness: True peak", "[math][loudness][unit]")
+{
+    SECTION("Peaks between samples are found")
+    {
+        // A quarter of the sample rate, 45 degrees off: every sample lands at 0.707, the waveform peaks at 1
+        math::c_loudness_meter meter(48000.F);
+        std::vector<float> samples;
+        for (std::size_t i = 0; i < 48000; ++i)
+        {
+            // Phase taken modulo the period, so that rounding does not move the samples off 0.707
+            auto value = std::sin((std::numbers::pi_v<float> / 2.F * static_cast<float>(i % 4)) + (std::numbers::pi_v<float> / 4.F));
+            samples.push_back(value);
+            samples.push_back(value);
+        }
+        meter.process(samples);
+        REQUIRE_THAT(meter.sample_peak(), Catch::Matchers::WithinAbs(-3.01F, 0.05F));
+        REQUIRE_THAT(meter.true_peak(), Catch::Matchers::WithinAbs(0.F, 0.5F));
+    }
+
+    SECTION("Low frequencies peak on the samples")
+    {
+        math::c_loudness_meter meter(48000.F);
+        std::vector<float> samples;
+        append_sine(samples, 997.F, -6.F, 1.F);
+        meter.process(samples);
+        REQUIRE_THAT(meter.true_peak(), Catch::Matchers::WithinAbs(-6.F, 0.2F));
+        REQUIRE(meter.true_peak() >= meter.sample_peak() - 0.1F);
+    }
+}
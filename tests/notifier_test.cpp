@@ -1,8 +1,13 @@
 #include <catch2/catch_test_macros.hpp>
 
+#include <array>
 #include <atomic>
 #include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
 #include <thread>
+#include <utility>
 #include <vector>
 
 import utility;
@@ -352,3 +357,98 @@ TEST_CASE("Notifier: State transitions", "[utility][notifier][unit]")
         REQUIRE_FALSE(deferred);
     }
 }
+
+TEST_CASE("Notifier: Channels", "[utility][notifier][unit]")
+{
+    SECTION("Channels are notified independently")
+    {
+        utility::c_notifier_channel first;
+        utility::c_notifier_channel second;
+
+        int first_count = 0;
+        int second_count = 0;
+        first.subscribe([&first_count]()
+                        { first_count++; });
+        second.subscribe([&second_count]()
+                         { second_count++; });
+
+        first.notify();
+        REQUIRE(first_count == 1);
+        REQUIRE(second_count == 0);
+        REQUIRE(first.is_notified());
+        REQUIRE_FALSE(second.is_notified());
+
+        second.notify();
+        REQUIRE(second_count == 1);
+    }
+
+    SECTION("The static interface uses the default channel")
+    {
+        utility::c_notifier::reset();
+        utility::c_notifier_channel other;
+
+        bool called = false;
+        utility::c_notifier::subscribe([&called]()
+                                       { called = true; });
+        other.notify();
+        REQUIRE_FALSE(called);
+        utility::c_notifier::channel().notify();
+        REQUIRE(called);
+    }
+
+    SECTION("Pending callbacks are destroyed with the channel")
+    {
+        auto token = std::make_shared<int>(0);
+        {
+            utility::c_notifier_channel channel;
+            channel.subscribe([token]() {});
+            REQUIRE(token.use_count() == 2);
+        }
+        REQUIRE(token.use_count() == 1);
+    }
+}
+
+TEST_CASE("Notifier: Callbacks", "[utility][notifier][unit]")
+{
+    SECTION("Move-only captures")
+    {
+        utility::c_notifier_channel channel;
+        int value = 0;
+        channel.subscribe([owned = std::make_unique<int>(7), &value]()
+                          { value = *owned; });
+        channel.notify();
+        REQUIRE(value == 7);
+    }
+
+    SECTION("Captures larger than the inline storage")
+    {
+        std::array<int, 64> large{};
+        large.back() = 5;
+        int value = 0;
+        utility::c_callback callback([large, &value]()
+                                     { value = large.back(); });
+        auto moved = std::move(callback);
+        REQUIRE_FALSE(callback);
+        moved();
+        REQUIRE(value == 5);
+    }
+
+    SECTION("Moving keeps the captured state")
+    {
+        std::string text = "moved";
+        std::string result;
+        utility::c_callback callback([text, &result]()
+                                     { result = text; });
+        utility::c_callback target;
+        target = std::move(callback);
+        target();
+        REQUIRE(result == "moved");
+    }
+
+    SECTION("Calling an empty callback throws")
+    {
+        utility::c_callback callback;
+        REQUIRE_FALSE(callback);
+        REQUIRE_THROWS_AS(callback(), std::bad_function_call);
+    }
+}
@@ -0,0 +1,155 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/matchers/catch_matchers_floating_point.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <numbers>
+#include <vector>
+
+import math;
+
+namespace
+{
+    // Decaying 1 kHz bursts at the given tempo, with a quiet tone underneath
+    auto click_track(float bpm, float seconds, float sample_rate = 44100.F) -> std::vector<float>
+    {
+        std::vector<float> samples(static_cast<std::size_t>(seconds * sample_rate));
+        auto period = static_cast<std::size_t>(60.F * sample_rate / bpm);
+        for (std::size_t i = 0; i < samples.size(); ++i)
+        {
+            auto time = static_cast<float>(i) / sample_rate;
+            auto since_click = static_cast<float>(i % period) / sample_rate;
+            samples[i] = (0.05F * std::sin(2.F * std::numbers::pi_v<float> * 220.F * time))
+                         + (std::exp(-since_click * 60.F) * std::sin(2.F * std::numbers::pi_v<float> * 1000.F * time));
+        }
+        return samples;
+    }
+} // namespace
+
+TEST_CASE("Onset detector: Spectral flux", "[math][onset][unit]")
+{
+    math::c_onset_detector detector;
+    std::vector<float> quiet(64, 0.1F);
+    std::vector<float> loud(64, 2.F);
+
+    SECTION("The first frame only primes the detector")
+    {
+        REQUIRE_FALSE(detector.push(loud));
+        REQUIRE(detector.flux() == 0.F);
+    }
+
+    SECTION("Steady frames are not onsets, a jump in energy is")
+    {
+        for (int frame = 0; frame < 30; ++frame)
+        {
+            REQUIRE_FALSE(detector.push(quiet));
+        }
+        REQUIRE(detector.push(loud));
+        REQUIRE(detector.flux() > detector.threshold());
+    }
+
+    SECTION("Falling energy is not an onset")
+    {
+        detector.push(loud);
+        REQUIRE_FALSE(detector.push(quiet));
+        REQUIRE(detector.flux() == 0.F);
+    }
+
+    SECTION("Onsets closer than the minimum interval are merged")
+    {
+        detector.push(quiet);
+        REQUIRE(detector.push(loud));
+        detector.push(quiet);
+        REQUIRE_FALSE(detector.push(loud));
+    }
+
+    SECTION("A different number of bins restarts detection")
+    {
+        detector.push(quiet);
+        REQUIRE_FALSE(detector.push(std::vector<float>(32, 2.F)));
+    }
+}
+
+TEST_CASE("Beat tracker: Synthetic envelopes", "[math][onset][unit]")
+{
+    SECTION("Tempo follows the spacing of pulses")
+    {
+        for (float bpm : { 90.F, 120.F, 150.F })
+        {
+            math::c_beat_tracker tracker;
+            auto period = static_cast<std::size_t>(std::lround(60.F * 60.F / bpm));
+            for (std::size_t frame = 0; frame < 600; ++frame)
+            {
+                tracker.push(frame % period == 0 ? 1.F : 0.F);
+            }
+            REQUIRE_THAT(tracker.tempo(), Catch::Matchers::WithinAbs(bpm, 2.F));
+        }
+    }
+
+    SECTION("Beats fall on the pulses once locked")
+    {
+        math::c_beat_tracker tracker;
+        std::vector<std::size_t> beats;
+        for (std::size_t frame = 0; frame < 900; ++frame)
+        {
+            if (tracker.push(frame % 30 == 7 ? 1.F : 0.F) and frame > 600)
+            {
+                beats.push_back(frame);
+            }
+        }
+        REQUIRE(beats.size() >= 9);
+        for (auto beat : beats)
+        {
+            auto distance = std::min((beat + 30 - 7) % 30, (7 + 30 - beat % 30) % 30);
+            REQUIRE(distance <= 1);
+        }
+    }
+
+    SECTION("No tempo before enough history")
+    {
+        math::c_beat_tracker tracker;
+        for (std::size_t frame = 0; frame < 60; ++frame)
+        {
+            REQUIRE_FALSE(tracker.push(frame % 30 == 0 ? 1.F : 0.F));
+        }
+        REQUIRE(tracker.tempo() == 0.F);
+    }
+
+    SECTION("Too short a history is rejected")
+    {
+        REQUIRE_THROWS_AS(math::c_beat_tracker({ .hop_rate = 60.F, .min_bpm = 60.F, .max_bpm = 200.F, .preferred_bpm = 120.F, .history = 1.F, .update_interval = 0.25F }), std::invalid_argument);
+    }
+}
+
+TEST_CASE("Rhythm analysis: Click track", "[math][onset][unit]")
+{
+    auto analysis = math::analyse_rhythm(click_track(128.F, 12.F), 44100.F);
+
+    SECTION("Tempo")
+    {
+        REQUIRE_THAT(analysis.tempo, Catch::Matchers::WithinAbs(128.F, 2.F));
+    }
+
+    SECTION("Every click is an onset, and nothing else")
+    {
+        auto clicks = static_cast<std::size_t>(12.F * 128.F / 60.F);
+        REQUIRE(analysis.onset_times.size() + 2 >= clicks);
+        REQUIRE(analysis.onset_times.size() <= clicks + 1);
+
+        auto period = 60.F / 128.F;
+        for (auto time : analysis.onset_times)
+        {
+            // Within a hop and a half of a click, frames are stamped at their centre
+            auto offset = std::fmod(time, period);
+            REQUIRE(std::min(offset, period - offset) < 1.5F * 512.F / 44100.F + (1024.F / 44100.F));
+        }
+    }
+
+    SECTION("Beats are a period apart")
+    {
+        REQUIRE(analysis.beat_times.size() >= 10);
+        auto last = analysis.beat_times.size() - 1;
+        REQUIRE_THAT(analysis.beat_times[last] - analysis.beat_times[last - 1], Catch::Matchers::WithinAbs(60.F / 128.F, 0.03F));
+    }
+}
@@ -0,0 +1,138 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/matchers/catch_matchers_floating_point.hpp>
+
+#include <cmath>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+import music;
+
+TEST_CASE("Peak pyramid: Level 0 reduction", "[music][peaks][unit]")
+{
+    SECTION("Bins hold min, max and RMS of their samples")
+    {
+        std::vector<float> samples(music::c_peak_pyramid::s_base_frames * 2, 0.5F);
+        samples[3] = -1.0F;
+        samples[music::c_peak_pyramid::s_base_frames + 7] = 0.75F;
+
+        std::vector<music::s_peak> bins(2);
+        music::c_peak_pyramid::reduce(samples, bins);
+
+        REQUIRE(bins[0].min == -1.0F);
+        REQUIRE(bins[0].max == 0.5F);
+        REQUIRE(bins[1].min == 0.5F);
+        REQUIRE(bins[1].max == 0.75F);
+
+        auto expected_rms = std::sqrt((1.0F + (255.0F * 0.25F)) / 256.0F);
+        REQUIRE_THAT(bins[0].rms, Catch::Matchers::WithinAbs(expected_rms, 1e-6F));
+    }
+
+    SECTION("Last bin may be partial")
+    {
+        std::vector<float> samples(music::c_peak_pyramid::s_base_frames + 10, -0.25F);
+        REQUIRE(music::c_peak_pyramid::bin_count(samples.size()) == 2);
+
+        std::vector<music::s_peak> bins(2);
+        music::c_peak_pyramid::reduce(samples, bins);
+        REQUIRE(bins[1].min == -0.25F);
+        REQUIRE_THAT(bins[1].rms, Catch::Matchers::WithinAbs(0.25F, 1e-6F));
+    }
+}
+
+TEST_CASE("Peak pyramid: Levels and sampling", "[music][peaks][unit]")
+{
+    // Ramp from -1 to 1 over 1000 bins
+    constexpr std::size_t bin_count = 1000;
+    std::vector<music::s_peak> base(bin_count);
+    for (std::size_t i = 0; i < bin_count; ++i)
+    {
+        auto value = (2.0F * static_cast<float>(i) / static_cast<float>(bin_count - 1)) - 1.0F;
+        base[i] = { .min = value, .max = value, .rms = std::abs(value) };
+    }
+    const std::uint64_t total_frames = bin_count * music::c_peak_pyramid::s_base_frames;
+    music::c_peak_pyramid pyramid(base, total_frames);
+
+    SECTION("Every level halves the one below until a single bin remains")
+    {
+        REQUIRE(pyramid.level(0).size() == bin_count);
+        for (std::size_t level = 1; level < pyramid.level_count(); ++level)
+        {
+            REQUIRE(pyramid.level(level).size() == (pyramid.level(level - 1).size() + 1) / 2);
+        }
+        auto top = pyramid.level(pyramid.level_count() - 1);
+        REQUIRE(top.size() == 1);
+        REQUIRE(top[0].min == -1.0F);
+        REQUIRE(top[0].max == 1.0F);
+    }
+
+    SECTION("Level selection follows the pixel width")
+    {
+        REQUIRE(pyramid.level_for(1.0) == 0);
+        REQUIRE(pyramid.level_for(static_cast<double>(music::c_peak_pyramid::s_base_frames)) == 0);
+        REQUIRE(pyramid.level_for(static_cast<double>(music::c_peak_pyramid::s_base_frames) * 4.5) == 2);
+        REQUIRE(pyramid.level_for(1e12) == pyramid.level_count() - 1);
+    }
+
+    SECTION("Sampled columns cover the whole range")
+    {
+        std::vector<music::s_peak> columns(100);
+        pyramid.sample(0, total_frames, columns);
+
+        REQUIRE(columns.front().min == -1.0F);
+        REQUIRE(columns.back().max == 1.0F);
+        for (std::size_t i = 1; i < columns.size(); ++i)
+        {
+            REQUIRE(columns[i].min >= columns[i - 1].min);
+            REQUIRE(columns[i].min <= columns[i].max);
+        }
+    }
+
+    SECTION("Sampling past the end leaves empty columns")
+    {
+        std::vector<music::s_peak> columns(10, music::s_peak{ .min = 5.0F, .max = 5.0F, .rms = 5.0F });
+        pyramid.sample(total_frames * 2, total_frames * 3, columns);
+        for (const auto &column : columns)
+        {
+            REQUIRE(column.max == 0.0F);
+        }
+    }
+}
+
+TEST_CASE("Peak pyramid: Cache files", "[music][peaks][unit]")
+{
+    auto directory = std::filesystem::temp_directory_path() / "spectra_peaks_test";
+    std::filesystem::create_directories(directory);
+    auto source = directory / "source.wav";
+    auto cache = directory / "source.wav.peaks";
+    {
+        std::ofstream file(source, std::ios::binary);
+        file << "not really audio";
+    }
+
+    std::vector<music::s_peak> base = { { .min = -0.5F, .max = 0.5F, .rms = 0.25F }, { .min = -1.0F, .max = 0.0F, .rms = 0.5F } };
+    music::c_peak_pyramid pyramid(base, 300);
+
+    SECTION("Saved pyramids load back")
+    {
+        REQUIRE(pyramid.save(cache, source));
+        auto loaded = music::c_peak_pyramid::load(cache, source);
+        REQUIRE(loaded.has_value());
+        REQUIRE(loaded->total_frames() == 300);
+        REQUIRE(loaded->level_count() == pyramid.level_count());
+        REQUIRE(loaded->level(0)[1].min == -1.0F);
+    }
+
+    SECTION("Cache is rejected once the source changes")
+    {
+        REQUIRE(pyramid.save(cache, source));
+        {
+            std::ofstream file(source, std::ios::binary | std::ios::app);
+            file << "more bytes";
+        }
+        REQUIRE_FALSE(music::c_peak_pyramid::load(cache, source).has_value());
+    }
+
+    std::filesystem::remove_all(directory);
+}
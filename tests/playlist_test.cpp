@@ -0,0 +1,242 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/matchers/catch_matchers_floating_point.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <numbers>
+#include <span>
+#include <thread>
+#include <vector>
+
+#include "temporary_wav.hpp"
+
+import music;
+
+namespace
+{
+    constexpr std::size_t s_channels = music::c_playlist::s_channels;
+    constexpr std::size_t s_file_frames = 2 * 44100; // A two second generated file
+    constexpr double s_sine_rms = 0.5 / std::numbers::sqrt2;
+
+    // A paused mix hands nothing out but takes over the streams, so the decoder thread moves on to the next file
+    auto wait_until_decoded(music::c_playlist &playlist) -> bool
+    {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds{ 10 };
+        while (playlist.pending() != 0)
+        {
+            if (std::chrono::steady_clock::now() > deadline)
+            {
+                return false;
+            }
+            playlist.mix({}, 0);
+            std::this_thread::sleep_for(std::chrono::milliseconds{ 1 });
+        }
+        return true;
+    }
+
+    // As the audio callback does, one period at a time
+    auto mix_periods(music::c_playlist &playlist, std::size_t frames) -> std::vector<float>
+    {
+        constexpr std::size_t period = 512;
+        std::vector<float> output(frames * s_channels, 0.F);
+        for (std::size_t first = 0; first < frames; first += period)
+        {
+            auto count = std::min(period, frames - first);
+            playlist.mix(std::span(output).subspan(first * s_channels, count * s_channels), count);
+        }
+        return output;
+    }
+
+    // Of the left channel, over count frames from first
+    auto rms(const std::vector<float> &output, std::size_t first, std::size_t count) -> double
+    {
+        double sum = 0.0;
+        for (std::size_t frame = first; frame < first + count; ++frame)
+        {
+            sum += static_cast<double>(output[frame * s_channels]) * output[frame * s_channels];
+        }
+        return std::sqrt(sum / static_cast<double>(count));
+    }
+} // namespace
+
+TEST_CASE("Playlist: Equal-power crossfade", "[music][playlist][unit]")
+{
+    using Catch::Matchers::WithinAbs;
+
+    SECTION("Gains keep the power constant")
+    {
+        for (int step = 0; step <= 10; ++step)
+        {
+            auto [outgoing, incoming] = music::c_playlist::crossfade_gains(static_cast<float>(step) / 10.F);
+            REQUIRE_THAT((outgoing * outgoing) + (incoming * incoming), WithinAbs(1.0, 1e-5));
+        }
+    }
+
+    SECTION("Fade runs from the outgoing file to the incoming one")
+    {
+        auto [start_outgoing, start_incoming] = music::c_playlist::crossfade_gains(0.F);
+        auto [end_outgoing, end_incoming] = music::c_playlist::crossfade_gains(1.F);
+        REQUIRE_THAT(start_outgoing, WithinAbs(1.0, 1e-6));
+        REQUIRE_THAT(start_incoming, WithinAbs(0.0, 1e-6));
+        REQUIRE_THAT(end_outgoing, WithinAbs(0.0, 1e-6));
+        REQUIRE_THAT(end_incoming, WithinAbs(1.0, 1e-6));
+    }
+
+    SECTION("Slices of a fade join up")
+    {
+        constexpr std::size_t frames = 8;
+        std::vector<float> outgoing(frames * music::c_playlist::s_channels, 1.F);
+        std::vector<float> incoming(frames * music::c_playlist::s_channels, -1.F);
+        std::vector<float> whole(outgoing.size(), 0.F);
+        std::vector<float> sliced(outgoing.size(), 0.F);
+
+        music::c_playlist::crossfade(outgoing, incoming, whole, 0, frames);
+        auto half = outgoing.size() / 2;
+        music::c_playlist::crossfade(std::span(outgoing).first(half), std::span(incoming).first(half), std::span(sliced).first(half), 0, frames);
+        music::c_playlist::crossfade(std::span(outgoing).subspan(half), std::span(incoming).subspan(half), std::span(sliced).subspan(half), frames / 2, frames);
+
+        for (std::size_t i = 0; i < whole.size(); ++i)
+        {
+            REQUIRE_THAT(sliced[i], WithinAbs(whole[i], 1e-6));
+        }
+
+        // Both channels of a frame share the gains; the midpoint is equal parts of both files
+        REQUIRE(whole[0] == whole[1]);
+        REQUIRE_THAT(whole[frames], WithinAbs(0.0, 1e-6));
+    }
+}
+
+TEST_CASE("Playlist: Queue", "[music][playlist][unit]")
+{
+    using namespace std::chrono_literals;
+    music::c_playlist playlist;
+
+    SECTION("Crossfade length round-trips through frames")
+    {
+        REQUIRE(playlist.get_crossfade() == 0ms);
+        playlist.set_crossfade(3000ms);
+        REQUIRE(playlist.get_crossfade() == 3000ms);
+    }
+
+    SECTION("Files that cannot be opened are skipped and nothing plays")
+    {
+        playlist.enqueue("/nonexistent/file.wav");
+        REQUIRE(playlist.items().size() == 1);
+        REQUIRE(wait_until_decoded(playlist));
+        playlist.play();
+
+        std::vector<float> output(64, 0.F);
+        playlist.mix(output, output.size() / music::c_playlist::s_channels);
+        REQUIRE_FALSE(playlist.now_playing().has_value());
+        for (auto sample : output)
+        {
+            REQUIRE(sample == 0.F);
+        }
+    }
+}
+
+TEST_CASE("Playlist: Mixing files", "[music][playlist][unit]")
+{
+    using namespace std::chrono_literals;
+    music::c_playlist playlist;
+
+    SECTION("Gapless transitions continue on the next frame")
+    {
+        support::c_temporary_wav first("spectra_playlist_gapless_0.wav", 44100);
+        support::c_temporary_wav second("spectra_playlist_gapless_1.wav", 44100);
+        playlist.enqueue(first.path());
+        playlist.enqueue(second.path());
+        REQUIRE(wait_until_decoded(playlist));
+        playlist.play();
+
+        auto output = mix_periods(playlist, (2 * s_file_frames) + 4410);
+        REQUIRE(playlist.underflows() == 0);
+
+        // Both files are one continuous sine, which moves at most 0.032 per frame: a larger step is a click
+        float largest_step = 0.F;
+        for (std::size_t frame = 1; frame < output.size() / s_channels; ++frame)
+        {
+            largest_step = std::max(largest_step, std::abs(output[frame * s_channels] - output[(frame - 1) * s_channels]));
+        }
+        REQUIRE(largest_step < 0.1F);
+
+        // No quieter stretch at the join either, 10 ms windows across both files
+        double quietest = s_sine_rms;
+        double loudest = s_sine_rms;
+        for (std::size_t frame = 441; frame + 882 < 2 * s_file_frames; frame += 441)
+        {
+            quietest = std::min(quietest, rms(output, frame, 441));
+            loudest = std::max(loudest, rms(output, frame, 441));
+        }
+        REQUIRE(quietest > 0.3);
+        REQUIRE(loudest < 0.4);
+
+        // Then the queue is done
+        REQUIRE(std::ranges::all_of(std::span(output).subspan(((2 * s_file_frames) + 64) * s_channels), [](float sample)
+                                    { return sample == 0.F; }));
+        REQUIRE_FALSE(playlist.now_playing().has_value());
+    }
+
+    SECTION("Crossfades overlap the files by the crossfade length")
+    {
+        support::c_temporary_wav first("spectra_playlist_crossfade_0.wav", 44100);
+        support::c_temporary_wav second("spectra_playlist_crossfade_1.wav", 44100);
+        playlist.set_crossfade(500ms);
+        playlist.enqueue(first.path());
+        playlist.enqueue(second.path());
+        REQUIRE(wait_until_decoded(playlist));
+        playlist.play();
+
+        constexpr std::size_t fade_frames = 22050;
+        constexpr std::size_t fade_start = s_file_frames - fade_frames;
+        constexpr std::size_t end = (2 * s_file_frames) - fade_frames;
+        auto output = mix_periods(playlist, (2 * s_file_frames) + 4410);
+        REQUIRE(playlist.underflows() == 0);
+
+        // The fade starts in whole cycles of both sines, so they add up in phase: equal power gains give the
+        // outgoing level before the fade and sqrt(2) of it halfway through
+        REQUIRE(std::abs(rms(output, fade_start - 882, 441) - s_sine_rms) < 0.03);
+        REQUIRE(std::abs(rms(output, fade_start + (fade_frames / 2) - 220, 441) - (s_sine_rms * std::numbers::sqrt2)) < 0.03);
+
+        // The second file ends early by the overlap
+        std::size_t last_audible = 0;
+        for (std::size_t frame = 0; frame < output.size() / s_channels; ++frame)
+        {
+            if (std::abs(output[frame * s_channels]) > 0.01F)
+            {
+                last_audible = frame;
+            }
+        }
+        REQUIRE(last_audible >= end - 64);
+        REQUIRE(last_audible < end);
+    }
+
+    SECTION("Frames not decoded in time play as silence")
+    {
+        // Longer than the ring; mixed in one go, faster than the decoder thread refills it
+        support::c_temporary_wav file("spectra_playlist_underflow.wav", 44100, 8);
+        playlist.enqueue(file.path());
+        REQUIRE(wait_until_decoded(playlist));
+        playlist.play();
+
+        constexpr std::size_t frames = 9 * 44100;
+        std::vector<float> output(frames * s_channels, 0.F);
+        playlist.mix(output, frames);
+        REQUIRE(playlist.underflows() > 0);
+
+        // What was decoded ahead plays, the rest of an underflowing block is exactly zero
+        REQUIRE(std::abs(rms(output, 441, 441) - s_sine_rms) < 0.03);
+        std::size_t longest_silence = 0;
+        std::size_t silence = 0;
+        for (std::size_t frame = 0; frame < frames; ++frame)
+        {
+            silence = output[frame * s_channels] == 0.F and output[(frame * s_channels) + 1] == 0.F ? silence + 1 : 0;
+            longest_silence = std::max(longest_silence, silence);
+        }
+        REQUIRE(longest_silence >= music::c_playlist::s_block_frames);
+        REQUIRE(std::ranges::all_of(output, [](float sample)
+                                    { return std::abs(sample) <= 0.51F; }));
+    }
+}
@@ -0,0 +1,122 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstddef>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+
+import utility;
+
+namespace
+{
+    auto trace() -> std::string
+    {
+        std::ostringstream stream;
+        utility::c_profiler::instance().write_chrome_trace(stream);
+        return stream.str();
+    }
+
+    auto count(std::string_view text, std::string_view pattern) -> std::size_t
+    {
+        std::size_t found = 0;
+        for (auto position = text.find(pattern); position != std::string_view::npos; position = text.find(pattern, position + pattern.size()))
+        {
+            ++found;
+        }
+        return found;
+    }
+} // namespace
+
+TEST_CASE("Profiler: Zones", "[utility][profiler][unit]")
+{
+    auto &profiler = utility::c_profiler::instance();
+    profiler.name_thread("Profiler test");
+
+    SECTION("A name always maps to the same zone")
+    {
+        auto first = profiler.register_zone("Profiler test: named");
+        REQUIRE(profiler.register_zone("Profiler test: named") == first);
+        REQUIRE(profiler.register_zone("Profiler test: other") != first);
+        REQUIRE(profiler.try_register_zone("Profiler test: named") == first);
+    }
+
+    SECTION("Scoped zones are written as complete events")
+    {
+        {
+            utility::c_profile_zone zone(utility::zone_id<"Profiler test: scoped">());
+        }
+        auto json = trace();
+        REQUIRE(json.starts_with(R"({"displayTimeUnit":"ms","traceEvents":[)"));
+        REQUIRE(json.ends_with("]}\n"));
+        if constexpr (utility::profiling_enabled)
+        {
+            REQUIRE(count(json, R"({"name":"Profiler test: scoped","cat":"spectra","ph":"X")") == 1);
+        }
+        else
+        {
+            REQUIRE(count(json, "Profiler test: scoped") == 0);
+        }
+    }
+
+    SECTION("Names are escaped")
+    {
+        profiler.record(profiler.register_zone(R"(Profiler test: "quoted")"), 0, 1);
+        REQUIRE(count(trace(), R"("name":"Profiler test: \"quoted\"")") == 1);
+    }
+}
+
+TEST_CASE("Profiler: Threads", "[utility][profiler][unit]")
+{
+    auto &profiler = utility::c_profiler::instance();
+
+    SECTION("Every thread has its own named track")
+    {
+        std::thread([&profiler]()
+                    {
+                        profiler.name_thread("Profiler test thread");
+                        profiler.record(profiler.register_zone("Profiler test: thread"), profiler.now(), profiler.now());
+                    })
+            .join();
+        auto json = trace();
+        REQUIRE(count(json, R"("args":{"name":"Profiler test thread"})") == 1);
+        REQUIRE(count(json, "Profiler test: thread\"") == 1);
+    }
+
+    SECTION("A thread that cannot register takes a reserved ring")
+    {
+        profiler.reserve_thread("Profiler test reserved");
+        std::thread([&profiler]()
+                    { profiler.record(profiler.register_zone("Profiler test: reserved"), profiler.now(), profiler.now()); })
+            .join();
+        auto json = trace();
+        REQUIRE(count(json, R"("args":{"name":"Profiler test reserved"})") == 1);
+        REQUIRE(count(json, "Profiler test: reserved\"") == 1);
+    }
+
+    SECTION("A full ring keeps the newest zones")
+    {
+        constexpr auto capacity = utility::c_profiler::s_events_per_thread;
+        std::thread([&profiler]()
+                    {
+                        profiler.name_thread("Profiler test ring");
+                        auto oldest = profiler.register_zone("Profiler test: overwritten");
+                        auto newest = profiler.register_zone("Profiler test: wrapped");
+                        for (std::size_t i = 0; i < 100; ++i)
+                        {
+                            profiler.record(oldest, 0, 1);
+                        }
+                        for (std::size_t i = 0; i < capacity; ++i)
+                        {
+                            profiler.record(newest, 0, 1);
+                        }
+                    })
+            .join();
+        auto json = trace();
+        REQUIRE(count(json, "Profiler test: overwritten") == 0);
+        // The slot next in line for overwriting is left out, its thread could be writing to it
+        auto kept = count(json, "Profiler test: wrapped");
+        REQUIRE(kept >= capacity - 1);
+        REQUIRE(kept <= capacity);
+    }
+}
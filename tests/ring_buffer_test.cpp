@@ -0,0 +1,103 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <numeric>
+#include <span>
+#include <thread>
+#include <vector>
+
+import utility;
+
+TEST_CASE("SPSC ring: Single thread", "[utility][ring_buffer][unit]")
+{
+    SECTION("Capacity is rounded up to a power of two")
+    {
+        utility::c_spsc_ring<float> ring(1000);
+        REQUIRE(ring.capacity() == 1024);
+        REQUIRE(ring.size() == 0);
+    }
+
+    SECTION("Values come out in the order they went in")
+    {
+        utility::c_spsc_ring<int> ring(8);
+        std::array<int, 5> input = { 1, 2, 3, 4, 5 };
+        REQUIRE(ring.push(input) == 5);
+        REQUIRE(ring.size() == 5);
+
+        std::array<int, 3> output{};
+        std::array<int, 3> expected = { 1, 2, 3 };
+        REQUIRE(ring.pop(output) == 3);
+        REQUIRE(output == expected);
+        REQUIRE(ring.pop(output) == 2);
+        REQUIRE(output[0] == 4);
+        REQUIRE(output[1] == 5);
+    }
+
+    SECTION("A full ring drops what does not fit")
+    {
+        utility::c_spsc_ring<int> ring(4);
+        std::array<int, 6> input = { 1, 2, 3, 4, 5, 6 };
+        REQUIRE(ring.push(input) == 4);
+
+        std::array<int, 6> output{};
+        REQUIRE(ring.pop(output) == 4);
+        REQUIRE(output[3] == 4);
+    }
+
+    SECTION("Writes and reads wrap around the end of the storage")
+    {
+        utility::c_spsc_ring<int> ring(4);
+        std::array<int, 3> first = { 1, 2, 3 };
+        std::array<int, 3> second = { 4, 5, 6 };
+        std::array<int, 3> output{};
+
+        ring.push(first);
+        ring.pop(output);
+        REQUIRE(ring.push(second) == 3);
+        REQUIRE(ring.pop(output) == 3);
+        REQUIRE(output == second);
+    }
+
+    SECTION("Discard empties the ring")
+    {
+        utility::c_spsc_ring<int> ring(4);
+        std::array<int, 3> input = { 1, 2, 3 };
+        ring.push(input);
+        REQUIRE(ring.discard() == 3);
+        REQUIRE(ring.size() == 0);
+        REQUIRE(ring.push(input) == 3);
+    }
+}
+
+TEST_CASE("SPSC ring: Concurrent producer and consumer", "[utility][ring_buffer][unit]")
+{
+    constexpr std::size_t total = 1U << 18U;
+    utility::c_spsc_ring<std::size_t> ring(256);
+
+    std::jthread producer([&ring]()
+                          {
+                              std::array<std::size_t, 37> chunk{};
+                              std::size_t next = 0;
+                              while (next < total)
+                              {
+                                  auto count = std::min(chunk.size(), total - next);
+                                  std::iota(chunk.begin(), chunk.begin() + static_cast<std::ptrdiff_t>(count), next);
+                                  next += ring.push(std::span(chunk).first(count));
+                              } });
+
+    std::vector<std::size_t> received;
+    received.reserve(total);
+    std::array<std::size_t, 53> chunk{};
+    while (received.size() < total)
+    {
+        auto count = ring.pop(chunk);
+        received.insert(received.end(), chunk.begin(), chunk.begin() + static_cast<std::ptrdiff_t>(count));
+    }
+
+    // Nothing lost, duplicated or reordered
+    std::vector<std::size_t> expected(total);
+    std::iota(expected.begin(), expected.end(), std::size_t{ 0 });
+    REQUIRE(received == expected);
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <sndfile.hh>
+
+#include <cmath>
+#include <cstddef>
+#include <filesystem>
+#include <numbers>
+#include <string>
+#include <system_error>
+#include <vector>
+
+namespace support
+{
+    /**
+     * @brief Stereo 440 Hz sine as a float WAV in the temporary directory, removed again on destruction. Whole seconds
+     * hold whole cycles, so consecutive files continue the same sine.
+     */
+    class c_temporary_wav
+    {
+    public:
+        c_temporary_wav(const std::string &name, int sample_rate, int seconds = 2)
+            : m_path(std::filesystem::temp_directory_path() / name)
+        {
+            SndfileHandle file(m_path.string(), SFM_WRITE, SF_FORMAT_WAV | SF_FORMAT_FLOAT, 2, sample_rate);
+            std::vector<float> samples(static_cast<std::size_t>(sample_rate) * static_cast<std::size_t>(seconds) * 2);
+            for (std::size_t i = 0; i < samples.size(); ++i)
+            {
+                samples[i] = 0.5F * std::sin(2.F * std::numbers::pi_v<float> * 440.F * static_cast<float>(i / 2) / static_cast<float>(sample_rate));
+            }
+            file.writef(samples.data(), static_cast<sf_count_t>(samples.size() / 2));
+        }
+        ~c_temporary_wav()
+        {
+            std::error_code error;
+            std::filesystem::remove(m_path, error);
+        }
+        c_temporary_wav(const c_temporary_wav &) = delete;
+        c_temporary_wav(c_temporary_wav &&) = delete;
+        auto operator=(const c_temporary_wav &) -> c_temporary_wav & = delete;
+        auto operator=(c_temporary_wav &&) -> c_temporary_wav & = delete;
+
+        [[nodiscard]] auto path() const -> const std::filesystem::path &
+        {
+            return m_path;
+        }
+
+    private:
+        std::filesystem::path m_path;
+    };
+} // namespace support
@@ -0,0 +1,82 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <array>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+import music;
+
+TEST_CASE("Analysis taps: Subscriptions", "[music][tap][unit]")
+{
+    std::array<float, 4> period = { 0.1F, 0.2F, 0.3F, 0.4F };
+
+    SECTION("Nothing is recorded without a subscriber")
+    {
+        music::c_tap_set taps(64);
+        taps.feed(period);
+        REQUIRE(taps.subscriber_count() == 0);
+
+        auto subscription = taps.subscribe();
+        REQUIRE(subscription);
+        std::array<float, 8> samples{};
+        REQUIRE(subscription.read(samples) == 0);
+    }
+
+    SECTION("Subscribers receive the samples fed after they attach")
+    {
+        music::c_tap_set taps(64);
+        auto first = taps.subscribe();
+        auto second = taps.subscribe();
+        taps.feed(period);
+
+        std::array<float, 8> samples{};
+        REQUIRE(first.read(samples) == 4);
+        REQUIRE(samples[3] == 0.4F);
+        REQUIRE(second.read(samples) == 4);
+        REQUIRE(samples[0] == 0.1F);
+    }
+
+    SECTION("The number of subscribers is bounded")
+    {
+        music::c_tap_set taps(64);
+        std::vector<music::c_tap_subscription> subscriptions;
+        for (std::size_t i = 0; i < music::c_tap_set::s_max_taps; ++i)
+        {
+            subscriptions.push_back(taps.subscribe());
+            REQUIRE(subscriptions.back());
+        }
+        REQUIRE_FALSE(taps.subscribe());
+
+        // Releasing one frees its tap for the next subscriber, without the stale samples
+        taps.feed(period);
+        subscriptions.pop_back();
+        REQUIRE(taps.subscriber_count() == music::c_tap_set::s_max_taps - 1);
+        auto again = taps.subscribe();
+        REQUIRE(again);
+        std::array<float, 8> samples{};
+        REQUIRE(again.read(samples) == 0);
+    }
+
+    SECTION("A slow subscriber loses the newest samples and is told so")
+    {
+        music::c_tap_set taps(4);
+        auto subscription = taps.subscribe();
+        taps.feed(period);
+        taps.feed(period);
+
+        std::array<float, 8> samples{};
+        REQUIRE(subscription.read(samples) == 4);
+        REQUIRE(subscription.dropped() == 4);
+    }
+
+    SECTION("Moving a subscription keeps the tap attached")
+    {
+        music::c_tap_set taps(64);
+        auto subscription = taps.subscribe();
+        auto moved = std::move(subscription);
+        REQUIRE(taps.subscriber_count() == 1);
+        moved = {};
+        REQUIRE(taps.subscriber_count() == 0);
+    }
+}
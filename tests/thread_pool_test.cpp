@@ -0,0 +1,53 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <atomic>
+#include <future>
+#include <stdexcept>
+#include <vector>
+
+import utility;
+
+TEST_CASE("Thread pool: Job execution", "[utility][thread_pool][unit]")
+{
+    SECTION("Results are delivered through futures")
+    {
+        utility::c_thread_pool pool(2);
+        auto future = pool.submit([]()
+                                  { return 42; });
+        REQUIRE(future.get() == 42);
+    }
+
+    SECTION("Exceptions are delivered through futures")
+    {
+        utility::c_thread_pool pool(1);
+        auto future = pool.submit([]() -> int
+                                  { throw std::runtime_error("job failed"); });
+        REQUIRE_THROWS_AS(future.get(), std::runtime_error);
+    }
+
+    SECTION("All jobs run")
+    {
+        utility::c_thread_pool pool(4);
+        std::atomic<int> counter = 0;
+        std::vector<std::future<void>> futures;
+        for (int i = 0; i < 100; ++i)
+        {
+            futures.push_back(pool.submit([&counter]()
+                                          { counter.fetch_add(1); }));
+        }
+        for (auto &future : futures)
+        {
+            future.get();
+        }
+        REQUIRE(counter.load() == 100);
+    }
+
+    SECTION("At least one worker is created")
+    {
+        utility::c_thread_pool pool(0);
+        REQUIRE(pool.thread_count() == 1);
+        REQUIRE(pool.submit([]()
+                            { return true; })
+                    .get());
+    }
+}